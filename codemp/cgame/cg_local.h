@@ -990,6 +990,8 @@ typedef struct skulltrail_s {
 
 #define MAX_PREDICTED_EVENTS	16
 
+#define NUM_SAVED_STATES		( CMD_BACKUP + 2 )
+
 #define	MAX_EMOJI_LENGTH			24 //max length of the characters between the colons
 #define	MAX_LOADABLE_EMOJIS			256 //max png files it can load
 #define	MAX_CHATBOX_ITEM_EMOJIS		32 //max emojis per chat message
@@ -1143,6 +1145,14 @@ typedef struct cg_s {
 	int			predictedErrorTime;
 	vec3_t		predictedError;
 
+	// cg_optimizePrediction keeps the state after every predicted command,
+	// so only commands after the last one predicted need to run through pmove
+	int			lastPredictedCommand;
+	int			lastServerTime;
+	playerState_t	savedPmoveStates[NUM_SAVED_STATES];
+	int			stateHead, stateTail;
+	int			predictionErrors;		// snapshots that didn't match the saved state
+
 	int			eventSequence;
 	int			predictableEvents[MAX_PREDICTED_EVENTS];
 
@@ -955,6 +955,289 @@ qboolean CG_UsingEWeb(void)
 	return qfalse;
 }
 
+/*
+=================
+CG_CopyUnsentFields
+
+Copies the playerState_t fields the server never sends from one state to
+another, mirroring the non-pilot playerStateFields table msg.cpp uses with
+_OPTIMIZED_VEHICLE_NETWORKING.  The client only ever learns these from its own
+pmove, so a snapshot can't disagree with the saved states about them.
+=================
+*/
+static void CG_CopyUnsentFields( playerState_t *to, const playerState_t *from ) {
+	forcedata_t	fd;
+	int			i;
+
+	VectorCopy( from->moveDir, to->moveDir );
+	to->slopeRecalcTime = from->slopeRecalcTime;
+	to->useTime = from->useTime;
+	to->externalEventTime = from->externalEventTime;
+	to->painTime = from->painTime;
+	to->painDirection = from->painDirection;
+	to->yawAngle = from->yawAngle;
+	to->yawing = from->yawing;
+	to->pitchAngle = from->pitchAngle;
+	to->pitching = from->pitching;
+
+	for ( i = MAX_AMMO_TRANSMIT; i < MAX_AMMO; i++ ) {
+		to->ammo[i] = from->ammo[i];
+	}
+
+	to->ping = from->ping;
+	to->pmove_framecount = from->pmove_framecount;
+	to->jumppad_frame = from->jumppad_frame;
+	to->entityEventSequence = from->entityEventSequence;
+	to->lastOnGround = from->lastOnGround;
+	to->saberBlocking = from->saberBlocking;
+	to->saberLockHits = from->saberLockHits;
+	to->saberLockHitCheckTime = from->saberLockHitCheckTime;
+	to->saberLockHitIncrementTime = from->saberLockHitIncrementTime;
+	to->saberEntityDist = from->saberEntityDist;
+	to->saberEntityState = from->saberEntityState;
+	to->saberThrowDelay = from->saberThrowDelay;
+	to->saberDidThrowTime = from->saberDidThrowTime;
+	to->saberDamageDebounceTime = from->saberDamageDebounceTime;
+	to->saberHitWallSoundDebounceTime = from->saberHitWallSoundDebounceTime;
+	to->saberEventFlags = from->saberEventFlags;
+	to->rocketLastValidTime = from->rocketLastValidTime;
+	to->emplacedTime = from->emplacedTime;
+	to->saberIndex = from->saberIndex;
+	to->droneFireTime = from->droneFireTime;
+	to->droneExistTime = from->droneExistTime;
+	memcpy( to->holocronsCarried, from->holocronsCarried, sizeof( to->holocronsCarried ) );
+	to->holocronCantTouch = from->holocronCantTouch;
+	to->holocronCantTouchTime = from->holocronCantTouchTime;
+	to->saberAttackSequence = from->saberAttackSequence;
+	to->saberIdleWound = from->saberIdleWound;
+	to->saberAttackWound = from->saberAttackWound;
+	to->saberBlockTime = from->saberBlockTime;
+	to->otherKiller = from->otherKiller;
+	to->otherKillerTime = from->otherKillerTime;
+	to->otherKillerDebounceTime = from->otherKillerDebounceTime;
+
+	// only a handful of the force data goes over the net
+	fd = to->fd;
+	to->fd = from->fd;
+	to->fd.forcePowersKnown = fd.forcePowersKnown;
+	to->fd.forcePowersActive = fd.forcePowersActive;
+	to->fd.forcePowerSelected = fd.forcePowerSelected;
+	to->fd.forcePower = fd.forcePower;
+	to->fd.forcePowerDebounce[FP_LEVITATION] = fd.forcePowerDebounce[FP_LEVITATION];
+	to->fd.forcePowerLevel[FP_LEVITATION] = fd.forcePowerLevel[FP_LEVITATION];
+	to->fd.forcePowerLevel[FP_SEE] = fd.forcePowerLevel[FP_SEE];
+	to->fd.forceJumpZStart = fd.forceJumpZStart;
+	to->fd.forceGripCripple = fd.forceGripCripple;
+	to->fd.forceMindtrickTargetIndex = fd.forceMindtrickTargetIndex;
+	to->fd.forceMindtrickTargetIndex2 = fd.forceMindtrickTargetIndex2;
+	to->fd.forceMindtrickTargetIndex3 = fd.forceMindtrickTargetIndex3;
+	to->fd.forceMindtrickTargetIndex4 = fd.forceMindtrickTargetIndex4;
+	to->fd.forceRageRecoveryTime = fd.forceRageRecoveryTime;
+	to->fd.forceSide = fd.forceSide;
+	to->fd.sentryDeployed = fd.sentryDeployed;
+	to->fd.saberAnimLevel = fd.saberAnimLevel;
+	to->fd.saberDrawAnimLevel = fd.saberDrawAnimLevel;
+
+	to->forceJumpFlip = from->forceJumpFlip;
+	to->forceHandExtendTime = from->forceHandExtendTime;
+	to->forceRageDrainTime = from->forceRageDrainTime;
+	to->quickerGetup = from->quickerGetup;
+	to->groundTime = from->groundTime;
+	to->footstepTime = from->footstepTime;
+	to->otherSoundTime = from->otherSoundTime;
+	to->otherSoundLen = from->otherSoundLen;
+	to->forceGripMoveInterval = from->forceGripMoveInterval;
+	to->forceGripChangeMovetype = from->forceGripChangeMovetype;
+	to->forceKickFlip = from->forceKickFlip;
+	to->forceAllowDeactivateTime = from->forceAllowDeactivateTime;
+	to->zoomLockTime = from->zoomLockTime;
+	to->useDelay = from->useDelay;
+	VectorCopy( from->vehOrientation, to->vehOrientation );
+	to->vehBoarding = from->vehBoarding;
+	to->vehSurfaces = from->vehSurfaces;
+	to->vehTurnaroundIndex = from->vehTurnaroundIndex;
+	to->vehTurnaroundTime = from->vehTurnaroundTime;
+	to->vehWeaponsLinked = from->vehWeaponsLinked;
+	to->hyperSpaceTime = from->hyperSpaceTime;
+	VectorCopy( from->hyperSpaceAngles, to->hyperSpaceAngles );
+#ifdef _ONEBIT_COMBO
+	to->deltaOneBits = from->deltaOneBits;
+	to->deltaNumBits = from->deltaNumBits;
+#endif
+}
+
+/*
+=================
+CG_IsUnacceptableError
+
+Compares the playerState_t from a snapshot against the one saved after
+predicting the same command.  Every field the server sends has to match,
+since the saved states would carry the old value forward; only origin,
+velocity and viewangles get a small tolerance.  The fields checked one by
+one come first so cg_showMiss can tell them apart.
+Returns 0 if the saved states can still be used.
+=================
+*/
+static int CG_IsUnacceptableError( const playerState_t *ps, const playerState_t *pps ) {
+	playerState_t	server;
+	vec3_t			delta;
+	int				i;
+
+	if ( pps->pm_type != ps->pm_type ||
+		pps->pm_flags != ps->pm_flags ||
+		pps->pm_time != ps->pm_time ) {
+		return 1;
+	}
+
+	VectorSubtract( pps->origin, ps->origin, delta );
+	if ( VectorLengthSquared( delta ) > 0.1f * 0.1f ) {
+		if ( cg_showMiss.integer ) {
+			trap->Print( "origin delta: %.2f\n", VectorLength( delta ) );
+		}
+		return 2;
+	}
+
+	VectorSubtract( pps->velocity, ps->velocity, delta );
+	if ( VectorLengthSquared( delta ) > 0.1f * 0.1f ) {
+		if ( cg_showMiss.integer ) {
+			trap->Print( "velocity delta: %.2f\n", VectorLength( delta ) );
+		}
+		return 3;
+	}
+
+	if ( pps->weaponTime != ps->weaponTime ||
+		pps->weaponChargeTime != ps->weaponChargeTime ||
+		pps->gravity != ps->gravity ||
+		pps->speed != ps->speed ||
+		pps->basespeed != ps->basespeed ||
+		pps->delta_angles[0] != ps->delta_angles[0] ||
+		pps->delta_angles[1] != ps->delta_angles[1] ||
+		pps->delta_angles[2] != ps->delta_angles[2] ||
+		pps->groundEntityNum != ps->groundEntityNum ) {
+		return 4;
+	}
+
+	if ( pps->legsTimer != ps->legsTimer ||
+		pps->legsAnim != ps->legsAnim ||
+		pps->torsoTimer != ps->torsoTimer ||
+		pps->torsoAnim != ps->torsoAnim ||
+		pps->legsFlip != ps->legsFlip ||
+		pps->torsoFlip != ps->torsoFlip ||
+		pps->movementDir != ps->movementDir ) {
+		return 5;
+	}
+
+	if ( pps->eFlags != ps->eFlags ||
+		pps->eFlags2 != ps->eFlags2 ) {
+		return 6;
+	}
+
+	if ( pps->eventSequence != ps->eventSequence ) {
+		return 7;
+	}
+
+	for ( i = 0; i < MAX_PS_EVENTS; i++ ) {
+		if ( pps->events[i] != ps->events[i] ||
+			pps->eventParms[i] != ps->eventParms[i] ) {
+			return 8;
+		}
+	}
+
+	if ( pps->externalEvent != ps->externalEvent ||
+		pps->externalEventParm != ps->externalEventParm ) {
+		return 9;
+	}
+
+	if ( pps->clientNum != ps->clientNum ||
+		pps->weapon != ps->weapon ||
+		pps->weaponstate != ps->weaponstate ) {
+		return 10;
+	}
+
+	if ( fabs( AngleDelta( ps->viewangles[0], pps->viewangles[0] ) ) > 1.0f ||
+		fabs( AngleDelta( ps->viewangles[1], pps->viewangles[1] ) ) > 1.0f ||
+		fabs( AngleDelta( ps->viewangles[2], pps->viewangles[2] ) ) > 1.0f ) {
+		return 11;
+	}
+
+	if ( pps->viewheight != ps->viewheight ) {
+		return 12;
+	}
+
+	if ( pps->damageEvent != ps->damageEvent ||
+		pps->damageYaw != ps->damageYaw ||
+		pps->damagePitch != ps->damagePitch ||
+		pps->damageCount != ps->damageCount ||
+		pps->damageType != ps->damageType ) {
+		return 13;
+	}
+
+	for ( i = 0; i < MAX_STATS; i++ ) {
+		if ( pps->stats[i] != ps->stats[i] ) {
+			return 14;
+		}
+	}
+
+	for ( i = 0; i < MAX_PERSISTANT; i++ ) {
+		if ( pps->persistant[i] != ps->persistant[i] ) {
+			return 15;
+		}
+	}
+
+	for ( i = 0; i < MAX_POWERUPS; i++ ) {
+		if ( pps->powerups[i] != ps->powerups[i] ) {
+			return 16;
+		}
+	}
+
+	for ( i = 0; i < MAX_AMMO_TRANSMIT; i++ ) {
+		if ( pps->ammo[i] != ps->ammo[i] ) {
+			return 17;
+		}
+	}
+
+	if ( pps->generic1 != ps->generic1 ||
+		pps->loopSound != ps->loopSound ||
+		pps->jumppad_ent != ps->jumppad_ent ) {
+		return 18;
+	}
+
+	if ( pps->saberMove != ps->saberMove ||
+		pps->saberBlocked != ps->saberBlocked ||
+		pps->saberHolstered != ps->saberHolstered ||
+		pps->saberInFlight != ps->saberInFlight ||
+		pps->saberLockTime != ps->saberLockTime ||
+		pps->forceHandExtend != ps->forceHandExtend ||
+		pps->zoomMode != ps->zoomMode ||
+		pps->duelInProgress != ps->duelInProgress ||
+		pps->m_iVehicleNum != ps->m_iVehicleNum ||
+		pps->jetpackFuel != ps->jetpackFuel ||
+		pps->cloakFuel != ps->cloakFuel ) {
+		return 19;
+	}
+
+	if ( pps->fd.forcePowersActive != ps->fd.forcePowersActive ||
+		pps->fd.forcePower != ps->fd.forcePower ||
+		pps->fd.forceGripCripple != ps->fd.forceGripCripple ||
+		pps->fd.saberAnimLevel != ps->fd.saberAnimLevel ||
+		pps->fd.saberDrawAnimLevel != ps->fd.saberDrawAnimLevel ) {
+		return 20;
+	}
+
+	// everything else the server sends, e.g. force levels, broken limbs or
+	// duel state set by the game outside of pmove
+	server = *ps;
+	CG_CopyUnsentFields( &server, pps );
+	VectorCopy( pps->origin, server.origin );
+	VectorCopy( pps->velocity, server.velocity );
+	VectorCopy( pps->viewangles, server.viewangles );
+	if ( memcmp( &server, pps, sizeof( server ) ) ) {
+		return 21;
+	}
+
+	return 0;
+}
+
 /*
 =================
 CG_PredictPlayerState
@@ -973,9 +1256,9 @@ but we simulate all unacknowledged commands each time, not just the new ones.
 This means that on an internet connection, quite a few pmoves may be issued
 each frame.
 
-OPTIMIZE: don't re-simulate unless the newly arrived snapshot playerState_t
-differs from the predicted one.  Would require saving all intermediate
-playerState_t during prediction.
+With cg_optimizePrediction the state after every predicted command is saved,
+and commands are only re-simulated once a newly arrived snapshot
+playerState_t differs from the one saved for the same command.
 
 We detect prediction errors and allow them to be decayed off over several frames
 to ease the jerk.
@@ -995,6 +1278,9 @@ void CG_PredictPlayerState( void ) {
 	usercmd_t	latestCmd;
 	centity_t *pEnt;
 	clientInfo_t *ci;
+	qboolean	optimize;
+	int			serverTime, predictCmd, stateIndex;
+	int			numPredicted, numPlayedBack;
 	const int REAL_CMD_BACKUP = (cl_commandsize.integer >= 4 && cl_commandsize.integer <= 512 ) ? (cl_commandsize.integer) : (CMD_BACKUP); //Loda - FPS UNLOCK client modcode
 
 	cg.hyperspace = qfalse;	// will be set if touching a trigger_teleport
@@ -1118,6 +1404,7 @@ void CG_PredictPlayerState( void ) {
 		}
 		cg.physicsTime = cg.snap->serverTime;
 	}
+	serverTime = cg.physicsTime;
 	if(((cg.physicsTime - cg.predictedPlayerState.commandTime) > 8) && (cg.predictedPlayerState.stats[STAT_MOVEMENTSTYLE] == MV_OCPM)){
 		cg.physicsTime = cg.predictedPlayerState.commandTime + 8;
 	}
@@ -1167,8 +1454,61 @@ void CG_PredictPlayerState( void ) {
 		cg.predictedVehicleState.commandTime = cg.predictedPlayerState.commandTime;
 	}
 
+	// with cg_optimizePrediction, commands that were already predicted from a
+	// state the server has since agreed with are played back from the saved
+	// states instead of going through pmove again.  Not while riding inside a
+	// vehicle, the server sends pilotPlayerStateFields then (the same test as
+	// MSG_WriteDeltaPlayerstate) and CG_CopyUnsentFields doesn't match those
+	optimize = (qboolean)( cg_optimizePrediction.integer && !CG_Piloting( cg.predictedPlayerState.m_iVehicleNum )
+		&& !( cg.predictedPlayerState.m_iVehicleNum && ( cg.predictedPlayerState.eFlags & EF_NODRAW ) ) );
+	predictCmd = 0;
+	stateIndex = cg.stateHead;
+	if ( optimize ) {
+		if ( cg.nextFrameTeleport || cg.thisFrameTeleport ) {
+			// nothing saved before a teleport is any use
+			cg.stateTail = cg.stateHead;
+		} else if ( serverTime == cg.lastServerTime ) {
+			// same snapshot as last frame, only the new commands need predicting
+			predictCmd = cg.lastPredictedCommand + 1;
+		} else {
+			int errorcode = -1;
+
+			// find the state saved after the command this snapshot ends on
+			while ( cg.stateHead != cg.stateTail ) {
+				const playerState_t *saved = &cg.savedPmoveStates[cg.stateHead];
+
+				if ( saved->commandTime == cg.predictedPlayerState.commandTime ) {
+					errorcode = CG_IsUnacceptableError( &cg.predictedPlayerState, saved );
+					if ( !errorcode ) {
+						cg.predictedPlayerState = *saved;
+						cg.stateHead = ( cg.stateHead + 1 ) % NUM_SAVED_STATES;
+						predictCmd = cg.lastPredictedCommand + 1;
+					}
+					break;
+				}
+				cg.stateHead = ( cg.stateHead + 1 ) % NUM_SAVED_STATES;
+			}
+
+			if ( errorcode ) {
+				if ( errorcode > 0 ) {
+					cg.predictionErrors++;
+					if ( cg_showMiss.integer ) {
+						trap->Print( "prediction error %i at %i (%i total)\n", errorcode, cg.time, cg.predictionErrors );
+					}
+				}
+				cg.stateTail = cg.stateHead;
+			}
+		}
+		cg.lastServerTime = serverTime;
+		stateIndex = cg.stateHead;
+	} else {
+		cg.stateTail = cg.stateHead;
+		cg.lastServerTime = 0;
+	}
+
 	// run cmds
 	moved = qfalse;
+	numPredicted = numPlayedBack = 0;
 	for ( cmdNum = current - REAL_CMD_BACKUP + 1 ; cmdNum <= current ; cmdNum++ ) {
 		// get the command
 		trap->GetUserCmd( cmdNum, &cg_pmove.cmd );
@@ -1348,7 +1688,25 @@ void CG_PredictPlayerState( void ) {
 			}
 		}
 
-		Pmove (&cg_pmove);
+		if ( optimize && cmdNum < predictCmd && stateIndex != cg.stateTail ) {
+			// predicted before from the same starting point
+			*cg_pmove.ps = cg.savedPmoveStates[stateIndex];
+			stateIndex = ( stateIndex + 1 ) % NUM_SAVED_STATES;
+			numPlayedBack++;
+		} else {
+			Pmove (&cg_pmove);
+			numPredicted++;
+
+			if ( optimize ) {
+				cg.lastPredictedCommand = cmdNum;
+				// when the queue is full the rest is just predicted every frame
+				if ( ( stateIndex + 1 ) % NUM_SAVED_STATES != cg.stateHead ) {
+					cg.savedPmoveStates[stateIndex] = *cg_pmove.ps;
+					stateIndex = ( stateIndex + 1 ) % NUM_SAVED_STATES;
+					cg.stateTail = stateIndex;
+				}
+			}
+		}
 
 		if (CG_Piloting(cg.predictedPlayerState.m_iVehicleNum) &&
 			cg.predictedPlayerState.pm_type != PM_INTERMISSION)
@@ -1466,6 +1824,9 @@ void CG_PredictPlayerState( void ) {
 
 	if ( cg_showMiss.integer > 1 ) {
 		trap->Print( "[%i : %i] ", cg_pmove.cmd.serverTime, cg.time );
+		if ( optimize ) {
+			trap->Print( "(%i predicted, %i played back) ", numPredicted, numPlayedBack );
+		}
 	}
 
 	if ( !moved ) {
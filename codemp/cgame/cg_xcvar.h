@@ -314,6 +314,7 @@ XCVAR_DEF( cg_noPredict,						"0",					NULL,					CVAR_NONE )
 XCVAR_DEF( cg_noProjectileTrail,				"0",					NULL,					CVAR_ARCHIVE )
 XCVAR_DEF( cg_noTaunt,							"0",					NULL,					CVAR_ARCHIVE )
 XCVAR_DEF( cg_oldPainSounds,					"0",					NULL,					CVAR_ARCHIVE )
+XCVAR_DEF( cg_optimizePrediction,				"1",					NULL,					CVAR_ARCHIVE )
 XCVAR_DEF( cg_predictItems,						"1",					NULL,					CVAR_ARCHIVE )
 XCVAR_DEF( cg_renderToTextureFX,				"1",					NULL,					CVAR_ARCHIVE )
 XCVAR_DEF( cg_repeaterOrb,						"0",					NULL,					CVAR_ARCHIVE )
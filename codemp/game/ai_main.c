@@ -1140,13 +1140,12 @@ qboolean BotPVSCheck( const vec3_t p1, const vec3_t p2 )
 //get the index to the nearest visible waypoint in the global trail
 int GetNearestVisibleWP(vec3_t org, int ignore)
 {
+	static int list[MAX_WPARRAY_SIZE];
 	int i;
+	int num;
 	float bestdist;
-	float flLen;
-	int bestindex;
-	vec3_t a, mins, maxs;
+	vec3_t mins, maxs;
 
-	i = 0;
 	if (RMG.integer)
 	{
 		bestdist = 300;
@@ -1156,7 +1155,6 @@ int GetNearestVisibleWP(vec3_t org, int ignore)
 		bestdist = 800;//99999;
 				   //don't trace over 800 units away to avoid GIANT HORRIBLE SPEED HITS ^_^
 	}
-	bestindex = -1;
 
 	mins[0] = -15;
 	mins[1] = -15;
@@ -1165,24 +1163,17 @@ int GetNearestVisibleWP(vec3_t org, int ignore)
 	maxs[1] = 15;
 	maxs[2] = 1;
 
-	while (i < gWPNum)
-	{
-		if (gWPArray[i] && gWPArray[i]->inuse)
-		{
-			VectorSubtract(org, gWPArray[i]->origin, a);
-			flLen = VectorLength(a);
+	num = GetWPsNearestFirst(org, bestdist, list);
 
-			if (flLen < bestdist && (RMG.integer || BotPVSCheck(org, gWPArray[i]->origin)) && OrgVisibleBox(org, mins, maxs, gWPArray[i]->origin, ignore))
-			{
-				bestdist = flLen;
-				bestindex = i;
-			}
+	for (i = 0; i < num; i++)
+	{ //nearest first, so the first visible one is the one we want
+		if ((RMG.integer || BotPVSCheck(org, gWPArray[list[i]]->origin)) && OrgVisibleBox(org, mins, maxs, gWPArray[list[i]]->origin, ignore))
+		{
+			return list[i];
 		}
-
-		i++;
 	}
 
-	return bestindex;
+	return -1;
 }
 
 //wpDirection
@@ -375,6 +375,7 @@ void BotWaypointRender(void);
 int OrgVisibleBox(vec3_t org1, vec3_t mins, vec3_t maxs, vec3_t org2, int ignore);
 int BotIsAChickenWuss(bot_state_t *bs);
 int GetNearestVisibleWP(vec3_t org, int ignore);
+int GetWPsNearestFirst(vec3_t org, float maxDist, int *list);
 int GetBestIdleGoal(bot_state_t *bs);
 
 char *ConcatArgs( int start );
@@ -41,6 +41,178 @@ int nodenum; //so we can connect broken trails
 
 int gLevelFlags = 0;
 
+/*
+Waypoint and node lookup grids
+
+Entries are sorted into cells on the xy plane, hashed into a fixed number
+of buckets and chained by index, so the points near an origin can be found
+without looking at every one of them.
+*/
+
+#define WPGRID_CELL_SIZE	128
+#define WPGRID_BUCKETS		1024
+
+typedef struct wpGrid_s
+{
+	int heads[WPGRID_BUCKETS];
+	int *next;
+	int (*cells)[2];
+	int num;
+} wpGrid_t;
+
+static int wpGridNext[MAX_WPARRAY_SIZE];
+static int wpGridCells[MAX_WPARRAY_SIZE][2];
+static wpGrid_t wpGrid = { { 0 }, wpGridNext, wpGridCells, 0 };
+static qboolean wpGridValid = qfalse;
+
+static int nodeGridNext[MAX_NODETABLE_SIZE];
+static int nodeGridCells[MAX_NODETABLE_SIZE][2];
+static wpGrid_t nodeGrid = { { 0 }, nodeGridNext, nodeGridCells, 0 };
+static qboolean nodeGridValid = qfalse;
+
+static int wpGridCollect[MAX_NODETABLE_SIZE];
+static float wpGridDist[MAX_WPARRAY_SIZE];
+
+static int WPGrid_Cell(float coord)
+{
+	return (int)floorf(coord / WPGRID_CELL_SIZE);
+}
+
+static int WPGrid_Bucket(int x, int y)
+{
+	return ((unsigned)x * 73856093u ^ (unsigned)y * 19349663u) & (WPGRID_BUCKETS - 1);
+}
+
+static void WPGrid_Clear(wpGrid_t *grid)
+{
+	int i;
+
+	for (i = 0; i < WPGRID_BUCKETS; i++)
+	{
+		grid->heads[i] = -1;
+	}
+	grid->num = 0;
+}
+
+static void WPGrid_Add(wpGrid_t *grid, int index, const vec3_t origin)
+{
+	int x = WPGrid_Cell(origin[0]);
+	int y = WPGrid_Cell(origin[1]);
+	int bucket = WPGrid_Bucket(x, y);
+
+	grid->cells[index][0] = x;
+	grid->cells[index][1] = y;
+	grid->next[index] = grid->heads[bucket];
+	grid->heads[bucket] = index;
+	grid->num++;
+}
+
+//collects every entry in the cells touching the square of radius around org,
+//or all entries in the grid once that is less work. returns the number collected.
+static int WPGrid_Collect(const wpGrid_t *grid, const vec3_t org, float radius, int maxIndex, int *list)
+{
+	int minX = WPGrid_Cell(org[0] - radius), maxX = WPGrid_Cell(org[0] + radius);
+	int minY = WPGrid_Cell(org[1] - radius), maxY = WPGrid_Cell(org[1] + radius);
+	int x, y, i;
+	int num = 0;
+
+	if (radius >= WPGRID_CELL_SIZE * 4096 ||
+		(float)(maxX - minX + 1) * (maxY - minY + 1) >= grid->num)
+	{
+		for (i = 0; i < maxIndex; i++)
+		{
+			list[num++] = i;
+		}
+		return num;
+	}
+
+	for (x = minX; x <= maxX; x++)
+	{
+		for (y = minY; y <= maxY; y++)
+		{
+			for (i = grid->heads[WPGrid_Bucket(x, y)]; i != -1; i = grid->next[i])
+			{ //other cells can share the bucket
+				if (grid->cells[i][0] == x && grid->cells[i][1] == y)
+				{
+					list[num++] = i;
+				}
+			}
+		}
+	}
+
+	return num;
+}
+
+static void WPGrid_Update(void)
+{
+	int i;
+
+	if (wpGridValid)
+	{
+		return;
+	}
+
+	WPGrid_Clear(&wpGrid);
+	for (i = 0; i < gWPNum; i++)
+	{
+		if (gWPArray[i] && gWPArray[i]->inuse)
+		{
+			WPGrid_Add(&wpGrid, i, gWPArray[i]->origin);
+		}
+	}
+	wpGridValid = qtrue;
+}
+
+static int QDECL WPGrid_SortDist(const void *a, const void *b)
+{
+	int ia = *(const int *)a;
+	int ib = *(const int *)b;
+
+	if (wpGridDist[ia] != wpGridDist[ib])
+	{
+		return wpGridDist[ia] < wpGridDist[ib] ? -1 : 1;
+	}
+	return ia - ib;
+}
+
+//puts the waypoints closer than maxDist to org into list, nearest first and
+//ties in index order, and returns how many there are. list must have room
+//for MAX_WPARRAY_SIZE entries.
+int GetWPsNearestFirst(vec3_t org, float maxDist, int *list)
+{
+	vec3_t a;
+	float flLen;
+	int numCollected;
+	int num = 0;
+	int i;
+
+	WPGrid_Update();
+
+	numCollected = WPGrid_Collect(&wpGrid, org, maxDist, gWPNum, wpGridCollect);
+	for (i = 0; i < numCollected; i++)
+	{
+		int index = wpGridCollect[i];
+
+		if (index >= gWPNum || !gWPArray[index] || !gWPArray[index]->inuse)
+		{
+			continue;
+		}
+
+		VectorSubtract(org, gWPArray[index]->origin, a);
+		flLen = VectorLength(a);
+
+		if (flLen < maxDist)
+		{
+			wpGridDist[index] = flLen;
+			list[num++] = index;
+		}
+	}
+
+	qsort(list, num, sizeof(list[0]), WPGrid_SortDist);
+
+	return num;
+}
+
 char *GetFlagStr( int flags )
 {
 	char *flagstr;
@@ -367,6 +539,8 @@ checkprint:
 
 void TransferWPData(int from, int to)
 {
+	wpGridValid = qfalse;
+
 	if (!gWPArray[to])
 	{
 		gWPArray[to] = (wpobject_t *)B_Alloc(sizeof(wpobject_t));
@@ -389,6 +563,8 @@ void TransferWPData(int from, int to)
 
 void CreateNewWP(vec3_t origin, int flags)
 {
+	wpGridValid = qfalse;
+
 	if (gWPNum >= MAX_WPARRAY_SIZE)
 	{
 		if (!RMG.integer)
@@ -423,6 +599,8 @@ void CreateNewWP_FromObject(wpobject_t *wp)
 {
 	int i;
 
+	wpGridValid = qfalse;
+
 	if (gWPNum >= MAX_WPARRAY_SIZE)
 	{
 		return;
@@ -474,6 +652,8 @@ void CreateNewWP_FromObject(wpobject_t *wp)
 
 void RemoveWP(void)
 {
+	wpGridValid = qfalse;
+
 	if (gWPNum <= 0)
 	{
 		return;
@@ -514,6 +694,8 @@ void RemoveWP_InTrail(int afterindex)
 	int didchange;
 	int i;
 
+	wpGridValid = qfalse;
+
 	foundindex = 0;
 	foundanindex = 0;
 	didchange = 0;
@@ -581,6 +763,8 @@ int CreateNewWP_InTrail(vec3_t origin, int flags, int afterindex)
 	int foundanindex;
 	int i;
 
+	wpGridValid = qfalse;
+
 	foundindex = 0;
 	foundanindex = 0;
 	i = 0;
@@ -659,6 +843,8 @@ int CreateNewWP_InsertUnder(vec3_t origin, int flags, int afterindex)
 	int foundanindex;
 	int i;
 
+	wpGridValid = qfalse;
+
 	foundindex = 0;
 	foundanindex = 0;
 	i = 0;
@@ -1069,6 +1255,7 @@ int ConnectTrail(int startindex, int endindex, qboolean behindTheScenes)
 	maxs[2] = 0;
 
 	nodenum = 0;
+	nodeGridValid = qfalse;
 	foundit = 0;
 
 	i = 0;
@@ -1632,15 +1819,106 @@ int CanForceJumpTo(int baseindex, int testingindex, float distance)
 	}
 }
 
+#define MAX_PATH_TRACE_BATCH 1024
+
+//waypoints further apart than this are never linked, CanForceJumpTo gives up past 400
+#define MAX_PATH_LINK_RADIUS 401
+
+typedef struct pathCandidate_s
+{
+	int from;
+	int num;
+	float dist;
+	int forceJumpable;
+	int trace;
+} pathCandidate_t;
+
+static pathCandidate_t pathCand[MAX_PATH_TRACE_BATCH];
+static traceRequest_t pathReqs[MAX_PATH_TRACE_BATCH];
+static trace_t pathTrs[MAX_PATH_TRACE_BATCH];
+static int pathLinkCandidates[MAX_NODETABLE_SIZE];
+
+static int QDECL SortIndices(const void *a, const void *b)
+{
+	return *(const int *)a - *(const int *)b;
+}
+
+//trap->TraceBatch is only there if the engine says so, the game import table
+//version didn't change when it was added
+static void WP_TraceBatch(trace_t *results, const traceRequest_t *requests, int numRequests)
+{
+	int i;
+
+	if (trap->Cvar_VariableIntegerValue("sv_traceBatch"))
+	{
+		trap->TraceBatch(results, requests, numRequests, qfalse, 0, 0);
+		return;
+	}
+
+	for (i = 0; i < numRequests; i++)
+	{
+		trap->Trace(&results[i], requests[i].start, requests[i].mins, requests[i].maxs, requests[i].end, requests[i].passEntityNum, requests[i].contentmask, qfalse, 0, 0);
+	}
+}
+
+//traces the pending candidates all at once, then links them in the order they
+//were found until the neighbor list of their waypoint is full
+static void LinkPathCandidates(int numCand, int numReq, int maxNeighborDist)
+{
+	pathCandidate_t *cand;
+	wpobject_t *wp;
+	trace_t *tr;
+	int n;
+
+	if (numReq)
+	{
+		WP_TraceBatch(pathTrs, pathReqs, numReq);
+	}
+
+	for (n = 0; n < numCand; n++)
+	{
+		cand = &pathCand[n];
+		wp = gWPArray[cand->from];
+
+		if (wp->neighbornum >= MAX_NEIGHBOR_SIZE)
+		{
+			continue;
+		}
+
+		if (cand->trace != -1)
+		{
+			tr = &pathTrs[cand->trace];
+			if (tr->fraction != 1 || tr->startsolid || tr->allsolid)
+			{
+				continue;
+			}
+		}
+
+		wp->neighbors[wp->neighbornum].num = cand->num;
+		if (cand->forceJumpable && ((int)wp->origin[2] != (int)gWPArray[cand->num]->origin[2] || cand->dist < maxNeighborDist))
+		{
+			wp->neighbors[wp->neighbornum].forceJumpTo = 999;//forceJumpable; //FJSR
+		}
+		else
+		{
+			wp->neighbors[wp->neighbornum].forceJumpTo = 0;
+		}
+		wp->neighbornum++;
+	}
+}
+
 void CalculatePaths(void)
 {
 	int i;
 	int c;
+	int n;
 	int forceJumpable;
 	int maxNeighborDist = MAX_NEIGHBOR_LINK_DISTANCE;
 	float nLDist;
 	vec3_t a;
 	vec3_t mins, maxs;
+	traceRequest_t *req;
+	int numCand, numReq, numLinks;
 
 	if (!gWPNum)
 	{
@@ -1678,50 +1956,81 @@ void CalculatePaths(void)
 		i++;
 	}
 
-	i = 0;
+	WPGrid_Update();
 
-	while (i < gWPNum)
+	// only waypoints in the grid cells around each one can be linked to it.
+	// the visibility traces of the candidates of many waypoints are done in
+	// one batch, then the candidates are linked in order until the neighbor
+	// lists are full
+	numCand = 0;
+	numReq = 0;
+
+	for (i = 0; i < gWPNum; i++)
 	{
-		if (gWPArray[i] && gWPArray[i]->inuse)
+		if (!gWPArray[i] || !gWPArray[i]->inuse)
 		{
-			c = 0;
+			continue;
+		}
+
+		numLinks = WPGrid_Collect(&wpGrid, gWPArray[i]->origin, Q_max(maxNeighborDist, MAX_PATH_LINK_RADIUS), gWPNum, pathLinkCandidates);
+		qsort(pathLinkCandidates, numLinks, sizeof(pathLinkCandidates[0]), SortIndices);
 
-			while (c < gWPNum)
+		for (n = 0; n < numLinks; n++)
+		{
+			c = pathLinkCandidates[n];
+
+			if (c >= gWPNum || !gWPArray[c] || !gWPArray[c]->inuse || i == c ||
+				!NotWithinRange(i, c))
 			{
-				if (gWPArray[c] && gWPArray[c]->inuse && i != c &&
-					NotWithinRange(i, c))
-				{
-					VectorSubtract(gWPArray[i]->origin, gWPArray[c]->origin, a);
+				continue;
+			}
 
-					nLDist = VectorLength(a);
-					forceJumpable = CanForceJumpTo(i, c, nLDist);
+			VectorSubtract(gWPArray[i]->origin, gWPArray[c]->origin, a);
 
-					if ((nLDist < maxNeighborDist || forceJumpable) &&
-						((int)gWPArray[i]->origin[2] == (int)gWPArray[c]->origin[2] || forceJumpable) &&
-						(OrgVisibleBox(gWPArray[i]->origin, mins, maxs, gWPArray[c]->origin, ENTITYNUM_NONE) || forceJumpable))
+			nLDist = VectorLength(a);
+			forceJumpable = CanForceJumpTo(i, c, nLDist);
+
+			if ((nLDist < maxNeighborDist || forceJumpable) &&
+				((int)gWPArray[i]->origin[2] == (int)gWPArray[c]->origin[2] || forceJumpable))
+			{
+				if (numCand == MAX_PATH_TRACE_BATCH)
+				{
+					LinkPathCandidates(numCand, numReq, maxNeighborDist);
+					numCand = 0;
+					numReq = 0;
+				}
+
+				pathCand[numCand].from = i;
+				pathCand[numCand].num = c;
+				pathCand[numCand].dist = nLDist;
+				pathCand[numCand].forceJumpable = forceJumpable;
+				pathCand[numCand].trace = -1;
+
+				if (!forceJumpable)
+				{ //only needs to be visible if it can't be jumped to
+					req = &pathReqs[numReq];
+					VectorCopy(gWPArray[i]->origin, req->start);
+					VectorCopy(gWPArray[c]->origin, req->end);
+					if (RMG.integer)
 					{
-						gWPArray[i]->neighbors[gWPArray[i]->neighbornum].num = c;
-						if (forceJumpable && ((int)gWPArray[i]->origin[2] != (int)gWPArray[c]->origin[2] || nLDist < maxNeighborDist))
-						{
-							gWPArray[i]->neighbors[gWPArray[i]->neighbornum].forceJumpTo = 999;//forceJumpable; //FJSR
-						}
-						else
-						{
-							gWPArray[i]->neighbors[gWPArray[i]->neighbornum].forceJumpTo = 0;
-						}
-						gWPArray[i]->neighbornum++;
+						VectorClear(req->mins);
+						VectorClear(req->maxs);
 					}
-
-					if (gWPArray[i]->neighbornum >= MAX_NEIGHBOR_SIZE)
+					else
 					{
-						break;
+						VectorCopy(mins, req->mins);
+						VectorCopy(maxs, req->maxs);
 					}
+					req->passEntityNum = ENTITYNUM_NONE;
+					req->contentmask = MASK_SOLID;
+					pathCand[numCand].trace = numReq++;
 				}
-				c++;
+				numCand++;
 			}
 		}
-		i++;
 	}
+
+	LinkPathCandidates(numCand, numReq, maxNeighborDist);
 }
 
 gentity_t *GetObjectThatTargets(gentity_t *ent)
@@ -1828,15 +2137,10 @@ float botGlobalNavWeaponWeights[WP_NUM_WEAPONS] =
 
 int GetNearestVisibleWPToItem(vec3_t org, int ignore)
 {
+	static int list[MAX_WPARRAY_SIZE];
 	int i;
-	float bestdist;
-	float flLen;
-	int bestindex;
-	vec3_t a, mins, maxs;
-
-	i = 0;
-	bestdist = 64; //has to be less than 64 units to the item or it isn't safe enough
-	bestindex = -1;
+	int num;
+	vec3_t mins, maxs;
 
 	mins[0] = -15;
 	mins[1] = -15;
@@ -1845,26 +2149,22 @@ int GetNearestVisibleWPToItem(vec3_t org, int ignore)
 	maxs[1] = 15;
 	maxs[2] = 0;
 
-	while (i < gWPNum)
+	//has to be less than 64 units to the item or it isn't safe enough
+	num = GetWPsNearestFirst(org, 64, list);
+
+	for (i = 0; i < num; i++)
 	{
-		if (gWPArray[i] && gWPArray[i]->inuse &&
-			gWPArray[i]->origin[2]-15 < org[2] &&
-			gWPArray[i]->origin[2]+15 > org[2])
-		{
-			VectorSubtract(org, gWPArray[i]->origin, a);
-			flLen = VectorLength(a);
+		wpobject_t *wp = gWPArray[list[i]];
 
-			if (flLen < bestdist && trap->InPVS(org, gWPArray[i]->origin) && OrgVisibleBox(org, mins, maxs, gWPArray[i]->origin, ignore))
-			{
-				bestdist = flLen;
-				bestindex = i;
-			}
+		if (wp->origin[2]-15 < org[2] &&
+			wp->origin[2]+15 > org[2] &&
+			trap->InPVS(org, wp->origin) && OrgVisibleBox(org, mins, maxs, wp->origin, ignore))
+		{ //nearest first, so this is the closest visible one
+			return list[i];
 		}
-
-		i++;
 	}
 
-	return bestindex;
+	return -1;
 }
 
 void CalculateWeightGoals(void)
@@ -2514,6 +2814,39 @@ int SavePathData(const char *filename)
 int gSpawnPointNum = 0;
 gentity_t *gSpawnPoints[MAX_SPAWNPOINT_ARRAY];
 
+static void G_NodeGridUpdate(void)
+{
+	int i;
+
+	if (nodeGridValid && nodeGrid.num == nodenum)
+	{
+		return;
+	}
+
+	WPGrid_Clear(&nodeGrid);
+	for (i = 0; i < nodenum; i++)
+	{
+		WPGrid_Add(&nodeGrid, i, nodetable[i].origin);
+	}
+	nodeGridValid = qtrue;
+}
+
+//collects the nodes within a unit of x,y on the xy plane in index order,
+//which includes every node whose coordinates match them
+static int G_NodesNearXY(float x, float y, int *list)
+{
+	vec3_t org;
+	int num;
+
+	G_NodeGridUpdate();
+
+	VectorSet(org, x, y, 0);
+	num = WPGrid_Collect(&nodeGrid, org, 1, nodenum, list);
+	qsort(list, num, sizeof(list[0]), SortIndices);
+
+	return num;
+}
+
 int G_NearestNodeToPoint(vec3_t point)
 { //gets the node on the entire grid which is nearest to the specified coordinates.
 	vec3_t vSub;
@@ -2521,27 +2854,38 @@ int G_NearestNodeToPoint(vec3_t point)
 	int i = 0;
 	float bestDist = 0;
 	float testDist = 0;
+	float radius = WPGRID_CELL_SIZE;
+	int numCollected;
 
-	while (i < nodenum)
-	{
-		VectorSubtract(nodetable[i].origin, point, vSub);
-		testDist = VectorLength(vSub);
+	G_NodeGridUpdate();
+
+	while (nodenum > 0)
+	{ //look in a growing square around the point until the nearest node in it is
+	  //close enough that nothing outside the square could be nearer
+		numCollected = WPGrid_Collect(&nodeGrid, point, radius, nodenum, wpGridCollect);
 
-		if (bestIndex == -1)
+		for (i = 0; i < numCollected; i++)
 		{
-			bestIndex = i;
-			bestDist = testDist;
+			int index = wpGridCollect[i];
 
-			i++;
-			continue;
+			VectorSubtract(nodetable[index].origin, point, vSub);
+			testDist = VectorLength(vSub);
+
+			if (bestIndex == -1 || testDist < bestDist ||
+				(testDist == bestDist && index < bestIndex))
+			{
+				bestIndex = index;
+				bestDist = testDist;
+			}
 		}
 
-		if (testDist < bestDist)
+		if (numCollected == nodenum || (bestIndex != -1 && bestDist <= radius))
 		{
-			bestIndex = i;
-			bestDist = testDist;
+			break;
 		}
-		i++;
+
+		bestIndex = -1;
+		radius *= 2;
 	}
 
 	return bestIndex;
@@ -2575,14 +2919,17 @@ void G_NodeClearFlags(void)
 int G_NodeMatchingXY(float x, float y)
 { //just get the first unflagged node with the matching x,y coordinates.
 	int i = 0;
+	int num = G_NodesNearXY(x, y, wpGridCollect);
 
-	while (i < nodenum)
+	while (i < num)
 	{
-		if (nodetable[i].origin[0] == x &&
-			nodetable[i].origin[1] == y &&
-			!nodetable[i].flags)
+		int index = wpGridCollect[i];
+
+		if (nodetable[index].origin[0] == x &&
+			nodetable[index].origin[1] == y &&
+			!nodetable[index].flags)
 		{
-			return i;
+			return index;
 		}
 
 		i++;
@@ -2596,20 +2943,23 @@ int G_NodeMatchingXY_BA(int x, int y, int final)
 	int i = 0;
 	int bestindex = -1;
 	float bestWeight = 9999;
+	int num = G_NodesNearXY(x, y, wpGridCollect);
 
-	while (i < nodenum)
+	while (i < num)
 	{
-		if ((int)nodetable[i].origin[0] == x &&
-			(int)nodetable[i].origin[1] == y &&
-			!nodetable[i].flags &&
-			((nodetable[i].weight < bestWeight) || (i == final)))
+		int index = wpGridCollect[i];
+
+		if ((int)nodetable[index].origin[0] == x &&
+			(int)nodetable[index].origin[1] == y &&
+			!nodetable[index].flags &&
+			((nodetable[index].weight < bestWeight) || (index == final)))
 		{
-			if (i == final)
+			if (index == final)
 			{
-				return i;
+				return index;
 			}
-			bestindex = i;
-			bestWeight = nodetable[i].weight;
+			bestindex = index;
+			bestWeight = nodetable[index].weight;
 		}
 
 		i++;
@@ -2618,79 +2968,172 @@ int G_NodeMatchingXY_BA(int x, int y, int final)
 	return bestindex;
 }
 
-int G_RecursiveConnection(int start, int end, int weight, qboolean traceCheck, float baseHeight)
+typedef struct nodeRouteOpen_s
 {
-	int indexDirections[4]; //0 == down, 1 == up, 2 == left, 3 == right
-	int recursiveIndex = -1;
-	int i = 0;
-	int passWeight = weight;
-	vec2_t givenXY;
-	trace_t tr;
-
-	passWeight++;
-	nodetable[start].weight = passWeight;
+	int f;		//steps so far plus the least steps still needed
+	int h;
+	int node;
+} nodeRouteOpen_t;
+
+static int nodeRouteSteps[MAX_NODETABLE_SIZE];
+static int nodeRouteParent[MAX_NODETABLE_SIZE];
+static byte nodeRouteClosed[MAX_NODETABLE_SIZE];
+static nodeRouteOpen_t nodeRouteHeap[MAX_NODETABLE_SIZE*4];
+static int nodeRouteHeapSize;
+
+static qboolean G_NodeRouteBefore(const nodeRouteOpen_t *a, const nodeRouteOpen_t *b)
+{
+	if (a->f != b->f)
+	{
+		return (qboolean)(a->f < b->f);
+	}
+	if (a->h != b->h)
+	{
+		return (qboolean)(a->h < b->h);
+	}
+	return (qboolean)(a->node < b->node);
+}
 
-	givenXY[0] = nodetable[start].origin[0];
-	givenXY[1] = nodetable[start].origin[1];
-	givenXY[0] -= DEFAULT_GRID_SPACING;
-	indexDirections[0] = G_NodeMatchingXY(givenXY[0], givenXY[1]);
+static void G_NodeRoutePush(int node, int steps, int end)
+{
+	nodeRouteOpen_t open;
+	int i, parent;
 
-	givenXY[0] = nodetable[start].origin[0];
-	givenXY[1] = nodetable[start].origin[1];
-	givenXY[0] += DEFAULT_GRID_SPACING;
-	indexDirections[1] = G_NodeMatchingXY(givenXY[0], givenXY[1]);
+	open.h = (int)((fabs(nodetable[end].origin[0] - nodetable[node].origin[0]) + fabs(nodetable[end].origin[1] - nodetable[node].origin[1])) / DEFAULT_GRID_SPACING + 0.5f);
+	open.f = steps + open.h;
+	open.node = node;
 
-	givenXY[0] = nodetable[start].origin[0];
-	givenXY[1] = nodetable[start].origin[1];
-	givenXY[1] -= DEFAULT_GRID_SPACING;
-	indexDirections[2] = G_NodeMatchingXY(givenXY[0], givenXY[1]);
+	i = nodeRouteHeapSize++;
+	while (i > 0)
+	{
+		parent = (i - 1) / 2;
+		if (!G_NodeRouteBefore(&open, &nodeRouteHeap[parent]))
+		{
+			break;
+		}
+		nodeRouteHeap[i] = nodeRouteHeap[parent];
+		i = parent;
+	}
+	nodeRouteHeap[i] = open;
+}
 
-	givenXY[0] = nodetable[start].origin[0];
-	givenXY[1] = nodetable[start].origin[1];
-	givenXY[1] += DEFAULT_GRID_SPACING;
-	indexDirections[3] = G_NodeMatchingXY(givenXY[0], givenXY[1]);
+static int G_NodeRoutePop(void)
+{
+	nodeRouteOpen_t last;
+	int node = nodeRouteHeap[0].node;
+	int i = 0, child;
 
-	i = 0;
-	while (i < 4)
+	last = nodeRouteHeap[--nodeRouteHeapSize];
+	while ((child = i * 2 + 1) < nodeRouteHeapSize)
 	{
-		if (indexDirections[i] == end)
-		{ //we've connected all the way to the destination.
-			return indexDirections[i];
+		if (child + 1 < nodeRouteHeapSize && G_NodeRouteBefore(&nodeRouteHeap[child + 1], &nodeRouteHeap[child]))
+		{
+			child++;
 		}
-
-		if (indexDirections[i] != -1 && nodetable[indexDirections[i]].flags)
-		{ //this point is already used, so it's not valid.
-			indexDirections[i] = -1;
+		if (!G_NodeRouteBefore(&nodeRouteHeap[child], &last))
+		{
+			break;
 		}
-		else if (indexDirections[i] != -1)
-		{ //otherwise mark it as used.
-			nodetable[indexDirections[i]].flags = 1;
+		nodeRouteHeap[i] = nodeRouteHeap[child];
+		i = child;
+	}
+	nodeRouteHeap[i] = last;
+
+	return node;
+}
+
+int G_NodeRoute(int start, int end, qboolean traceCheck)
+{ //A* over the node grid from start to end, stepping to the nodes one grid space away on x or y.
+  //the nodes of the route found get weights counting up from 1 at start, for G_BackwardAttachment
+  //to follow back down. every node is expanded at most once, so this is bounded by the node count.
+	static const int dirs[4][2] = { { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 } }; //0 == down, 1 == up, 2 == left, 3 == right
+	traceRequest_t reqs[4];
+	trace_t trs[4];
+	int next[4];
+	int numNext;
+	int node, i, steps;
+
+	if (start < 0 || start >= nodenum || end < 0 || end >= nodenum)
+	{
+		return -1;
+	}
+
+	memset(nodeRouteClosed, 0, nodenum);
+	for (i = 0; i < nodenum; i++)
+	{
+		nodeRouteSteps[i] = -1;
+	}
+
+	nodeRouteHeapSize = 0;
+	nodeRouteSteps[start] = 0;
+	nodeRouteParent[start] = -1;
+	G_NodeRoutePush(start, 0, end);
+
+	while (nodeRouteHeapSize)
+	{
+		node = G_NodeRoutePop();
+
+		if (nodeRouteClosed[node])
+		{ //already reached in fewer steps
+			continue;
 		}
+		nodeRouteClosed[node] = 1;
+
+		numNext = 0;
+		for (i = 0; i < 4; i++)
+		{
+			int index = G_NodeMatchingXY(nodetable[node].origin[0] + dirs[i][0]*DEFAULT_GRID_SPACING, nodetable[node].origin[1] + dirs[i][1]*DEFAULT_GRID_SPACING);
 
-		if (indexDirections[i] != -1 && traceCheck)
-		{ //if we care about trace visibility between nodes, perform the check and mark as not valid if the trace isn't clear.
-			trap->Trace(&tr, nodetable[start].origin, NULL, NULL, nodetable[indexDirections[i]].origin, ENTITYNUM_NONE, CONTENTS_SOLID, qfalse, 0, 0);
+			if (index == end)
+			{ //we've connected all the way to the destination.
+				nodeRouteParent[end] = node;
+				nodeRouteSteps[end] = nodeRouteSteps[node] + 1;
 
-			if (tr.fraction != 1)
+				for (steps = nodeRouteSteps[end]; index != -1; index = nodeRouteParent[index], steps--)
+				{
+					nodetable[index].weight = steps + 1;
+				}
+				return end;
+			}
+
+			if (index == -1 || nodeRouteClosed[index] ||
+				(nodeRouteSteps[index] != -1 && nodeRouteSteps[index] <= nodeRouteSteps[node] + 1))
 			{
-				indexDirections[i] = -1;
+				continue;
 			}
-		}
 
-		if (indexDirections[i] != -1)
-		{ //it's still valid, so keep connecting via this point.
-			recursiveIndex = G_RecursiveConnection(indexDirections[i], end, passWeight, traceCheck, baseHeight);
+			next[numNext] = index;
+			if (traceCheck)
+			{ //if we care about trace visibility between nodes, the step has to be clear.
+				VectorCopy(nodetable[node].origin, reqs[numNext].start);
+				VectorCopy(nodetable[index].origin, reqs[numNext].end);
+				VectorClear(reqs[numNext].mins);
+				VectorClear(reqs[numNext].maxs);
+				reqs[numNext].passEntityNum = ENTITYNUM_NONE;
+				reqs[numNext].contentmask = CONTENTS_SOLID;
+			}
+			numNext++;
 		}
 
-		if (recursiveIndex != -1)
-		{ //the result of the recursive check was valid, so return it.
-			return recursiveIndex;
+		if (traceCheck && numNext)
+		{
+			WP_TraceBatch(trs, reqs, numNext);
 		}
 
-		i++;
+		for (i = 0; i < numNext; i++)
+		{
+			if (traceCheck && trs[i].fraction != 1)
+			{
+				continue;
+			}
+
+			nodeRouteSteps[next[i]] = nodeRouteSteps[node] + 1;
+			nodeRouteParent[next[i]] = node;
+			G_NodeRoutePush(next[i], nodeRouteSteps[next[i]], end);
+		}
 	}
 
-	return recursiveIndex;
+	return -1;
 }
 
 #ifdef DEBUG_NODE_FILE
@@ -3078,6 +3521,7 @@ void G_RMGPathing(void)
 #endif
 
 	nodenum = 0;
+	nodeGridValid = qfalse;
 	memset(&nodetable, 0, sizeof(nodetable));
 
 	VectorSet(trMins, -15, -15, DEFAULT_MINS_2);
@@ -3157,13 +3601,11 @@ void G_RMGPathing(void)
 		//So, nearestIndex is now the node for the spawn point we're on, and nearestIndexForNext is the
 		//node we want to get to from here.
 
-		//For now I am going to branch out mindlessly, but I will probably want to use some sort of A* algorithm
-		//here to lessen the time taken.
-		if (G_RecursiveConnection(nearestIndex, nearestIndexForNext, 0, qtrue, terrain->r.absmin[2]) != nearestIndexForNext)
+		if (G_NodeRoute(nearestIndex, nearestIndexForNext, qtrue) != nearestIndexForNext)
 		{ //failed to branch to where we want. Oh well, try it without trace checks.
 			G_NodeClearForNext();
 
-			if (G_RecursiveConnection(nearestIndex, nearestIndexForNext, 0, qfalse, terrain->r.absmin[2]) != nearestIndexForNext)
+			if (G_NodeRoute(nearestIndex, nearestIndexForNext, qfalse) != nearestIndexForNext)
 			{ //still failed somehow. Just disregard this point.
 				G_NodeClearForNext();
 				i++;
@@ -3,6 +3,14 @@
 #include <stdlib.h>
 #include <string.h>
 #include "sqlite3.h"
+#include "g_leaderboard.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
 
 #define _USE_CURL 0
 
@@ -31,7 +39,538 @@ static char LOCAL_DB_PATH[MAX_QPATH];
             fprintf (stderr, "%s failed with status %d: %s\n",  \
                      #f, i, sqlite3_errmsg (db));               \
         }                                                       \
-    }   
+    }
+
+/*
+=============================================================================
+
+SHARED CONNECTION
+
+One connection is kept open for the whole map instead of every function
+opening and closing the file itself, and prepared statements are cached by
+their SQL text so the same query is only compiled once per map.  The
+database worker thread gets a connection and cache of its own, sqlite
+statements must never be shared between threads.
+
+=============================================================================
+*/
+
+#define DB_STMT_CACHE_SIZE		128
+#define DB_BUSY_TIMEOUT			1000	// ms to wait when the other connection holds the write lock
+
+typedef struct dbStmtCache_s {
+	char			*sql;
+	unsigned int	hash;
+	sqlite3_stmt	*stmt;
+	qboolean		inUse;
+	int				lastUsed;
+} dbStmtCache_t;
+
+typedef struct dbConnection_s {
+	sqlite3			*db;
+	dbStmtCache_t	cache[DB_STMT_CACHE_SIZE];
+	int				counter;
+	int				hits, misses;
+} dbConnection_t;
+
+static dbConnection_t	dbMain;		// game thread
+static dbConnection_t	dbWorker;	// database worker thread
+
+static qboolean G_DBOnWorker( void );
+
+static unsigned int G_DBHashSQL( const char *sql ) {
+	unsigned int hash = 5381;
+
+	while ( *sql )
+		hash = hash * 33 + (unsigned char)*sql++;
+	return hash;
+}
+
+static void G_DBExec( sqlite3 *db, const char *sql ) {
+	char *err = NULL;
+
+	if ( sqlite3_exec( db, sql, NULL, NULL, &err ) != SQLITE_OK ) {
+		fprintf( stderr, "%s failed: %s\n", sql, err ? err : "unknown error" );
+	}
+	sqlite3_free( err );
+}
+
+static dbConnection_t *G_DBConnectionFor( sqlite3 *db ) {
+	if ( !db )
+		return NULL;
+	if ( db == dbMain.db )
+		return &dbMain;
+	if ( db == dbWorker.db )
+		return &dbWorker;
+	return NULL;
+}
+
+/*
+==================
+G_DBOpen
+
+Hands out the calling thread's connection, opening it the first time it is needed
+==================
+*/
+static int G_DBOpen( sqlite3 **db ) {
+	dbConnection_t *conn = G_DBOnWorker() ? &dbWorker : &dbMain;
+	int s;
+
+	if ( !conn->db ) {
+		s = sqlite3_open( LOCAL_DB_PATH, &conn->db );
+		if ( s != SQLITE_OK ) {
+			fprintf( stderr, "open failed with status %d: %s\n", s, sqlite3_errmsg( conn->db ) );
+			sqlite3_close( conn->db );
+			conn->db = NULL;
+			*db = NULL;
+			return s;
+		}
+
+		// WAL lets web stats pages read while we write, and NORMAL sync is
+		// still safe in WAL mode; losing the last run on a power cut is fine
+		G_DBExec( conn->db, "PRAGMA journal_mode=WAL" );
+		G_DBExec( conn->db, "PRAGMA synchronous=NORMAL" );
+		G_DBExec( conn->db, "PRAGMA temp_store=MEMORY" );
+		G_DBExec( conn->db, "PRAGMA cache_size=-8192" );
+		sqlite3_busy_timeout( conn->db, DB_BUSY_TIMEOUT );
+	}
+
+	*db = conn->db;
+	return SQLITE_OK;
+}
+
+/*
+==================
+G_DBClose
+
+The connection stays open until G_DBShutdown, but a caller bailing out
+halfway through a transaction must not leave it open for everyone else
+==================
+*/
+static void G_DBClose( sqlite3 *db ) {
+	if ( db && !sqlite3_get_autocommit( db ) ) {
+		G_DBExec( db, "ROLLBACK" );
+	}
+}
+
+/*
+==================
+G_DBPrepare
+
+Returns a reset statement for sql, compiling it only if it is not cached yet.
+A statement that is still being stepped is never handed out twice, nested
+users of the same query get a private copy instead.
+==================
+*/
+static int G_DBPrepare( sqlite3 *db, const char *sql, sqlite3_stmt **stmt ) {
+	dbConnection_t	*conn = G_DBConnectionFor( db );
+	dbStmtCache_t	*entry, *slot = NULL;
+	unsigned int	hash = G_DBHashSQL( sql );
+	int				i, s;
+
+	if ( conn ) {
+		for ( i = 0, entry = conn->cache; i < DB_STMT_CACHE_SIZE; i++, entry++ ) {
+			if ( !entry->stmt ) {
+				if ( !slot || slot->stmt )
+					slot = entry;
+				continue;
+			}
+			if ( entry->hash == hash && !entry->inUse && !strcmp( entry->sql, sql ) ) {
+				entry->inUse = qtrue;
+				entry->lastUsed = ++conn->counter;
+				conn->hits++;
+				*stmt = entry->stmt;
+				return SQLITE_OK;
+			}
+			if ( !entry->inUse && ( !slot || ( slot->stmt && entry->lastUsed < slot->lastUsed ) ) )
+				slot = entry;
+		}
+		conn->misses++;
+	}
+
+	s = sqlite3_prepare_v2( db, sql, strlen( sql ) + 1, stmt, NULL );
+	if ( s != SQLITE_OK ) {
+		fprintf( stderr, "prepare_v2 failed with status %d: %s\n", s, sqlite3_errmsg( db ) );
+		return s;
+	}
+
+	if ( !slot )
+		return s; // everything is busy, this one gets finalized when done
+
+	if ( slot->stmt ) {
+		sqlite3_finalize( slot->stmt );
+		free( slot->sql );
+	}
+	slot->sql = strdup( sql );
+	if ( !slot->sql ) {
+		slot->stmt = NULL;
+		return s;
+	}
+	slot->hash = hash;
+	slot->stmt = *stmt;
+	slot->inUse = qtrue;
+	slot->lastUsed = ++conn->counter;
+	return s;
+}
+
+/*
+==================
+G_DBFinalize
+
+Gives a statement back to the cache, or finalizes it if it was never cached
+==================
+*/
+static int G_DBFinalize( sqlite3_stmt *stmt ) {
+	dbConnection_t	*conn;
+	int				i;
+
+	if ( !stmt )
+		return SQLITE_OK;
+
+	conn = G_DBConnectionFor( sqlite3_db_handle( stmt ) );
+	for ( i = 0; conn && i < DB_STMT_CACHE_SIZE; i++ ) {
+		if ( conn->cache[i].stmt == stmt ) {
+			sqlite3_reset( stmt );
+			sqlite3_clear_bindings( stmt );
+			conn->cache[i].inUse = qfalse;
+			return SQLITE_OK;
+		}
+	}
+
+	return sqlite3_finalize( stmt );
+}
+
+static int G_DBCachedStatements( const dbConnection_t *conn ) {
+	int i, count = 0;
+
+	for ( i = 0; i < DB_STMT_CACHE_SIZE; i++ ) {
+		if ( conn->cache[i].stmt )
+			count++;
+	}
+	return count;
+}
+
+static void G_DBCloseConnection( dbConnection_t *conn ) {
+	int i;
+
+	for ( i = 0; i < DB_STMT_CACHE_SIZE; i++ ) {
+		if ( conn->cache[i].stmt ) {
+			sqlite3_finalize( conn->cache[i].stmt );
+			free( conn->cache[i].sql );
+		}
+	}
+
+	if ( conn->db )
+		sqlite3_close( conn->db );
+	memset( conn, 0, sizeof( *conn ) );
+}
+
+/*
+=============================================================================
+
+DATABASE WORKER
+
+Race times, duels and playtime are written by a worker thread so the game
+frame never waits on the disk.  Jobs go into a fixed ring and are run in the
+order they were queued, each inside its own transaction.  The same slot is
+handed back to the game once the worker is done with it, G_DBRunCompletions
+delivers the results (prints, sounds, demo and unlock updates) from
+G_RunFrame.  The game only blocks if the ring is full.
+
+=============================================================================
+*/
+
+#define DB_QUEUE_SIZE			64
+
+typedef enum {
+	DBJOB_RACE,
+	DBJOB_DUEL,
+	DBJOB_PLAYTIME
+} dbJobType_t;
+
+typedef struct dbRaceJob_s {
+	// filled in by the game
+	char			username[16];
+	char			netname[MAX_NETNAME];
+	char			coursename[40];
+	char			message[64];
+	qboolean		hasMessage;
+	char			styleString[32];
+	int				clientNum;
+	int				style, duration_ms, topspeed, average, end_time;
+	int				awesomenoise, worldrecordnoise;
+	int				playtime;		// seconds of racetime to flush to the account, 0 for none
+	unsigned int	unlocks;		// cosmetics this time earns if it is a personal best
+
+	// filled in by the worker
+	qboolean		seasonPB, globalPB, writeFailed;
+	int				season_oldRank, season_newRank, global_oldRank, global_newRank;
+	float			addedScore;
+} dbRaceJob_t;
+
+typedef struct dbDuelJob_s {
+	char			winner[16];
+	char			loser[16];
+	int				type, duration, winner_hp, winner_shield, end_time;
+} dbDuelJob_t;
+
+typedef struct dbPlaytimeJob_s {
+	char			username[16];
+	int				seconds;
+} dbPlaytimeJob_t;
+
+typedef struct dbJob_s {
+	dbJobType_t		type;
+	union {
+		dbRaceJob_t		race;
+		dbDuelJob_t		duel;
+		dbPlaytimeJob_t	playtime;
+	} u;
+	char			errors[256];	// G_ErrorPrint output from the worker, printed on completion
+} dbJob_t;
+
+static struct {
+	dbJob_t			jobs[DB_QUEUE_SIZE];
+	unsigned int	head;		// oldest job whose results have not been delivered
+	unsigned int	done;		// next job for the worker, everything before it is finished
+	unsigned int	tail;		// next free slot
+	dbJob_t			*current;	// job the worker is running
+
+	qboolean		initialized, running, quit;
+	int				queued, maxDepth;
+#ifdef _WIN32
+	HANDLE				thread;
+	DWORD				threadId;
+	CRITICAL_SECTION	lock;
+	CONDITION_VARIABLE	wake;		// signalled when a job is queued
+	CONDITION_VARIABLE	finished;	// signalled when a job is done
+#else
+	pthread_t			thread;
+	pthread_mutex_t		lock;
+	pthread_cond_t		wake;
+	pthread_cond_t		finished;
+#endif
+} dbQueue;
+
+static void G_DBRunJob( dbJob_t *job );
+static void G_DBFinishJob( dbJob_t *job );
+
+#ifdef _WIN32
+#define DB_LOCK()			EnterCriticalSection( &dbQueue.lock )
+#define DB_UNLOCK()			LeaveCriticalSection( &dbQueue.lock )
+#define DB_WAIT( cond )		SleepConditionVariableCS( &dbQueue.cond, &dbQueue.lock, INFINITE )
+#define DB_SIGNAL( cond )	WakeAllConditionVariable( &dbQueue.cond )
+#else
+#define DB_LOCK()			pthread_mutex_lock( &dbQueue.lock )
+#define DB_UNLOCK()			pthread_mutex_unlock( &dbQueue.lock )
+#define DB_WAIT( cond )		pthread_cond_wait( &dbQueue.cond, &dbQueue.lock )
+#define DB_SIGNAL( cond )	pthread_cond_broadcast( &dbQueue.cond )
+#endif
+
+static qboolean G_DBOnWorker( void ) {
+	if ( !dbQueue.running )
+		return qfalse;
+#ifdef _WIN32
+	return (qboolean)( GetCurrentThreadId() == dbQueue.threadId );
+#else
+	return (qboolean)pthread_equal( pthread_self(), dbQueue.thread );
+#endif
+}
+
+static void G_DBWorker( void ) {
+	dbJob_t *job;
+
+	DB_LOCK();
+	while ( 1 ) {
+		while ( !dbQueue.quit && dbQueue.done == dbQueue.tail )
+			DB_WAIT( wake );
+		if ( dbQueue.done == dbQueue.tail )
+			break; // quitting and nothing left to write
+
+		job = &dbQueue.jobs[dbQueue.done % DB_QUEUE_SIZE];
+		DB_UNLOCK();
+
+		dbQueue.current = job;
+		G_DBRunJob( job );
+		dbQueue.current = NULL;
+
+		DB_LOCK();
+		dbQueue.done++;
+		DB_SIGNAL( finished );
+	}
+	DB_UNLOCK();
+
+	G_DBCloseConnection( &dbWorker );
+}
+
+#ifdef _WIN32
+static DWORD WINAPI G_DBWorkerThread( LPVOID arg ) {
+	G_DBWorker();
+	return 0;
+}
+#else
+static void *G_DBWorkerThread( void *arg ) {
+	G_DBWorker();
+	return NULL;
+}
+#endif
+
+static qboolean G_DBStartWorker( void ) {
+	if ( dbQueue.running )
+		return qtrue;
+
+	if ( !dbQueue.initialized ) {
+#ifdef _WIN32
+		InitializeCriticalSection( &dbQueue.lock );
+		InitializeConditionVariable( &dbQueue.wake );
+		InitializeConditionVariable( &dbQueue.finished );
+#else
+		pthread_mutex_init( &dbQueue.lock, NULL );
+		pthread_cond_init( &dbQueue.wake, NULL );
+		pthread_cond_init( &dbQueue.finished, NULL );
+#endif
+		dbQueue.initialized = qtrue;
+	}
+
+	dbQueue.quit = qfalse;
+	dbQueue.running = qtrue; // before the thread can look at it
+#ifdef _WIN32
+	dbQueue.thread = CreateThread( NULL, 0, G_DBWorkerThread, NULL, 0, &dbQueue.threadId );
+	if ( !dbQueue.thread )
+		dbQueue.running = qfalse;
+#else
+	if ( pthread_create( &dbQueue.thread, NULL, G_DBWorkerThread, NULL ) )
+		dbQueue.running = qfalse;
+#endif
+
+	if ( !dbQueue.running )
+		trap->Print( "WARNING: Couldn't start the database thread, writing on the game thread\n" );
+	return dbQueue.running;
+}
+
+/*
+==================
+G_DBRunCompletions
+
+Delivers the results of every job the worker has finished so far
+==================
+*/
+void G_DBRunCompletions( void ) {
+	unsigned int done;
+
+	if ( !dbQueue.running )
+		return;
+
+	DB_LOCK();
+	done = dbQueue.done;
+	DB_UNLOCK();
+
+	while ( dbQueue.head != done ) {
+		G_DBFinishJob( &dbQueue.jobs[dbQueue.head % DB_QUEUE_SIZE] );
+
+		DB_LOCK();
+		dbQueue.head++;
+		DB_UNLOCK();
+	}
+}
+
+/*
+==================
+G_DBFlush
+
+Waits for every queued write, for anything that needs to read them back
+==================
+*/
+static void G_DBFlush( void ) {
+	if ( !dbQueue.running )
+		return;
+
+	DB_LOCK();
+	while ( dbQueue.done != dbQueue.tail )
+		DB_WAIT( finished );
+	DB_UNLOCK();
+
+	G_DBRunCompletions();
+}
+
+static void G_DBStopWorker( void ) {
+	if ( !dbQueue.running )
+		return;
+
+	G_DBFlush();
+
+	DB_LOCK();
+	dbQueue.quit = qtrue;
+	DB_SIGNAL( wake );
+	DB_UNLOCK();
+
+#ifdef _WIN32
+	WaitForSingleObject( dbQueue.thread, INFINITE );
+	CloseHandle( dbQueue.thread );
+#else
+	pthread_join( dbQueue.thread, NULL );
+#endif
+	dbQueue.running = qfalse;
+	dbQueue.head = dbQueue.done = dbQueue.tail = 0;
+}
+
+/*
+==================
+G_DBQueueJob
+
+Hands a write to the worker, or runs it right away when there is none
+==================
+*/
+static void G_DBQueueJob( const dbJob_t *job ) {
+	dbJob_t *slot;
+
+	if ( !g_dbThread.integer || !G_DBStartWorker() ) {
+		dbJob_t inlineJob = *job;
+
+		inlineJob.errors[0] = '\0';
+		G_DBFlush(); // keep the order if the thread was just turned off
+		G_DBRunJob( &inlineJob );
+		G_DBFinishJob( &inlineJob );
+		return;
+	}
+
+	while ( 1 ) {
+		DB_LOCK();
+		if ( dbQueue.tail - dbQueue.head < DB_QUEUE_SIZE )
+			break;
+		if ( dbQueue.done == dbQueue.head )
+			DB_WAIT( finished );
+		DB_UNLOCK();
+
+		G_DBRunCompletions(); // frees the slots of finished jobs
+	}
+
+	slot = &dbQueue.jobs[dbQueue.tail % DB_QUEUE_SIZE];
+	*slot = *job;
+	slot->errors[0] = '\0';
+	dbQueue.tail++;
+	dbQueue.queued++;
+	if ( (int)( dbQueue.tail - dbQueue.done ) > dbQueue.maxDepth )
+		dbQueue.maxDepth = dbQueue.tail - dbQueue.done;
+	DB_SIGNAL( wake );
+	DB_UNLOCK();
+}
+
+/*
+==================
+G_DBShutdown
+
+Called once per map from G_ShutdownGame, after the last stats are written
+==================
+*/
+void G_RaceBoardsClear( void );
+void G_DBShutdown( void ) {
+	G_DBStopWorker();
+	G_RaceBoardsClear();
+	dbQueue.queued = dbQueue.maxDepth = 0;
+
+	G_DBCloseConnection( &dbMain );
+}
 
 #if 0
 typedef struct RaceRecord_s {
@@ -123,6 +662,15 @@ unsigned int ip_to_int (const char * ip) {
 }
 
 void G_ErrorPrint( const char *fmt, int s ) {
+	if ( G_DBOnWorker() ) { //Not safe to touch the engine from here, print it when the job completes
+		char line[128];
+
+		if ( dbQueue.current ) {
+			Com_sprintf( line, sizeof( line ), "%s %i\n", fmt, s ); //va() is not thread safe
+			Q_strcat( dbQueue.current->errors, sizeof( dbQueue.current->errors ), line );
+		}
+		return;
+	}
 	trap->SendServerCommand( -1, va("print \"%s %i\n\"", fmt, s) );
 	G_SecurityLogPrintf(fmt);
 }
@@ -150,10 +698,10 @@ void DebugWriteToDB(char *entrypoint) {
 	Q_strncpyz(username, "test", sizeof(username));
 	Q_strncpyz(password, "test", sizeof(password));
 
-	CALL_SQLITE (open (LOCAL_DB_PATH, & db));
+	G_DBOpen (& db);
 
 	sql = "UPDATE LocalAccount SET password = ? WHERE username = ?";
-	CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+	G_DBPrepare (db, sql, & stmt);
 	CALL_SQLITE (bind_text (stmt, 1, username, -1, SQLITE_STATIC));
 
 	s = sqlite3_step(stmt);
@@ -161,8 +709,8 @@ void DebugWriteToDB(char *entrypoint) {
 	if (s != SQLITE_DONE)
 		G_SecurityLogPrintf( "ERROR: Could not write to database with error %i, entrypoint %s\n", s, entrypoint );
 
-	CALL_SQLITE (finalize(stmt));
-	CALL_SQLITE (close(db));
+	G_DBFinalize (stmt);
+	G_DBClose (db);
 }
 */
 
@@ -174,9 +722,9 @@ int CheckUserExists(char *username) { //make this accept existing DB so we dont
 
 	//load fixme replace this with simple select count
 
-	CALL_SQLITE (open (LOCAL_DB_PATH, & db));
+	G_DBOpen (& db);
 	sql = "SELECT id FROM LocalAccount WHERE username = ?";
-	CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+	G_DBPrepare (db, sql, & stmt);
 	CALL_SQLITE (bind_text (stmt, 1, username, -1, SQLITE_STATIC));
 	
     while (1) {
@@ -192,8 +740,8 @@ int CheckUserExists(char *username) { //make this accept existing DB so we dont
         }
     }
 
-	CALL_SQLITE (finalize(stmt));
-	CALL_SQLITE (close(db));
+	G_DBFinalize (stmt);
+	G_DBClose (db);
 
 	//DebugWriteToDB("CheckUserExists");
 
@@ -295,7 +843,7 @@ int GetDuelCount(char *username, int type, int end_time, sqlite3 * db) {
 
 	//Get Current Count, Get last duel id, get new duel id
 	sql = "SELECT COUNT(*) FROM LocalDuel WHERE type = ? AND (winner = ? OR loser = ?) AND end_time < ?";
-	CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+	G_DBPrepare (db, sql, & stmt);
 	CALL_SQLITE (bind_int (stmt, 1, type));
 	CALL_SQLITE (bind_text (stmt, 2, username, -1, SQLITE_STATIC));
 	CALL_SQLITE (bind_text (stmt, 3, username, -1, SQLITE_STATIC));
@@ -310,7 +858,7 @@ int GetDuelCount(char *username, int type, int end_time, sqlite3 * db) {
 		G_ErrorPrint("ERROR: SQL Select Failed (GetDuelCount)", s);
 	}
 
-	CALL_SQLITE (finalize(stmt));
+	G_DBFinalize (stmt);
 
 	return count;
 }
@@ -324,7 +872,7 @@ float GetDuelElo( char *username, int type, int end_time, sqlite3 * db) {
 	sql = "SELECT winner_elo AS elo, end_time FROM LocalDuel where type = ? AND winner = ? AND end_time < ? "
 		"UNION ALL SELECT loser_elo AS elo, end_time FROM LocalDuel where type = ? AND loser = ? AND end_time < ? "
 		"ORDER BY end_time DESC LIMIT 1";
-	CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+	G_DBPrepare (db, sql, & stmt);
 	CALL_SQLITE (bind_int (stmt, 1, type));
 	CALL_SQLITE (bind_text (stmt, 2, username, -1, SQLITE_STATIC));
 	CALL_SQLITE (bind_int (stmt, 3, end_time));
@@ -345,7 +893,7 @@ float GetDuelElo( char *username, int type, int end_time, sqlite3 * db) {
 		elo = 1000; //Elo not found, give them initial value
 	}
 
-	CALL_SQLITE (finalize(stmt));
+	G_DBFinalize (stmt);
 
 	//Com_Printf("Getting duel elo %.2f %s %i %i\n", elo, username, type, end_time);
 
@@ -362,7 +910,7 @@ void UpdatePlayerRating(char *username, int type, qboolean winner, float newElo,
 			sql = "UPDATE LocalDuel SET winner_elo = ?, odds = ? WHERE id = ?";
 		else
 			sql = "UPDATE LocalDuel SET loser_elo = ?, odds = ? WHERE id = ?";
-		CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+		G_DBPrepare (db, sql, & stmt);
 		CALL_SQLITE (bind_double (stmt, 1, newElo));
 		CALL_SQLITE (bind_double (stmt, 2, odds));
 		CALL_SQLITE (bind_int (stmt, 3, id));
@@ -372,7 +920,7 @@ void UpdatePlayerRating(char *username, int type, qboolean winner, float newElo,
 			sql = "UPDATE LocalDuel SET winner_elo = ?, odds = ? WHERE type = ? AND winner = ? AND end_time = (SELECT MAX(end_time) FROM LocalDuel WHERE type = ? and winner = ?)";
 		else
 			sql = "UPDATE LocalDuel SET loser_elo = ?, odds = ? WHERE type = ? AND loser = ? AND end_time = (SELECT MAX(end_time) FROM LocalDuel WHERE type = ? and loser = ?)";
-		CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+		G_DBPrepare (db, sql, & stmt);
 		CALL_SQLITE (bind_double (stmt, 1, newElo));
 		CALL_SQLITE (bind_double (stmt, 2, odds));
 		CALL_SQLITE (bind_int (stmt, 3, type));
@@ -387,7 +935,7 @@ void UpdatePlayerRating(char *username, int type, qboolean winner, float newElo,
 		G_ErrorPrint("ERROR: SQL Update Failed (UpdatePlayerRating)", s);
 	}
 
-	CALL_SQLITE (finalize(stmt));
+	G_DBFinalize (stmt);
 }
 
 int GetEloKValue(int numDuels) { //Also take rank into account
@@ -416,16 +964,13 @@ int GetEloKValue(int numDuels) { //Also take rank into account
 	return k3;
 }
 
-void G_AddDuelToDB(char *winner, char *loser, int type, int duration, int winner_hp, int winner_shield, int end_time) {
-	sqlite3 * db;
+void G_AddDuelToDB(char *winner, char *loser, int type, int duration, int winner_hp, int winner_shield, int end_time, sqlite3 *db) {
     char * sql;
     sqlite3_stmt * stmt;
 	int s;
 
-	CALL_SQLITE (open (LOCAL_DB_PATH, & db));
-
 	sql = "INSERT INTO LocalDuel(winner, loser, duration, type, winner_hp, winner_shield, end_time, winner_elo, loser_elo, odds) VALUES (?, ?, ?, ?, ?, ?, ?, -999, -999, 0)";
-	CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+	G_DBPrepare (db, sql, & stmt);
 	CALL_SQLITE (bind_text (stmt, 1, winner, -1, SQLITE_STATIC));
 	CALL_SQLITE (bind_text (stmt, 2, loser, -1, SQLITE_STATIC));
 	CALL_SQLITE (bind_int (stmt, 3, duration));
@@ -438,9 +983,7 @@ void G_AddDuelToDB(char *winner, char *loser, int type, int duration, int winner
 		G_ErrorPrint("ERROR: SQL Insert Failed (G_AddDuelToDB)", s);
 	}
 
-	CALL_SQLITE (finalize(stmt));
-
-	CALL_SQLITE (close(db));
+	G_DBFinalize (stmt);
 }
 
 void G_AddDuelElo(char *winner, char *loser, int type, int duration, int winner_hp, int winner_shield, int id, int end_time, sqlite3 *db) { //id and end_time are passed through if its a /rebuildElo 
@@ -532,7 +1075,7 @@ void G_AddDuelElo(char *winner, char *loser, int type, int duration, int winner_
 		newLoserElo = loserElo + loserK * (0 - expectedScoreLoser);
 
 	if (!id) { //We are not doing a rebuild, so add the duel here after we get the needed info
-		 G_AddDuelToDB(winner, loser, type, duration, winner_hp, winner_shield, end_time);
+		 G_AddDuelToDB(winner, loser, type, duration, winner_hp, winner_shield, end_time, db);
 	}
 
 	if (newWinnerElo != winnerElo) //Update winner elo
@@ -552,19 +1095,21 @@ void SV_RebuildElo_f() {
 	int s;
 	int time1 = trap->Milliseconds();
 
-	CALL_SQLITE (open (LOCAL_DB_PATH, & db));
+	G_DBFlush(); //Duels still waiting on the database thread have to be in before we replay them
+
+	G_DBOpen (& db);
 
 	sql = "UPDATE LocalDuel SET winner_elo = -999, loser_elo = -999, odds = 0";//Save rank into row - use null
     //sql = "DELETE FROM DuelRanks";
-    CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+    G_DBPrepare (db, sql, & stmt);
 	s = sqlite3_step(stmt);
 	if (s != SQLITE_DONE) {
 		G_ErrorPrint("ERROR: SQL Update Failed (SV_RebuildElo_f 1)", s);
 	}
-	CALL_SQLITE (finalize(stmt));
+	G_DBFinalize (stmt);
 
 	sql = "SELECT winner, loser, type, id, end_time from LocalDuel ORDER BY end_time ASC";
-	CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+	G_DBPrepare (db, sql, & stmt);
 	
     while (1) {
         s = sqlite3_step(stmt);
@@ -580,8 +1125,8 @@ void SV_RebuildElo_f() {
         }
     }
 	
-	CALL_SQLITE (finalize(stmt));
-	CALL_SQLITE (close(db));
+	G_DBFinalize (stmt);
+	G_DBClose (db);
 
 	Com_Printf("Duel ranks cleared in %i ms.\n", trap->Milliseconds() - time1);
 }
@@ -705,7 +1250,7 @@ void Cmd_DuelTop10_f(gentity_t *ent) {
 		int rank, count, TS, s, row = 1;
 		char msg[1024-128] = {0};
 
-		CALL_SQLITE (open (LOCAL_DB_PATH, & db));
+		G_DBOpen (& db);
 
 		//We dont need to select from loser since we know a users highscore will always be from a winning duel.  And we can ignore users who have never won a duel(?)
 		//How to get count?
@@ -725,7 +1270,7 @@ void Cmd_DuelTop10_f(gentity_t *ent) {
 			GROUP BY username ORDER BY rank DESC LIMIT 10";
 		*/
 
-		CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+		G_DBPrepare (db, sql, & stmt);
 		CALL_SQLITE (bind_int (stmt, 1, type));
 		CALL_SQLITE (bind_int (stmt, 2, type));
 		CALL_SQLITE (bind_int (stmt, 3, type));
@@ -765,14 +1310,13 @@ void Cmd_DuelTop10_f(gentity_t *ent) {
 			}
 		}
 
-		CALL_SQLITE (finalize(stmt));
-		CALL_SQLITE (close(db));
+		G_DBFinalize (stmt);
+		G_DBClose (db);
 	}
 }
 #endif
 
 void G_AddDuel(char *winner, char *loser, int start_time, int type, int winner_hp, int winner_shield) {
-	sqlite3 * db;
 	time_t	rawtime;
 	char	string[256] = {0};
 	const int duration = start_time ? (level.time - start_time) : 0;
@@ -788,10 +1332,18 @@ void G_AddDuel(char *winner, char *loser, int start_time, int type, int winner_h
 	//Might want to make this log to file, and have that sent to db on map change.  But whatever.. duel finishes are not as frequent as race course finishes usually.
 
 #if _ELORANKING	
-	if (g_eloRanking.integer) {
-		CALL_SQLITE (open (LOCAL_DB_PATH, & db));
-		G_AddDuelElo(winner, loser, type, duration, winner_hp, winner_shield, 0, rawtime, db);
-		CALL_SQLITE (close(db));
+	if (g_eloRanking.integer) { //Elo needs a few queries, let the database thread do it
+		dbJob_t job;
+
+		job.type = DBJOB_DUEL;
+		Q_strncpyz(job.u.duel.winner, winner, sizeof(job.u.duel.winner));
+		Q_strncpyz(job.u.duel.loser, loser, sizeof(job.u.duel.loser));
+		job.u.duel.type = type;
+		job.u.duel.duration = duration;
+		job.u.duel.winner_hp = winner_hp;
+		job.u.duel.winner_shield = winner_shield;
+		job.u.duel.end_time = rawtime;
+		G_DBQueueJob(&job);
 	}
 #endif
 
@@ -847,10 +1399,10 @@ void G_AddToDBFromFile(void) { //loda fixme, we can filter out the slower times
 	buf[fLen] = 0;
 	trap->FS_Close(f);
 	
-	CALL_SQLITE (open (LOCAL_DB_PATH, & db));
+	G_DBOpen (& db);
 	sql = "INSERT INTO LocalRun (username, coursename, duration_ms, topspeed, average, style, end_time) VALUES (?, ?, ?, ?, ?, ?, ?)";	 //loda fixme, make multiple?
 
-	CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+	G_DBPrepare (db, sql, & stmt);
 
 	//Todo: make TempRaceRecord an array of structs instead, maybe like 32 long idk, and build a query to insert 32 at a time or something.. instead of 1 by 1
 	pch = strtok (buf,";\n");
@@ -939,8 +1491,8 @@ void G_AddToDBFromFile(void) { //loda fixme, we can filter out the slower times
 		good = qtrue;
 	}
 
-	CALL_SQLITE (finalize(stmt));
-	CALL_SQLITE (close(db));	
+	G_DBFinalize (stmt);
+	G_DBClose (db);	
 
 	if (good) { //dont delete tmp file if mysql database is not responding 
 		trap->FS_Open(TEMP_RACE_LOG, &f, FS_WRITE);
@@ -1042,10 +1594,10 @@ void CleanupLocalRun() { //This should never actually change anything since we i
     sqlite3_stmt * stmt;
 	int s;
 
-	CALL_SQLITE (open (LOCAL_DB_PATH, & db));
+	G_DBOpen (& db);
 
 	sql = "DELETE FROM LocalRun WHERE id NOT IN (SELECT id FROM (SELECT id, coursename, username, style, season FROM LocalRun ORDER BY duration_ms DESC) AS T GROUP BY T.username, T.coursename, T.style, T.season)";
-	CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+	G_DBPrepare (db, sql, & stmt);
 	//Print to textfile what got deleted since this should never happen? failRaceLog
 
 	s = sqlite3_step(stmt);
@@ -1054,8 +1606,8 @@ void CleanupLocalRun() { //This should never actually change anything since we i
 	else 
 		G_ErrorPrint("ERROR: SQL Delete Failed (CleanupLocalRun)", s);
 
-	CALL_SQLITE (finalize(stmt));
-	CALL_SQLITE (close(db));
+	G_DBFinalize (stmt);
+	G_DBClose (db);
 
 	//DebugWriteToDB("CleanupLocalRun");
 }
@@ -1074,7 +1626,7 @@ void G_GetRaceScore(int id, char *username, char *coursename, int style, int sea
 	//Get season count and global count of races on specified course/style
 	sql = "SELECT COUNT(*) FROM LocalRun WHERE coursename = ? AND style = ? AND season = ? "
 		"UNION ALL SELECT COUNT(DISTINCT username) FROM LocalRun WHERE coursename = ? AND style = ?";//Select count for that course,style
-	CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+	G_DBPrepare (db, sql, & stmt);
 	CALL_SQLITE (bind_text (stmt, 1, coursename, -1, SQLITE_STATIC));
 	CALL_SQLITE (bind_int (stmt, 2, style));
 	CALL_SQLITE (bind_int (stmt, 3, season));
@@ -1094,11 +1646,11 @@ void G_GetRaceScore(int id, char *username, char *coursename, int style, int sea
 	else if (s != SQLITE_DONE) {
 		G_ErrorPrint("ERROR: SQL Select Failed (G_GetRaceScore 2)", s);
 	}
-	CALL_SQLITE (finalize(stmt));
+	G_DBFinalize (stmt);
 
 	//Get season rank
 	sql = "SELECT id FROM LocalRun WHERE coursename = ? AND style = ? AND season = ? ORDER BY duration_ms ASC, end_time ASC"; //assume just one per person to speed this up..
-	CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+	G_DBPrepare (db, sql, & stmt);
 	CALL_SQLITE (bind_text (stmt, 1, coursename, -1, SQLITE_STATIC));
 	CALL_SQLITE (bind_int (stmt, 2, style));
 	CALL_SQLITE (bind_int (stmt, 3, season));
@@ -1118,14 +1670,14 @@ void G_GetRaceScore(int id, char *username, char *coursename, int style, int sea
 			break;
         }
     }
-	CALL_SQLITE (finalize(stmt));
+	G_DBFinalize (stmt);
 
 	i = 1; // AH HA ha
 
 	//can we index on duration_ms ?
 	//Get global rank - if its a season PB but not a global PB, leave global rank at 0
 	sql = "SELECT id, MIN(duration_ms) AS duration FROM LocalRun WHERE coursename = ? AND style = ? GROUP BY username ORDER BY duration ASC, end_time ASC"; 
-	CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+	G_DBPrepare (db, sql, & stmt);
 	CALL_SQLITE (bind_text (stmt, 1, coursename, -1, SQLITE_STATIC));
 	CALL_SQLITE (bind_int (stmt, 2, style));
     while (1) {
@@ -1144,11 +1696,11 @@ void G_GetRaceScore(int id, char *username, char *coursename, int style, int sea
 			break;
         }
     }
-	CALL_SQLITE (finalize(stmt));
+	G_DBFinalize (stmt);
 	
 	//Save rank into row
 	sql = "UPDATE LocalRun SET rank = ?, entries = ?, season_rank = ?, season_entries = ?, last_update = ? WHERE id = ?";
-	CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+	G_DBPrepare (db, sql, & stmt);
 	CALL_SQLITE (bind_int (stmt, 1, global_rank));
 	CALL_SQLITE (bind_int (stmt, 2, global_count));
 	CALL_SQLITE (bind_int (stmt, 3, season_rank));
@@ -1158,7 +1710,7 @@ void G_GetRaceScore(int id, char *username, char *coursename, int style, int sea
 	s = sqlite3_step(stmt);
 	if (s != SQLITE_DONE)
 		G_ErrorPrint("ERROR: SQL Update Failed (G_GetRaceScore 5)", s);
-	CALL_SQLITE (finalize(stmt));
+	G_DBFinalize (stmt);
 
 }
 #endif
@@ -1173,7 +1725,7 @@ void G_GetRaceScore(int id, char *username, char *coursename, int style, int sea
 
 	//Get season rank
 	sql = "SELECT id, duration_ms FROM LocalRun WHERE coursename = ? AND style = ? AND season = ? ORDER BY duration_ms ASC, end_time ASC, average DESC"; //assume just one per person to speed this up..
-	CALL_SQLITE(prepare_v2(db, sql, strlen(sql) + 1, &stmt, NULL));
+	G_DBPrepare (db, sql, & stmt);
 	CALL_SQLITE(bind_text(stmt, 1, coursename, -1, SQLITE_STATIC));
 	CALL_SQLITE(bind_int(stmt, 2, style));
 	CALL_SQLITE(bind_int(stmt, 3, season));
@@ -1200,7 +1752,7 @@ void G_GetRaceScore(int id, char *username, char *coursename, int style, int sea
 			break;
 		}
 	}
-	CALL_SQLITE(finalize(stmt));
+	G_DBFinalize (stmt);
 
 	i = 1; // AH HA ha
 	lastDuration = 0;
@@ -1210,7 +1762,7 @@ void G_GetRaceScore(int id, char *username, char *coursename, int style, int sea
 	//don't do this if it's invalid?
 	if (!invalid) {
 		sql = "SELECT id, MIN(duration_ms) AS duration FROM LocalRun WHERE coursename = ? AND style = ? AND invalid = 0 GROUP BY username ORDER BY duration ASC, end_time ASC, average DESC";
-		CALL_SQLITE(prepare_v2(db, sql, strlen(sql) + 1, &stmt, NULL));
+		G_DBPrepare (db, sql, & stmt);
 		CALL_SQLITE(bind_text(stmt, 1, coursename, -1, SQLITE_STATIC));
 		CALL_SQLITE(bind_int(stmt, 2, style));
 		while (1) {
@@ -1237,12 +1789,12 @@ void G_GetRaceScore(int id, char *username, char *coursename, int style, int sea
 				break;
 			}
 		}
-		CALL_SQLITE(finalize(stmt));
+		G_DBFinalize (stmt);
 	}
 
 	//Save rank into row
 	sql = "UPDATE LocalRun SET rank = ?, entries = ?, season_rank = ?, season_entries = ?, last_update = ? WHERE id = ?";
-	CALL_SQLITE(prepare_v2(db, sql, strlen(sql) + 1, &stmt, NULL));
+	G_DBPrepare (db, sql, & stmt);
 	CALL_SQLITE(bind_int(stmt, 1, global_rank));
 	CALL_SQLITE(bind_int(stmt, 2, global_count));
 	CALL_SQLITE(bind_int(stmt, 3, season_rank));
@@ -1252,7 +1804,7 @@ void G_GetRaceScore(int id, char *username, char *coursename, int style, int sea
 	s = sqlite3_step(stmt);
 	if (s != SQLITE_DONE)
 		G_ErrorPrint("ERROR: SQL Update Failed (G_GetRaceScore 5)", s);
-	CALL_SQLITE(finalize(stmt));
+	G_DBFinalize (stmt);
 
 }
 
@@ -1269,10 +1821,10 @@ void SV_RebuildRaceRanks_f(void) {
 
 	CleanupLocalRun();//Make sure no duplicate entries
 
-	CALL_SQLITE (open (LOCAL_DB_PATH, & db)); 
+	G_DBOpen (& db); 
 
 	sql = "SELECT id, username, coursename, style, season FROM LocalRun ORDER BY end_time ASC";
-	CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+	G_DBPrepare (db, sql, & stmt);
     while (1) {
         s = sqlite3_step(stmt);
         if (s == SQLITE_ROW) {
@@ -1286,9 +1838,9 @@ void SV_RebuildRaceRanks_f(void) {
 			break;
         }
     }
-	CALL_SQLITE (finalize(stmt));
+	G_DBFinalize (stmt);
 
-	CALL_SQLITE (close(db));
+	G_DBClose (db);
 
 }
 #endif
@@ -1305,7 +1857,7 @@ void SV_RebuildRaceRanks_f(void) {
 
 	CleanupLocalRun();//Make sure no duplicate entries
 
-	CALL_SQLITE(open(LOCAL_DB_PATH, &db));
+	G_DBOpen (& db);
 	
 	//This doesn't have to be ordered at all does it?
 	//also select invalid, pass thru to get racescore, and skip global rank calc if its invalid
@@ -1317,7 +1869,7 @@ void SV_RebuildRaceRanks_f(void) {
 		"LEFT JOIN "
 		"(SELECT coursename, style, COUNT(DISTINCT username) AS global_count FROM LocalRun GROUP BY coursename, style) AS LR3 "
 		"ON LR1.style = LR3.style AND LR1.coursename = LR3.coursename";
-	CALL_SQLITE(prepare_v2(db, sql, strlen(sql) + 1, &stmt, NULL));
+	G_DBPrepare (db, sql, & stmt);
 	while (1) {
 		s = sqlite3_step(stmt);
 		if (s == SQLITE_ROW) {
@@ -1333,9 +1885,9 @@ void SV_RebuildRaceRanks_f(void) {
 			break;
 		}
 	}
-	CALL_SQLITE(finalize(stmt));
+	G_DBFinalize (stmt);
 
-	CALL_SQLITE(close(db));
+	G_DBClose (db);
 
 }
 
@@ -1343,11 +1895,12 @@ static QINLINE int G_GetSeason(void) {
 	return 6;
 }
 
-static void G_UpdateOurLocalRun(sqlite3 * db, int seasonOldRank_self, int seasonNewRank_self, int globalOldRank_self, int globalNewRank_self, int style_self, char *username_self, char *coursename_self, 
+static qboolean G_UpdateOurLocalRun(sqlite3 * db, int seasonOldRank_self, int seasonNewRank_self, int globalOldRank_self, int globalNewRank_self, int style_self, char *username_self, char *coursename_self, 
 	int duration_ms_self, int topspeed_self, int average_self, int end_time_self, int seasonCount, int globalCount) {
 	char * sql;
 	sqlite3_stmt * stmt;
 	int s;
+	qboolean ok = qtrue;
 	const int season = G_GetSeason();
 
 	//Get count
@@ -1357,7 +1910,7 @@ static void G_UpdateOurLocalRun(sqlite3 * db, int seasonOldRank_self, int season
 	//This also needs to update lastupdatetime for the website!
 	if (globalNewRank_self && globalOldRank_self) { //And globalOldRankSelf ? - We dont want to update other rows if we dont have any other rows
 		sql = "UPDATE LocalRun SET rank = 0, last_update = ? WHERE username = ? AND coursename = ? AND style = ?";
-		CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+		G_DBPrepare (db, sql, & stmt);
 		CALL_SQLITE (bind_int (stmt, 1, end_time_self));
 		CALL_SQLITE (bind_text (stmt, 2, username_self, -1, SQLITE_STATIC));
 		CALL_SQLITE (bind_text (stmt, 3, coursename_self, -1, SQLITE_STATIC));
@@ -1366,12 +1919,12 @@ static void G_UpdateOurLocalRun(sqlite3 * db, int seasonOldRank_self, int season
 		if (s != SQLITE_DONE) {
 			G_ErrorPrint("ERROR: SQL Update Failed (G_UpdateOurLocalRun 1)", s);
 		}
-		CALL_SQLITE (finalize(stmt));
+		G_DBFinalize (stmt);
 	}
 
 	if (seasonOldRank_self == -1) { //First attempt of the season
 		sql = "INSERT INTO LocalRun (username, coursename, duration_ms, topspeed, average, style, season, end_time, rank, entries, season_rank, season_entries, last_update, invalid) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, 0)";
-		CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+		G_DBPrepare (db, sql, & stmt);
 		CALL_SQLITE (bind_text (stmt, 1, username_self, -1, SQLITE_STATIC));
 		CALL_SQLITE (bind_text (stmt, 2, coursename_self, -1, SQLITE_STATIC));
 		CALL_SQLITE (bind_int (stmt, 3, duration_ms_self));
@@ -1386,19 +1939,15 @@ static void G_UpdateOurLocalRun(sqlite3 * db, int seasonOldRank_self, int season
 		CALL_SQLITE (bind_int (stmt, 12, seasonCount));
 		CALL_SQLITE (bind_int (stmt, 13, end_time_self));
 		s = sqlite3_step(stmt);
-		if (s != SQLITE_DONE) {
-			char string[1024] = {0};
-
-			Com_sprintf(string, sizeof(string), "%s;%s;%i;%i;%i;%i;%i;%i\n", username_self, coursename_self, duration_ms_self, topspeed_self, average_self, style_self, season, end_time_self);
-			trap->FS_Write( string, strlen( string ), level.failRaceLog );
-
+		if (s != SQLITE_DONE) { //Caller logs it to failRaceLog so it can be added back later
 			G_ErrorPrint("ERROR: SQL Insert Failed (G_UpdateOurLocalRun 2)", s);
+			ok = qfalse;
 		}
-		CALL_SQLITE (finalize(stmt));
+		G_DBFinalize (stmt);
 	}
 	else {
 		sql = "UPDATE LocalRun SET duration_ms = ?, topspeed = ?, average = ?, end_time = ?, rank = ?, season_rank = ?, last_update = ?, invalid = 0 WHERE username = ? AND coursename = ? AND style = ? AND season = ?";
-		CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+		G_DBPrepare (db, sql, & stmt);
 		CALL_SQLITE (bind_int (stmt, 1, duration_ms_self));
 		CALL_SQLITE (bind_int (stmt, 2, topspeed_self));
 		CALL_SQLITE (bind_int (stmt, 3, average_self));
@@ -1411,17 +1960,14 @@ static void G_UpdateOurLocalRun(sqlite3 * db, int seasonOldRank_self, int season
 		CALL_SQLITE (bind_int (stmt, 10, style_self));
 		CALL_SQLITE (bind_int (stmt, 11, season));
 		s = sqlite3_step(stmt);
-		if (s != SQLITE_DONE) {
-			char string[1024] = {0};
-
-			Com_sprintf(string, sizeof(string), "%s;%s;%i;%i;%i;%i;%i;%i\n", username_self, coursename_self, duration_ms_self, topspeed_self, average_self, style_self, season, end_time_self);
-			trap->FS_Write( string, strlen( string ), level.failRaceLog );
-
+		if (s != SQLITE_DONE) { //Caller logs it to failRaceLog so it can be added back later
 			G_ErrorPrint("ERROR: SQL Update Failed (G_UpdateOurLocalRun 3)", s);
+			ok = qfalse;
 		}
-		CALL_SQLITE (finalize(stmt));
+		G_DBFinalize (stmt);
 	}
 
+	return ok;
 }
 
 static void G_UpdateOtherLocalRun(sqlite3 * db, int seasonNewRank_self, int seasonOldRank_self, int globalNewRank_self, int globalOldRank_self, int style_self, char *coursename_self, int time) {
@@ -1437,7 +1983,7 @@ static void G_UpdateOtherLocalRun(sqlite3 * db, int seasonNewRank_self, int seas
 	else
 		sql = "UPDATE LocalRun SET season_rank = season_rank + 1, last_update = ? WHERE coursename = ? and style = ? AND season = ? AND season_rank >= ? AND season_rank < ?";
 
-	CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+	G_DBPrepare (db, sql, & stmt);
 	CALL_SQLITE (bind_int (stmt, 1, time));
 	CALL_SQLITE (bind_text (stmt, 2, coursename_self, -1, SQLITE_STATIC));
 	CALL_SQLITE (bind_int (stmt, 3, style_self));
@@ -1451,7 +1997,7 @@ static void G_UpdateOtherLocalRun(sqlite3 * db, int seasonNewRank_self, int seas
 	if (s != SQLITE_DONE) {
 		G_ErrorPrint("ERROR: SQL Update Failed (G_UpdateOtherLocalRun)", s);
 	}
-	CALL_SQLITE (finalize(stmt));
+	G_DBFinalize (stmt);
 
 	//Should not care about what season we update if its a global pb ?
 	if (globalNewRank_self) { //Dont update other peoples global ranks if our run was not a global personal best...
@@ -1460,7 +2006,7 @@ static void G_UpdateOtherLocalRun(sqlite3 * db, int seasonNewRank_self, int seas
 		else
 			sql = "UPDATE LocalRun SET rank = rank + 1, last_update = ? WHERE coursename = ? and style = ? AND rank >= ? AND rank < ?";
 
-		CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+		G_DBPrepare (db, sql, & stmt);
 		CALL_SQLITE (bind_int (stmt, 1, time));
 		CALL_SQLITE (bind_text (stmt, 2, coursename_self, -1, SQLITE_STATIC));
 		CALL_SQLITE (bind_int (stmt, 3, style_self));
@@ -1473,14 +2019,14 @@ static void G_UpdateOtherLocalRun(sqlite3 * db, int seasonNewRank_self, int seas
 		if (s != SQLITE_DONE) {
 			G_ErrorPrint("ERROR: SQL Update Failed (G_UpdateOtherLocalRun 2)", s);
 		}
-		CALL_SQLITE (finalize(stmt));
+		G_DBFinalize (stmt);
 	}
 
 	//loda this can be combined with above query probably
 	if (seasonOldRank_self == -1) { //First attempt  
 		sql = "UPDATE LocalRun SET season_entries = season_entries + 1, last_update = ? WHERE coursename = ? AND style = ? AND season = ?";
 	//+1 count for all, +1 rank only if affected
-		CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+		G_DBPrepare (db, sql, & stmt);
 		CALL_SQLITE (bind_int (stmt, 1, time));
 		CALL_SQLITE (bind_text (stmt, 2, coursename_self, -1, SQLITE_STATIC));
 		CALL_SQLITE (bind_int (stmt, 3, style_self));
@@ -1490,14 +2036,14 @@ static void G_UpdateOtherLocalRun(sqlite3 * db, int seasonNewRank_self, int seas
 		if (s != SQLITE_DONE) {
 			G_ErrorPrint("ERROR: SQL Update Failed (G_UpdateOtherLocalRun 3)", s);
 		}
-		CALL_SQLITE (finalize(stmt));
+		G_DBFinalize (stmt);
 	}
 
 
 	if (globalOldRank_self == -1) { //First attempt  
 		sql = "UPDATE LocalRun SET entries = entries + 1, last_update = ? WHERE coursename = ? AND style = ?";
 	//+1 count for all, +1 rank only if affected
-		CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+		G_DBPrepare (db, sql, & stmt);
 		CALL_SQLITE (bind_int (stmt, 1, time));
 		CALL_SQLITE (bind_text (stmt, 2, coursename_self, -1, SQLITE_STATIC));
 		CALL_SQLITE (bind_int (stmt, 3, style_self));
@@ -1506,7 +2052,7 @@ static void G_UpdateOtherLocalRun(sqlite3 * db, int seasonNewRank_self, int seas
 		if (s != SQLITE_DONE) {
 			G_ErrorPrint("ERROR: SQL Update Failed (G_UpdateOtherLocalRun 4)", s);
 		}
-		CALL_SQLITE (finalize(stmt));
+		G_DBFinalize (stmt);
 	}
 
 }
@@ -1654,15 +2200,19 @@ void G_UpdatePlaytime(sqlite3 *db, char *username, int seconds ) {
 	char * sql;
 	sqlite3_stmt * stmt;
 	int s;
-	qboolean newDB = qfalse;
 
-	if (!db) {
-		CALL_SQLITE (open (LOCAL_DB_PATH, & db)); 
-		newDB = qtrue;
+	if (!db) { //Called from the game, let the database thread write it
+		dbJob_t job;
+
+		job.type = DBJOB_PLAYTIME;
+		Q_strncpyz(job.u.playtime.username, username, sizeof(job.u.playtime.username));
+		job.u.playtime.seconds = seconds;
+		G_DBQueueJob(&job);
+		return;
 	}
-	
+
 	sql = "UPDATE LocalAccount SET racetime = racetime + ? WHERE username = ?";
-	CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+	G_DBPrepare (db, sql, & stmt);
 	CALL_SQLITE (bind_int (stmt, 1, seconds));
 	CALL_SQLITE (bind_text (stmt, 2, username, -1, SQLITE_STATIC));
 
@@ -1671,13 +2221,10 @@ void G_UpdatePlaytime(sqlite3 *db, char *username, int seconds ) {
 		G_ErrorPrint("ERROR: SQL Update Failed (G_UpdatePlaytime)", s);
 	}
 
-	CALL_SQLITE (finalize(stmt));
-	if (newDB) {
-		CALL_SQLITE (close(db));
-	}
+	G_DBFinalize (stmt);
 }
 
-void G_UpdateUnlocks(char *username, char *coursename, int style, int duration_ms, gclient_t *client, sqlite3 *db) { //Combine with update playtime i think, to reduce queries.  Update playtime is done after course completion..?
+static unsigned int G_GetUnlocks(char *coursename, int style, int duration_ms, gclient_t *client) {
 	//If its a cumulative award or something, we can check if current race is any of the conditions, then sql check inside to see if all the other conditions are met
 	//Or, just make it cumulative when we check ValidateCosmetics, i guess thats better?
 	unsigned int unlock = 0;
@@ -1695,22 +2242,32 @@ void G_UpdateUnlocks(char *username, char *coursename, int style, int duration_m
 		}
 	}
 
-	if (unlock) {
-		char * sql;
-		sqlite3_stmt * stmt;
-		int s;
+	return unlock;
+}
 
-		sql = "UPDATE LocalAccount SET unlocks = unlocks | ? WHERE username = ?";
-		CALL_SQLITE(prepare_v2(db, sql, strlen(sql) + 1, &stmt, NULL));
-		CALL_SQLITE(bind_int(stmt, 1, unlock));
-		CALL_SQLITE(bind_text(stmt, 2, username, -1, SQLITE_STATIC));
+static void G_WriteUnlocks(char *username, unsigned int unlock, sqlite3 *db) { //Safe from the database thread, does not touch the client
+	char * sql;
+	sqlite3_stmt * stmt;
+	int s;
 
-		s = sqlite3_step(stmt);
-		if (s != SQLITE_DONE) {
-			G_ErrorPrint("ERROR: SQL Update Failed (G_UpdateUnlocks)", s);
-		}
+	sql = "UPDATE LocalAccount SET unlocks = unlocks | ? WHERE username = ?";
+	G_DBPrepare (db, sql, & stmt);
+	CALL_SQLITE(bind_int(stmt, 1, unlock));
+	CALL_SQLITE(bind_text(stmt, 2, username, -1, SQLITE_STATIC));
 
-		CALL_SQLITE(finalize(stmt));
+	s = sqlite3_step(stmt);
+	if (s != SQLITE_DONE) {
+		G_ErrorPrint("ERROR: SQL Update Failed (G_UpdateUnlocks)", s);
+	}
+
+	G_DBFinalize (stmt);
+}
+
+void G_UpdateUnlocks(char *username, char *coursename, int style, int duration_ms, gclient_t *client, sqlite3 *db) { //Combine with update playtime i think, to reduce queries.  Update playtime is done after course completion..?
+	const unsigned int unlock = G_GetUnlocks(coursename, style, duration_ms, client);
+
+	if (unlock) {
+		G_WriteUnlocks(username, unlock, db);
 
 		if (client)//Also update in realtime if possible.
 			client->pers.unlocks |= unlock;
@@ -1773,18 +2330,20 @@ void SV_RebuildUnlocks_f(void) {
 	memset(cosmeticUnlocks, 0, sizeof(cosmeticUnlocks));
 	G_SpawnCosmeticUnlocks();//Re Spawn from CFG
 
-	CALL_SQLITE(open(LOCAL_DB_PATH, &db));
+	G_DBFlush(); //Races still waiting on the database thread have to be in before we rebuild
+
+	G_DBOpen (& db);
 
 	//Set all unlocks to 0 ?
 	sql = "UPDATE LocalAccount SET unlocks = 0"; //Only get username for cumulative checks if needed
-	CALL_SQLITE(prepare_v2(db, sql, strlen(sql) + 1, &stmt, NULL));
+	G_DBPrepare (db, sql, & stmt);
 	s = sqlite3_step(stmt);
 	if (s != SQLITE_DONE)
 		G_ErrorPrint("ERROR: SQL Update Failed (SV_RebuildUnlocks_f 1)", s);
-	CALL_SQLITE(finalize(stmt));
+	G_DBFinalize (stmt);
 
 	sql = "SELECT username, coursename, style, duration_ms FROM LocalRun"; //Only get username for cumulative checks if needed
-	CALL_SQLITE(prepare_v2(db, sql, strlen(sql) + 1, &stmt, NULL));
+	G_DBPrepare (db, sql, & stmt);
 	while (1) {
 		s = sqlite3_step(stmt);
 		if (s == SQLITE_ROW) {
@@ -1797,58 +2356,281 @@ void SV_RebuildUnlocks_f(void) {
 			break;
 		}
 	}
-	CALL_SQLITE(finalize(stmt));
+	G_DBFinalize (stmt);
 
-	CALL_SQLITE(close(db));
+	G_DBClose (db);
 }
 
-void StripWhitespace(char *s);
-void G_AddRaceTime(char *username, char *message, int duration_ms, int style, int topspeed, int average, int clientNum, int awesomenoise, int worldrecordnoise) {//should be short.. but have to change elsewhere? is it worth it?
-	time_t	rawtime;
-	char	string[1024] = {0}, info[1024] = {0}, coursename[40], timeStr[32] = {0}, styleString[32] = {0};
-	qboolean seasonPB = qfalse, globalPB = qfalse;//, WR = qfalse;
+/*
+=============================================================================
+
+RACE BOARDS
+
+rTop and rFind answer from the sorted boards in g_leaderboard.c.  A board
+is read from LocalRun the first time its course, style and season is asked
+for, and G_FinishRaceJob keeps it current after that, so only the first
+lookup of a board each map touches the database.
+
+=============================================================================
+*/
+
+#define MAX_RACE_BOARDS			256
+#define MAX_COURSE_NAME_CACHE	32
+
+typedef struct courseNameCache_s {
+	qboolean		ignoreSpaces;
+	char			partial[40];
+	char			full[40];
+} courseNameCache_t;
+
+static raceBoard_t			*raceBoards[MAX_RACE_BOARDS];
+static int					numRaceBoards, raceBoardCounter;
+static courseNameCache_t	courseNameCache[MAX_COURSE_NAME_CACHE];
+static int					numCourseNames, nextCourseName;
+
+/*
+==================
+G_RaceBoardsClear
+
+Drops every board, for anything that rewrites LocalRun behind their back
+==================
+*/
+void G_RaceBoardsClear( void ) {
+	int i;
+
+	for ( i = 0; i < numRaceBoards; i++ ) {
+		G_BoardFree( raceBoards[i] );
+		free( raceBoards[i] );
+	}
+	numRaceBoards = 0;
+	numCourseNames = nextCourseName = 0;
+}
+
+static raceBoard_t *G_FindRaceBoard( const char *coursename, int style, int season ) {
+	int i;
+
+	for ( i = 0; i < numRaceBoards; i++ ) {
+		raceBoard_t *board = raceBoards[i];
+
+		if ( board->style == style && board->season == season && !strcmp( board->coursename, coursename ) ) {
+			board->lastUsed = ++raceBoardCounter;
+			return board;
+		}
+	}
+	return NULL;
+}
+
+static void G_DropRaceBoard( raceBoard_t *board ) {
+	int i;
+
+	for ( i = 0; i < numRaceBoards; i++ ) {
+		if ( raceBoards[i] == board ) {
+			raceBoards[i] = raceBoards[--numRaceBoards];
+			break;
+		}
+	}
+	G_BoardFree( board );
+	free( board );
+}
+
+static raceBoard_t *G_GetRaceBoard( const char *coursename, int style, int season ) {
 	sqlite3 * db;
 	char * sql;
 	sqlite3_stmt * stmt;
-	int s;
-	int season_oldBest, season_oldRank = 0, season_newRank = -1, global_oldBest, global_oldRank = 0, global_newRank = -1; //Changed newrank to be -1 ??
-	float addedScore = 0.0f;
-	gclient_t	*cl;
-	const int season = G_GetSeason();
+	int s, i, numRows = 0, maxRows = 0;
+	raceEntry_t *rows = NULL;
+	raceBoard_t *board = G_FindRaceBoard( coursename, style, season );
 
-	cl = &level.clients[clientNum];
+	if ( board )
+		return board;
 
-	time(&rawtime);
-	localtime(&rawtime);
+	G_DBOpen (& db);
+	if ( season == -1 )
+		sql = "SELECT username, MIN(duration_ms), topspeed, average, end_time FROM LocalRun WHERE coursename = ? AND style = ? AND invalid = 0 GROUP BY username";
+	else
+		sql = "SELECT username, MIN(duration_ms), topspeed, average, end_time FROM LocalRun WHERE coursename = ? AND style = ? AND season = ? GROUP BY username";
+	G_DBPrepare (db, sql, & stmt);
+	CALL_SQLITE (bind_text (stmt, 1, coursename, -1, SQLITE_STATIC));
+	CALL_SQLITE (bind_int (stmt, 2, style));
+	if ( season != -1 )
+		CALL_SQLITE (bind_int (stmt, 3, season));
+
+	while ( 1 ) {
+		s = sqlite3_step( stmt );
+		if ( s == SQLITE_ROW ) {
+			raceEntry_t *row;
+
+			if ( numRows == maxRows ) {
+				raceEntry_t *newRows;
+
+				maxRows = maxRows ? maxRows * 2 : 256;
+				newRows = (raceEntry_t *)realloc( rows, maxRows * sizeof( raceEntry_t ) );
+				if ( !newRows ) {
+					G_ErrorPrint( "ERROR: Out of memory (G_GetRaceBoard)", numRows );
+					G_DBFinalize (stmt);
+					G_DBClose (db);
+					free( rows );
+					return NULL;
+				}
+				rows = newRows;
+			}
+			row = &rows[numRows++];
+			Q_strncpyz( row->username, (char*)sqlite3_column_text( stmt, 0 ), sizeof( row->username ) );
+			row->duration_ms = sqlite3_column_int( stmt, 1 );
+			row->topspeed = sqlite3_column_int( stmt, 2 );
+			row->average = sqlite3_column_int( stmt, 3 );
+			row->end_time = sqlite3_column_int( stmt, 4 );
+		}
+		else if ( s == SQLITE_DONE )
+			break;
+		else {
+			G_ErrorPrint( "ERROR: SQL Select Failed (G_GetRaceBoard)", s );
+			G_DBFinalize (stmt);
+			G_DBClose (db);
+			free( rows );
+			return NULL;
+		}
+	}
+	G_DBFinalize (stmt);
+	G_DBClose (db);
 
-	trap->GetServerinfo(info, sizeof(info));
-	Q_strncpyz(coursename, Info_ValueForKey(info, "mapname"), sizeof(coursename));
+	if ( numRaceBoards == MAX_RACE_BOARDS ) { //Throw out the one nobody looked at for the longest
+		int oldest = 0;
 
-	if (message) {// [0]?
-		Q_strlwr(message);
-		Q_CleanStr(message);
-		Q_strcat(coursename, sizeof(coursename), va(" (%s)", message));
+		for ( i = 1; i < numRaceBoards; i++ ) {
+			if ( raceBoards[i]->lastUsed < raceBoards[oldest]->lastUsed )
+				oldest = i;
+		}
+		board = raceBoards[oldest];
+		G_BoardFree( board );
+		raceBoards[oldest] = raceBoards[--numRaceBoards];
+	}
+	else {
+		board = (raceBoard_t *)malloc( sizeof( raceBoard_t ) );
+		if ( !board ) {
+			G_ErrorPrint( "ERROR: Out of memory (G_GetRaceBoard)", numRows );
+			free( rows );
+			return NULL;
+		}
 	}
 
-	if (average > topspeed) {
-		average = topspeed; //need to sample speeds every clientframe.. but how to calculate average if client frames are not evenly spaced.. can use pml.msec ?
+	if ( !G_BoardInit( board, coursename, style, season ) || !G_BoardLoad( board, rows, numRows ) ) {
+		G_ErrorPrint( "ERROR: Out of memory (G_GetRaceBoard)", numRows );
+		G_BoardFree( board );
+		free( board );
+		free( rows );
+		return NULL;
 	}
+	free( rows );
 
-	Q_strlwr(coursename);
-	Q_CleanStr(coursename);
+	board->lastUsed = ++raceBoardCounter;
+	raceBoards[numRaceBoards++] = board;
+	return board;
+}
 
-	IntegerToRaceName(style, styleString, sizeof(styleString));
+/*
+==================
+G_RaceBoardsSubmit
 
-	Com_sprintf(string, sizeof(string), "%s;%s;%i;%i;%i;%i;%i\n", username, coursename, duration_ms, topspeed, average, style, rawtime);
+A run has been written, move it up on any board that is loaded
+==================
+*/
+static void G_RaceBoardsSubmit( const dbRaceJob_t *race ) {
+	raceBoard_t *board;
+	raceEntry_t run;
+	qboolean outOfMemory;
+
+	memset( &run, 0, sizeof( run ) );
+	Q_strncpyz( run.username, race->username, sizeof( run.username ) );
+	run.duration_ms = race->duration_ms;
+	run.topspeed = race->topspeed;
+	run.average = race->average;
+	run.end_time = race->end_time;
+
+	if ( race->seasonPB && ( board = G_FindRaceBoard( race->coursename, race->style, G_GetSeason() ) ) != NULL ) {
+		G_BoardSubmit( board, &run, &outOfMemory );
+		if ( outOfMemory ) //It would be missing this run, load it again next time
+			G_DropRaceBoard( board );
+	}
+	if ( race->globalPB && ( board = G_FindRaceBoard( race->coursename, race->style, -1 ) ) != NULL ) {
+		G_BoardSubmit( board, &run, &outOfMemory );
+		if ( outOfMemory )
+			G_DropRaceBoard( board );
+	}
+}
 
-	if (level.raceLog)
-		trap->FS_Write(string, strlen(string), level.raceLog); //Always write to text file races.log
+/*
+==================
+G_LookupCourseName
 
-	CALL_SQLITE(open(LOCAL_DB_PATH, &db));
+Expands a partial course name to the most run course containing it,
+remembering the answer for the map.  With ignoreSpaces the spaces in the
+course names are not matched against.
+==================
+*/
+static int G_LookupCourseName( qboolean ignoreSpaces, const char *partial, char *full, size_t fullSize ) {
+	sqlite3 * db;
+	char * sql;
+	sqlite3_stmt * stmt;
+	courseNameCache_t *cached;
+	int s, i;
+
+	for ( i = 0; i < numCourseNames; i++ ) {
+		if ( courseNameCache[i].ignoreSpaces == ignoreSpaces && !strcmp( courseNameCache[i].partial, partial ) ) {
+			Q_strncpyz( full, courseNameCache[i].full, fullSize );
+			return SQLITE_ROW;
+		}
+	}
+
+	if ( ignoreSpaces )
+		sql = "SELECT DISTINCT(coursename) FROM LocalRun WHERE instr(replace(coursename, ' ', ''), ?) > 0 ORDER BY entries DESC LIMIT 1";
+	else
+		sql = "SELECT DISTINCT(coursename) FROM LocalRun WHERE instr(coursename, ?) > 0 ORDER BY entries DESC LIMIT 1";
+
+	G_DBOpen (& db);
+	G_DBPrepare (db, sql, & stmt);
+	CALL_SQLITE (bind_text (stmt, 1, partial, -1, SQLITE_STATIC));
+	s = sqlite3_step(stmt);
+	if ( s == SQLITE_ROW ) {
+		//Check if it actually has text, if not return.  then we can use cheaper (MAX) entries query above //loda fixme
+		Q_strncpyz( full, (char*)sqlite3_column_text( stmt, 0 ), fullSize );
+
+		cached = &courseNameCache[nextCourseName]; //Overwrite the oldest once it's full
+		nextCourseName = ( nextCourseName + 1 ) % MAX_COURSE_NAME_CACHE;
+		if ( numCourseNames < MAX_COURSE_NAME_CACHE )
+			numCourseNames++;
+		cached->ignoreSpaces = ignoreSpaces;
+		Q_strncpyz( cached->partial, partial, sizeof( cached->partial ) );
+		Q_strncpyz( cached->full, full, sizeof( cached->full ) );
+	}
+	G_DBFinalize (stmt);
+	G_DBClose (db);
+
+	return s;
+}
+
+void StripWhitespace(char *s);
+static void G_RunRaceJob(dbRaceJob_t *race, sqlite3 *db) { //Database thread, no trap calls in here
+	char * sql;
+	sqlite3_stmt * stmt;
+	int s;
+	int season_oldBest, season_oldRank = 0, season_newRank = -1, global_oldBest, global_oldRank = 0, global_newRank = -1; //Changed newrank to be -1 ??
+	qboolean seasonPB = qfalse, globalPB = qfalse;//, WR = qfalse;
+	float addedScore = 0.0f;
+	char *username = race->username, *coursename = race->coursename;
+	const int duration_ms = race->duration_ms, style = race->style, topspeed = race->topspeed, average = race->average, rawtime = race->end_time;
+	const int season = G_GetSeason();
+
+	//All or nothing, the ranks of everyone else on the course are shifted too
+	if (sqlite3_exec(db, "BEGIN IMMEDIATE", NULL, NULL, NULL) != SQLITE_OK) { //Busy past the timeout, writing now would autocommit each statement on its own
+		G_ErrorPrint("ERROR: SQL Begin Failed (G_AddRaceTime)", sqlite3_errcode(db));
+		race->writeFailed = qtrue;
+		return;
+	}
 
 	sql = "SELECT MIN(duration_ms), season_rank FROM LocalRun WHERE username = ? AND coursename = ? AND style = ? AND season = ? "
 		"UNION ALL SELECT MIN(duration_ms), rank FROM LocalRun WHERE username = ? AND coursename = ? AND style = ? AND invalid = 0";
-	CALL_SQLITE(prepare_v2(db, sql, strlen(sql) + 1, &stmt, NULL));
+	G_DBPrepare (db, sql, & stmt);
 	CALL_SQLITE(bind_text(stmt, 1, username, -1, SQLITE_STATIC));
 	CALL_SQLITE(bind_text(stmt, 2, coursename, -1, SQLITE_STATIC));
 	CALL_SQLITE(bind_int(stmt, 3, style));
@@ -1900,7 +2682,7 @@ void G_AddRaceTime(char *username, char *message, int duration_ms, int style, in
 	else if (s != SQLITE_DONE) {
 		G_ErrorPrint("ERROR: SQL Select Failed (G_AddRaceTime 2)", s);
 	}
-	CALL_SQLITE(finalize(stmt));
+	G_DBFinalize (stmt);
 
 
 	if (seasonPB) {
@@ -1910,7 +2692,7 @@ void G_AddRaceTime(char *username, char *message, int duration_ms, int style, in
 
 		sql = "SELECT COUNT(*) FROM LocalRun WHERE coursename = ? AND style = ? AND season = ? "
 			"UNION ALL SELECT COUNT(DISTINCT username) FROM LocalRun WHERE coursename = ? AND style = ? AND invalid = 0"; //entries ?
-		CALL_SQLITE(prepare_v2(db, sql, strlen(sql) + 1, &stmt, NULL));
+		G_DBPrepare (db, sql, & stmt);
 		CALL_SQLITE(bind_text(stmt, 1, coursename, -1, SQLITE_STATIC));
 		CALL_SQLITE(bind_int(stmt, 2, style));
 		CALL_SQLITE(bind_int(stmt, 3, season));
@@ -1932,11 +2714,11 @@ void G_AddRaceTime(char *username, char *message, int duration_ms, int style, in
 			G_ErrorPrint("ERROR: SQL Select Failed (G_AddRaceTime 4)", s);
 		}
 
-		CALL_SQLITE(finalize(stmt));
+		G_DBFinalize (stmt);
 
 		//Get season rank
 		sql = "SELECT duration_ms FROM LocalRun WHERE coursename = ? AND style = ? AND season = ? ORDER BY duration_ms ASC, end_time ASC, average DESC"; //assume just one per person to speed this up..
-		CALL_SQLITE(prepare_v2(db, sql, strlen(sql) + 1, &stmt, NULL));
+		G_DBPrepare (db, sql, & stmt);
 		CALL_SQLITE(bind_text(stmt, 1, coursename, -1, SQLITE_STATIC));
 		CALL_SQLITE(bind_int(stmt, 2, style));
 		CALL_SQLITE(bind_int(stmt, 3, season));
@@ -1965,14 +2747,14 @@ void G_AddRaceTime(char *username, char *message, int duration_ms, int style, in
 				break;
 			}
 		}
-		CALL_SQLITE(finalize(stmt));
+		G_DBFinalize (stmt);
 
 		i = 1; //oh no no
 		lastDuration = 0;
 
 		//Get global rank, could union this with previous query maybe
 		sql = "SELECT MIN(duration_ms) FROM LocalRun WHERE coursename = ? AND style = ? AND invalid = 0 GROUP BY username ORDER BY duration_ms ASC, end_time ASC, average DESC";
-		CALL_SQLITE(prepare_v2(db, sql, strlen(sql) + 1, &stmt, NULL));
+		G_DBPrepare (db, sql, & stmt);
 		CALL_SQLITE(bind_text(stmt, 1, coursename, -1, SQLITE_STATIC));
 		CALL_SQLITE(bind_int(stmt, 2, style));
 		while (1) {
@@ -2000,7 +2782,7 @@ void G_AddRaceTime(char *username, char *message, int duration_ms, int style, in
 				break;
 			}
 		}
-		CALL_SQLITE(finalize(stmt));
+		G_DBFinalize (stmt);
 
 		if (season_newRank == 0) { //We wern't faster than any times, so set our rank to count (+ 1) ? -- loda checkme
 			season_newRank = season_oldCount + 1;
@@ -2042,25 +2824,8 @@ void G_AddRaceTime(char *username, char *message, int duration_ms, int style, in
 				G_UpdateOtherLocalRun(db, season_newRank, season_oldRank, global_newRank, global_oldRank, style, coursename, rawtime); //Update other spots in race list
 			}
 		}
-		G_UpdateOurLocalRun(db, season_oldRank, season_newRank, global_oldRank, global_newRank, style, username, coursename, duration_ms, topspeed, average, rawtime, season_newCount, global_newCount);//Update our race list
-
-		if (cl->pers.recordingDemo && globalPB) {
-			char mapCourse[MAX_QPATH] = { 0 };
-
-			Q_strncpyz(mapCourse, coursename, sizeof(mapCourse));
-			StripWhitespace(mapCourse);
-			Q_strstrip(mapCourse, "\n\r;:.?*<>|\\/\"", NULL);
-
-			if (cl) {
-				cl->pers.stopRecordingTime = level.time + 2000;
-				cl->pers.keepDemo = qtrue;
-				Com_sprintf(cl->pers.oldDemoName, sizeof(cl->pers.oldDemoName), "%s", cl->pers.userName);
-				if (style == MV_SIEGE) //Give siege demos a hidden demoname
-					Com_sprintf(cl->pers.demoName, sizeof(cl->pers.demoName), "hidden/%s/%s-%s-%s", cl->pers.userName, cl->pers.userName, mapCourse, styleString); //TODO, change this to %s/%s-%s-%s so its puts in individual players folder
-				else
-					Com_sprintf(cl->pers.demoName, sizeof(cl->pers.demoName), "%s/%s-%s-%s", cl->pers.userName, cl->pers.userName, mapCourse, styleString); //TODO, change this to %s/%s-%s-%s so its puts in individual players folder
-			}
-		}
+		if (!G_UpdateOurLocalRun(db, season_oldRank, season_newRank, global_oldRank, global_newRank, style, username, coursename, duration_ms, topspeed, average, rawtime, season_newCount, global_newCount))//Update our race list
+			race->writeFailed = qtrue;
 
 		//For print
 		if (global_newRank > 0) {
@@ -2074,24 +2839,185 @@ void G_AddRaceTime(char *username, char *message, int duration_ms, int style, in
 				addedScore -= ((season_oldCount / (float)season_oldRank) + (season_oldCount - season_oldRank)) * 0.5f;
 		}
 
-		if (globalPB) {
-			G_UpdateUnlocks(username, coursename, style, duration_ms, cl, db);
+		if (globalPB && race->unlocks) {
+			G_WriteUnlocks(username, race->unlocks, db);
 		}
 	}
 	//else.. set ranks to 0 for print, nothing to update
 
+	if (race->playtime) {
+		G_UpdatePlaytime(db, username, race->playtime);
+	}
+
+	if (sqlite3_exec(db, "COMMIT", NULL, NULL, NULL) != SQLITE_OK) {
+		G_ErrorPrint("ERROR: SQL Commit Failed (G_AddRaceTime)", sqlite3_errcode(db));
+		G_DBExec(db, "ROLLBACK");
+		race->writeFailed = qtrue;
+	}
+
+	race->seasonPB = seasonPB;
+	race->globalPB = globalPB;
+	race->season_oldRank = season_oldRank;
+	race->season_newRank = season_newRank;
+	race->global_oldRank = global_oldRank;
+	race->global_newRank = global_newRank;
+	race->addedScore = addedScore;
+}
+
+static void G_FinishRaceJob(dbRaceJob_t *race) {
+	gclient_t	*cl = &level.clients[race->clientNum];
+	char		timeStr[32] = {0};
+
+	if (race->writeFailed && level.failRaceLog) { //Keep it so it can be added back later
+		char string[1024] = {0};
+
+		Com_sprintf(string, sizeof(string), "%s;%s;%i;%i;%i;%i;%i;%i\n", race->username, race->coursename, race->duration_ms, race->topspeed, race->average, race->style, G_GetSeason(), race->end_time);
+		trap->FS_Write( string, strlen( string ), level.failRaceLog );
+	}
+
+	//They could have left or logged out while the database thread was busy
+	if (cl->pers.connected == CON_DISCONNECTED || Q_stricmp(cl->pers.userName, race->username))
+		cl = NULL;
+
+	if (cl && cl->pers.recordingDemo && race->globalPB) {
+		char mapCourse[MAX_QPATH] = { 0 };
+
+		Q_strncpyz(mapCourse, race->coursename, sizeof(mapCourse));
+		StripWhitespace(mapCourse);
+		Q_strstrip(mapCourse, "\n\r;:.?*<>|\\/\"", NULL);
+
+		cl->pers.stopRecordingTime = level.time + 2000;
+		cl->pers.keepDemo = qtrue;
+		Com_sprintf(cl->pers.oldDemoName, sizeof(cl->pers.oldDemoName), "%s", cl->pers.userName);
+		if (race->style == MV_SIEGE) //Give siege demos a hidden demoname
+			Com_sprintf(cl->pers.demoName, sizeof(cl->pers.demoName), "hidden/%s/%s-%s-%s", cl->pers.userName, cl->pers.userName, mapCourse, race->styleString); //TODO, change this to %s/%s-%s-%s so its puts in individual players folder
+		else
+			Com_sprintf(cl->pers.demoName, sizeof(cl->pers.demoName), "%s/%s-%s-%s", cl->pers.userName, cl->pers.userName, mapCourse, race->styleString); //TODO, change this to %s/%s-%s-%s so its puts in individual players folder
+	}
+
+	if (cl && race->globalPB && !race->writeFailed) //Also update in realtime if possible.
+		cl->pers.unlocks |= race->unlocks;
+
+	if (!race->writeFailed)
+		G_RaceBoardsSubmit(race);
+
+	TimeToString((int)(race->duration_ms), timeStr, sizeof(timeStr));
+	PrintRaceTime(race->username, race->netname, race->hasMessage ? race->message : NULL, race->styleString, race->topspeed, race->average, timeStr, race->clientNum, race->season_newRank, race->seasonPB, race->global_newRank, qtrue, qtrue, race->season_oldRank, race->global_oldRank, race->addedScore, race->awesomenoise, race->worldrecordnoise);
+	//DebugWriteToDB("G_AddRaceTime");
+}
+
+void G_AddRaceTime(char *username, char *message, int duration_ms, int style, int topspeed, int average, int clientNum, int awesomenoise, int worldrecordnoise) {//should be short.. but have to change elsewhere? is it worth it?
+	time_t	rawtime;
+	char	string[1024] = {0}, info[1024] = {0};
+	gclient_t	*cl;
+	dbJob_t		job;
+	dbRaceJob_t	*race = &job.u.race;
+
+	memset(&job, 0, sizeof(job));
+	job.type = DBJOB_RACE;
+
+	cl = &level.clients[clientNum];
+
+	time(&rawtime);
+	localtime(&rawtime);
+
+	trap->GetServerinfo(info, sizeof(info));
+	Q_strncpyz(race->coursename, Info_ValueForKey(info, "mapname"), sizeof(race->coursename));
+
+	if (message) {// [0]?
+		Q_strlwr(message);
+		Q_CleanStr(message);
+		Q_strcat(race->coursename, sizeof(race->coursename), va(" (%s)", message));
+		Q_strncpyz(race->message, message, sizeof(race->message));
+		race->hasMessage = qtrue;
+	}
+
+	if (average > topspeed) {
+		average = topspeed; //need to sample speeds every clientframe.. but how to calculate average if client frames are not evenly spaced.. can use pml.msec ?
+	}
+
+	Q_strlwr(race->coursename);
+	Q_CleanStr(race->coursename);
+
+	IntegerToRaceName(style, race->styleString, sizeof(race->styleString));
+
+	Com_sprintf(string, sizeof(string), "%s;%s;%i;%i;%i;%i;%i\n", username, race->coursename, duration_ms, topspeed, average, style, rawtime);
+
+	if (level.raceLog)
+		trap->FS_Write(string, strlen(string), level.raceLog); //Always write to text file races.log
+
+	Q_strncpyz(race->username, username, sizeof(race->username));
+	Q_strncpyz(race->netname, cl->pers.netname, sizeof(race->netname));
+	race->clientNum = clientNum;
+	race->style = style;
+	race->duration_ms = duration_ms;
+	race->topspeed = topspeed;
+	race->average = average;
+	race->end_time = rawtime;
+	race->awesomenoise = awesomenoise;
+	race->worldrecordnoise = worldrecordnoise;
+	race->unlocks = G_GetUnlocks(race->coursename, style, duration_ms, cl); //Only written if this turns out to be a PB
+
 	cl->pers.stats.racetime += (duration_ms*0.001f) - cl->afkDuration*0.001f;
 	cl->afkDuration = 0;
 	if (cl->pers.stats.racetime > 120.0f) { //Avoid spamming the db
-		G_UpdatePlaytime(db, username, (int)(cl->pers.stats.racetime + 0.5f));
+		race->playtime = (int)(cl->pers.stats.racetime + 0.5f);
 		cl->pers.stats.racetime = 0.0f;
 	}
-	
-	CALL_SQLITE(close(db));
 
-	TimeToString((int)(duration_ms), timeStr, sizeof(timeStr));
-	PrintRaceTime(username, cl->pers.netname, message, styleString, topspeed, average, timeStr, clientNum, season_newRank, seasonPB, global_newRank, qtrue, qtrue, season_oldRank, global_oldRank, addedScore, awesomenoise, worldrecordnoise);
-	//DebugWriteToDB("G_AddRaceTime");
+	G_DBQueueJob(&job);
+}
+
+/*
+==================
+G_DBRunJob
+
+Runs on the database thread, or on the game thread if there is none
+==================
+*/
+static void G_DBRunJob( dbJob_t *job ) {
+	sqlite3 * db;
+
+	G_DBOpen (& db);
+	if (!db) {
+		G_ErrorPrint("ERROR: SQL Open Failed (G_DBRunJob)", job->type);
+		if (job->type == DBJOB_RACE)
+			job->u.race.writeFailed = qtrue;
+		return;
+	}
+
+	switch (job->type) {
+	case DBJOB_RACE:
+		G_RunRaceJob(&job->u.race, db);
+		break;
+	case DBJOB_DUEL:
+#if _ELORANKING
+		G_AddDuelElo(job->u.duel.winner, job->u.duel.loser, job->u.duel.type, job->u.duel.duration, job->u.duel.winner_hp, job->u.duel.winner_shield, 0, job->u.duel.end_time, db);
+#endif
+		break;
+	case DBJOB_PLAYTIME:
+		G_UpdatePlaytime(db, job->u.playtime.username, job->u.playtime.seconds);
+		break;
+	}
+
+	G_DBClose (db);
+}
+
+/*
+==================
+G_DBFinishJob
+
+Back on the game thread once the job is written
+==================
+*/
+static void G_DBFinishJob( dbJob_t *job ) {
+	if (job->errors[0]) {
+		trap->SendServerCommand( -1, va("print \"%s\"", job->errors) );
+		G_SecurityLogPrintf( "%s", job->errors );
+	}
+
+	if (job->type == DBJOB_RACE)
+		G_FinishRaceJob(&job->u.race);
 }
 
 #if 0
@@ -2206,11 +3132,11 @@ void Cmd_ACLogin_f( gentity_t *ent ) { //loda fixme show lastip ? or use lastip
 		gclient_t	*cl;
 		unsigned int lastip = 0, unlocks = 0, flags = 0;
 
-		CALL_SQLITE(open(LOCAL_DB_PATH, &db));
+		G_DBOpen (& db);
 
 		if (ip) {
 			sql = "SELECT COUNT(*) FROM LocalAccount WHERE lastip = ?";
-			CALL_SQLITE(prepare_v2(db, sql, strlen(sql) + 1, &stmt, NULL));
+			G_DBPrepare (db, sql, & stmt);
 			CALL_SQLITE(bind_int64(stmt, 1, ip));
 
 			s = sqlite3_step(stmt);
@@ -2219,16 +3145,16 @@ void Cmd_ACLogin_f( gentity_t *ent ) { //loda fixme show lastip ? or use lastip
 				count = sqlite3_column_int(stmt, 0);
 			else if (s != SQLITE_DONE) {
 				G_ErrorPrint("ERROR: SQL Select Failed (Cmd_ACLogin_f 1)", s);
-				CALL_SQLITE(finalize(stmt));
-				CALL_SQLITE(close(db));
+				G_DBFinalize (stmt);
+				G_DBClose (db);
 				return;
 			}
 
-			CALL_SQLITE(finalize(stmt));
+			G_DBFinalize (stmt);
 		}
 
 		sql = "SELECT password, lastip, flags, unlocks FROM LocalAccount WHERE username = ?";
-		CALL_SQLITE(prepare_v2(db, sql, strlen(sql) + 1, &stmt, NULL));
+		G_DBPrepare (db, sql, & stmt);
 		CALL_SQLITE(bind_text(stmt, 1, username, -1, SQLITE_STATIC));
 
 		while (1) {
@@ -2248,22 +3174,22 @@ void Cmd_ACLogin_f( gentity_t *ent ) { //loda fixme show lastip ? or use lastip
 			}
 		}
 
-		CALL_SQLITE(finalize(stmt));
+		G_DBFinalize (stmt);
 
 		if (row == 0) { // No accounts found
 			trap->SendServerCommand(ent - g_entities, "print \"Account not found! To make a new account, use the /register command.\n\"");
-			CALL_SQLITE(close(db));
+			G_DBClose (db);
 			return;
 		}
 		else if (row > 1) { // More than 1 account found
 			trap->Print("WARNING: Multiple accounts with same name!\n");
-			CALL_SQLITE(close(db));
+			G_DBClose (db);
 			return;
 		}
 
 		if (!(flags & JAPRO_ACCOUNTFLAG_TRUSTED) && (count > 0) && lastip && ip && (lastip != ip)) { //IF lastip already tied to account, and lastIP (of attempted login username) does not match current IP, deny.?
 			trap->SendServerCommand(ent - g_entities, "print \"Your IP address already belongs to an account. You are only allowed one account.\n\"");
-			CALL_SQLITE(close(db));
+			G_DBClose (db);
 			return;
 		}
 
@@ -2273,7 +3199,7 @@ void Cmd_ACLogin_f( gentity_t *ent ) { //loda fixme show lastip ? or use lastip
 			cl = &level.clients[i];
 			if (!Q_stricmp(username, cl->pers.userName)) {
 				trap->SendServerCommand(ent - g_entities, "print \"This account is already logged in!\n\"");
-				CALL_SQLITE(close(db));
+				G_DBClose (db);
 				return;
 			}
 		}
@@ -2286,7 +3212,7 @@ void Cmd_ACLogin_f( gentity_t *ent ) { //loda fixme show lastip ? or use lastip
 
 			if ((flags & JAPRO_ACCOUNTFLAG_IPLOCK) && lastip && lastip != ip) {
 				trap->SendServerCommand(ent - g_entities, "print \"This account is locked to a different IP address.\n\"");
-				CALL_SQLITE(close(db));
+				G_DBClose (db);
 				return;
 			}
 
@@ -2302,7 +3228,7 @@ void Cmd_ACLogin_f( gentity_t *ent ) { //loda fixme show lastip ? or use lastip
 				ip = lastip;
 
 			sql = "UPDATE LocalAccount SET lastip = ?, lastlogin = ? WHERE username = ?";
-			CALL_SQLITE(prepare_v2(db, sql, strlen(sql) + 1, &stmt, NULL));
+			G_DBPrepare (db, sql, & stmt);
 			CALL_SQLITE(bind_int64(stmt, 1, ip));
 			CALL_SQLITE(bind_int(stmt, 2, rawtime));
 			CALL_SQLITE(bind_text(stmt, 3, username, -1, SQLITE_STATIC));
@@ -2312,7 +3238,7 @@ void Cmd_ACLogin_f( gentity_t *ent ) { //loda fixme show lastip ? or use lastip
 			if (s != SQLITE_DONE)
 				G_ErrorPrint("ERROR: SQL Update Failed (Cmd_ACLogin_f 3)", s);
 
-			CALL_SQLITE(finalize(stmt));
+			G_DBFinalize (stmt);
 
 			ent->client->pers.unlocks = unlocks;
 
@@ -2329,7 +3255,7 @@ void Cmd_ACLogin_f( gentity_t *ent ) { //loda fixme show lastip ? or use lastip
 		else {
 			trap->SendServerCommand(ent - g_entities, "print \"Incorrect password!\n\"");
 		}
-		CALL_SQLITE(close(db));
+		G_DBClose (db);
 	}
 
 	//DebugWriteToDB("Cmd_ACLogin_f");
@@ -2367,9 +3293,9 @@ void Cmd_ChangePassword_f( gentity_t *ent ) {
 	Q_CleanStr(enteredPassword);
 	Q_CleanStr(newPassword);
 
-	CALL_SQLITE (open (LOCAL_DB_PATH, & db));
+	G_DBOpen (& db);
 	sql = "SELECT password FROM LocalAccount WHERE username = ?";
-	CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+	G_DBPrepare (db, sql, & stmt);
 	CALL_SQLITE (bind_text (stmt, 1, ent->client->pers.userName, -1, SQLITE_STATIC));
 	
     while (1) {
@@ -2386,13 +3312,13 @@ void Cmd_ChangePassword_f( gentity_t *ent ) {
         }
     }
 
-	CALL_SQLITE (finalize(stmt));
+	G_DBFinalize (stmt);
 
 	if (enteredPassword[0] && password[0] && !Q_stricmp(enteredPassword, password)) {
 		int s;
 
 		sql = "UPDATE LocalAccount SET password = ? WHERE username = ?";
-		CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+		G_DBPrepare (db, sql, & stmt);
 		CALL_SQLITE (bind_text (stmt, 1, newPassword, -1, SQLITE_STATIC));
 		CALL_SQLITE (bind_text (stmt, 2, ent->client->pers.userName, -1, SQLITE_STATIC));
 		s = sqlite3_step(stmt);
@@ -2401,12 +3327,12 @@ void Cmd_ChangePassword_f( gentity_t *ent ) {
 		else
 			G_ErrorPrint("ERROR: SQL Update Failed (Cmd_ChangePassword_f 2)", s);
 
-		CALL_SQLITE (finalize(stmt));
+		G_DBFinalize (stmt);
 	}
 	else {
 		trap->SendServerCommand(ent-g_entities, "print \"Incorrect password!\n\"");
 	}	
-	CALL_SQLITE (close(db));
+	G_DBClose (db);
 
 	//DebugWriteToDB("Cmd_ChangePassword_f");
 }
@@ -2437,9 +3363,9 @@ void Svcmd_ChangePass_f(void)
 		return;
 	}
 
-	CALL_SQLITE (open (LOCAL_DB_PATH, & db));
+	G_DBOpen (& db);
 	sql = "UPDATE LocalAccount SET password = ? WHERE username = ?";
-	CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+	G_DBPrepare (db, sql, & stmt);
 	CALL_SQLITE (bind_text (stmt, 1, newPassword, -1, SQLITE_STATIC));
 	CALL_SQLITE (bind_text (stmt, 2, username, -1, SQLITE_STATIC));
 	s = sqlite3_step(stmt);
@@ -2448,8 +3374,8 @@ void Svcmd_ChangePass_f(void)
 	else
 		G_ErrorPrint("ERROR: SQL Update Failed (Svcmd_ChangePass_f)", s);
 
-	CALL_SQLITE (finalize(stmt));
-	CALL_SQLITE (close(db));
+	G_DBFinalize (stmt);
+	G_DBClose (db);
 }
 
 void Svcmd_ClearIP_f(void)
@@ -2475,9 +3401,9 @@ void Svcmd_ClearIP_f(void)
 		return;
 	}
 
-	CALL_SQLITE (open (LOCAL_DB_PATH, & db));
+	G_DBOpen (& db);
 	sql = "UPDATE LocalAccount SET lastip = 0 WHERE username = ?";
-	CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+	G_DBPrepare (db, sql, & stmt);
 	CALL_SQLITE (bind_text (stmt, 1, username, -1, SQLITE_STATIC));
 	s = sqlite3_step(stmt);
 
@@ -2486,8 +3412,8 @@ void Svcmd_ClearIP_f(void)
 	else
 		G_ErrorPrint("ERROR: SQL Update Failed (Svcmd_ClearIP_f)", s);
 
-	CALL_SQLITE (finalize(stmt));
-	CALL_SQLITE (close(db));
+	G_DBFinalize (stmt);
+	G_DBClose (db);
 }
 
 void Svcmd_Register_f(void)
@@ -2531,9 +3457,9 @@ void Svcmd_Register_f(void)
 	time( &rawtime );
 	localtime( &rawtime );
 
-	CALL_SQLITE (open (LOCAL_DB_PATH, & db));
+	G_DBOpen (& db);
     sql = "INSERT INTO LocalAccount (username, password, kills, deaths, suicides, captures, returns, racetime, created, lastlogin, lastip) VALUES (?, ?, 0, 0, 0, 0, 0, 0, ?, ?, 0)";
-    CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+    G_DBPrepare (db, sql, & stmt);
     CALL_SQLITE (bind_text (stmt, 1, username, -1, SQLITE_STATIC));
 	CALL_SQLITE (bind_text (stmt, 2, password, -1, SQLITE_STATIC));
 	CALL_SQLITE (bind_int (stmt, 3, rawtime));
@@ -2545,8 +3471,8 @@ void Svcmd_Register_f(void)
 	else
 		G_ErrorPrint("ERROR: SQL Insert Failed (Svcmd_Register_f)", s);
 
-	CALL_SQLITE (finalize(stmt));
-	CALL_SQLITE (close(db));
+	G_DBFinalize (stmt);
+	G_DBClose (db);
 }
 
 void Svcmd_DeleteAccount_f(void)
@@ -2569,30 +3495,33 @@ void Svcmd_DeleteAccount_f(void)
 	Q_strlwr(username);
 	Q_CleanStr(username);
 
+	G_DBFlush(); //Runs still queued for the database thread would be written after this otherwise
+	G_RaceBoardsClear(); //Read back from LocalRun the next time they are needed
+
 	{
 		sqlite3 * db;
 		char * sql;
 		sqlite3_stmt * stmt;
 		int s;
 
-		CALL_SQLITE(open(LOCAL_DB_PATH, &db));
+		G_DBOpen (& db);
 
 		if (CheckUserExists(username)) {
 			sql = "DELETE FROM LocalAccount WHERE username = ?";
-			CALL_SQLITE(prepare_v2(db, sql, strlen(sql) + 1, &stmt, NULL));
+			G_DBPrepare (db, sql, & stmt);
 			CALL_SQLITE(bind_text(stmt, 1, username, -1, SQLITE_STATIC));
 			s = sqlite3_step(stmt);
 			if (s == SQLITE_DONE)
 				trap->Print("Account deleted.\n");
 			else
 				G_ErrorPrint("ERROR: SQL Delete Failed (Svcmd_DeleteAccount_f 1)", s);
-			CALL_SQLITE(finalize(stmt));
+			G_DBFinalize (stmt);
 		}
 		else
 			trap->Print("User does not exist, deleting highscores for username anyway.\n");
 
 		sql = "DELETE FROM LocalRun WHERE username = ?";
-		CALL_SQLITE(prepare_v2(db, sql, strlen(sql) + 1, &stmt, NULL));
+		G_DBPrepare (db, sql, & stmt);
 		CALL_SQLITE(bind_text(stmt, 1, username, -1, SQLITE_STATIC));
 
 		//Delete from localduel?
@@ -2600,9 +3529,9 @@ void Svcmd_DeleteAccount_f(void)
 		s = sqlite3_step(stmt);
 		if (s != SQLITE_DONE)
 			G_ErrorPrint("ERROR: SQL Delete Failed (Svcmd_DeleteAccount_f 2)", s);
-		CALL_SQLITE(finalize(stmt));
+		G_DBFinalize (stmt);
 
-		CALL_SQLITE(close(db));
+		G_DBClose (db);
 	}
 }
 
@@ -2640,17 +3569,20 @@ void Svcmd_RenameAccount_f(void)
 		//return;
 	}
 
+	G_DBFlush(); //Runs still queued for the database thread would be written after this otherwise
+	G_RaceBoardsClear(); //Read back from LocalRun the next time they are needed
+
 	{
 		sqlite3 * db;
 		char * sql;
 		sqlite3_stmt * stmt;
 		int s;
 
-		CALL_SQLITE(open(LOCAL_DB_PATH, &db));
+		G_DBOpen (& db);
 
 		if (CheckUserExists(username)) {
 			sql = "UPDATE LocalAccount SET username = ? WHERE username = ?";
-			CALL_SQLITE(prepare_v2(db, sql, strlen(sql) + 1, &stmt, NULL));
+			G_DBPrepare (db, sql, & stmt);
 			CALL_SQLITE(bind_text(stmt, 1, newUsername, -1, SQLITE_STATIC));
 			CALL_SQLITE(bind_text(stmt, 2, username, -1, SQLITE_STATIC));
 			s = sqlite3_step(stmt);
@@ -2658,13 +3590,13 @@ void Svcmd_RenameAccount_f(void)
 				trap->Print("Account renamed.\n");
 			else
 				G_ErrorPrint("ERROR: SQL Update Failed (Svcmd_RenameAccount_f 1)", s);
-			CALL_SQLITE(finalize(stmt));
+			G_DBFinalize (stmt);
 		}
 		else
 			trap->Print("User does not exist, renaming in races and duels anyway.\n");
 
 		sql = "UPDATE LocalRun SET username = ? WHERE username = ?";
-		CALL_SQLITE(prepare_v2(db, sql, strlen(sql) + 1, &stmt, NULL));
+		G_DBPrepare (db, sql, & stmt);
 		CALL_SQLITE(bind_text(stmt, 1, newUsername, -1, SQLITE_STATIC));
 		CALL_SQLITE(bind_text(stmt, 2, username, -1, SQLITE_STATIC));
 
@@ -2672,10 +3604,10 @@ void Svcmd_RenameAccount_f(void)
 		if (s != SQLITE_DONE)
 			G_ErrorPrint("ERROR: SQL Update Failed (Svcmd_RenameAccount_f 2)", s);
 
-		CALL_SQLITE(finalize(stmt));
+		G_DBFinalize (stmt);
 
 		sql = "UPDATE LocalDuel SET winner = ? WHERE winner = ?";
-		CALL_SQLITE(prepare_v2(db, sql, strlen(sql) + 1, &stmt, NULL));
+		G_DBPrepare (db, sql, & stmt);
 		CALL_SQLITE(bind_text(stmt, 1, newUsername, -1, SQLITE_STATIC));
 		CALL_SQLITE(bind_text(stmt, 2, username, -1, SQLITE_STATIC));
 
@@ -2683,10 +3615,10 @@ void Svcmd_RenameAccount_f(void)
 		if (s != SQLITE_DONE)
 			G_ErrorPrint("ERROR: SQL Update Failed (Svcmd_RenameAccount_f 3)", s);
 
-		CALL_SQLITE(finalize(stmt));
+		G_DBFinalize (stmt);
 
 		sql = "UPDATE LocalDuel SET loser = ? WHERE loser = ?";
-		CALL_SQLITE(prepare_v2(db, sql, strlen(sql) + 1, &stmt, NULL));
+		G_DBPrepare (db, sql, & stmt);
 		CALL_SQLITE(bind_text(stmt, 1, newUsername, -1, SQLITE_STATIC));
 		CALL_SQLITE(bind_text(stmt, 2, username, -1, SQLITE_STATIC));
 
@@ -2694,8 +3626,8 @@ void Svcmd_RenameAccount_f(void)
 		if (s != SQLITE_DONE)
 			G_ErrorPrint("ERROR: SQL Update Failed (Svcmd_RenameAccount_f 4)", s);
 
-		CALL_SQLITE(finalize(stmt));
-		CALL_SQLITE(close(db));
+		G_DBFinalize (stmt);
+		G_DBClose (db);
 
 	}
 }
@@ -2728,9 +3660,9 @@ void Svcmd_AccountInfo_f(void)
 		int s;
 		char timeStr[64] = { 0 }, buf[MAX_STRING_CHARS - 64] = { 0 };
 
-		CALL_SQLITE(open(LOCAL_DB_PATH, &db));
+		G_DBOpen (& db);
 		sql = "SELECT created, lastlogin, lastip, racetime FROM LocalAccount WHERE username = ?";
-		CALL_SQLITE(prepare_v2(db, sql, strlen(sql) + 1, &stmt, NULL));
+		G_DBPrepare (db, sql, & stmt);
 		CALL_SQLITE(bind_text(stmt, 1, username, -1, SQLITE_STATIC));
 
 		s = sqlite3_step(stmt);
@@ -2742,13 +3674,13 @@ void Svcmd_AccountInfo_f(void)
 		}
 		else if (s != SQLITE_DONE) {
 			G_ErrorPrint("ERROR: SQL Select Failed (Svcmd_AccountInfo_f)", s);
-			CALL_SQLITE(finalize(stmt));
-			CALL_SQLITE(close(db));
+			G_DBFinalize (stmt);
+			G_DBClose (db);
 			return;
 		}
 
-		CALL_SQLITE(finalize(stmt));
-		CALL_SQLITE(close(db));
+		G_DBFinalize (stmt);
+		G_DBClose (db);
 
 		Q_strncpyz(buf, va("Stats for %s:\n", username), sizeof(buf));
 		getDateTime(created, timeStr, sizeof(timeStr));
@@ -2826,9 +3758,9 @@ void Svcmd_FlagAccount_f( void ) {
 		int s;
 		int flags;
 
-		CALL_SQLITE (open (LOCAL_DB_PATH, & db));
+		G_DBOpen (& db);
 		sql = "SELECT flags FROM LocalAccount WHERE username = ?";
-		CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+		G_DBPrepare (db, sql, & stmt);
 		CALL_SQLITE (bind_text (stmt, 1, username, -1, SQLITE_STATIC));
 	
 		s = sqlite3_step(stmt);
@@ -2837,11 +3769,11 @@ void Svcmd_FlagAccount_f( void ) {
 		}
 		else if (s != SQLITE_DONE){
 			G_ErrorPrint("ERROR: SQL Select Failed (Svcmd_FlagAccount_f 1)", s);
-			CALL_SQLITE(finalize(stmt));
-			CALL_SQLITE(close(db));
+			G_DBFinalize (stmt);
+			G_DBClose (db);
 			return;
 		}
-		CALL_SQLITE (finalize(stmt));
+		G_DBFinalize (stmt);
 
 		if ( args == 2 ) {
 			int i = 0;
@@ -2853,7 +3785,7 @@ void Svcmd_FlagAccount_f( void ) {
 					trap->Print( "%2d [ ] %s\n", i, accountFlags[i].string );
 				}
 			}
-			CALL_SQLITE (close(db));
+			G_DBClose (db);
 			return;
 		}
 		else if (args == 3) {
@@ -2868,7 +3800,7 @@ void Svcmd_FlagAccount_f( void ) {
 			//DM Start: New -1 toggle all options.
 			if (index < 0 || index >= MAX_ACCOUNT_FLAGS) {  //Whereas we need to allow -1 now, we must change the limit for this value.
 				trap->Print("flagAccount: Invalid range: %i [0-%i]\n", index, MAX_ACCOUNT_FLAGS - 1);
-				CALL_SQLITE (close(db));
+				G_DBClose (db);
 				return;
 			}
 
@@ -2877,7 +3809,7 @@ void Svcmd_FlagAccount_f( void ) {
 			else 
 				sql = "UPDATE LocalAccount SET flags = flags | ? WHERE username = ?";
 
-			CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+			G_DBPrepare (db, sql, & stmt);
 			CALL_SQLITE (bind_int (stmt, 1, (1 << index)));
 			CALL_SQLITE (bind_text (stmt, 2, username, -1, SQLITE_STATIC));
 			s = sqlite3_step(stmt);
@@ -2889,8 +3821,8 @@ void Svcmd_FlagAccount_f( void ) {
 				G_ErrorPrint("ERROR: SQL Update Failed (Svcmd_FlagAccount_f 2)", s);
 			}
 
-			CALL_SQLITE (finalize(stmt));
-			CALL_SQLITE (close(db));
+			G_DBFinalize (stmt);
+			G_DBClose (db);
 
 			for (i=0;  i<level.numPlayingClients; i++) {
 				cl = &level.clients[level.sortedClients[i]];
@@ -2924,7 +3856,7 @@ void Svcmd_FlagAccount_f( void ) {
 				bitmask = g_fullAdminLevel.integer;
 
 			sql = "UPDATE LocalAccount SET flags = ? WHERE username = ?";
-			CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+			G_DBPrepare (db, sql, & stmt);
 			CALL_SQLITE (bind_int (stmt, 1, bitmask));
 			CALL_SQLITE (bind_text (stmt, 2, username, -1, SQLITE_STATIC));
 			s = sqlite3_step(stmt);
@@ -2936,8 +3868,8 @@ void Svcmd_FlagAccount_f( void ) {
 				G_ErrorPrint("ERROR: SQL Update Failed (Svcmd_FlagAccount_f 2)", s);
 			}
 
-			CALL_SQLITE (finalize(stmt));
-			CALL_SQLITE (close(db));
+			G_DBFinalize (stmt);
+			G_DBClose (db);
 
 			for (i=0;  i<level.numPlayingClients; i++) {
 				cl = &level.clients[level.sortedClients[i]];
@@ -2966,10 +3898,10 @@ void Svcmd_ListAdmins_f(void)
 		char adminString[16];
 		int row = 1;
 
-		CALL_SQLITE(open(LOCAL_DB_PATH, &db));
+		G_DBOpen (& db);
 
 		sql = "SELECT username, flags FROM localAccount WHERE flags & 4194304 ORDER BY flags DESC"; //ehh
-		CALL_SQLITE(prepare_v2(db, sql, strlen(sql) + 1, &stmt, NULL));
+		G_DBPrepare (db, sql, & stmt);
 
 		Com_Printf("    ^5Username           Admin\n");
 
@@ -2989,8 +3921,8 @@ void Svcmd_ListAdmins_f(void)
 				break;
 			}
 		}
-		CALL_SQLITE(finalize(stmt));
-		CALL_SQLITE(close(db));
+		G_DBFinalize (stmt);
+		G_DBClose (db);
 	}
 }
 
@@ -3001,50 +3933,53 @@ void Svcmd_DBInfo_f(void)
     sqlite3_stmt * stmt;
 	int s, numAccounts = 0, numRaces = 0, numDuels = 0;
 
-	CALL_SQLITE (open (LOCAL_DB_PATH, & db));
+	G_DBOpen (& db);
 	sql = "SELECT COUNT(*) FROM LocalAccount";
-	CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+	G_DBPrepare (db, sql, & stmt);
     s = sqlite3_step(stmt);
     if (s == SQLITE_ROW)
 		numAccounts = sqlite3_column_int(stmt, 0);
 	else if (s != SQLITE_DONE) {
 		G_ErrorPrint("ERROR: SQL Select Failed (Svcmd_DBInfo_f 1)", s);
-		CALL_SQLITE (finalize(stmt));
-		CALL_SQLITE (close(db));
+		G_DBFinalize (stmt);
+		G_DBClose (db);
 		return;
 	}
-	CALL_SQLITE (finalize(stmt));
+	G_DBFinalize (stmt);
 
-	CALL_SQLITE (open (LOCAL_DB_PATH, & db));
+	G_DBOpen (& db);
 	sql = "SELECT COUNT(*) FROM LocalRun";
-	CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+	G_DBPrepare (db, sql, & stmt);
     s = sqlite3_step(stmt);
     if (s == SQLITE_ROW)
 		numRaces = sqlite3_column_int(stmt, 0);
 	else if (s != SQLITE_DONE) {
 		G_ErrorPrint("ERROR: SQL Select Failed (Svcmd_DBInfo_f 2)", s);
-		CALL_SQLITE (finalize(stmt));
-		CALL_SQLITE (close(db));
+		G_DBFinalize (stmt);
+		G_DBClose (db);
 		return;
 	}
-	CALL_SQLITE (finalize(stmt));
+	G_DBFinalize (stmt);
 
 	sql = "SELECT COUNT(*) FROM LocalDuel";
-	CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+	G_DBPrepare (db, sql, & stmt);
     s = sqlite3_step(stmt);
     if (s == SQLITE_ROW)
 		numDuels = sqlite3_column_int(stmt, 0);
 	else if (s != SQLITE_DONE) {
 		G_ErrorPrint("ERROR: SQL Select Failed (Svcmd_DBInfo_f 3)", s);
-		CALL_SQLITE (finalize(stmt));
-		CALL_SQLITE (close(db));
+		G_DBFinalize (stmt);
+		G_DBClose (db);
 		return;
 	}
-	CALL_SQLITE (finalize(stmt));
+	G_DBFinalize (stmt);
 
-	CALL_SQLITE (close(db));
+	G_DBClose (db);
 
 	trap->Print( "There are %i accounts, %i race records, and %i duels in the database.\n", numAccounts, numRaces, numDuels);
+	trap->Print( "%i cached statements, %i cache hits, %i misses this map.\n", G_DBCachedStatements(&dbMain), dbMain.hits, dbMain.misses);
+	trap->Print( "Database thread is %s, %i writes pending, %i queued this map (deepest %i).\n", dbQueue.running ? "running" : "stopped",
+		(int)(dbQueue.tail - dbQueue.head), dbQueue.queued, dbQueue.maxDepth);
 }
 
 void Svcmd_ClanDelete_f(void) {
@@ -3066,10 +4001,10 @@ void Svcmd_ClanDelete_f(void) {
 	Q_strlwr(teamname);
 	Q_CleanStr(teamname);
 	
-	CALL_SQLITE (open (LOCAL_DB_PATH, & db));
+	G_DBOpen (& db);
 
 	sql = "SELECT COUNT(*) FROM LocalTeam WHERE name = ?";
-	CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+	G_DBPrepare (db, sql, & stmt);
 	CALL_SQLITE (bind_text (stmt, 1, teamname, -1, SQLITE_STATIC));
 	
 	s = sqlite3_step(stmt);
@@ -3077,21 +4012,21 @@ void Svcmd_ClanDelete_f(void) {
 		count = sqlite3_column_int(stmt, 0);
 		if (count == 0) {
 			trap->Print( "Clan does not exist!\n");
-			CALL_SQLITE (finalize(stmt));
-			CALL_SQLITE (close(db));
+			G_DBFinalize (stmt);
+			G_DBClose (db);
 			return;
 		}
 	}
 	else if (s != SQLITE_DONE) {
 		G_ErrorPrint("ERROR: SQL Select Failed (Svcmd_ClanDelete_f 1)", s);
-		CALL_SQLITE (finalize(stmt));
-		CALL_SQLITE (close(db));
+		G_DBFinalize (stmt);
+		G_DBClose (db);
 		return;
 	}
-	CALL_SQLITE (finalize(stmt));
+	G_DBFinalize (stmt);
 
 	sql = "DELETE FROM LocalTeam WHERE name = ?";
-	CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+	G_DBPrepare (db, sql, & stmt);
 	CALL_SQLITE (bind_text (stmt, 1, teamname, -1, SQLITE_STATIC));
 	s = sqlite3_step(stmt);
 
@@ -3101,9 +4036,9 @@ void Svcmd_ClanDelete_f(void) {
 	else
 		G_ErrorPrint("ERROR: SQL Delete Failed (Svcmd_ClanDelete_f 2)", s);
 
-	CALL_SQLITE (finalize(stmt));
+	G_DBFinalize (stmt);
 
-	CALL_SQLITE (close(db));
+	G_DBClose (db);
 }
 
 void Svcmd_ClanCreate_f(void) {
@@ -3125,10 +4060,10 @@ void Svcmd_ClanCreate_f(void) {
 	Q_strlwr(teamname);
 	Q_CleanStr(teamname);
 	
-	CALL_SQLITE (open (LOCAL_DB_PATH, & db));
+	G_DBOpen (& db);
 
 	sql = "SELECT COUNT(*) FROM LocalTeam WHERE name = ?";
-	CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+	G_DBPrepare (db, sql, & stmt);
 	CALL_SQLITE (bind_text (stmt, 1, teamname, -1, SQLITE_STATIC));
 	
 	s = sqlite3_step(stmt);
@@ -3136,21 +4071,21 @@ void Svcmd_ClanCreate_f(void) {
 		count = sqlite3_column_int(stmt, 0);
 		if (count > 0) {
 			trap->Print( "Clan already exists!\n");
-			CALL_SQLITE (finalize(stmt));
-			CALL_SQLITE (close(db));
+			G_DBFinalize (stmt);
+			G_DBClose (db);
 			return;
 		}
 	}
 	else if (s != SQLITE_DONE) {
 		G_ErrorPrint("ERROR: SQL Select Failed (Svcmd_ClanCreate_f 1)", s);
-		CALL_SQLITE (finalize(stmt));
-		CALL_SQLITE (close(db));
+		G_DBFinalize (stmt);
+		G_DBClose (db);
 		return;
 	}
-	CALL_SQLITE (finalize(stmt));
+	G_DBFinalize (stmt);
 
 	sql = "INSERT INTO LocalTeam (name, flags) VALUES (?, 1)";
-	CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+	G_DBPrepare (db, sql, & stmt);
 	CALL_SQLITE (bind_text (stmt, 1, teamname, -1, SQLITE_STATIC));
 	s = sqlite3_step(stmt);
 
@@ -3160,9 +4095,9 @@ void Svcmd_ClanCreate_f(void) {
 	else
 		G_ErrorPrint("ERROR: SQL Insert Failed (Svcmd_ClanCreate_f 2)", s);
 
-	CALL_SQLITE (finalize(stmt));
+	G_DBFinalize (stmt);
 
-	CALL_SQLITE (close(db));
+	G_DBClose (db);
 }
 
 void Svcmd_ClanKick_f(void) {
@@ -3188,7 +4123,7 @@ void Svcmd_ClanKick_f(void) {
 	Q_strlwr(teamname);
 	Q_CleanStr(teamname);
 	
-	CALL_SQLITE (open (LOCAL_DB_PATH, & db));
+	G_DBOpen (& db);
 
 	if (!CheckUserExists(username)) {
 		trap->Print( "This user does not exist!\n");
@@ -3196,7 +4131,7 @@ void Svcmd_ClanKick_f(void) {
 	}
 
 	sql = "SELECT COUNT(*) FROM LocalTeam WHERE name = ?";
-	CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+	G_DBPrepare (db, sql, & stmt);
 	CALL_SQLITE (bind_text (stmt, 1, teamname, -1, SQLITE_STATIC));
 	
 	s = sqlite3_step(stmt);
@@ -3204,21 +4139,21 @@ void Svcmd_ClanKick_f(void) {
 		count = sqlite3_column_int(stmt, 0);
 		if (count == 0) {
 			trap->Print( "Clan does not exist!\n");
-			CALL_SQLITE (finalize(stmt));
-			CALL_SQLITE (close(db));
+			G_DBFinalize (stmt);
+			G_DBClose (db);
 			return;
 		}
 	}
 	else if (s != SQLITE_DONE) {
 		G_ErrorPrint("ERROR: SQL Select Failed (Svcmd_ClanKick_f 1)", s);
-		CALL_SQLITE (finalize(stmt));
-		CALL_SQLITE (close(db));
+		G_DBFinalize (stmt);
+		G_DBClose (db);
 		return;
 	}
-	CALL_SQLITE (finalize(stmt));
+	G_DBFinalize (stmt);
 
 	sql = "SELECT COUNT(*) FROM LocalTeamAccount WHERE team = ? AND account = ?";
-	CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+	G_DBPrepare (db, sql, & stmt);
 	CALL_SQLITE (bind_text (stmt, 1, teamname, -1, SQLITE_STATIC));
 	CALL_SQLITE (bind_text (stmt, 2, username, -1, SQLITE_STATIC));
 	
@@ -3227,22 +4162,22 @@ void Svcmd_ClanKick_f(void) {
 		count = sqlite3_column_int(stmt, 0);
 		if (count == 0) {
 			trap->Print( "User is not in this clan!\n");
-			CALL_SQLITE (finalize(stmt));
-			CALL_SQLITE (close(db));
+			G_DBFinalize (stmt);
+			G_DBClose (db);
 			return;
 		}
 	}
 	else if (s != SQLITE_DONE) {
 		G_ErrorPrint("ERROR: SQL Select Failed (Svcmd_ClanKick_f 2)", s);
-		CALL_SQLITE (finalize(stmt));
-		CALL_SQLITE (close(db));
+		G_DBFinalize (stmt);
+		G_DBClose (db);
 		return;
 	}
-	CALL_SQLITE (finalize(stmt));
+	G_DBFinalize (stmt);
 	
 
 	sql = "DELETE FROM LocalTeamAccount WHERE team = ? AND account = ?";
-	CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+	G_DBPrepare (db, sql, & stmt);
 	CALL_SQLITE (bind_text (stmt, 1, teamname, -1, SQLITE_STATIC));
 	CALL_SQLITE (bind_text (stmt, 2, username, -1, SQLITE_STATIC));
 	s = sqlite3_step(stmt);
@@ -3253,9 +4188,9 @@ void Svcmd_ClanKick_f(void) {
 	else
 		G_ErrorPrint("ERROR: SQL Delete Failed (Svcmd_ClanKick_f 3)", s);
 
-	CALL_SQLITE (finalize(stmt));
+	G_DBFinalize (stmt);
 
-	CALL_SQLITE (close(db));
+	G_DBClose (db);
 }
 
 void Svcmd_ClanJoin_f(void) {
@@ -3281,7 +4216,7 @@ void Svcmd_ClanJoin_f(void) {
 	Q_strlwr(teamname);
 	Q_CleanStr(teamname);
 	
-	CALL_SQLITE (open (LOCAL_DB_PATH, & db));
+	G_DBOpen (& db);
 
 	if (!CheckUserExists(username)) {
 		trap->Print( "This user does not exist!\n");
@@ -3289,7 +4224,7 @@ void Svcmd_ClanJoin_f(void) {
 	}
 
 	sql = "SELECT COUNT(*) FROM LocalTeam WHERE name = ?";
-	CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+	G_DBPrepare (db, sql, & stmt);
 	CALL_SQLITE (bind_text (stmt, 1, teamname, -1, SQLITE_STATIC));
 	
 	s = sqlite3_step(stmt);
@@ -3297,21 +4232,21 @@ void Svcmd_ClanJoin_f(void) {
 		count = sqlite3_column_int(stmt, 0);
 		if (count == 0) {
 			trap->Print( "Clan does not exist.\n");
-			CALL_SQLITE (finalize(stmt));
-			CALL_SQLITE (close(db));
+			G_DBFinalize (stmt);
+			G_DBClose (db);
 			return;
 		}
 	}
 	else if (s != SQLITE_DONE) {
 		G_ErrorPrint("ERROR: SQL Select Failed (Svcmd_ClanJoin_f 1)", s);
-		CALL_SQLITE (finalize(stmt));
-		CALL_SQLITE (close(db));
+		G_DBFinalize (stmt);
+		G_DBClose (db);
 		return;
 	}
-	CALL_SQLITE (finalize(stmt));
+	G_DBFinalize (stmt);
 
 	sql = "SELECT COUNT(*) FROM LocalTeamAccount WHERE team = ? AND account = ?";
-	CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+	G_DBPrepare (db, sql, & stmt);
 	CALL_SQLITE (bind_text (stmt, 1, teamname, -1, SQLITE_STATIC));
 	CALL_SQLITE (bind_text (stmt, 2, username, -1, SQLITE_STATIC));
 	
@@ -3320,22 +4255,22 @@ void Svcmd_ClanJoin_f(void) {
 		count = sqlite3_column_int(stmt, 0);
 		if (count > 0) {
 			trap->Print( "User is already in this clan!\n");
-			CALL_SQLITE (finalize(stmt));
-			CALL_SQLITE (close(db));
+			G_DBFinalize (stmt);
+			G_DBClose (db);
 			return;
 		}
 	}
 	else if (s != SQLITE_DONE) {
 		G_ErrorPrint("ERROR: SQL Select Failed (Svcmd_ClanJoin_f 2)", s);
-		CALL_SQLITE (finalize(stmt));
-		CALL_SQLITE (close(db));
+		G_DBFinalize (stmt);
+		G_DBClose (db);
 		return;
 	}
-	CALL_SQLITE (finalize(stmt));
+	G_DBFinalize (stmt);
 	
 
 	sql = "INSERT INTO LocalTeamAccount (team, account, flags) VALUES (?, ?, 0)";
-	CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+	G_DBPrepare (db, sql, & stmt);
 	CALL_SQLITE (bind_text (stmt, 1, teamname, -1, SQLITE_STATIC));
 	CALL_SQLITE (bind_text (stmt, 2, username, -1, SQLITE_STATIC));
 	s = sqlite3_step(stmt);
@@ -3346,9 +4281,9 @@ void Svcmd_ClanJoin_f(void) {
 	else
 		G_ErrorPrint("ERROR: SQL Insert Failed (Svcmd_ClanJoin_f 3)", s);
 
-	CALL_SQLITE (finalize(stmt));
+	G_DBFinalize (stmt);
 
-	CALL_SQLITE (close(db));
+	G_DBClose (db);
 }
 
 void Cmd_ACRegister_f( gentity_t *ent ) { //Temporary, until global shit is done
@@ -3409,11 +4344,11 @@ void Cmd_ACRegister_f( gentity_t *ent ) { //Temporary, until global shit is done
 		*p = 0;
 	ip = ip_to_int(strIP);
 
-	CALL_SQLITE (open (LOCAL_DB_PATH, & db));
+	G_DBOpen (& db);
 
 	if (ip) {
 		sql = "SELECT COUNT(*) FROM LocalAccount WHERE lastip = ?";
-		CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+		G_DBPrepare (db, sql, & stmt);
 		CALL_SQLITE (bind_int64 (stmt, 1, ip));
 
 		s = sqlite3_step(stmt);
@@ -3423,22 +4358,22 @@ void Cmd_ACRegister_f( gentity_t *ent ) { //Temporary, until global shit is done
 			count = sqlite3_column_int(stmt, 0);
 			if (count > 0) {
 				trap->SendServerCommand(ent-g_entities, "print \"Your IP address already belongs to an account. You are only allowed one account.\n\"");
-				CALL_SQLITE (finalize(stmt));
-				CALL_SQLITE (close(db));
+				G_DBFinalize (stmt);
+				G_DBClose (db);
 				return;
 			}
 		}
 		else if (s != SQLITE_DONE) {
 			G_ErrorPrint("ERROR: SQL Select Failed (Cmd_ACRegister_f 1)", s);
-			CALL_SQLITE (finalize(stmt));
-			CALL_SQLITE (close(db));
+			G_DBFinalize (stmt);
+			G_DBClose (db);
 			return;
 		}
-		CALL_SQLITE (finalize(stmt));
+		G_DBFinalize (stmt);
 	}
 
     sql = "INSERT INTO LocalAccount (username, password, kills, deaths, suicides, captures, returns, racetime, created, lastlogin, lastip, flags, unlocks) VALUES (?, ?, 0, 0, 0, 0, 0, 0, ?, ?, ?, 0, 0)";
-    CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+    G_DBPrepare (db, sql, & stmt);
     CALL_SQLITE (bind_text (stmt, 1, username, -1, SQLITE_STATIC));
 	CALL_SQLITE (bind_text (stmt, 2, password, -1, SQLITE_STATIC));
 	CALL_SQLITE (bind_int (stmt, 3, rawtime));
@@ -3454,8 +4389,8 @@ void Cmd_ACRegister_f( gentity_t *ent ) { //Temporary, until global shit is done
 		G_ErrorPrint("ERROR: SQL Insert Failed (Cmd_ACRegister_f 2)", s);
 
 
-	CALL_SQLITE (finalize(stmt));
-	CALL_SQLITE (close(db));
+	G_DBFinalize (stmt);
+	G_DBClose (db);
 
 	//DebugWriteToDB("Cmd_ACRegister_f");
 }
@@ -3519,10 +4454,10 @@ void Cmd_JoinTeam_f( gentity_t *ent ) {
 		qboolean inviteOnly = qfalse;
 		int count = 0;
 
-		CALL_SQLITE (open (LOCAL_DB_PATH, & db));
+		G_DBOpen (& db);
 
 		sql = "SELECT flags FROM LocalTeam WHERE name = ?";
-		CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+		G_DBPrepare (db, sql, & stmt);
 		CALL_SQLITE (bind_text (stmt, 1, teamname, -1, SQLITE_STATIC));
 	
 		s = sqlite3_step(stmt);
@@ -3534,18 +4469,18 @@ void Cmd_JoinTeam_f( gentity_t *ent ) {
 		}
 		else if (s == SQLITE_DONE) {
 			trap->SendServerCommand(ent-g_entities, "print \"Clan does not exist!\n\""); //You already own a team
-			CALL_SQLITE (finalize(stmt));
-			CALL_SQLITE (close(db));
+			G_DBFinalize (stmt);
+			G_DBClose (db);
 			return;
 		}
 		else {
 			G_ErrorPrint("ERROR: SQL Select Failed (Cmd_JoinTeam_f 1)", s);
 		}
-		CALL_SQLITE (finalize(stmt));
+		G_DBFinalize (stmt);
 
 		if (inviteOnly) {
 			sql = "SELECT flags FROM LocalTeamAccount WHERE team = ? AND account = ?";
-			CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+			G_DBPrepare (db, sql, & stmt);
 			CALL_SQLITE (bind_text (stmt, 1, teamname, -1, SQLITE_STATIC));
 			CALL_SQLITE (bind_text (stmt, 2, username, -1, SQLITE_STATIC));
 	
@@ -3554,8 +4489,8 @@ void Cmd_JoinTeam_f( gentity_t *ent ) {
 				int flags = sqlite3_column_int(stmt, 0);
 				if (!(flags & JAPRO_ACCOUNTTEAMFLAG_PENDING)) {
 					trap->SendServerCommand(ent-g_entities, "print \"You are already in this clan!\n\"");//Already in this clan?
-					CALL_SQLITE (finalize(stmt));
-					CALL_SQLITE (close(db));
+					G_DBFinalize (stmt);
+					G_DBClose (db);
 					return;
 				}
 				else {
@@ -3564,18 +4499,18 @@ void Cmd_JoinTeam_f( gentity_t *ent ) {
 			}
 			else if (s == SQLITE_DONE) {
 				trap->SendServerCommand(ent-g_entities, "print \"This clan is invite-only!\n\"");//Not yet invited
-				CALL_SQLITE (finalize(stmt));
-				CALL_SQLITE (close(db));
+				G_DBFinalize (stmt);
+				G_DBClose (db);
 				return;
 			}
 			else {
 				G_ErrorPrint("ERROR: SQL Select Failed (Cmd_JoinTeam_f 1)", s);
 			}
-			CALL_SQLITE (finalize(stmt));
+			G_DBFinalize (stmt);
 		}
 		else {
 			sql = "SELECT COUNT(*) FROM LocalTeamAccount WHERE team = ? AND account = ?";
-			CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+			G_DBPrepare (db, sql, & stmt);
 			CALL_SQLITE (bind_text (stmt, 1, teamname, -1, SQLITE_STATIC));
 			CALL_SQLITE (bind_text (stmt, 2, username, -1, SQLITE_STATIC));
 	
@@ -3584,25 +4519,25 @@ void Cmd_JoinTeam_f( gentity_t *ent ) {
 				count = sqlite3_column_int(stmt, 0);
 				if (count > 0) {
 					trap->SendServerCommand(ent-g_entities, "print \"You are already in this clan!\n\""); //You already own a team - optional?
-					CALL_SQLITE (finalize(stmt));
-					CALL_SQLITE (close(db));
+					G_DBFinalize (stmt);
+					G_DBClose (db);
 					return;
 				}
 			}
 			else if (s != SQLITE_DONE) {
 				G_ErrorPrint("ERROR: SQL Select Failed (Cmd_JoinTeam_f 2)", s);
-				CALL_SQLITE (finalize(stmt));
-				CALL_SQLITE (close(db));
+				G_DBFinalize (stmt);
+				G_DBClose (db);
 				return;
 			}
-			CALL_SQLITE (finalize(stmt));
+			G_DBFinalize (stmt);
 		}
 
 		if (count > 0)
 			sql = "UPDATE LocalTeamAccount SET flags = 0 WHERE team = ? AND account = ?";
 		else 
 			sql = "INSERT INTO LocalTeamAccount (team, account, flags) VALUES (?, ?, 0)"; //Replace
-		CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+		G_DBPrepare (db, sql, & stmt);
 		CALL_SQLITE (bind_text (stmt, 1, teamname, -1, SQLITE_STATIC));
 		CALL_SQLITE (bind_text (stmt, 2, username, -1, SQLITE_STATIC));
 		s = sqlite3_step(stmt);
@@ -3613,9 +4548,9 @@ void Cmd_JoinTeam_f( gentity_t *ent ) {
 		else
 			G_ErrorPrint("ERROR: SQL Insert Failed (Cmd_JoinTeam_f 3)", s);
 
-		CALL_SQLITE (finalize(stmt));
+		G_DBFinalize (stmt);
 
-		CALL_SQLITE (close(db));
+		G_DBClose (db);
 	}
 
 }
@@ -3647,10 +4582,10 @@ void Cmd_LeaveTeam_f( gentity_t *ent ) {
 		int s;//, row = 0;
 		int count;
 
-		CALL_SQLITE (open (LOCAL_DB_PATH, & db));
+		G_DBOpen (& db);
 
 		sql = "SELECT flags FROM LocalTeam WHERE name = ?";
-		CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+		G_DBPrepare (db, sql, & stmt);
 		CALL_SQLITE (bind_text (stmt, 1, teamname, -1, SQLITE_STATIC));
 	
 		s = sqlite3_step(stmt);
@@ -3658,17 +4593,17 @@ void Cmd_LeaveTeam_f( gentity_t *ent ) {
 		}
 		else if (s == SQLITE_DONE) {
 			trap->SendServerCommand(ent-g_entities, "print \"Clan does not exist!\n\""); //You already own a team
-			CALL_SQLITE (finalize(stmt));
-			CALL_SQLITE (close(db));
+			G_DBFinalize (stmt);
+			G_DBClose (db);
 			return;
 		}
 		else {
 			G_ErrorPrint("ERROR: SQL Select Failed (Cmd_JoinTeam_f 1)", s);
 		}
-		CALL_SQLITE (finalize(stmt));
+		G_DBFinalize (stmt);
 
 		sql = "SELECT COUNT(*) FROM LocalTeamAccount WHERE team = ? AND account = ?";
-		CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+		G_DBPrepare (db, sql, & stmt);
 		CALL_SQLITE (bind_text (stmt, 1, teamname, -1, SQLITE_STATIC));
 		CALL_SQLITE (bind_text (stmt, 2, username, -1, SQLITE_STATIC));
 	
@@ -3677,21 +4612,21 @@ void Cmd_LeaveTeam_f( gentity_t *ent ) {
 			count = sqlite3_column_int(stmt, 0);
 			if (count == 0) {
 				trap->SendServerCommand(ent-g_entities, "print \"You are not in this clan!\n\""); //You already own a team - optional?
-				CALL_SQLITE (finalize(stmt));
-				CALL_SQLITE (close(db));
+				G_DBFinalize (stmt);
+				G_DBClose (db);
 				return;
 			}
 		}
 		else if (s != SQLITE_DONE) {
 			G_ErrorPrint("ERROR: SQL Select Failed (Cmd_JoinTeam_f 2)", s);
-			CALL_SQLITE (finalize(stmt));
-			CALL_SQLITE (close(db));
+			G_DBFinalize (stmt);
+			G_DBClose (db);
 			return;
 		}
-		CALL_SQLITE (finalize(stmt));
+		G_DBFinalize (stmt);
 
 		sql = "DELETE FROM LocalTeamAccount WHERE team = ? AND account = ?";
-		CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+		G_DBPrepare (db, sql, & stmt);
 		CALL_SQLITE (bind_text (stmt, 1, teamname, -1, SQLITE_STATIC));
 		CALL_SQLITE (bind_text (stmt, 2, username, -1, SQLITE_STATIC));
 		s = sqlite3_step(stmt);
@@ -3702,9 +4637,9 @@ void Cmd_LeaveTeam_f( gentity_t *ent ) {
 		else
 			G_ErrorPrint("ERROR: SQL Delete Failed (Cmd_JoinTeam_f 3)", s);
 
-		CALL_SQLITE (finalize(stmt));
+		G_DBFinalize (stmt);
 
-		CALL_SQLITE (close(db));
+		G_DBClose (db);
 	}
 
 }
@@ -3740,10 +4675,10 @@ void Cmd_CreateTeam_f( gentity_t *ent ) {
 		sqlite3_stmt * stmt;
 		int s;//, row = 0;
 
-		CALL_SQLITE (open (LOCAL_DB_PATH, & db));
+		G_DBOpen (& db);
 
 		sql = "SELECT COUNT(*) FROM LocalTeam WHERE name = ?";
-		CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+		G_DBPrepare (db, sql, & stmt);
 		CALL_SQLITE (bind_text (stmt, 1, teamname, -1, SQLITE_STATIC));
 		s = sqlite3_step(stmt);
 
@@ -3751,21 +4686,21 @@ void Cmd_CreateTeam_f( gentity_t *ent ) {
 			int count = sqlite3_column_int(stmt, 0);
 			if (count > 0) {
 				trap->SendServerCommand(ent-g_entities, "print \"This clan already exists.\n\"");
-				CALL_SQLITE (finalize(stmt));
-				CALL_SQLITE (close(db));
+				G_DBFinalize (stmt);
+				G_DBClose (db);
 				return;
 			}
 		}
 		else if (s != SQLITE_DONE) {
 			G_ErrorPrint("ERROR: SQL Select Failed (Cmd_CreateTeam_f 1)", s);
-			CALL_SQLITE (finalize(stmt));
-			CALL_SQLITE (close(db));
+			G_DBFinalize (stmt);
+			G_DBClose (db);
 			return;
 		}
-		CALL_SQLITE (finalize(stmt));
+		G_DBFinalize (stmt);
 
 		sql = "SELECT COUNT(*) FROM LocalTeamAccount WHERE account = ?"; //AND FLAGS = OWNER, fixme
-		CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+		G_DBPrepare (db, sql, & stmt);
 		CALL_SQLITE (bind_text (stmt, 1, username, -1, SQLITE_STATIC));
 		s = sqlite3_step(stmt);
 
@@ -3774,21 +4709,21 @@ void Cmd_CreateTeam_f( gentity_t *ent ) {
 			count = sqlite3_column_int(stmt, 0);
 			if (count > 0) {
 				trap->SendServerCommand(ent-g_entities, "print \"You are already in a clan.\n\""); //You already own a team
-				CALL_SQLITE (finalize(stmt));
-				CALL_SQLITE (close(db));
+				G_DBFinalize (stmt);
+				G_DBClose (db);
 				return;
 			}
 		}
 		else if (s != SQLITE_DONE) {
 			G_ErrorPrint("ERROR: SQL Select Failed (Cmd_CreateTeam_f 2)", s);
-			CALL_SQLITE (finalize(stmt));
-			CALL_SQLITE (close(db));
+			G_DBFinalize (stmt);
+			G_DBClose (db);
 			return;
 		}
-		CALL_SQLITE (finalize(stmt));
+		G_DBFinalize (stmt);
 
 		sql = "INSERT INTO LocalTeam (name, flags) VALUES (?, 0)";
-		CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+		G_DBPrepare (db, sql, & stmt);
 		CALL_SQLITE (bind_text (stmt, 1, teamname, -1, SQLITE_STATIC));
 		s = sqlite3_step(stmt);
 
@@ -3797,10 +4732,10 @@ void Cmd_CreateTeam_f( gentity_t *ent ) {
 		else
 			G_ErrorPrint("ERROR: SQL Insert Failed (Cmd_CreateTeam_f 4)", s);
 
-		CALL_SQLITE (finalize(stmt));
+		G_DBFinalize (stmt);
 
 		sql = "INSERT INTO LocalTeamAccount (team, account, flags) VALUES (?, ?, ?)";
-		CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+		G_DBPrepare (db, sql, & stmt);
 		CALL_SQLITE (bind_text (stmt, 1, teamname, -1, SQLITE_STATIC));
 		CALL_SQLITE (bind_text (stmt, 2, username, -1, SQLITE_STATIC));
 		CALL_SQLITE (bind_int (stmt, 3, JAPRO_ACCOUNTTEAMFLAG_OWNER)); //1, JAPRO_ACCOUNTTEAMFLAG_OWNER
@@ -3813,9 +4748,9 @@ void Cmd_CreateTeam_f( gentity_t *ent ) {
 		else
 			G_ErrorPrint("ERROR: SQL Insert Failed (Cmd_CreateTeam_f 6)", s);
 
-		CALL_SQLITE (finalize(stmt));
+		G_DBFinalize (stmt);
 
-		CALL_SQLITE (close(db));
+		G_DBClose (db);
 	}
 }
 
@@ -3854,10 +4789,10 @@ void Cmd_InfoTeam_f( gentity_t *ent ) {
 		int s, row = 1;
 		char msg[1024-128] = {0}, playername[16] = {0};
 
-		CALL_SQLITE (open (LOCAL_DB_PATH, & db));
+		G_DBOpen (& db);
 
 		sql = "SELECT username, ROUND(SUM((entries/CAST(rank AS FLOAT) + entries-rank))/2,0) AS score FROM LocalRun WHERE rank != 0 AND username IN (SELECT account FROM LocalTeamAccount WHERE team = ? AND (flags & 2 != 2)) GROUP BY username ORDER BY score DESC LIMIT ?, 10";
-		CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+		G_DBPrepare (db, sql, & stmt);
 		CALL_SQLITE (bind_text (stmt, 1, teamname, -1, SQLITE_STATIC));
 		CALL_SQLITE (bind_int (stmt, 2, start));
 
@@ -3888,8 +4823,8 @@ void Cmd_InfoTeam_f( gentity_t *ent ) {
 			}
 		}
 
-		CALL_SQLITE (finalize(stmt));
-		CALL_SQLITE (close(db));
+		G_DBFinalize (stmt);
+		G_DBClose (db);
 	}
 }
 
@@ -3934,36 +4869,36 @@ void Cmd_AddMaster_f(gentity_t *ent) {
 		sqlite3_stmt * stmt;
 		int s;
 
-		CALL_SQLITE(open(LOCAL_DB_PATH, &db));
+		G_DBOpen (& db);
 
 		if (!Q_stricmp(mastername, "none")) {
 			sql = "UPDATE LocalAccount SET master = NULL WHERE username = ?";
-			CALL_SQLITE(prepare_v2(db, sql, strlen(sql) + 1, &stmt, NULL));
+			G_DBPrepare (db, sql, & stmt);
 			CALL_SQLITE(bind_text(stmt, 1, username, -1, SQLITE_STATIC));
 		}
 		else {
 #if 0
 			//Make sure we are not their master
 			sql = "SELECT id FROM LocalAccount WHERE master = ? AND username = ?";
-			CALL_SQLITE(prepare_v2(db, sql, strlen(sql) + 1, &stmt, NULL));
+			G_DBPrepare (db, sql, & stmt);
 			CALL_SQLITE(bind_text(stmt, 1, username, -1, SQLITE_STATIC));
 			CALL_SQLITE(bind_text(stmt, 2, mastername, -1, SQLITE_STATIC));
 
 			s = sqlite3_step(stmt);
 			if (s == SQLITE_ROW) {
 				trap->SendServerCommand(ent - g_entities, "print \"You can not be your own master.\n\"");
-				CALL_SQLITE(finalize(stmt));
-				CALL_SQLITE(close(db));
+				G_DBFinalize (stmt);
+				G_DBClose (db);
 				return;
 			}
 			else if (s != SQLITE_DONE) {
 				G_ErrorPrint("ERROR: SQL Update Failed (Cmd_AddMaster_f 1)", s);
 			}
-			CALL_SQLITE(finalize(stmt));
+			G_DBFinalize (stmt);
 #endif
 
 			sql = "UPDATE LocalAccount SET master = ? WHERE username = ?";
-			CALL_SQLITE(prepare_v2(db, sql, strlen(sql) + 1, &stmt, NULL));
+			G_DBPrepare (db, sql, & stmt);
 			CALL_SQLITE(bind_text(stmt, 1, mastername, -1, SQLITE_STATIC));
 			CALL_SQLITE(bind_text(stmt, 2, username, -1, SQLITE_STATIC));
 		}
@@ -3975,9 +4910,9 @@ void Cmd_AddMaster_f(gentity_t *ent) {
 		else {
 			trap->SendServerCommand(ent - g_entities, "print \"Master added.\n\"");
 		}
-		CALL_SQLITE(finalize(stmt));
+		G_DBFinalize (stmt);
 
-		CALL_SQLITE(close(db));
+		G_DBClose (db);
 	}
 
 }
@@ -4010,13 +4945,13 @@ void Cmd_ListMasters_f(gentity_t *ent) {
 		int s, row = 1;
 		char msg[1024 - 128] = { 0 }, mastername[16] = { 0 };
 
-		CALL_SQLITE(open(LOCAL_DB_PATH, &db));
+		G_DBOpen (& db);
 
 		sql = "SELECT T1.master, T1.username FROM "
 			"(SELECT master, username FROM LocalAccount WHERE master IS NOT NULL) AS T1 "
 			"INNER JOIN(SELECT master, COUNT(*) AS count FROM LocalAccount WHERE master IS NOT NULL GROUP BY master) AS T2 "
 			"ON T1.master = T2.master ORDER BY T2.count DESC, T1.master DESC LIMIT ?, 10"; //Order by score - OH BOY! Or by member count?
-		CALL_SQLITE(prepare_v2(db, sql, strlen(sql) + 1, &stmt, NULL));
+		G_DBPrepare (db, sql, & stmt);
 		CALL_SQLITE(bind_int(stmt, 1, start));
 
 		trap->SendServerCommand(ent - g_entities, "print \"Masterlist:\n    ^5Name               Padawans\"");
@@ -4055,8 +4990,8 @@ void Cmd_ListMasters_f(gentity_t *ent) {
 
 		trap->SendServerCommand(ent - g_entities, va("print \"%s\n\"", msg));
 
-		CALL_SQLITE(finalize(stmt));
-		CALL_SQLITE(close(db));
+		G_DBFinalize (stmt);
+		G_DBClose (db);
 	}
 }
 
@@ -4089,14 +5024,14 @@ void Cmd_ListTeam_f( gentity_t *ent ) { //Should i bother to cache player stats
 		int s, row = 1;
 		char msg[1024-128] = {0}, teamname[16] = {0};
 
-		CALL_SQLITE (open (LOCAL_DB_PATH, & db));
+		G_DBOpen (& db);
 
 		sql = "SELECT T.name AS name, TA.count AS count, T.flags AS flags FROM "
 				"(SELECT name, flags From LocalTeam) AS T "
 				"INNER JOIN "
 				"(SELECT team, COUNT(*) AS count From LocalTeamAccount WHERE (flags & 2 != 2) GROUP BY team) AS TA "
 				"ON T.name = TA.team ORDER BY count DESC LIMIT ?, 10"; //Order by score - OH BOY! Or by member count?
-		CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+		G_DBPrepare (db, sql, & stmt);
 		CALL_SQLITE (bind_int (stmt, 1, start));
 
 		trap->SendServerCommand(ent-g_entities, "print \"Clanlist:\n    ^5Name               Members\n\"");
@@ -4126,8 +5061,8 @@ void Cmd_ListTeam_f( gentity_t *ent ) { //Should i bother to cache player stats
 			}
 		}
 
-		CALL_SQLITE (finalize(stmt));
-		CALL_SQLITE (close(db));
+		G_DBFinalize (stmt);
+		G_DBClose (db);
 	}
 }
 
@@ -4174,10 +5109,10 @@ void Cmd_InviteTeam_f( gentity_t *ent ) {
 		int s;//, row = 0;
 		//qboolean inviteOnly = qfalse;
 
-		CALL_SQLITE (open (LOCAL_DB_PATH, & db));
+		G_DBOpen (& db);
 
 		sql = "SELECT flags FROM LocalTeam WHERE name = ?";
-		CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+		G_DBPrepare (db, sql, & stmt);
 		CALL_SQLITE (bind_text (stmt, 1, teamname, -1, SQLITE_STATIC));
 	
 		s = sqlite3_step(stmt);
@@ -4185,24 +5120,24 @@ void Cmd_InviteTeam_f( gentity_t *ent ) {
 			int flags = sqlite3_column_int(stmt, 0);
 			if (!(flags & JAPRO_TEAMFLAG_PRIVATE)) {
 				trap->SendServerCommand(ent-g_entities, "print \"This clan is public!\n\""); //You already own a team
-				CALL_SQLITE (finalize(stmt));
-				CALL_SQLITE (close(db));
+				G_DBFinalize (stmt);
+				G_DBClose (db);
 				return;
 			}
 		}
 		else if (s == SQLITE_DONE) {
 			trap->SendServerCommand(ent-g_entities, "print \"This clan does not exist!\n\""); //You already own a team
-			CALL_SQLITE (finalize(stmt));
-			CALL_SQLITE (close(db));
+			G_DBFinalize (stmt);
+			G_DBClose (db);
 			return;
 		}
 		else {
 			G_ErrorPrint("ERROR: SQL Select Failed (Cmd_JoinTeam_f 1)", s);
 		}
-		CALL_SQLITE (finalize(stmt));
+		G_DBFinalize (stmt);
 
 		sql = "SELECT flags FROM LocalTeamAccount WHERE team = ? AND account = ?";
-		CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+		G_DBPrepare (db, sql, & stmt);
 		CALL_SQLITE (bind_text (stmt, 1, teamname, -1, SQLITE_STATIC));
 		CALL_SQLITE (bind_text (stmt, 2, username, -1, SQLITE_STATIC));
 
@@ -4211,25 +5146,25 @@ void Cmd_InviteTeam_f( gentity_t *ent ) {
 			int flags = sqlite3_column_int(stmt, 0);
 			if (!(flags & JAPRO_ACCOUNTTEAMFLAG_OWNER)) {
 				trap->SendServerCommand(ent-g_entities, "print \"You are not the clan leader!\n\"");//no permission
-				CALL_SQLITE (finalize(stmt));
-				CALL_SQLITE (close(db));
+				G_DBFinalize (stmt);
+				G_DBClose (db);
 				return;
 			}
 		}
 		else if (s == SQLITE_DONE) {
 			trap->SendServerCommand(ent-g_entities, "print \"You are not the clan leader!\n\"");//not even in the clan - lmao
-			CALL_SQLITE (finalize(stmt));
-			CALL_SQLITE (close(db));
+			G_DBFinalize (stmt);
+			G_DBClose (db);
 			return;
 		}
 		else {
 			G_ErrorPrint("ERROR: SQL Select Failed (Cmd_InviteTeam_f 2)", s);
 		}
-		CALL_SQLITE (finalize(stmt));
+		G_DBFinalize (stmt);
 
 
 		sql = "SELECT COUNT(*) FROM LocalTeamAccount WHERE team = ? AND account = ?";
-		CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+		G_DBPrepare (db, sql, & stmt);
 		CALL_SQLITE (bind_text (stmt, 1, teamname, -1, SQLITE_STATIC));
 		CALL_SQLITE (bind_text (stmt, 2, invitee, -1, SQLITE_STATIC));
 
@@ -4238,21 +5173,21 @@ void Cmd_InviteTeam_f( gentity_t *ent ) {
 			int count = sqlite3_column_int(stmt, 0);
 			if (count > 0) {
 				trap->SendServerCommand(ent-g_entities, "print \"Recepient is already in the clan!\n\"");
-				CALL_SQLITE (finalize(stmt));
-				CALL_SQLITE (close(db));
+				G_DBFinalize (stmt);
+				G_DBClose (db);
 				return;
 			}
 		}
 		else if (s != SQLITE_DONE) {
 			G_ErrorPrint("ERROR: SQL Select Failed (Cmd_InviteTeam_f 3)", s);
-			CALL_SQLITE (finalize(stmt));
-			CALL_SQLITE (close(db));
+			G_DBFinalize (stmt);
+			G_DBClose (db);
 			return;
 		}
-		CALL_SQLITE (finalize(stmt));
+		G_DBFinalize (stmt);
 
 		sql = "INSERT INTO LocalTeamAccount (team, account, flags) VALUES (?, ?, ?)";
-		CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+		G_DBPrepare (db, sql, & stmt);
 		CALL_SQLITE (bind_text (stmt, 1, teamname, -1, SQLITE_STATIC));
 		CALL_SQLITE (bind_text (stmt, 2, invitee, -1, SQLITE_STATIC));
 		CALL_SQLITE (bind_int (stmt, 3, JAPRO_ACCOUNTTEAMFLAG_PENDING));
@@ -4264,9 +5199,9 @@ void Cmd_InviteTeam_f( gentity_t *ent ) {
 		else
 			G_ErrorPrint("ERROR: SQL Insert Failed (Cmd_InviteTeam_f 4)", s);
 
-		CALL_SQLITE (finalize(stmt));
+		G_DBFinalize (stmt);
 
-		CALL_SQLITE (close(db));
+		G_DBClose (db);
 	}
 
 }
@@ -4307,10 +5242,10 @@ void Cmd_AdminTeam_f( gentity_t *ent ) {
 		sqlite3_stmt * stmt;
 		int s;
 
-		CALL_SQLITE (open (LOCAL_DB_PATH, & db));
+		G_DBOpen (& db);
 
 		sql = "SELECT flags FROM LocalTeamAccount WHERE team = ? AND account = ?";
-		CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+		G_DBPrepare (db, sql, & stmt);
 		CALL_SQLITE (bind_text (stmt, 1, teamname, -1, SQLITE_STATIC));
 		CALL_SQLITE (bind_text (stmt, 2, username, -1, SQLITE_STATIC));
 
@@ -4319,31 +5254,31 @@ void Cmd_AdminTeam_f( gentity_t *ent ) {
 			int flags = sqlite3_column_int(stmt, 0);
 			if (!(flags & JAPRO_ACCOUNTTEAMFLAG_OWNER)) {
 				trap->SendServerCommand(ent-g_entities, "print \"You are not the clan leader!\n\"");//no permission
-				CALL_SQLITE (finalize(stmt));
-				CALL_SQLITE (close(db));
+				G_DBFinalize (stmt);
+				G_DBClose (db);
 				return;
 			}
 		}
 		else if (s == SQLITE_DONE) {
 			trap->SendServerCommand(ent-g_entities, "print \"You are not the clan leader!\n\"");//not even in the clan - lmao
-			CALL_SQLITE (finalize(stmt));
-			CALL_SQLITE (close(db));
+			G_DBFinalize (stmt);
+			G_DBClose (db);
 			return;
 		}
 		else {
 			G_ErrorPrint("ERROR: SQL Select Failed (Cmd_AdminTeam_f 1)", s);
-			CALL_SQLITE (finalize(stmt));
-			CALL_SQLITE (close(db));
+			G_DBFinalize (stmt);
+			G_DBClose (db);
 			return;
 		}
-		CALL_SQLITE (finalize(stmt));
+		G_DBFinalize (stmt);
 
 		if (!Q_stricmp(command, "kick")) {
 			char player[16];
 
 			if (args < 4) {
 				trap->SendServerCommand(ent-g_entities, "print \"Usage: /clanAdmin <clan> <kick/private/public/longname/tag> <text (optional)>\n\"");
-				CALL_SQLITE (close(db));
+				G_DBClose (db);
 				return;
 			}
 
@@ -4353,7 +5288,7 @@ void Cmd_AdminTeam_f( gentity_t *ent ) {
 			Q_strstrip(player, "\n\r", NULL);
 
 			sql = "DELETE FROM LocalTeamAccount WHERE team = ? AND account = ?";
-			CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+			G_DBPrepare (db, sql, & stmt);
 			CALL_SQLITE (bind_text (stmt, 1, teamname, -1, SQLITE_STATIC));
 			CALL_SQLITE (bind_text (stmt, 2, player, -1, SQLITE_STATIC));
 			s = sqlite3_step(stmt);
@@ -4361,12 +5296,12 @@ void Cmd_AdminTeam_f( gentity_t *ent ) {
 				trap->SendServerCommand(ent-g_entities, "print \"Player removed.\n\"");//eh, maybe check if they were even in the team b4 printing this
 			else 
 				G_ErrorPrint("ERROR: SQL Delete Failed (Cmd_AdminTeam_f 2)", s);
-			CALL_SQLITE (finalize(stmt));
+			G_DBFinalize (stmt);
 
 		}
 		else if (!Q_stricmp(command, "private")) {
 			sql = "UPDATE LocalTeam SET flags = ? WHERE name = ?";
-			CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+			G_DBPrepare (db, sql, & stmt);
 			CALL_SQLITE (bind_int (stmt, 1, JAPRO_TEAMFLAG_PRIVATE));
 			CALL_SQLITE (bind_text (stmt, 2, teamname, -1, SQLITE_STATIC));
 			s = sqlite3_step(stmt);
@@ -4374,25 +5309,25 @@ void Cmd_AdminTeam_f( gentity_t *ent ) {
 				trap->SendServerCommand(ent-g_entities, "print \"Clan made private.\n\"");//eh, maybe check if they were even in the team b4 printing this
 			else 
 				G_ErrorPrint("ERROR: SQL Delete Failed (Cmd_AdminTeam_f 3)", s);
-			CALL_SQLITE (finalize(stmt));
+			G_DBFinalize (stmt);
 		}
 		else if (!Q_stricmp(command, "public")) {
 			sql = "UPDATE LocalTeam SET flags = 0 WHERE name = ?";
-			CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+			G_DBPrepare (db, sql, & stmt);
 			CALL_SQLITE (bind_text (stmt, 1, teamname, -1, SQLITE_STATIC));
 			s = sqlite3_step(stmt);
 			if (s == SQLITE_DONE)
 				trap->SendServerCommand(ent-g_entities, "print \"Clan made public.\n\"");//eh, maybe check if they were even in the team b4 printing this
 			else 
 				G_ErrorPrint("ERROR: SQL Delete Failed (Cmd_AdminTeam_f 4)", s);
-			CALL_SQLITE (finalize(stmt));
+			G_DBFinalize (stmt);
 		}
 		else if (!Q_stricmp(command, "longname")) {
 			char longname[24];
 
 			if (args < 4) {
 				trap->SendServerCommand(ent-g_entities, "print \"Usage: /clanAdmin <clan> <kick/private/public/longname/tag> <text (optional)>\n\"");
-				CALL_SQLITE (close(db));
+				G_DBClose (db);
 				return;
 			}
 
@@ -4403,7 +5338,7 @@ void Cmd_AdminTeam_f( gentity_t *ent ) {
 			Q_strstrip(longname, "\n\r", NULL);
 
 			sql = "UPDATE LocalTeam SET longname = ? WHERE name = ?";
-			CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+			G_DBPrepare (db, sql, & stmt);
 			CALL_SQLITE (bind_text (stmt, 1, longname, -1, SQLITE_STATIC));
 			CALL_SQLITE (bind_text (stmt, 2, teamname, -1, SQLITE_STATIC));
 			s = sqlite3_step(stmt);
@@ -4411,14 +5346,14 @@ void Cmd_AdminTeam_f( gentity_t *ent ) {
 				trap->SendServerCommand(ent-g_entities, "print \"Longname set.\n\"");//eh, maybe check if they were even in the team b4 printing this
 			else 
 				G_ErrorPrint("ERROR: SQL Delete Failed (Cmd_AdminTeam_f 5)", s);
-			CALL_SQLITE (finalize(stmt));
+			G_DBFinalize (stmt);
 		}
 		else if (!Q_stricmp(command, "tag")) {
 			char tags[16];
 
 			if (args < 4) {
 				trap->SendServerCommand(ent-g_entities, "print \"Usage: /clanAdmin <clan> <kick/private/public/longname/tag> <text (optional)>\n\"");
-				CALL_SQLITE (close(db));
+				G_DBClose (db);
 				return;
 			}
 
@@ -4428,7 +5363,7 @@ void Cmd_AdminTeam_f( gentity_t *ent ) {
 			Q_strstrip(tags, "\n\r", NULL);
 
 			sql = "UPDATE LocalTeam SET tag = ? WHERE name = ?";
-			CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+			G_DBPrepare (db, sql, & stmt);
 			CALL_SQLITE (bind_text (stmt, 1, tags, -1, SQLITE_STATIC));
 			CALL_SQLITE (bind_text (stmt, 2, teamname, -1, SQLITE_STATIC));
 			s = sqlite3_step(stmt);
@@ -4436,13 +5371,13 @@ void Cmd_AdminTeam_f( gentity_t *ent ) {
 				trap->SendServerCommand(ent-g_entities, "print \"Tag set.\n\"");//eh, maybe check if they were even in the team b4 printing this
 			else 
 				G_ErrorPrint("ERROR: SQL Delete Failed (Cmd_AdminTeam_f 6)", s);
-			CALL_SQLITE (finalize(stmt));
+			G_DBFinalize (stmt);
 		}
 		else {
 			trap->SendServerCommand(ent-g_entities, "print \"Usage: /clanAdmin <clan> <kick/private/public/longname/tag> <text (optional)>\n\"");
 		}
 
-		CALL_SQLITE (close(db));
+		G_DBClose (db);
 
 	}
 }
@@ -4513,11 +5448,11 @@ void Cmd_AccountStats_f(gentity_t *ent) { //Should i bother to cache player stat
 		int s, created = 0;
 		qboolean printInfo = qfalse;
 
-		CALL_SQLITE(open(LOCAL_DB_PATH, &db));
+		G_DBOpen (& db);
 
 		sql = "SELECT created, master FROM LocalAccount WHERE username = ? "
 			"UNION ALL SELECT username, NULL  from LocalAccount WHERE master = ? LIMIT 32";
-		CALL_SQLITE(prepare_v2(db, sql, strlen(sql) + 1, &stmt, NULL));
+		G_DBPrepare (db, sql, & stmt);
 		CALL_SQLITE(bind_text(stmt, 1, username, -1, SQLITE_STATIC));
 		CALL_SQLITE(bind_text(stmt, 2, username, -1, SQLITE_STATIC));
 
@@ -4529,14 +5464,14 @@ void Cmd_AccountStats_f(gentity_t *ent) { //Should i bother to cache player stat
 		}
 		else if (s == SQLITE_DONE) {
 			trap->SendServerCommand(ent - g_entities, "print \"Account not found!\n\"");
-			CALL_SQLITE(finalize(stmt));
-			CALL_SQLITE(close(db));
+			G_DBFinalize (stmt);
+			G_DBClose (db);
 			return;
 		}
 		else if (s == SQLITE_ERROR) {
 			G_ErrorPrint("ERROR: SQL Select Failed (Cmd_Stats_f 1)", s);
-			CALL_SQLITE(finalize(stmt));
-			CALL_SQLITE(close(db));
+			G_DBFinalize (stmt);
+			G_DBClose (db);
 			return;
 		}
 
@@ -4552,7 +5487,7 @@ void Cmd_AccountStats_f(gentity_t *ent) { //Should i bother to cache player stat
 				break;
 			}
 		}
-		CALL_SQLITE(finalize(stmt));
+		G_DBFinalize (stmt);
 
 		{
 			char msg[1024-128] = { 0 };
@@ -4590,7 +5525,7 @@ void Cmd_AccountStats_f(gentity_t *ent) { //Should i bother to cache player stat
 			//Race stats
 			sql = "SELECT SUM(entries-rank) AS newscore, CAST(SUM(entries/CAST(rank AS FLOAT)) AS INT) AS oldscore, AVG(rank) as rank, AVG((entries - CAST(rank-1 AS float))/entries) AS percentile, SUM(CASE WHEN rank == 1 THEN 1 ELSE 0 END) AS golds, SUM(CASE WHEN rank == 2 THEN 1 ELSE 0 END) AS silvers, SUM(CASE WHEN rank == 3 THEN 1 ELSE 0 END) AS bronzes, COUNT(*) as count FROM LocalRun "
 				"WHERE rank != 0 AND style != 14 AND username = ?";
-			CALL_SQLITE(prepare_v2(db, sql, strlen(sql) + 1, &stmt, NULL));
+			G_DBPrepare (db, sql, & stmt);
 			CALL_SQLITE(bind_text(stmt, 1, username, -1, SQLITE_STATIC));
 
 			s = sqlite3_step(stmt);
@@ -4608,11 +5543,11 @@ void Cmd_AccountStats_f(gentity_t *ent) { //Should i bother to cache player stat
 			else if (s != SQLITE_DONE) {
 				G_ErrorPrint("ERROR: SQL Select Failed (Cmd_Stats_f 2)", s);
 			}
-			CALL_SQLITE(finalize(stmt));
+			G_DBFinalize (stmt);
 
 			//Recent races
 			sql = "SELECT coursename, style, rank, season_rank, duration_ms, end_time FROM LocalRun WHERE username = ? ORDER BY end_time DESC LIMIT ?, 10";
-			CALL_SQLITE(prepare_v2(db, sql, strlen(sql) + 1, &stmt, NULL));
+			G_DBPrepare (db, sql, & stmt);
 			CALL_SQLITE(bind_text(stmt, 1, username, -1, SQLITE_STATIC));
 			CALL_SQLITE(bind_int(stmt, 2, start));
 
@@ -4648,7 +5583,7 @@ void Cmd_AccountStats_f(gentity_t *ent) { //Should i bother to cache player stat
 			}
 			trap->SendServerCommand(ent - g_entities, va("print \"%s\"", msg));
 
-			CALL_SQLITE(finalize(stmt));
+			G_DBFinalize (stmt);
 
 		}
 		else if (type == 2)//All Combat..? break down per style? gametype?
@@ -4667,7 +5602,7 @@ void Cmd_AccountStats_f(gentity_t *ent) { //Should i bother to cache player stat
 				"ON D1.username = D2.username2) "
 				"INNER JOIN (SELECT loser AS username3, COUNT(*) AS loss_count, SUM(1-odds) AS loss_ts FROM LocalDuel WHERE type = ? GROUP BY username3) AS D3 "
 				"ON D1.username = D3.username3 ORDER BY elo desc LIMIT ?, 10";
-			CALL_SQLITE(prepare_v2(db, sql, strlen(sql) + 1, &stmt, NULL));
+			G_DBPrepare (db, sql, & stmt);
 			CALL_SQLITE(bind_text(stmt, 1, username, -1, SQLITE_STATIC));
 
 			s = sqlite3_step(stmt);
@@ -4685,12 +5620,12 @@ void Cmd_AccountStats_f(gentity_t *ent) { //Should i bother to cache player stat
 			else if (s != SQLITE_DONE) {
 				G_ErrorPrint("ERROR: SQL Select Failed (Cmd_Stats_f 2)", s);
 			}
-			CALL_SQLITE(finalize(stmt));
+			G_DBFinalize (stmt);
 #endif
 
 			//Recent duels
 			sql = "SELECT winner, loser, type, end_time FROM LocalDuel WHERE winner = ? OR loser = ? ORDER BY end_time DESC LIMIT ?, 10";
-			CALL_SQLITE(prepare_v2(db, sql, strlen(sql) + 1, &stmt, NULL));
+			G_DBPrepare (db, sql, & stmt);
 			CALL_SQLITE(bind_text(stmt, 1, username, -1, SQLITE_STATIC));
 			CALL_SQLITE(bind_text(stmt, 2, username, -1, SQLITE_STATIC));
 			CALL_SQLITE(bind_int(stmt, 3, start));
@@ -4729,10 +5664,10 @@ void Cmd_AccountStats_f(gentity_t *ent) { //Should i bother to cache player stat
 			}
 			trap->SendServerCommand(ent - g_entities, va("print \"%s\"", msg));
 
-			CALL_SQLITE(finalize(stmt));
+			G_DBFinalize (stmt);
 		}
 
-		CALL_SQLITE(close(db));
+		G_DBClose (db);
 	}
 	//DebugWriteToDB("Cmd_AccountStats_f");
 }
@@ -4854,11 +5789,11 @@ void G_AddSimpleStatsToDB() {
 	buf[fLen] = 0;
 	trap->FS_Close(f);
 	
-	CALL_SQLITE (open (LOCAL_DB_PATH, & db));
+	G_DBOpen (& db);
 	sql = "UPDATE LocalAccount SET "
 		"kills = kills + ?, deaths = deaths + ?, suicides = suicides + ?, captures = captures + ?, returns = returns + ? "
 		"WHERE username = ?";
-	CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+	G_DBPrepare (db, sql, & stmt);
 
 	//Todo: make TempRaceRecord an array of structs instead, maybe like 32 long idk, and build a query to insert 32 at a time or something.. instead of 1 by 1
 	pch = strtok (buf,";\n");
@@ -4894,8 +5829,8 @@ void G_AddSimpleStatsToDB() {
 	s = sqlite3_step(stmt); //this duplicates last one..?
 	if (s == SQLITE_DONE)
 		good = qtrue;
-	CALL_SQLITE (finalize(stmt));
-	CALL_SQLITE (close(db));	
+	G_DBFinalize (stmt);
+	G_DBClose (db);	
 
 	if (good) { //dont delete tmp file if mysql database is not responding 
 		trap->FS_Open(TEMP_STAT_LOG, &f, FS_WRITE); 
@@ -4917,11 +5852,11 @@ void G_AddSimpleStatsToDB2() { //For each item in array.. do an update query?  C
     sqlite3_stmt * stmt;
 	int row = 0;
 
-	CALL_SQLITE (open (LOCAL_DB_PATH, & db));
+	G_DBOpen (& db);
 	sql = "UPDATE LocalAccount SET "
 		"kills = kills + ?, deaths = deaths + ?, suicides = suicides + ?, captures = captures + ?, returns = returns + ? "
 		"WHERE username = ?";
-	CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+	G_DBPrepare (db, sql, & stmt);
 
 	for (row = 0; row < 256; row++) { //size of UserStats ?
 		if (!UserStats[row].username || !UserStats[row].username[0])
@@ -4938,8 +5873,8 @@ void G_AddSimpleStatsToDB2() { //For each item in array.. do an update query?  C
 		CALL_SQLITE (clear_bindings (stmt));
 	}
 
-	CALL_SQLITE (finalize(stmt));
-	CALL_SQLITE (close(db));
+	G_DBFinalize (stmt);
+	G_DBClose (db);
 }
 #endif
 
@@ -4956,7 +5891,7 @@ void BuildMapHighscores() { //loda fixme, take prepare,query out of loop
 	Q_strlwr(mapName);
 	Q_CleanStr(mapName);
 
-	CALL_SQLITE (open (LOCAL_DB_PATH, & db));
+	G_DBOpen (& db);
 
 	for (i = 0; i < level.numCourses; i++) { //32 max
 		Q_strncpyz(courseName, mapName, sizeof(courseName));
@@ -4972,7 +5907,7 @@ void BuildMapHighscores() { //loda fixme, take prepare,query out of loop
 				   "GROUP by username) " 
 				"AS X INNER JOIN LocalRun AS LR ON LR.id = X.id ORDER BY duration_ms, end_time LIMIT 10"; //end_time so in case of tie, first one shows up first?
 
-			CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+			G_DBPrepare (db, sql, & stmt);
 			CALL_SQLITE (bind_text (stmt, 1, courseName, -1, SQLITE_STATIC));
 			CALL_SQLITE (bind_int (stmt, 2, mstyle));
 
@@ -5015,10 +5950,10 @@ void BuildMapHighscores() { //loda fixme, take prepare,query out of loop
 					break;
 				}
 			}
-			CALL_SQLITE (finalize(stmt));
+			G_DBFinalize (stmt);
 		}
 	}
-	CALL_SQLITE (close(db));
+	G_DBClose (db);
 
 	if (level.numCourses)
 		trap->Print("Highscores built for %s\n", mapName);
@@ -5196,9 +6131,9 @@ void Cmd_PersonalBest_f(gentity_t *ent) { //loda fixme bugged, always finds in c
 	}
 
 	if (!duration_ms) { //Not found in cache, so check db
-		CALL_SQLITE (open (LOCAL_DB_PATH, & db));
+		G_DBOpen (& db);
 		sql = "SELECT MIN(duration_ms), topspeed, average FROM LocalRun WHERE username = ? AND coursename = ? AND style = ?";
-		CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+		G_DBPrepare (db, sql, & stmt);
 		CALL_SQLITE (bind_text (stmt, 1, username, -1, SQLITE_STATIC));
 		CALL_SQLITE (bind_text (stmt, 2, courseNameFull, -1, SQLITE_STATIC));
 		CALL_SQLITE (bind_int (stmt, 3, style));
@@ -5212,13 +6147,13 @@ void Cmd_PersonalBest_f(gentity_t *ent) { //loda fixme bugged, always finds in c
 		}
 		else if (s != SQLITE_DONE) {
 			fprintf (stderr, "ERROR: SQL Select Failed.\n");//trap print?
-			CALL_SQLITE (finalize(stmt));
-			CALL_SQLITE (close(db));
+			G_DBFinalize (stmt);
+			G_DBClose (db);
 			return;
 		}
 
-		CALL_SQLITE (finalize(stmt));
-		CALL_SQLITE (close(db));
+		G_DBFinalize (stmt);
+		G_DBClose (db);
 	}
 
 	if (duration_ms >= 60000) { //FIXME, make this use the inttostring function if it tests bugfree
@@ -5364,24 +6299,27 @@ void Cmd_InvalidateRace_f(gentity_t* ent)
 
 	//Com_Printf("%s - %s - %s - %s\n", username, coursename, style, season);
 
+	G_DBFlush(); //Runs still queued for the database thread would be written after this otherwise
+	G_RaceBoardsClear(); //Read back from LocalRun the next time they are needed
+
 	if (!Q_stricmp(mode, "f")) {
 		sqlite3* db;
 		char* sql;
 		sqlite3_stmt* stmt;
 		int s;
 
-		CALL_SQLITE(open(LOCAL_DB_PATH, &db));
+		G_DBOpen (& db);
 
 		if (!Q_stricmp(season, "-1")) {
 			sql = "UPDATE LocalRun SET invalid = 1 WHERE username = ? AND coursename = ? AND style = ? AND season < 5";
-			CALL_SQLITE(prepare_v2(db, sql, strlen(sql) + 1, &stmt, NULL));
+			G_DBPrepare (db, sql, & stmt);
 			CALL_SQLITE(bind_text(stmt, 1, username, -1, SQLITE_STATIC));
 			CALL_SQLITE(bind_text(stmt, 2, coursename, -1, SQLITE_STATIC));
 			CALL_SQLITE(bind_int(stmt, 3, style));
 		}
 		else {
 			sql = "UPDATE LocalRun SET invalid = 1 WHERE username = ? AND coursename = ? AND style = ? AND season = ?";
-			CALL_SQLITE(prepare_v2(db, sql, strlen(sql) + 1, &stmt, NULL));
+			G_DBPrepare (db, sql, & stmt);
 			CALL_SQLITE(bind_text(stmt, 1, username, -1, SQLITE_STATIC));
 			CALL_SQLITE(bind_text(stmt, 2, coursename, -1, SQLITE_STATIC));
 			CALL_SQLITE(bind_int(stmt, 3, style));
@@ -5393,9 +6331,9 @@ void Cmd_InvalidateRace_f(gentity_t* ent)
 			trap->SendServerCommand(ent - g_entities, "print \"Record flagged?\n\"");
 		else
 			G_ErrorPrint("ERROR: SQL Update Failed (Svcmd_InvalidateRace_f 1)", s);
-		CALL_SQLITE(finalize(stmt));
+		G_DBFinalize (stmt);
 
-		CALL_SQLITE(close(db));
+		G_DBClose (db);
 	}
 	else if (!Q_stricmp(mode, "u")) {
 		sqlite3* db;
@@ -5403,18 +6341,18 @@ void Cmd_InvalidateRace_f(gentity_t* ent)
 		sqlite3_stmt* stmt;
 		int s;
 
-		CALL_SQLITE(open(LOCAL_DB_PATH, &db));
+		G_DBOpen (& db);
 
 		if (!Q_stricmp(season, "-1")) {
 			sql = "UPDATE LocalRun SET invalid = 0 WHERE username = ? AND coursename = ? AND style = ? AND season < 5";
-			CALL_SQLITE(prepare_v2(db, sql, strlen(sql) + 1, &stmt, NULL));
+			G_DBPrepare (db, sql, & stmt);
 			CALL_SQLITE(bind_text(stmt, 1, username, -1, SQLITE_STATIC));
 			CALL_SQLITE(bind_text(stmt, 2, coursename, -1, SQLITE_STATIC));
 			CALL_SQLITE(bind_int(stmt, 3, style));
 		}
 		else {
 			sql = "UPDATE LocalRun SET invalid = 0 WHERE username = ? AND coursename = ? AND style = ? AND season = ?";
-			CALL_SQLITE(prepare_v2(db, sql, strlen(sql) + 1, &stmt, NULL));
+			G_DBPrepare (db, sql, & stmt);
 			CALL_SQLITE(bind_text(stmt, 1, username, -1, SQLITE_STATIC));
 			CALL_SQLITE(bind_text(stmt, 2, coursename, -1, SQLITE_STATIC));
 			CALL_SQLITE(bind_int(stmt, 3, style));
@@ -5426,9 +6364,9 @@ void Cmd_InvalidateRace_f(gentity_t* ent)
 			trap->SendServerCommand(ent - g_entities, "print \"Record unflagged?\n\"");
 		else
 			G_ErrorPrint("ERROR: SQL Update Failed (Svcmd_InvalidateRace_f 1)", s);
-		CALL_SQLITE(finalize(stmt));
+		G_DBFinalize (stmt);
 
-		CALL_SQLITE(close(db));
+		G_DBClose (db);
 	}
 	else if (!Q_stricmp(mode, "d")) {
 		sqlite3* db;
@@ -5436,18 +6374,18 @@ void Cmd_InvalidateRace_f(gentity_t* ent)
 		sqlite3_stmt* stmt;
 		int s;
 
-		CALL_SQLITE(open(LOCAL_DB_PATH, &db));
+		G_DBOpen (& db);
 
 		if (!Q_stricmp(season, "-1")) {
 			sql = "UPDATE LocalRun SET invalid = 2 WHERE username = ? AND coursename = ? AND style = ? AND season < 5";
-			CALL_SQLITE(prepare_v2(db, sql, strlen(sql) + 1, &stmt, NULL));
+			G_DBPrepare (db, sql, & stmt);
 			CALL_SQLITE(bind_text(stmt, 1, username, -1, SQLITE_STATIC));
 			CALL_SQLITE(bind_text(stmt, 2, coursename, -1, SQLITE_STATIC));
 			CALL_SQLITE(bind_int(stmt, 3, style));
 		}
 		else {
 			sql = "UPDATE LocalRun SET invalid = 2 WHERE username = ? AND coursename = ? AND style = ? AND season = ?";
-			CALL_SQLITE(prepare_v2(db, sql, strlen(sql) + 1, &stmt, NULL));
+			G_DBPrepare (db, sql, & stmt);
 			CALL_SQLITE(bind_text(stmt, 1, username, -1, SQLITE_STATIC));
 			CALL_SQLITE(bind_text(stmt, 2, coursename, -1, SQLITE_STATIC));
 			CALL_SQLITE(bind_int(stmt, 3, style));
@@ -5459,9 +6397,9 @@ void Cmd_InvalidateRace_f(gentity_t* ent)
 			trap->SendServerCommand(ent - g_entities, "print \"Record flagged for deletion?\n\"");
 		else
 			G_ErrorPrint("ERROR: SQL Update Failed (Svcmd_InvalidateRace_f 1)", s);
-		CALL_SQLITE(finalize(stmt));
+		G_DBFinalize (stmt);
 
-		CALL_SQLITE(close(db));
+		G_DBClose (db);
 	}
 }
 
@@ -5555,59 +6493,32 @@ void Cmd_DFFind_f(gentity_t *ent) {
 	}
 
 	{ //See if course is found in database and print it then..?
-		sqlite3 * db;
-		char * sql;
-		sqlite3_stmt * stmt;
-		int s;
+		raceBoard_t *board;
+		int s, index;
 		char dateStr[64] = {0}, dateStrColored[64] = {0}, timeStr[32], msg[1024-128] = {0};
 		time_t	rawtime;
 
-		CALL_SQLITE (open (LOCAL_DB_PATH, & db));
-
 		if (enteredCourseName) { //Course e
 			//Com_Printf("doing sql query %s %i\n", courseName, style);
 			//sql = "SELECT DISTINCT(coursename) FROM LocalRun WHERE coursename LIKE %?%";
 			//sql = "SELECT DISTINCT(coursename) FROM LocalRun WHERE instr(coursename, ?) > 0 LIMIT 1";
 			//sql = "SELECT coursename, MAX(entries) FROM LocalRun WHERE instr(coursename, ?) > 0 LIMIT 1";
 			//sql = "SELECT DISTINCT(coursename) FROM LocalRun WHERE instr(coursename, ?) > 0 ORDER BY LENGTH(coursename) ASC, entries DESC LIMIT 1";
-			sql = "SELECT DISTINCT(coursename) FROM LocalRun WHERE instr(replace(coursename, ' ', ''), ?) > 0 ORDER BY entries DESC LIMIT 1";
-			CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
-			CALL_SQLITE (bind_text (stmt, 1, partialCourseName, -1, SQLITE_STATIC));
-			s = sqlite3_step(stmt);
-			if (s == SQLITE_ROW) {
-				//Check if it actually has text, if not return.  then we can use cheaper (MAX) entries query above //loda fixme
-				Q_strncpyz(fullCourseName, (char*)sqlite3_column_text(stmt, 0), sizeof(fullCourseName));
-			}
-			else if (s == SQLITE_DONE) {
+			s = G_LookupCourseName(qtrue, partialCourseName, fullCourseName, sizeof(fullCourseName));
+			if (s == SQLITE_DONE) {
 				//Com_Printf("fail 4\n");
 				trap->SendServerCommand(ent-g_entities, "print \"Usage: /rFind <username> <mapname (optional)> <season (optional - example: s1)> <style (optional)>.  This displays the players best time.\n\"");
-				CALL_SQLITE (finalize(stmt));
-				CALL_SQLITE (close(db));
 				return;
 			}
-			else {
+			else if (s != SQLITE_ROW) {
 				G_ErrorPrint("ERROR: SQL Select Failed (Cmd_DFFind_f)", s);
 				return;
 			}
-			CALL_SQLITE (finalize(stmt));
-
 		}
 
-		//Problem - crossmap query can return multiple records for same person since the cleanup cmd is only done on mapchange, 
-		//fix by grouping by username here? and using min() so it shows right one? who knows if that will work
-		//could be cheaper by using where rank != 0 instead of min(duration_ms) but w/e
-		if (season == -1)
-			sql = "SELECT rank, MIN(duration_ms) AS duration, topspeed, average, end_time FROM LocalRun WHERE username = ? AND coursename = ? AND style = ? GROUP BY username ORDER BY duration ASC, end_time ASC LIMIT 1";
-		else 
-			sql = "SELECT season_rank, MIN(duration_ms) AS duration, topspeed, average, end_time FROM LocalRun WHERE username = ? AND coursename = ? AND style = ? AND season = ? GROUP BY username ORDER BY duration ASC, end_time ASC LIMIT 1";
-		CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
-		CALL_SQLITE (bind_text (stmt, 1, username, -1, SQLITE_STATIC));
-		CALL_SQLITE (bind_text (stmt, 2, fullCourseName, -1, SQLITE_STATIC));
-		CALL_SQLITE (bind_int (stmt, 3, style));
-
-		if (season != -1) {
-			CALL_SQLITE (bind_int (stmt, 4, season));
-		}
+		board = G_GetRaceBoard(fullCourseName, style, season);
+		if (!board)
+			return;
 
 		time( &rawtime );
 		localtime( &rawtime );
@@ -5616,36 +6527,23 @@ void Cmd_DFFind_f(gentity_t *ent) {
 			trap->SendServerCommand(ent-g_entities, va("print \"Best time for %s on %s using %s:\n    ^5Rank     Time         Topspeed    Average      Date\n\"", username, fullCourseName, inputStyleString));
 		else
 			trap->SendServerCommand(ent-g_entities, va("print \"Best time for %s on %s using %s season %i:\n    ^5Rank     Time         Topspeed    Average      Date\n\"", username, fullCourseName, inputStyleString, season));
-		while (1) {
-			s = sqlite3_step(stmt);
-			if (s == SQLITE_ROW) {
-				char *tmpMsg = NULL;
-				TimeToString(sqlite3_column_int(stmt, 1), timeStr, sizeof(timeStr));
-				getDateTime(sqlite3_column_int(stmt, 4), dateStr, sizeof(dateStr));
-				if (rawtime - sqlite3_column_int(stmt, 4) < 60*60*24) { //Today
-					Com_sprintf(dateStrColored, sizeof(dateStrColored), "^2%s^7", dateStr);
-				}
-				else {
-					Q_strncpyz(dateStrColored, dateStr, sizeof(dateStrColored));
-				}
-				tmpMsg = va("    ^3%-8i %-12s %-11i %-12i %s\n", sqlite3_column_int(stmt, 0), timeStr, sqlite3_column_int(stmt, 2), sqlite3_column_int(stmt, 3), dateStrColored);
-				if (strlen(msg) + strlen(tmpMsg) >= sizeof( msg)) {
-					trap->SendServerCommand( ent-g_entities, va("print \"%s\"", msg));
-					msg[0] = '\0';
-				}
-				Q_strcat(msg, sizeof(msg), tmpMsg);
+
+		//The all time board leaves out invalidated runs like rTop does, so this is the best valid run and its rank among them
+		index = G_BoardFind(board, username);
+		if (index != -1) {
+			const raceEntry_t *entry = &board->entries[index];
+
+			TimeToString(entry->duration_ms, timeStr, sizeof(timeStr));
+			getDateTime(entry->end_time, dateStr, sizeof(dateStr));
+			if (rawtime - entry->end_time < 60*60*24) { //Today
+				Com_sprintf(dateStrColored, sizeof(dateStrColored), "^2%s^7", dateStr);
 			}
-			else if (s == SQLITE_DONE)
-				break;
 			else {
-				G_ErrorPrint("ERROR: SQL Select Failed (Cmd_DFFind_f)", s);
-				break;
+				Q_strncpyz(dateStrColored, dateStr, sizeof(dateStrColored));
 			}
+			Com_sprintf(msg, sizeof(msg), "    ^3%-8i %-12s %-11i %-12i %s\n", G_BoardRank(board, index, (qboolean)(style == MV_COOP_JKA)), timeStr, entry->topspeed, entry->average, dateStrColored);
 		}
 		trap->SendServerCommand(ent-g_entities, va("print \"%s\"", msg));
-
-		CALL_SQLITE (finalize(stmt));
-		CALL_SQLITE (close(db));
 	}
 }
 
@@ -5709,14 +6607,14 @@ void Cmd_DFTopRank_f(gentity_t *ent) { //Add season support?
 		float rank, percentile;
 		char msg[1024-128] = {0}, username[40];
 
-		CALL_SQLITE (open (LOCAL_DB_PATH, & db)); //Needs to select only top entry from each person not all seasons
+		G_DBOpen (& db); //Needs to select only top entry from each person not all seasons
 		if (style == -1) {
 			if (season == -1) {
 				sql = "SELECT username, SUM(entries-rank) AS newscore, CAST(SUM(entries/CAST(rank AS FLOAT)) AS INT) AS oldscore, AVG(rank) as rank, AVG((entries - CAST(rank-1 AS float))/entries) AS percentile, SUM(CASE WHEN rank == 1 THEN 1 ELSE 0 END) AS golds, SUM(CASE WHEN rank == 2 THEN 1 ELSE 0 END) AS silvers, SUM(CASE WHEN rank == 3 THEN 1 ELSE 0 END) AS bronzes, COUNT(*) as count FROM LocalRun "
 					"WHERE rank != 0 "
 					"GROUP BY username "
 					"ORDER BY oldscore+newscore DESC, rank DESC LIMIT ?, 10";
-				CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+				G_DBPrepare (db, sql, & stmt);
 				CALL_SQLITE (bind_int (stmt, 1, start));
 			}
 			else {
@@ -5724,7 +6622,7 @@ void Cmd_DFTopRank_f(gentity_t *ent) { //Add season support?
 					"WHERE season = ? "
 					"GROUP BY username "
 					"ORDER BY oldscore+newscore DESC, rank DESC LIMIT ?, 10";
-				CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+				G_DBPrepare (db, sql, & stmt);
 				CALL_SQLITE (bind_int (stmt, 1, season));
 				CALL_SQLITE (bind_int (stmt, 2, start));
 			}
@@ -5735,7 +6633,7 @@ void Cmd_DFTopRank_f(gentity_t *ent) { //Add season support?
 					"WHERE rank != 0 AND style = ? "
 					"GROUP BY username "
 					"ORDER BY oldscore+newscore DESC, rank DESC LIMIT ?, 10";
-				CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+				G_DBPrepare (db, sql, & stmt);
 				CALL_SQLITE (bind_int (stmt, 1, style));
 				CALL_SQLITE (bind_int (stmt, 2, start));
 			}
@@ -5744,7 +6642,7 @@ void Cmd_DFTopRank_f(gentity_t *ent) { //Add season support?
 					"WHERE season = ? AND style = ? "
 					"GROUP BY username "
 					"ORDER BY oldscore+newscore DESC, rank DESC LIMIT ?, 10";
-				CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+				G_DBPrepare (db, sql, & stmt);
 				CALL_SQLITE (bind_int (stmt, 1, season));
 				CALL_SQLITE (bind_int (stmt, 2, style));
 				CALL_SQLITE (bind_int (stmt, 3, start));
@@ -5787,8 +6685,8 @@ void Cmd_DFTopRank_f(gentity_t *ent) { //Add season support?
 		}
 		trap->SendServerCommand(ent-g_entities, va("print \"%s\"", msg));
 
-		CALL_SQLITE (finalize(stmt));
-		CALL_SQLITE (close(db));
+		G_DBFinalize (stmt);
+		G_DBClose (db);
 
 	}
 }
@@ -5875,14 +6773,14 @@ void Cmd_DFHardest_f(gentity_t *ent) {
 		char styleStr[16] = {0}, msg[128] = {0};
 		int s;
 
-		CALL_SQLITE (open (LOCAL_DB_PATH, & db));
+		G_DBOpen (& db);
 
 		if (style == -1) {
 			if (currentSeason)
 				sql = "SELECT username, coursename, style, season_entries FROM LocalRun WHERE season = (SELECT MAX(season) FROM LocalRun) ORDER BY season_entries ASC, entries ASC LIMIT ?,10";
 			else
 				sql = "SELECT username, coursename, style, entries FROM LocalRun ORDER BY entries ASC LIMIT ?,10";
-			CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+			G_DBPrepare (db, sql, & stmt);
 			CALL_SQLITE (bind_int (stmt, 1, start));
 		}
 		else {
@@ -5890,7 +6788,7 @@ void Cmd_DFHardest_f(gentity_t *ent) {
 				sql = "SELECT username, coursename, style, season_entries FROM LocalRun WHERE season = (SELECT MAX(season) FROM LocalRun) AND style = ? ORDER BY season_entries ASC, entries ASC LIMIT ?,10";
 			else
 				sql = "SELECT username, coursename, style, entries FROM LocalRun WHERE style = ? ORDER BY entries ASC LIMIT ?,10";
-			CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+			G_DBPrepare (db, sql, & stmt);
 			CALL_SQLITE (bind_int (stmt, 1, style));
 			CALL_SQLITE (bind_int (stmt, 2, start));
 		}
@@ -5923,8 +6821,8 @@ void Cmd_DFHardest_f(gentity_t *ent) {
 		}
 		trap->SendServerCommand(ent-g_entities, va("print \"%s\"", msg));
 
-		CALL_SQLITE (finalize(stmt));
-		CALL_SQLITE (close(db));
+		G_DBFinalize (stmt);
+		G_DBClose (db);
 	}
 
 
@@ -6016,14 +6914,14 @@ GROUP BY coursename, style, season
 		char styleStr[16] = { 0 }, msg[128] = { 0 };
 		int s;
 
-		CALL_SQLITE(open(LOCAL_DB_PATH, &db));
+		G_DBOpen (& db);
 
 		//Problem - these queries return races if the other person has not even done that race.  The query is just bad in general..
 		if (season == -1) {
 			if (style == -1) { //All seasons, all styles
 				trap->SendServerCommand(ent - g_entities, va("print \"Results for player %s %s:\n    ^5Coursename                     Style\n\"", theirUsername, inputStyleString));
 				sql = "SELECT a.coursename, a.style FROM LocalRun a INNER JOIN LocalRun b ON a.coursename = b.coursename AND a.style = b.style WHERE a.duration_ms < b.duration_ms AND a.username = ? AND b.username = ? AND a.rank != 0 AND b.rank != 0 ORDER BY a.entries DESC LIMIT ?,10";
-					CALL_SQLITE(prepare_v2(db, sql, strlen(sql) + 1, &stmt, NULL));
+					G_DBPrepare (db, sql, & stmt);
 					CALL_SQLITE(bind_text(stmt, 1, theirUsername, -1, SQLITE_STATIC));
 					CALL_SQLITE(bind_text(stmt, 2, myUsername, -1, SQLITE_STATIC));
 					CALL_SQLITE(bind_int(stmt, 3, start));
@@ -6031,7 +6929,7 @@ GROUP BY coursename, style, season
 			else {//All seasons, specific style
 				trap->SendServerCommand(ent - g_entities, va("print \"Results for player %s %s:\n    ^5Coursename\n\"", theirUsername, inputStyleString));
 				sql = "SELECT a.coursename FROM LocalRun a INNER JOIN LocalRun b ON a.coursename = b.coursename AND a.style = b.style WHERE a.duration_ms < b.duration_ms AND a.username = ? AND b.username = ? AND a.rank != 0 AND b.rank != 0 AND a.style = ? AND b.style = ? ORDER BY a.entries DESC LIMIT ?,10";
-					CALL_SQLITE(prepare_v2(db, sql, strlen(sql) + 1, &stmt, NULL));
+					G_DBPrepare (db, sql, & stmt);
 					CALL_SQLITE(bind_text(stmt, 1, theirUsername, -1, SQLITE_STATIC));
 					CALL_SQLITE(bind_text(stmt, 2, myUsername, -1, SQLITE_STATIC));
 					CALL_SQLITE(bind_int(stmt, 3, style));
@@ -6043,7 +6941,7 @@ GROUP BY coursename, style, season
 			if (style == -1) {//Specific season, all styles
 				trap->SendServerCommand(ent - g_entities, va("print \"Results for player %s %s season %i:\n    ^5Coursename                     Style\n\"", theirUsername, inputStyleString, season));
 				sql = "SELECT a.coursename, a.style FROM LocalRun a INNER JOIN LocalRun b ON a.coursename = b.coursename AND a.style = b.style WHERE a.duration_ms < b.duration_ms AND a.username = ? AND b.username = ? AND a.season = ? AND b.season = ? ORDER BY a.entries DESC LIMIT ?,10";
-					CALL_SQLITE(prepare_v2(db, sql, strlen(sql) + 1, &stmt, NULL));
+					G_DBPrepare (db, sql, & stmt);
 					CALL_SQLITE(bind_text(stmt, 1, theirUsername, -1, SQLITE_STATIC));
 					CALL_SQLITE(bind_text(stmt, 2, myUsername, -1, SQLITE_STATIC));
 					CALL_SQLITE(bind_int(stmt, 3, season));
@@ -6053,7 +6951,7 @@ GROUP BY coursename, style, season
 			else {//Speific season, specific style
 				trap->SendServerCommand(ent - g_entities, va("print \"Results for player %s %s season %i:\n    ^5Coursename\n\"", theirUsername, inputStyleString, season));
 				sql = "SELECT a.coursename FROM LocalRun a INNER JOIN LocalRun b ON a.coursename = b.coursename AND a.style = b.style WHERE a.duration_ms < b.duration_ms AND a.username = ? AND b.username = ? AND A.style = ? AND b.style = ? AND a.season = ? AND b.season = ? ORDER BY a.entries DESC LIMIT ?,10";
-				CALL_SQLITE(prepare_v2(db, sql, strlen(sql) + 1, &stmt, NULL));
+				G_DBPrepare (db, sql, & stmt);
 				CALL_SQLITE(bind_text(stmt, 1, theirUsername, -1, SQLITE_STATIC));
 				CALL_SQLITE(bind_text(stmt, 2, myUsername, -1, SQLITE_STATIC));
 				CALL_SQLITE(bind_int(stmt, 3, style));
@@ -6092,8 +6990,8 @@ GROUP BY coursename, style, season
 		}
 		trap->SendServerCommand(ent - g_entities, va("print \"%s\"", msg));
 
-		CALL_SQLITE(finalize(stmt));
-		CALL_SQLITE(close(db));
+		G_DBFinalize (stmt);
+		G_DBClose (db);
 	}
 
 
@@ -6159,14 +7057,14 @@ void Cmd_DFRecent_f(gentity_t *ent) {
 		char dateStr[64] = {0}, timeStr[32] = {0}, styleStr[16] = {0}, rankStr[16] = {0}, msg[1024 - 128] = { 0 };
 		int s;
 
-		CALL_SQLITE (open (LOCAL_DB_PATH, & db));
+		G_DBOpen (& db);
 
 		if (style == -1) {
 			if (showSeasons)
 				sql = "SELECT username, coursename, style, rank, duration_ms, end_time, season_rank FROM LocalRun ORDER BY end_time DESC LIMIT ?,10";
 			else
 				sql = "SELECT username, coursename, style, rank, duration_ms, end_time FROM LocalRun WHERE rank != 0 ORDER BY end_time DESC LIMIT ?,10";
-			CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+			G_DBPrepare (db, sql, & stmt);
 			CALL_SQLITE (bind_int (stmt, 1, start));
 		}
 		else {
@@ -6174,7 +7072,7 @@ void Cmd_DFRecent_f(gentity_t *ent) {
 				sql = "SELECT username, coursename, style, rank, duration_ms, end_time, season_rank FROM LocalRun WHERE style = ? ORDER BY end_time DESC LIMIT ?,10";
 			else
 				sql = "SELECT username, coursename, style, rank, duration_ms, end_time FROM LocalRun WHERE rank != 0 AND style = ? ORDER BY end_time DESC LIMIT ?,10";
-			CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+			G_DBPrepare (db, sql, & stmt);
 			CALL_SQLITE (bind_int (stmt, 1, style));
 			CALL_SQLITE (bind_int (stmt, 2, start));
 		}
@@ -6218,8 +7116,8 @@ void Cmd_DFRecent_f(gentity_t *ent) {
 		}
 		trap->SendServerCommand(ent-g_entities, va("print \"%s\"", msg));
 
-		CALL_SQLITE (finalize(stmt));
-		CALL_SQLITE (close(db));
+		G_DBFinalize (stmt);
+		G_DBClose (db);
 	}
 
 
@@ -6341,59 +7239,28 @@ void Cmd_DFTop10_f(gentity_t *ent) {
 	//Com_Printf("Style %i, page %i, season %i, map %s, fullmap %s\n", style, page, season, partialCourseName, fullCourseName);
 
 	{ //See if course is found in database and print it then..?
-		sqlite3 * db;
-		char * sql;
-		sqlite3_stmt * stmt;
-		int row = 1;
-		int s;
+		raceBoard_t *board;
+		int row, s;
 		char dateStr[64] = {0}, dateStrColored[64] = {0}, timeStr[32], msg[1024-128] = {0};
 		time_t	rawtime;
 
-		CALL_SQLITE (open (LOCAL_DB_PATH, & db));
-
 		if (enteredCourseName) { //Course e
 			//sql = "SELECT DISTINCT(coursename) FROM LocalRun WHERE instr(replace(coursename, ' ', ''), ?) > 0 ORDER BY entries DESC LIMIT 1";
-			sql = "SELECT DISTINCT(coursename) FROM LocalRun WHERE instr(coursename, ?) > 0 ORDER BY entries DESC LIMIT 1";
-			CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
-			CALL_SQLITE (bind_text (stmt, 1, partialCourseName, -1, SQLITE_STATIC));
-			s = sqlite3_step(stmt);
-			if (s == SQLITE_ROW) {
-				//Check if it actually has text, if not return.  then we can use cheaper (MAX) entries query above //loda fixme
-				Q_strncpyz(fullCourseName, (char*)sqlite3_column_text(stmt, 0), sizeof(fullCourseName));
-			}
-			else if (s == SQLITE_DONE) {
+			s = G_LookupCourseName(qfalse, partialCourseName, fullCourseName, sizeof(fullCourseName));
+			if (s == SQLITE_DONE) {
 				//Com_Printf("fail 4\n");
 				trap->SendServerCommand(ent-g_entities, "print \"Usage: /rTop <course (if needed)> <style (optional)> <season (optional - example: s1)> <page (optional)>.  This displays highscores for the specified course.\n\"");
-				CALL_SQLITE (finalize(stmt));
-				CALL_SQLITE (close(db));
 				return;
 			}
-			else {
+			else if (s != SQLITE_ROW) {
 				G_ErrorPrint("ERROR: SQL Select Failed (Cmd_DFTop10_f)", s);
 				return;
 			}
-			CALL_SQLITE (finalize(stmt));
-
 		}
 
-		//Problem - crossmap query can return multiple records for same person since the cleanup cmd is only done on mapchange, 
-		//fix by grouping by username here? and using min() so it shows right one? who knows if that will work
-		//could be cheaper by using where rank != 0 instead of min(duration_ms) but w/e
-		if (season == -1)
-			sql = "SELECT username, MIN(duration_ms) AS duration, topspeed, average, end_time FROM LocalRun WHERE coursename = ? AND style = ? AND invalid = 0 GROUP BY username ORDER BY duration ASC, end_time ASC, average DESC LIMIT ?, 10";
-		else 
-			sql = "SELECT username, MIN(duration_ms) AS duration, topspeed, average, end_time FROM LocalRun WHERE coursename = ? AND style = ? AND season = ? GROUP BY username ORDER BY duration ASC, end_time ASC, average DESC LIMIT ?, 10";
-		CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
-		CALL_SQLITE (bind_text (stmt, 1, fullCourseName, -1, SQLITE_STATIC));
-		CALL_SQLITE (bind_int (stmt, 2, style));
-
-		if (season == -1) {
-			CALL_SQLITE (bind_int (stmt, 3, start));
-		}
-		else {
-			CALL_SQLITE (bind_int (stmt, 3, season));
-			CALL_SQLITE (bind_int (stmt, 4, start));
-		}
+		board = G_GetRaceBoard(fullCourseName, style, season);
+		if (!board)
+			return;
 
 		//Todo, select flagged, if flagged - change color of the time during print.
 
@@ -6404,40 +7271,26 @@ void Cmd_DFTop10_f(gentity_t *ent) {
 			trap->SendServerCommand(ent-g_entities, va("print \"Highscore results for %s using %s:\n    ^5Username           Time         Topspeed    Average      Date\n\"", fullCourseName, inputStyleString));
 		else
 			trap->SendServerCommand(ent-g_entities, va("print \"Highscore results for %s using %s season %i:\n    ^5Username           Time         Topspeed    Average      Date\n\"", fullCourseName, inputStyleString, season));
-		while (1) {
-			s = sqlite3_step(stmt);
-			if (s == SQLITE_ROW) {
-				char *tmpMsg = NULL;
-				TimeToString(sqlite3_column_int(stmt, 1), timeStr, sizeof(timeStr));
-				getDateTime(sqlite3_column_int(stmt, 4), dateStr, sizeof(dateStr));
-				if (rawtime - sqlite3_column_int(stmt, 4) < 60*60*24) { //Today
-					Com_sprintf(dateStrColored, sizeof(dateStrColored), "^2%s^7", dateStr);
-				}
-				else {
-					Q_strncpyz(dateStrColored, dateStr, sizeof(dateStrColored));
-				}
-				//if (sqlite3_column_int(stmt, 5) == 1) //temp, make flagged runs red until we can figure out how to handle them
-					//tmpMsg = va("^5%2i^3: ^3%-18s ^1%-12s ^3%-11i ^3%-12i %s\n", row+start, sqlite3_column_text(stmt, 0), timeStr, sqlite3_column_int(stmt, 2), sqlite3_column_int(stmt, 3), dateStrColored);
-				//else
-					tmpMsg = va("^5%2i^3: ^3%-18s ^3%-12s ^3%-11i ^3%-12i %s\n", row + start, sqlite3_column_text(stmt, 0), timeStr, sqlite3_column_int(stmt, 2), sqlite3_column_int(stmt, 3), dateStrColored);
-				if (strlen(msg) + strlen(tmpMsg) >= sizeof( msg)) {
-					trap->SendServerCommand( ent-g_entities, va("print \"%s\"", msg));
-					msg[0] = '\0';
-				}
-				Q_strcat(msg, sizeof(msg), tmpMsg);
-				row++;
+		for (row = start; row < start + 10 && row < board->numEntries; row++) {
+			const raceEntry_t *entry = &board->entries[row];
+			char *tmpMsg = NULL;
+
+			TimeToString(entry->duration_ms, timeStr, sizeof(timeStr));
+			getDateTime(entry->end_time, dateStr, sizeof(dateStr));
+			if (rawtime - entry->end_time < 60*60*24) { //Today
+				Com_sprintf(dateStrColored, sizeof(dateStrColored), "^2%s^7", dateStr);
 			}
-			else if (s == SQLITE_DONE)
-				break;
 			else {
-				G_ErrorPrint("ERROR: SQL Select Failed (Cmd_DFTop10_f)", s);
-				break;
+				Q_strncpyz(dateStrColored, dateStr, sizeof(dateStrColored));
 			}
+			tmpMsg = va("^5%2i^3: ^3%-18s ^3%-12s ^3%-11i ^3%-12i %s\n", row + 1, entry->username, timeStr, entry->topspeed, entry->average, dateStrColored);
+			if (strlen(msg) + strlen(tmpMsg) >= sizeof( msg)) {
+				trap->SendServerCommand( ent-g_entities, va("print \"%s\"", msg));
+				msg[0] = '\0';
+			}
+			Q_strcat(msg, sizeof(msg), tmpMsg);
 		}
 		trap->SendServerCommand(ent-g_entities, va("print \"%s\"", msg));
-
-		CALL_SQLITE (finalize(stmt));
-		CALL_SQLITE (close(db));
 	}
 }
 
@@ -6558,7 +7411,7 @@ void Cmd_DFTop10_f(gentity_t *ent) {
 		char dateStr[64] = {0}, dateStrColored[64] = {0};
 		time_t	rawtime;
 
-		CALL_SQLITE (open (LOCAL_DB_PATH, & db));
+		G_DBOpen (& db);
 
 		if (partialCourseName) { //Course e
 			//Com_Printf("doing sql query %s %i\n", courseName, style);
@@ -6567,7 +7420,7 @@ void Cmd_DFTop10_f(gentity_t *ent) {
 			//sql = "SELECT coursename, MAX(entries) FROM LocalRun WHERE instr(coursename, ?) > 0 LIMIT 1";
 			//sql = "SELECT DISTINCT(coursename) FROM LocalRun WHERE instr(coursename, ?) > 0 ORDER BY LENGTH(coursename) ASC, entries DESC LIMIT 1";
 			sql = "SELECT DISTINCT(coursename) FROM LocalRun WHERE instr(coursename, ?) > 0 ORDER BY entries DESC LIMIT 1";
-			CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+			G_DBPrepare (db, sql, & stmt);
 			CALL_SQLITE (bind_text (stmt, 1, courseName, -1, SQLITE_STATIC));
 			s = sqlite3_step(stmt);
 			if (s == SQLITE_ROW) {
@@ -6577,11 +7430,11 @@ void Cmd_DFTop10_f(gentity_t *ent) {
 			else {
 				//Com_Printf("fail 4\n");
 				trap->SendServerCommand(ent-g_entities, "print \"Usage: /rTop <course (if needed)> <style (optional)> <page (optional)>.  This displays the top10 for the specified course.\n\"");
-				CALL_SQLITE (finalize(stmt));
-				CALL_SQLITE (close(db));
+				G_DBFinalize (stmt);
+				G_DBClose (db);
 				return;
 			}
-			CALL_SQLITE (finalize(stmt));
+			G_DBFinalize (stmt);
 
 		}
 
@@ -6589,7 +7442,7 @@ void Cmd_DFTop10_f(gentity_t *ent) {
 		//fix by grouping by username here? and using min() so it shows right one? who knows if that will work
 		//could be cheaper by using where rank != 0 instead of min(duration_ms) but w/e
 		sql = "SELECT username, MIN(duration_ms) AS duration, topspeed, average, end_time FROM LocalRun WHERE coursename = ? AND style = ? GROUP BY username ORDER BY duration ASC, end_time ASC LIMIT ?, 10";
-		CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+		G_DBPrepare (db, sql, & stmt);
 		CALL_SQLITE (bind_text (stmt, 1, courseNameFull, -1, SQLITE_STATIC));
 		CALL_SQLITE (bind_int (stmt, 2, style));
 		CALL_SQLITE (bind_int (stmt, 3, start));
@@ -6627,8 +7480,8 @@ void Cmd_DFTop10_f(gentity_t *ent) {
 		}
 		trap->SendServerCommand(ent-g_entities, va("print \"%s\"", msg));
 
-		CALL_SQLITE (finalize(stmt));
-		CALL_SQLITE (close(db));
+		G_DBFinalize (stmt);
+		G_DBClose (db);
 	}
 }
 #endif
@@ -6700,7 +7553,7 @@ void Cmd_DFTodo_f(gentity_t *ent) {
 		char msg[1024-128] = {0}, timeStr[64], dateStr[64], styleStr[16], rankStr[16];
 		int s, row = 1;
 
-		CALL_SQLITE (open (LOCAL_DB_PATH, & db));
+		G_DBOpen (& db);
 		if (style == -1) {
 			if (enteredCoursename) {
 				//sql = "SELECT coursename, style, rank, entries, duration_ms, end_time FROM LocalRun WHERE rank != 0 AND username = ? AND instr(coursename, ?) > 0 ORDER BY (entries - entries / rank) DESC LIMIT ?, 10";
@@ -6715,7 +7568,7 @@ void Cmd_DFTodo_f(gentity_t *ent) {
 								"ON T1.coursename = T2.coursename AND T1.style = T2.style "
 							"WHERE T2.coursename IS NULL OR T2.style IS NULL) "	
 					"ORDER BY (entries-((entries/cast(rank as float))+(entries-rank)/2.0)) DESC LIMIT ?, 10";
-					CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+					G_DBPrepare (db, sql, & stmt);
 					CALL_SQLITE (bind_text (stmt, 1, username, -1, SQLITE_STATIC));
 					CALL_SQLITE (bind_text (stmt, 2, partialCourseName, -1, SQLITE_STATIC));
 					CALL_SQLITE (bind_text (stmt, 3, partialCourseName, -1, SQLITE_STATIC));
@@ -6736,7 +7589,7 @@ void Cmd_DFTodo_f(gentity_t *ent) {
 								"ON T1.coursename = T2.coursename AND T1.style = T2.style "
 							"WHERE T2.coursename IS NULL OR T2.style IS NULL) "	
 					"ORDER BY (entries-((entries/cast(rank as float))+(entries-rank)/2.0)) DESC LIMIT ?, 10";
-					CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+					G_DBPrepare (db, sql, & stmt);
 					CALL_SQLITE (bind_text (stmt, 1, username, -1, SQLITE_STATIC));
 					CALL_SQLITE (bind_text (stmt, 2, username, -1, SQLITE_STATIC));
 					CALL_SQLITE (bind_int (stmt, 3, start));
@@ -6756,7 +7609,7 @@ void Cmd_DFTodo_f(gentity_t *ent) {
 								"ON T1.coursename = T2.coursename AND T1.style = T2.style "
 							"WHERE T2.coursename IS NULL OR T2.style IS NULL) "	
 					"ORDER BY (entries-((entries/cast(rank as float))+(entries-rank)/2.0)) DESC LIMIT ?, 10";
-					CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+					G_DBPrepare (db, sql, & stmt);
 					CALL_SQLITE (bind_text (stmt, 1, username, -1, SQLITE_STATIC));
 					CALL_SQLITE (bind_int (stmt, 2, style));
 					CALL_SQLITE (bind_text (stmt, 3, partialCourseName, -1, SQLITE_STATIC));
@@ -6780,7 +7633,7 @@ void Cmd_DFTodo_f(gentity_t *ent) {
 								"ON T1.coursename = T2.coursename AND T1.style = T2.style "
 							"WHERE T2.coursename IS NULL OR T2.style IS NULL) "	
 					"ORDER BY (entries-((entries/cast(rank as float))+(entries-rank)/2.0)) DESC LIMIT ?, 10";
-					CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+					G_DBPrepare (db, sql, & stmt);
 					CALL_SQLITE (bind_text (stmt, 1, username, -1, SQLITE_STATIC));
 					CALL_SQLITE (bind_int (stmt, 2, style));
 					CALL_SQLITE (bind_int (stmt, 3, style));
@@ -6823,9 +7676,9 @@ void Cmd_DFTodo_f(gentity_t *ent) {
 			}
 		}
 		trap->SendServerCommand(ent-g_entities, va("print \"%s\"", msg));
-		CALL_SQLITE (finalize(stmt));
+		G_DBFinalize (stmt);
 
-		CALL_SQLITE (close(db));
+		G_DBClose (db);
 	}
 
 }
@@ -6901,7 +7754,7 @@ void Cmd_DFPopular_f(gentity_t *ent) {
 		char msg[1024-128] = {0}, styleStr[16], entriesStr[16];
 		int s, row = 1;
 
-		CALL_SQLITE (open (LOCAL_DB_PATH, & db));
+		G_DBOpen (& db);
 		if (style == -1) {
 			if (enteredUsername) {
 				if (season == -1) { //User
@@ -6911,7 +7764,7 @@ void Cmd_DFPopular_f(gentity_t *ent) {
 									"ON T1.coursename = T2.coursename AND T1.style = T2.style "
 								"WHERE T2.coursename IS NULL OR T2.style IS NULL "
 					"ORDER BY entries DESC LIMIT ?, 10";
-					CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+					G_DBPrepare (db, sql, & stmt);
 					CALL_SQLITE (bind_text (stmt, 1, username, -1, SQLITE_STATIC));
 					CALL_SQLITE (bind_int (stmt, 2, start));
 				}
@@ -6922,7 +7775,7 @@ void Cmd_DFPopular_f(gentity_t *ent) {
 									"ON T1.coursename = T2.coursename AND T1.style = T2.style "
 								"WHERE T2.coursename IS NULL OR T2.style IS NULL "
 					"ORDER BY season_entries DESC LIMIT ?, 10";
-					CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+					G_DBPrepare (db, sql, & stmt);
 					CALL_SQLITE (bind_int (stmt, 1, season));
 					CALL_SQLITE (bind_int (stmt, 2, season));
 					CALL_SQLITE (bind_text (stmt, 3, username, -1, SQLITE_STATIC));
@@ -6932,12 +7785,12 @@ void Cmd_DFPopular_f(gentity_t *ent) {
 			else {
 				if (season == -1) {
 					sql = "SELECT coursename, style, entries, username FROM LocalRun WHERE rank = 1 GROUP BY coursename, style ORDER BY entries DESC LIMIT ?, 10";
-					CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+					G_DBPrepare (db, sql, & stmt);
 					CALL_SQLITE (bind_int (stmt, 1, start));
 				}
 				else { //Season
 					sql = "SELECT coursename, style, season_entries, username FROM LocalRun WHERE season_rank = 1 AND season = ? GROUP BY coursename, style ORDER BY season_entries DESC LIMIT ?, 10";
-					CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+					G_DBPrepare (db, sql, & stmt);
 					CALL_SQLITE (bind_int (stmt, 1, season));
 					CALL_SQLITE (bind_int (stmt, 2, start));
 				}
@@ -6952,7 +7805,7 @@ void Cmd_DFPopular_f(gentity_t *ent) {
 									"ON T1.coursename = T2.coursename AND T1.style = T2.style "
 								"WHERE T2.coursename IS NULL OR T2.style IS NULL "
 					"ORDER BY entries DESC LIMIT ?, 10";
-					CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+					G_DBPrepare (db, sql, & stmt);
 					CALL_SQLITE (bind_int (stmt, 1, style));
 					CALL_SQLITE (bind_int (stmt, 2, style));
 					CALL_SQLITE (bind_text (stmt, 3, username, -1, SQLITE_STATIC));
@@ -6965,7 +7818,7 @@ void Cmd_DFPopular_f(gentity_t *ent) {
 									"ON T1.coursename = T2.coursename AND T1.style = T2.style "
 								"WHERE T2.coursename IS NULL OR T2.style IS NULL "
 					"ORDER BY season_entries DESC LIMIT ?, 10";
-					CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+					G_DBPrepare (db, sql, & stmt);
 					CALL_SQLITE (bind_int (stmt, 1, style));
 					CALL_SQLITE (bind_int (stmt, 2, season));
 					CALL_SQLITE (bind_int (stmt, 3, style));
@@ -6977,13 +7830,13 @@ void Cmd_DFPopular_f(gentity_t *ent) {
 			else {
 				if (season == -1) { //Style
 					sql = "SELECT coursename, style, entries, username FROM LocalRun WHERE rank = 1 AND style = ? GROUP BY coursename, style ORDER BY entries DESC LIMIT ?, 10";
-					CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+					G_DBPrepare (db, sql, & stmt);
 					CALL_SQLITE (bind_int (stmt, 1, style));
 					CALL_SQLITE (bind_int (stmt, 2, start));
 				}
 				else { //Style, season
 					sql = "SELECT coursename, style, season_entries, username FROM LocalRun WHERE season_rank = 1 AND style = ? AND season = ? GROUP BY coursename, style ORDER BY season_entries DESC LIMIT ?, 10";
-					CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+					G_DBPrepare (db, sql, & stmt);
 					CALL_SQLITE (bind_int (stmt, 1, style));
 					CALL_SQLITE (bind_int (stmt, 2, season));
 					CALL_SQLITE (bind_int (stmt, 3, start));
@@ -7019,9 +7872,9 @@ void Cmd_DFPopular_f(gentity_t *ent) {
 			}
 		}
 		trap->SendServerCommand(ent-g_entities, va("print \"%s\"", msg));
-		CALL_SQLITE (finalize(stmt));
+		G_DBFinalize (stmt);
 
-		CALL_SQLITE (close(db));
+		G_DBClose (db);
 	}
 
 }
@@ -7085,9 +7938,9 @@ void Cmd_ACWhois_f( gentity_t *ent ) { //why does this crash sometimes..? condit
 		seeip = qtrue;
 	
 	if (whois) {
-		CALL_SQLITE (open (LOCAL_DB_PATH, & db));
+		G_DBOpen (& db);
 		sql = "SELECT username FROM LocalAccount WHERE lastip = ?";
-		CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+		G_DBPrepare (db, sql, & stmt);
 	}
 
 	if (whois && seeip) {
@@ -7193,8 +8046,8 @@ void Cmd_ACWhois_f( gentity_t *ent ) { //why does this crash sometimes..? condit
 					}
 					else if (s != SQLITE_DONE) {
 						G_ErrorPrint("ERROR: SQL Select Failed (Cmd_ACWhois_f)", s);
-						CALL_SQLITE (finalize(stmt));
-						CALL_SQLITE (close(db));
+						G_DBFinalize (stmt);
+						G_DBClose (db);
 						return;
 					}
 
@@ -7233,8 +8086,8 @@ void Cmd_ACWhois_f( gentity_t *ent ) { //why does this crash sometimes..? condit
 	}
 
 	if (whois) {
-		CALL_SQLITE (finalize(stmt));
-		CALL_SQLITE (close(db));
+		G_DBFinalize (stmt);
+		G_DBClose (db);
 	}
 
 	trap->SendServerCommand(ent-g_entities, va("print \"%s\"", msg));
@@ -7261,7 +8114,7 @@ void InitGameAccountStuff( void ) { //Called every mapload , move the create tab
 
 	Com_sprintf(LOCAL_DB_PATH, sizeof(LOCAL_DB_PATH), "%s/data.db", fs_game);
 
-	CALL_SQLITE (open (LOCAL_DB_PATH, & db));
+	G_DBOpen (& db);
 
 	//sqlite_exec(db, "VACUUM;", 0, 0);
 	//index LocalRun on RANK
@@ -7272,11 +8125,11 @@ void InitGameAccountStuff( void ) { //Called every mapload , move the create tab
 
 	sql = "CREATE TABLE IF NOT EXISTS LocalAccount(id INTEGER PRIMARY KEY, username VARCHAR(16), password VARCHAR(16), kills UNSIGNED SMALLINT, deaths UNSIGNED SMALLINT, "
 		"suicides UNSIGNED SMALLINT, captures UNSIGNED SMALLINT, returns UNSIGNED SMALLINT, racetime UNSIGNED INTEGER, lastlogin UNSIGNED INTEGER, created UNSIGNED INTEGER, lastip UNSIGNED INTEGER, flags UNSIGNED INTEGER, unlocks UNSIGNED INTEGER, master VARCHAR(16))";
-    CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+    G_DBPrepare (db, sql, & stmt);
 	s = sqlite3_step(stmt);
 	if (s != SQLITE_DONE)
 		G_ErrorPrint("ERROR: SQL Create Failed (InitGameAccountStuff 1)", s);
-	CALL_SQLITE (finalize(stmt));
+	G_DBFinalize (stmt);
 
 #if 1//NEWRACERANKING
 	sql = "CREATE TABLE IF NOT EXISTS LocalRun(id INTEGER PRIMARY KEY, username VARCHAR(16), coursename VARCHAR(40), duration_ms UNSIGNED INTEGER, topspeed UNSIGNED SMALLINT, "
@@ -7285,51 +8138,51 @@ void InitGameAccountStuff( void ) { //Called every mapload , move the create tab
 	sql = "CREATE TABLE IF NOT EXISTS LocalRun(id INTEGER PRIMARY KEY, username VARCHAR(16), coursename VARCHAR(40), duration_ms UNSIGNED INTEGER, topspeed UNSIGNED SMALLINT, "
 		"average UNSIGNED SMALLINT, style UNSIGNED TINYINT, end_time UNSIGNED INTEGER)";
 #endif
-    CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+    G_DBPrepare (db, sql, & stmt);
 	s = sqlite3_step(stmt);
 	if (s != SQLITE_DONE)
 		G_ErrorPrint("ERROR: SQL Create Failed (InitGameAccountStuff 2)", s);
-	CALL_SQLITE (finalize(stmt));
+	G_DBFinalize (stmt);
 
 	sql = "CREATE TABLE IF NOT EXISTS LocalDuel(id INTEGER PRIMARY KEY, winner VARCHAR(16), loser VARCHAR(16), duration UNSIGNED SMALLINT, "
 		"type UNSIGNED TINYINT, winner_hp UNSIGNED TINYINT, winner_shield UNSIGNED TINYINT, end_time UNSIGNED INTEGER, winner_elo DECIMAL(6,2), loser_elo DECIMAL(6,2), odds DECIMAL(9,2))";
-    CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+    G_DBPrepare (db, sql, & stmt);
 	s = sqlite3_step(stmt);
 	if (s != SQLITE_DONE)
 		G_ErrorPrint("ERROR: SQL Create Failed (InitGameAccountStuff 3)", s);
-	CALL_SQLITE (finalize(stmt));
+	G_DBFinalize (stmt);
 
 	sql = "CREATE TABLE IF NOT EXISTS LocalTeam(id INTEGER PRIMARY KEY, name VARCHAR(16), tag VARCHAR(16), longname VARCHAR(24), flags UNSIGNED TINYINT)";
-    CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+    G_DBPrepare (db, sql, & stmt);
 	s = sqlite3_step(stmt);
 	if (s != SQLITE_DONE)
 		G_ErrorPrint("ERROR: SQL Create Failed (InitGameAccountStuff 4)", s);
-	CALL_SQLITE (finalize(stmt));
+	G_DBFinalize (stmt);
 
 	sql = "CREATE TABLE IF NOT EXISTS LocalTeamAccount(id INTEGER PRIMARY KEY, team VARCHAR(16), account VARCHAR(16), flags UNSIGNED TINYINT)";
-    CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+    G_DBPrepare (db, sql, & stmt);
 	s = sqlite3_step(stmt);
 	if (s != SQLITE_DONE)
 		G_ErrorPrint("ERROR: SQL Create Failed (InitGameAccountStuff 5)", s);
-	CALL_SQLITE (finalize(stmt));
+	G_DBFinalize (stmt);
 
 #if _ELORANKING
 	/*
 	sql = "CREATE TABLE IF NOT EXISTS DuelRanks(id INTEGER PRIMARY KEY, username VARCHAR(16), type UNSIGNED SMALLINT, rank DECIMAL(6,2), TSSUM DECIMAL(9,2), count UNSIGNED INTEGER)"; //We only need like 2 decimal precision here so how do that in sqlite C? --todo
-    CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+    G_DBPrepare (db, sql, & stmt);
 	CALL_SQLITE_EXPECT (step (stmt), DONE);
-	CALL_SQLITE (finalize(stmt));
+	G_DBFinalize (stmt);
 	*/
 #endif
 
 #if 0//NEWRACERANKING
 	sql = "CREATE TABLE IF NOT EXISTS RaceRanks(id INTEGER PRIMARY KEY, username VARCHAR(16), style UNSIGNED SMALLINT, score DECIMAL(6,2), percentilesum DECIMAL(6,2), ranksum DECIMAL(6,2), golds UNSIGNED SMALLINT, silvers UNSIGNED SMALLINT, bronzes UNSIGNED SMALLINT, count UNSIGNED SMALLINT)"; //We only need like 2 decimal precision here so how do that in sqlite C? --todo
-    CALL_SQLITE (prepare_v2 (db, sql, strlen (sql) + 1, & stmt, NULL));
+    G_DBPrepare (db, sql, & stmt);
 	CALL_SQLITE_EXPECT (step (stmt), DONE);
-	CALL_SQLITE (finalize(stmt));
+	G_DBFinalize (stmt);
 #endif
 
-	CALL_SQLITE (close(db));
+	G_DBClose (db);
 
 	CleanupLocalRun(); //Deletes useless shit from LocalRun database table
 #if !_NEWRACERANKING
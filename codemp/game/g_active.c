@@ -142,22 +142,6 @@ void G_StoreTrail( gentity_t *ent ) {
 }
 
 
-/*
-=============
-TimeShiftLerp
-
-Used below to interpolate between two previous vectors
-Returns a vector "frac" times the distance between "start" and "end"
-=============
-*/
-static void TimeShiftLerp( float frac, vec3_t start, vec3_t end, vec3_t result ) {
-	float	comp = 1.0f - frac;
-
-	result[0] = frac * start[0] + comp * end[0];
-	result[1] = frac * start[1] + comp * end[1];
-	result[2] = frac * start[2] + comp * end[2];
-}
-
 static void TimeShiftAnimLerp( float frac, int anim1, int anim2, int time1, int time2, int *outTime ) {
 	if (anim1 == anim2 && time2 > time1) {//Only lerp if both anims are same and time2 is after time1.
 		*outTime = time1 + (time2 - time1)*frac;
@@ -265,22 +249,8 @@ void G_TimeShiftClient( gentity_t *ent, int time, qboolean timeshiftAnims ) {
 	}
 
 	// find two entries in the origin trail whose times sandwich "time"
-	// assumes no two adjacent trail records have the same timestamp
-	j = k = ent->client->unlagged.trailHead;
-	do {
-		if ( ent->client->unlagged.trail[j].time <= time )
-			break;
-
-		k = j;
-		j--;
-		if ( j < 0 ) {
-			j = numTrails - 1;
-		}
-	}
-	while ( j != ent->client->unlagged.trailHead );
-
-	// if we got past the first iteration above, we've sandwiched (or wrapped)
-	if ( j != k ) {
+	// if we got past the first entry, we've sandwiched (or wrapped)
+	if ( G_TrailEntriesForTime( ent->client->unlagged.trail, ent->client->unlagged.trailHead, time, &j, &k ) ) {
 		// make sure it doesn't get re-saved
 		if ( ent->client->unlagged.saved.leveltime != level.time ) {
 			// save the current origin and bounding box
@@ -307,6 +277,11 @@ void G_TimeShiftClient( gentity_t *ent, int time, qboolean timeshiftAnims ) {
 		}
 #endif
 
+		// interpolate between the two origins to give position at time index "time",
+		// lerp the size too, just for fun (and ducking)
+		G_TrailBoxForTime( ent->client->unlagged.trail, ent->client->unlagged.trailHead, time,
+			ent->r.currentOrigin, ent->r.mins, ent->r.maxs );
+
 		// if we haven't wrapped back to the head, we've sandwiched, so
 		// we shift the client's position back to where he was at "time"
 		if ( j != ent->client->unlagged.trailHead )
@@ -316,14 +291,8 @@ void G_TimeShiftClient( gentity_t *ent, int time, qboolean timeshiftAnims ) {
 			// FOR TESTING ONLY
 			//Com_Printf( "level time: %d, fire time: %d, j time: %d, k time: %d\n", level.time, time, ent->client->unlagged.trail[j].time, ent->client->unlagged.trail[k].time );
 
-			// interpolate between the two origins to give position at time index "time"
-			TimeShiftLerp( frac, ent->client->unlagged.trail[k].currentOrigin, ent->client->unlagged.trail[j].currentOrigin, ent->r.currentOrigin );
 			//ent->r.currentAngles[YAW] = LerpAngle( ent->client->unlagged.trail[k].currentAngles[YAW], ent->r.currentAngles[YAW], frac );
 
-			// lerp these too, just for fun (and ducking)
-			TimeShiftLerp( frac, ent->client->unlagged.trail[k].mins, ent->client->unlagged.trail[j].mins, ent->r.mins );
-			TimeShiftLerp( frac, ent->client->unlagged.trail[k].maxs, ent->client->unlagged.trail[j].maxs, ent->r.maxs );
-			
 			//Lerp this somehow?
 			if (timeshiftAnims) {
 				/*
@@ -349,9 +318,6 @@ void G_TimeShiftClient( gentity_t *ent, int time, qboolean timeshiftAnims ) {
 		} else {
 			// we wrapped, so grab the earliest
 			//VectorCopy( ent->client->unlagged.trail[k].currentAngles, ent->r.currentAngles );
-			VectorCopy( ent->client->unlagged.trail[k].currentOrigin, ent->r.currentOrigin );
-			VectorCopy( ent->client->unlagged.trail[k].mins, ent->r.mins );
-			VectorCopy( ent->client->unlagged.trail[k].maxs, ent->r.maxs );
 
 			if (timeshiftAnims) {
 				/*
@@ -420,6 +386,60 @@ void G_TimeShiftAllClients( int time, gentity_t *skip, qboolean timeshiftAnims )
 }
 
 
+/*
+=====================
+G_TimeShiftClientsForTrace
+
+Like G_TimeShiftAllClients for a shot that only traces from start to end,
+but clients that the trace can't come near, neither where they are now nor
+where they were at "time", are left alone instead of being moved and
+relinked. The trace hits exactly the same as with all clients shifted.
+=====================
+*/
+void G_TimeShiftClientsForTrace( int time, gentity_t *skip, const vec3_t start, const vec3_t mins, const vec3_t maxs,
+	const vec3_t end, qboolean timeshiftAnims ) {
+	int			i;
+	gentity_t	*ent;
+	vec3_t		origin, boxMins, boxMaxs;
+	vec3_t		absmin, absmax;
+
+	if (!skip->client)
+		return;
+	if (skip->r.svFlags & SVF_BOT)
+		return;
+	if (skip->s.eType == ET_NPC)
+		return;
+
+	if ( time > level.time ) {
+		time = level.time;
+	}
+
+	ent = &g_entities[0];
+	for ( i = 0; i < MAX_CLIENTS; i++, ent++ ) {
+		if ( !ent->client || !ent->inuse || ent->client->sess.sessionTeam >= TEAM_SPECTATOR || ent == skip ) {
+			continue;
+		}
+
+		if ( !G_TrailBoxForTime( ent->client->unlagged.trail, ent->client->unlagged.trailHead, time, origin, boxMins, boxMaxs ) ) {
+			continue;	// wouldn't be moved anyway
+		}
+
+		if ( !ent->r.linked || !G_TraceMayTouchBox( start, mins, maxs, end, ent->r.absmin, ent->r.absmax ) ) {
+			// the same box SV_LinkEntity will give it
+			VectorAdd( origin, boxMins, absmin );
+			VectorAdd( origin, boxMaxs, absmax );
+			absmin[0] -= 1; absmin[1] -= 1; absmin[2] -= 1;
+			absmax[0] += 1; absmax[1] += 1; absmax[2] += 1;
+
+			if ( !G_TraceMayTouchBox( start, mins, maxs, end, absmin, absmax ) ) {
+				continue;
+			}
+		}
+
+		G_TimeShiftClient( ent, time, timeshiftAnims );
+	}
+}
+
 /*
 ===================
 G_UnTimeShiftClient
@@ -3449,6 +3469,27 @@ void ClientThink_real( gentity_t *ent ) {
 		return;
 	}
 
+	if (!isNPC)
+	{
+		int serverTime = Com_Clampi( level.time - 1000, level.time + 200, client->pers.cmd.serverTime );
+
+		client->pers.cmdsThought++;
+
+		// pmove_fixed and racemode round command times up, so at high fps most
+		// commands end on a time that has already been moved to and return
+		// below without moving; leave before the saber setup as well
+		if ( serverTime <= client->ps.commandTime &&
+			client->sess.spectatorState != SPECTATOR_FOLLOW &&
+			!client->ps.m_iVehicleNum &&
+			!(client->ps.eFlags2 & EF2_HELD_BY_MONSTER) )
+		{
+			client->pers.cmd.serverTime = serverTime;
+			client->lastUpdateFrame = level.framenum; //Unlagged
+			client->pers.cmdsSkipped++;
+			return;
+		}
+	}
+
 	// This code was moved here from clientThink to fix a problem with g_synchronousClients
 	// being set to 1 when in vehicles.
 	if ( ent->s.number < MAX_CLIENTS && ent->client->ps.m_iVehicleNum )
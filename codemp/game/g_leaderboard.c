@@ -0,0 +1,254 @@
+/*
+===========================================================================
+Copyright (C) 1999 - 2005, Id Software, Inc.
+Copyright (C) 2000 - 2013, Raven Software, Inc.
+Copyright (C) 2001 - 2013, Activision, Inc.
+Copyright (C) 2013 - 2015, OpenJK contributors
+
+This file is part of the OpenJK source code.
+
+OpenJK is free software; you can redistribute it and/or modify it
+under the terms of the GNU General Public License version 2 as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, see <http://www.gnu.org/licenses/>.
+===========================================================================
+*/
+
+// g_leaderboard.c -- sorted in memory race highscore boards, see g_leaderboard.h
+
+#include "qcommon/q_shared.h"
+#include "g_leaderboard.h"
+
+#define MIN_BOARD_USER_SLOTS	64
+
+/*
+=================
+G_BoardCompare
+
+The rTop order: fastest first, then whoever got there first, then the
+higher average.  The username only keeps the order total.
+=================
+*/
+static int G_BoardCompare( const raceEntry_t *a, const raceEntry_t *b ) {
+	if ( a->duration_ms != b->duration_ms )
+		return a->duration_ms < b->duration_ms ? -1 : 1;
+	if ( a->end_time != b->end_time )
+		return a->end_time < b->end_time ? -1 : 1;
+	if ( a->average != b->average )
+		return a->average > b->average ? -1 : 1;
+	return strcmp( a->username, b->username );
+}
+
+static int QDECL G_BoardSortEntries( const void *a, const void *b ) {
+	return G_BoardCompare( (const raceEntry_t *)a, (const raceEntry_t *)b );
+}
+
+// first index whose entry does not sort before run
+static int G_BoardLowerBound( const raceBoard_t *board, const raceEntry_t *run ) {
+	int low = 0, high = board->numEntries, mid;
+
+	while ( low < high ) {
+		mid = ( low + high ) >> 1;
+		if ( G_BoardCompare( &board->entries[mid], run ) < 0 )
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	return low;
+}
+
+static unsigned int G_BoardHashName( const char *username ) {
+	unsigned int hash = 5381;
+
+	while ( *username )
+		hash = hash * 33 + (unsigned char)*username++;
+	return hash;
+}
+
+// the slot holding username, or the empty slot it would go in
+static raceEntry_t *G_BoardUserSlot( const raceBoard_t *board, const char *username ) {
+	unsigned int i = G_BoardHashName( username ) & ( board->userSlots - 1 );
+
+	while ( board->users[i].username[0] && strcmp( board->users[i].username, username ) )
+		i = ( i + 1 ) & ( board->userSlots - 1 );
+	return &board->users[i];
+}
+
+// the board is left as it was if the new table can't be allocated
+static qboolean G_BoardRehash( raceBoard_t *board, int numUsers ) {
+	raceEntry_t	*old = board->users, *users;
+	int			oldSlots = board->userSlots, userSlots = MIN_BOARD_USER_SLOTS, i;
+
+	while ( userSlots * 3 < numUsers * 4 )
+		userSlots <<= 1;
+	users = (raceEntry_t *)calloc( userSlots, sizeof( raceEntry_t ) );
+	if ( !users )
+		return qfalse;
+
+	board->users = users;
+	board->userSlots = userSlots;
+	for ( i = 0; i < oldSlots; i++ ) {
+		if ( old[i].username[0] )
+			*G_BoardUserSlot( board, old[i].username ) = old[i];
+	}
+	free( old );
+	return qtrue;
+}
+
+static qboolean G_BoardReserve( raceBoard_t *board, int numEntries ) {
+	raceEntry_t	*entries;
+	int			maxEntries;
+
+	if ( numEntries <= board->maxEntries )
+		return qtrue;
+
+	maxEntries = board->maxEntries ? board->maxEntries : MIN_BOARD_USER_SLOTS;
+	while ( maxEntries < numEntries )
+		maxEntries <<= 1;
+
+	if ( board->userSlots * 3 < maxEntries * 4 && !G_BoardRehash( board, maxEntries ) )
+		return qfalse;
+
+	entries = (raceEntry_t *)realloc( board->entries, maxEntries * sizeof( raceEntry_t ) );
+	if ( !entries )
+		return qfalse;
+
+	board->entries = entries;
+	board->maxEntries = maxEntries;
+	return qtrue;
+}
+
+qboolean G_BoardInit( raceBoard_t *board, const char *coursename, int style, int season ) {
+	memset( board, 0, sizeof( *board ) );
+	strncpy( board->coursename, coursename, sizeof( board->coursename ) - 1 );
+	board->style = style;
+	board->season = season;
+	return G_BoardRehash( board, 0 );
+}
+
+void G_BoardFree( raceBoard_t *board ) {
+	free( board->entries );
+	free( board->users );
+	memset( board, 0, sizeof( *board ) );
+}
+
+/*
+=================
+G_BoardLoad
+
+Replaces the board with rows, which may be in any order and contain more
+than one run per player; only the best one is kept.  rows is sorted in place.
+Returns qfalse if there is no memory for the rows, the board is empty then.
+=================
+*/
+qboolean G_BoardLoad( raceBoard_t *board, raceEntry_t *rows, int numRows ) {
+	raceEntry_t	*user;
+	int			i;
+
+	board->numEntries = 0;
+	memset( board->users, 0, board->userSlots * sizeof( raceEntry_t ) );
+	if ( !G_BoardReserve( board, numRows ) )
+		return qfalse;
+
+	qsort( rows, numRows, sizeof( raceEntry_t ), G_BoardSortEntries );
+	for ( i = 0; i < numRows; i++ ) {
+		if ( !rows[i].username[0] )
+			continue;
+		user = G_BoardUserSlot( board, rows[i].username );
+		if ( user->username[0] )
+			continue; // already have a faster one
+		*user = rows[i];
+		board->entries[board->numEntries++] = rows[i];
+	}
+	return qtrue;
+}
+
+/*
+=================
+G_BoardSubmit
+
+Puts a run on the board if it beats the player's time there.
+Returns qtrue if the board changed.  If there is no room for a new player
+the board is left as it was and *outOfMemory is set.
+=================
+*/
+qboolean G_BoardSubmit( raceBoard_t *board, const raceEntry_t *run, qboolean *outOfMemory ) {
+	raceEntry_t	*user;
+	int			index;
+
+	if ( outOfMemory )
+		*outOfMemory = qfalse;
+	if ( !run->username[0] )
+		return qfalse;
+
+	if ( !G_BoardReserve( board, board->numEntries + 1 ) ) {
+		if ( outOfMemory )
+			*outOfMemory = qtrue;
+		return qfalse;
+	}
+
+	user = G_BoardUserSlot( board, run->username );
+	if ( user->username[0] ) {
+		if ( run->duration_ms >= user->duration_ms )
+			return qfalse;
+
+		// take the old run out
+		index = G_BoardLowerBound( board, user );
+		memmove( &board->entries[index], &board->entries[index + 1], ( board->numEntries - index - 1 ) * sizeof( raceEntry_t ) );
+		board->numEntries--;
+	}
+	*user = *run;
+
+	index = G_BoardLowerBound( board, run );
+	memmove( &board->entries[index + 1], &board->entries[index], ( board->numEntries - index ) * sizeof( raceEntry_t ) );
+	board->entries[index] = *run;
+	board->numEntries++;
+	return qtrue;
+}
+
+/*
+=================
+G_BoardFind
+
+Index of the player's run in entries, or -1 if they have none
+=================
+*/
+int G_BoardFind( const raceBoard_t *board, const char *username ) {
+	const raceEntry_t *user;
+
+	if ( !username[0] )
+		return -1;
+
+	user = G_BoardUserSlot( board, username );
+	if ( !user->username[0] )
+		return -1;
+	return G_BoardLowerBound( board, user );
+}
+
+/*
+=================
+G_BoardRank
+
+1 based rank of entries[index].  With tiesShareRank equal times share a rank
+and the next time only goes one further, the way coop ranks are counted.
+=================
+*/
+int G_BoardRank( const raceBoard_t *board, int index, qboolean tiesShareRank ) {
+	int i, rank = 1;
+
+	if ( !tiesShareRank )
+		return index + 1;
+
+	for ( i = 1; i <= index; i++ ) {
+		if ( board->entries[i].duration_ms != board->entries[i - 1].duration_ms )
+			rank++;
+	}
+	return rank;
+}
@@ -0,0 +1,61 @@
+/*
+===========================================================================
+Copyright (C) 1999 - 2005, Id Software, Inc.
+Copyright (C) 2000 - 2013, Raven Software, Inc.
+Copyright (C) 2001 - 2013, Activision, Inc.
+Copyright (C) 2013 - 2015, OpenJK contributors
+
+This file is part of the OpenJK source code.
+
+OpenJK is free software; you can redistribute it and/or modify it
+under the terms of the GNU General Public License version 2 as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, see <http://www.gnu.org/licenses/>.
+===========================================================================
+*/
+
+#pragma once
+
+// g_leaderboard.h -- sorted in memory race highscore boards
+//
+// One board holds the best run of every player on a course for one style and
+// season, in the same order as the rTop query.  g_account.c fills them from
+// the database and keeps them current as runs are written, the lookups here
+// don't touch the database at all.
+
+#define MAX_BOARD_USERNAME	16
+
+typedef struct raceEntry_s {
+	char	username[MAX_BOARD_USERNAME];
+	int		duration_ms;
+	int		topspeed;
+	int		average;
+	int		end_time;
+} raceEntry_t;
+
+typedef struct raceBoard_s {
+	char			coursename[40];
+	int				style;
+	int				season;			// -1 for the all time board
+	int				lastUsed;
+
+	raceEntry_t		*entries;		// fastest first
+	int				numEntries, maxEntries;
+
+	raceEntry_t		*users;			// open addressed by username, the same runs as entries
+	int				userSlots;
+} raceBoard_t;
+
+qboolean	G_BoardInit( raceBoard_t *board, const char *coursename, int style, int season );
+void		G_BoardFree( raceBoard_t *board );
+qboolean	G_BoardLoad( raceBoard_t *board, raceEntry_t *rows, int numRows );
+qboolean	G_BoardSubmit( raceBoard_t *board, const raceEntry_t *run, qboolean *outOfMemory );
+int			G_BoardFind( const raceBoard_t *board, const char *username );
+int			G_BoardRank( const raceBoard_t *board, int index, qboolean tiesShareRank );
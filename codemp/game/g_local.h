@@ -389,17 +389,9 @@ void G_TimeShiftClient( gentity_t *ent, int time, qboolean timeshiftAnims );
 void G_TimeShiftAllClients( int time, gentity_t *skip, qboolean timeshiftAnims );
 void G_UnTimeShiftClient( gentity_t *ent, qboolean timeshiftAnims );
 void G_UnTimeShiftAllClients( gentity_t *skip, qboolean timeshiftAnims );
+void G_TimeShiftClientsForTrace( int time, gentity_t *skip, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end, qboolean timeshiftAnims );
 void G_PredictPlayerStepSlideMove( gentity_t *ent, float frametime );
 
-//NT - client origin trails
-#define NUM_CLIENT_TRAILS 10
-typedef struct { //Should this store their g2 anim? for proper g2 sync?
-	vec3_t	mins, maxs;
-	vec3_t	currentOrigin;//, currentAngles; //Well r.currentAngles are never actually used by clients in this game?
-	int		time, leveltime, torsoAnim, torsoTimer, legsAnim, legsTimer;
-	float	realAngle; //Only the [YAW] is ever used for hit detection
-} clientTrail_t;
-
 //JAPRO - Serverside - Emote bitrates
 typedef enum {
 	E_BEG,
@@ -814,6 +806,9 @@ typedef struct clientPersistant_s {
 
 	int			connectTime;
 
+	int			cmdsThought;		// usercmds handed to ClientThink_real
+	int			cmdsSkipped;		// of those, ones that ended on a time already moved to
+
 	qboolean	isJAPRO;//JAPRO - Serverside - Add Clientside Version
 	qboolean	JAWARUN;//JAPRO - Serverside - Add Clientside Version
 	qboolean	centerMuzzle;//JAPRO - Serverside - Check if client wants to center muzzlepoint.
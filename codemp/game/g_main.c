@@ -562,6 +562,7 @@ void G_AddSimpleStatsToDB();
 G_ShutdownGame
 =================
 */
+void G_DBShutdown( void );
 void G_ShutdownGame( int restart ) {
 	int i = 0;
 	gentity_t *ent;
@@ -569,6 +570,7 @@ void G_ShutdownGame( int restart ) {
 	//This is for the previous map, so do this here, not in initgame so cl->pers stuff does not get cleared.
 	G_AddSimpleStatsToFile();//Add previous maps stats from memory to file.
 	G_AddSimpleStatsToDB();//Add previous maps stats from file to database.  (use file incase database cant be written to, so the stats wont be lost.. we can just add them later).
+	G_DBShutdown();//Finish queued database writes, then close this map's database connections.
 
 //	trap->Print ("==== ShutdownGame ====\n");
 
@@ -3544,6 +3546,7 @@ qboolean G_PointInBounds( vec3_t point, vec3_t mins, vec3_t maxs );
 int g_siegeRespawnCheck = 0;
 void SetMoverState( gentity_t *ent, moverState_t moverState, int time );
 
+void G_DBRunCompletions( void );
 void G_RunFrame( int levelTime ) {
 	int			i;
 	int			j;
@@ -3563,6 +3566,8 @@ void G_RunFrame( int levelTime ) {
 
 	static int lastMsgTime = 0;//OSP: pause
 
+	G_DBRunCompletions(); //Race and duel results the database thread has finished
+
 	if (!level.numVotingClients && g_autoQuit.integer) {
 		if (levelTime > g_autoQuit.integer * 24 * 60 * 60 * 1000) {//X days
 			//Where to do this other than runframe.. something thats called like every 1 second?
@@ -716,7 +716,8 @@ typedef enum gameImportLegacy_e {
 	G_CM_REGISTER_TERRAIN,
 	G_RMG_INIT,
 	G_BOT_UPDATEWAYPOINTS,
-	G_BOT_CALCULATEPATHS
+	G_BOT_CALCULATEPATHS,
+	G_TRACE_BATCH
 } gameImportLegacy_t;
 
 typedef enum gameExportLegacy_e {
@@ -1098,6 +1099,8 @@ typedef struct gameImport_s {
 	void		(*G2API_CleanEntAttachments)			( void );
 	qboolean	(*G2API_OverrideServer)					( void *serverInstance );
 	void		(*G2API_GetSurfaceName)					( void *ghoul2, int surfNumber, int modelIndex, char *fillBuf );
+
+	void		(*TraceBatch)							( trace_t *results, const traceRequest_t *requests, int numRequests, int capsule, int traceFlags, int useLod );
 } gameImport_t;
 
 typedef struct gameExport_s {
@@ -836,6 +836,26 @@ void Svcmd_Say_f( void ) {
 	trap->SendServerCommand( -1, va("print \"server: %s\n\"", text ) );
 }
 
+// how many usercmds each client sent and how many of them didn't need a pmove
+void Svcmd_PmoveStats_f( void ) {
+	int i, thought = 0, skipped = 0;
+
+	trap->Print( "num name                                 usercmds  skipped\n" );
+	trap->Print( "--- ------------------------------------ -------- --------\n" );
+	for ( i = 0; i < level.maxclients; i++ ) {
+		gclient_t *cl = &level.clients[i];
+
+		if ( cl->pers.connected != CON_CONNECTED ) {
+			continue;
+		}
+		trap->Print( "%3i %-36s %8i %7i%%\n", i, cl->pers.netname_nocolor, cl->pers.cmdsThought,
+			cl->pers.cmdsThought ? (int)( 100LL * cl->pers.cmdsSkipped / cl->pers.cmdsThought ) : 0 );
+		thought += cl->pers.cmdsThought;
+		skipped += cl->pers.cmdsSkipped;
+	}
+	trap->Print( "%i usercmds, %i skipped without a pmove\n", thought, skipped );
+}
+
 typedef struct bitInfo_S {
 	const char	*string;
 } bitInfo_T;
@@ -1680,6 +1700,7 @@ svcmd_t svcmds[] = {
 	{ "listip",						Svcmd_ListIP_f,						qfalse },
 
 	{ "pause",						SV_Pause_f,							qfalse },
+	{ "pmoveStats",					Svcmd_PmoveStats_f,					qfalse },
 
 #if _ELORANKING
 	{ "rebuildElo",					SV_RebuildElo_f,					qfalse },
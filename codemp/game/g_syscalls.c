@@ -1127,6 +1127,9 @@ void trap_Bot_UpdateWaypoints(int wpnum, wpobject_t **wps) {
 void trap_Bot_CalculatePaths(int rmg) {
 	Q_syscall(G_BOT_CALCULATEPATHS, rmg);
 }
+void trap_TraceBatch( trace_t *results, const traceRequest_t *requests, int numRequests, int capsule, int traceFlags, int useLod ) {
+	Q_syscall( G_TRACE_BATCH, results, requests, numRequests, capsule, traceFlags, useLod );
+}
 
 
 // Translate import table funcptrs to syscalls
@@ -1488,4 +1491,6 @@ static void TranslateSyscalls( void ) {
 	trap->G2API_CleanEntAttachments			= trap_G2API_CleanEntAttachments;
 	trap->G2API_OverrideServer				= trap_G2API_OverrideServer;
 	trap->G2API_GetSurfaceName				= trap_G2API_GetSurfaceName;
+
+	trap->TraceBatch						= trap_TraceBatch;
 }
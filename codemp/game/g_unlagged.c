@@ -0,0 +1,147 @@
+/*
+===========================================================================
+Copyright (C) 2013 - 2015, OpenJK contributors
+
+This file is part of the OpenJK source code.
+
+OpenJK is free software; you can redistribute it and/or modify it
+under the terms of the GNU General Public License version 2 as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, see <http://www.gnu.org/licenses/>.
+===========================================================================
+*/
+
+// g_unlagged.c -- trail lookups for the unlagged hitscan code in g_active.c
+
+#include "qcommon/q_shared.h"
+#include "g_unlagged.h"
+
+/*
+=================
+G_TrailEntriesForTime
+
+Finds the two entries in the origin trail whose times sandwich "time".
+Returns qfalse if the client doesn't have to be moved at all. If older
+is the trail head, the trail wrapped and newer is the earliest entry.
+=================
+*/
+qboolean G_TrailEntriesForTime( const clientTrail_t *trail, int head, int time, int *older, int *newer ) {
+	int		j, k;
+
+	// assumes no two adjacent trail records have the same timestamp
+	j = k = head;
+	do {
+		if ( trail[j].time <= time )
+			break;
+
+		k = j;
+		j--;
+		if ( j < 0 ) {
+			j = NUM_CLIENT_TRAILS - 1;
+		}
+	}
+	while ( j != head );
+
+	*older = j;
+	*newer = k;
+
+	// if we got past the first iteration above, we've sandwiched (or wrapped)
+	return (qboolean)( j != k );
+}
+
+/*
+=================
+G_TrailBoxForTime
+
+Position and size of the client at "time", exactly as G_TimeShiftClient
+places it. Returns qfalse if the client isn't moved for that time.
+=================
+*/
+qboolean G_TrailBoxForTime( const clientTrail_t *trail, int head, int time, vec3_t origin, vec3_t mins, vec3_t maxs ) {
+	const clientTrail_t	*older, *newer;
+	float				frac, comp;
+	int					i, j, k;
+
+	if ( !G_TrailEntriesForTime( trail, head, time, &j, &k ) ) {
+		return qfalse;
+	}
+
+	older = &trail[j];
+	newer = &trail[k];
+
+	if ( j == head ) {
+		// we wrapped, so grab the earliest
+		for ( i = 0; i < 3; i++ ) {
+			origin[i] = newer->currentOrigin[i];
+			mins[i] = newer->mins[i];
+			maxs[i] = newer->maxs[i];
+		}
+		return qtrue;
+	}
+
+	// interpolate between the two entries to give the box at time index "time"
+	frac = (float)(newer->time - time) / (float)(newer->time - older->time);
+	comp = 1.0f - frac;
+	for ( i = 0; i < 3; i++ ) {
+		origin[i] = frac * newer->currentOrigin[i] + comp * older->currentOrigin[i];
+		mins[i] = frac * newer->mins[i] + comp * older->mins[i];
+		maxs[i] = frac * newer->maxs[i] + comp * older->maxs[i];
+	}
+	return qtrue;
+}
+
+/*
+=================
+G_TraceMayTouchBox
+
+Cheap test whether a trace from start to end with the given size (NULL
+for a point trace) can come near the absolute box. Generous by a unit,
+so it never misses anything the real trace would hit.
+=================
+*/
+qboolean G_TraceMayTouchBox( const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end,
+	const vec3_t absmin, const vec3_t absmax ) {
+	float	tmin = 0.0f, tmax = 1.0f;
+	float	lo, hi, d, t1, t2;
+	int		i;
+
+	for ( i = 0; i < 3; i++ ) {
+		// grow the box by the size of the trace so it can be treated as a line
+		lo = absmin[i] - ( maxs ? maxs[i] : 0.0f ) - 1.0f;
+		hi = absmax[i] - ( mins ? mins[i] : 0.0f ) + 1.0f;
+		d = end[i] - start[i];
+
+		if ( fabsf( d ) < 0.0001f ) {
+			if ( start[i] < lo || start[i] > hi ) {
+				return qfalse;
+			}
+			continue;
+		}
+
+		t1 = ( lo - start[i] ) / d;
+		t2 = ( hi - start[i] ) / d;
+		if ( t1 > t2 ) {
+			float t = t1;
+			t1 = t2;
+			t2 = t;
+		}
+		if ( t1 > tmin ) {
+			tmin = t1;
+		}
+		if ( t2 < tmax ) {
+			tmax = t2;
+		}
+		if ( tmin > tmax ) {
+			return qfalse;
+		}
+	}
+
+	return qtrue;
+}
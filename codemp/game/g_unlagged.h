@@ -1 +1,43 @@
+/*
+===========================================================================
+Copyright (C) 1999 - 2005, Id Software, Inc.
+Copyright (C) 2000 - 2013, Raven Software, Inc.
+Copyright (C) 2001 - 2013, Activision, Inc.
+Copyright (C) 2013 - 2015, OpenJK contributors
 
+This file is part of the OpenJK source code.
+
+OpenJK is free software; you can redistribute it and/or modify it
+under the terms of the GNU General Public License version 2 as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, see <http://www.gnu.org/licenses/>.
+===========================================================================
+*/
+
+#pragma once
+
+// g_unlagged.h -- client origin trails used to rewind clients for hitscan weapons
+//
+// Only the trail math lives in g_unlagged.c, so it can be tested without the
+// rest of the game.
+
+//NT - client origin trails
+#define NUM_CLIENT_TRAILS 10
+typedef struct { //Should this store their g2 anim? for proper g2 sync?
+	vec3_t	mins, maxs;
+	vec3_t	currentOrigin;//, currentAngles; //Well r.currentAngles are never actually used by clients in this game?
+	int		time, leveltime, torsoAnim, torsoTimer, legsAnim, legsTimer;
+	float	realAngle; //Only the [YAW] is ever used for hit detection
+} clientTrail_t;
+
+qboolean G_TrailEntriesForTime( const clientTrail_t *trail, int head, int time, int *older, int *newer );
+qboolean G_TrailBoxForTime( const clientTrail_t *trail, int head, int time, vec3_t origin, vec3_t mins, vec3_t maxs );
+qboolean G_TraceMayTouchBox( const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end,
+	const vec3_t absmin, const vec3_t absmax );
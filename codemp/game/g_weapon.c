@@ -276,7 +276,7 @@ static void WP_FireColt(gentity_t *ent, qboolean altFire)
 	VectorMA(start, 1, vright, start);
 
 	if (g_unlagged.integer & UNLAGGED_HITSCAN)
-		G_TimeShiftAllClients(ent->client->pers.cmd.serverTime, ent, qfalse);
+		G_TimeShiftClientsForTrace(ent->client->pers.cmd.serverTime, ent, start, NULL, NULL, end, qfalse);
 
 	ignore = ent->s.number;
 
@@ -795,7 +795,7 @@ static void WP_DisruptorMainFire( gentity_t *ent )
 	VectorMA( start, shotRange, forward, end );
 
 	if ( g_unlagged.integer & UNLAGGED_HITSCAN )
-		G_TimeShiftAllClients( ent->client->pers.cmd.serverTime, ent, ghoul2 );
+		G_TimeShiftClientsForTrace( ent->client->pers.cmd.serverTime, ent, start, NULL, NULL, end, ghoul2 );
 
 	ignore = ent->s.number;
 	traces = 0;
@@ -1084,8 +1084,11 @@ void WP_DisruptorAltFire(gentity_t *ent)
 
 	skip = ent->s.number;
 
-	if ( g_unlagged.integer & UNLAGGED_HITSCAN )
-		G_TimeShiftAllClients( ent->client->pers.cmd.serverTime, ent, ghoul2 );
+	if ( g_unlagged.integer & UNLAGGED_HITSCAN ) {
+		// each trace starts where the last one stopped, so together they never go past this
+		VectorMA( start, shotRange * traces, forward, end );
+		G_TimeShiftClientsForTrace( ent->client->pers.cmd.serverTime, ent, start, NULL, NULL, end, ghoul2 );
+	}
 
 	for (i = 0; i < traces; i++ )
 	{
@@ -4753,8 +4756,11 @@ static void WP_FireConcussionAlt( gentity_t *ent )
 	VectorSet( shot_mins, -1, -1, -1 );
 	VectorSet( shot_maxs, 1, 1, 1 );
 
-	if ( g_unlagged.integer & UNLAGGED_HITSCAN )
-		G_TimeShiftAllClients( ent->client->pers.cmd.serverTime, ent, ghoul2 );
+	if ( g_unlagged.integer & UNLAGGED_HITSCAN ) {
+		// each trace starts where the last one stopped, so together they never go past this
+		VectorMA( start, shotRange * traces, forward, end );
+		G_TimeShiftClientsForTrace( ent->client->pers.cmd.serverTime, ent, start, shot_mins, shot_maxs, end, ghoul2 );
+	}
 
 	for ( i = 0; i < traces; i++ )
 	{
@@ -5269,7 +5275,7 @@ static void WP_FireLightningGun( gentity_t *ent )
 	VectorMA( start, 1, vright, start );
 
 	if ( g_unlagged.integer & UNLAGGED_HITSCAN )
-		G_TimeShiftAllClients( ent->client->pers.cmd.serverTime, ent, ghoul2 );
+		G_TimeShiftClientsForTrace( ent->client->pers.cmd.serverTime, ent, start, NULL, NULL, end, ghoul2 );
 
 	ignore = ent->s.number;
 
@@ -5382,7 +5388,7 @@ static void WP_FireShockLance( gentity_t *ent )
 	VectorMA( start, 1, vright, start );
 
 	if ( g_unlagged.integer & UNLAGGED_HITSCAN )
-		G_TimeShiftAllClients( ent->client->pers.cmd.serverTime, ent, qfalse );
+		G_TimeShiftClientsForTrace( ent->client->pers.cmd.serverTime, ent, start, NULL, NULL, end, qfalse );
 
 	ignore = ent->s.number;
 
@@ -35,11 +35,71 @@ ICARUS_Instance		*iICARUS;
 bufferlist_t		ICARUS_BufferList;
 entlist_t			ICARUS_EntList;
 
+static scriptcache_t	ICARUS_ScriptCache;		//All loaded scripts by content checksum, ICARUS_BufferList points into it
+static int				ICARUS_Session;
+
 extern uint32_t Com_BlockChecksum (const void *buffer, int length);
 extern	void	Q3_DebugPrint( int level, const char *format, ... );
 
 int			ICARUS_entFilter = -1;
 
+/*
+=============
+ICARUS_FindCachedScript
+
+Finds a loaded script with exactly these contents
+=============
+*/
+
+static pscript_t *ICARUS_FindCachedScript( const char *buffer, long length, uint32_t checksum )
+{
+	std::pair< scriptcache_t::iterator, scriptcache_t::iterator > range = ICARUS_ScriptCache.equal_range( checksum );
+
+	for ( scriptcache_t::iterator ci = range.first; ci != range.second; ++ci )
+	{
+		pscript_t *pscript = (*ci).second;
+
+		if ( pscript->length == length && !memcmp( pscript->buffer, buffer, length ) )
+			return pscript;
+	}
+
+	return NULL;
+}
+
+/*
+=============
+ICARUS_FlushScriptCache
+
+Frees every cached script not registered during keepSession, -1 frees them all
+=============
+*/
+
+static void ICARUS_FlushScriptCache( int keepSession )
+{
+	scriptcache_t::iterator	ci = ICARUS_ScriptCache.begin();
+
+	while ( ci != ICARUS_ScriptCache.end() )
+	{
+		pscript_t *pscript = (*ci).second;
+
+		if ( pscript->session == keepSession )
+		{
+			++ci;
+			continue;
+		}
+
+		for ( size_t i = 0; i < pscript->precache.size(); i++ )
+		{
+			delete pscript->precache[i];
+		}
+
+		ICARUS_Free( pscript->buffer );
+		delete pscript;
+
+		ICARUS_ScriptCache.erase( ci++ );
+	}
+}
+
 /*
 =============
 ICARUS_GetScript
@@ -165,6 +225,7 @@ void ICARUS_Init( void )
 
 	//Create the ICARUS instance for this session
 	iICARUS = ICARUS_Instance::Create( &interface_export );
+	ICARUS_Session++;
 
 	if ( iICARUS == NULL )
 	{
@@ -183,7 +244,6 @@ Frees up ICARUS resources from all entities
 
 void ICARUS_Shutdown( void )
 {
-	bufferlist_t::iterator	ei;
 	sharedEntity_t				*ent = SV_GentityNum(0);
 
 	//Release all ICARUS resources from the entities
@@ -203,15 +263,9 @@ void ICARUS_Shutdown( void )
 		}
 	}
 
-	//Clear out all precached scripts
-	for ( ei = ICARUS_BufferList.begin(); ei != ICARUS_BufferList.end(); ++ei )
-	{
-		//gi.Free( (*ei).second->buffer );
-		ICARUS_Free((*ei).second->buffer);
-		delete (*ei).second;
-	}
-
+	//Clear out all precached scripts, the ones this session used are kept for the next map if caching
 	ICARUS_BufferList.clear();
+	ICARUS_FlushScriptCache( sv_icarusCache->integer ? ICARUS_Session : -1 );
 
 	//Clear the name map
 	ICARUS_EntList.clear();
@@ -350,6 +404,7 @@ bool ICARUS_RegisterScript( const char *name, qboolean bCalledDuringInterrogate
 	char		newname[MAX_FILENAME_LENGTH];
 	char		*buffer = NULL;	// lose compiler warning about uninitialised vars
 	long		length;
+	uint32_t	checksum;
 
 	//Make sure this isn't already cached
 	ei = ICARUS_BufferList.find( (char *) name );
@@ -402,11 +457,24 @@ bool ICARUS_RegisterScript( const char *name, qboolean bCalledDuringInterrogate
 		return false;
 	}
 
-	pscript = new pscript_t;
+	//Scripts with the same contents share one entry, which may still be around from an earlier map
+	checksum = Com_BlockChecksum( buffer, length );
+	pscript = ICARUS_FindCachedScript( buffer, length, checksum );
 
-	pscript->buffer = (char *) ICARUS_Malloc(length);//gi.Malloc(length, TAG_ICARUS, qfalse);
-	memcpy (pscript->buffer, buffer, length);
-	pscript->length = length;
+	if ( pscript == NULL )
+	{
+		pscript = new pscript_t;
+
+		pscript->buffer = (char *) ICARUS_Malloc(length);//gi.Malloc(length, TAG_ICARUS, qfalse);
+		memcpy (pscript->buffer, buffer, length);
+		pscript->length = length;
+		pscript->checksum = checksum;
+		pscript->interrogated = false;
+
+		ICARUS_ScriptCache.insert( scriptcache_t::value_type( checksum, pscript ) );
+	}
+
+	pscript->session = ICARUS_Session;
 
 	FS_FreeFile( buffer );
 
@@ -433,6 +501,124 @@ int ICARUS_GetIDForString( const char *string )
 	return GVM_ICARUS_GetSetIDForString();
 }
 
+/*
+-------------------------
+ICARUS_InterrogateBlock
+-------------------------
+*/
+
+void ICARUS_InterrogateScript( const char *filename );
+
+static void ICARUS_InterrogateBlock( CBlock &block )
+{
+	CBlockMember	*blockMember;
+	const char		*sVal1, *sVal2;
+	char			temp[1024];
+	int				setID;
+
+	//Determine what type of block this is
+	switch( block.GetBlockID() )
+	{
+	case ID_CAMERA:	// to cache ROFF files
+		{
+			float f = *(float *) block.GetMemberData( 0 );
+
+			if (f == TYPE_PATH)
+			{
+				sVal1 = (const char *) block.GetMemberData( 1 );
+
+				//we can do this I guess since the roff is loaded on the server.
+				theROFFSystem.Cache((char *)sVal1, qfalse);
+			}
+		}
+		break;
+
+	case ID_PLAY:	// to cache ROFF files
+
+		sVal1 = (const char *) block.GetMemberData( 0 );
+
+		if (!Q_stricmp(sVal1,"PLAY_ROFF"))
+		{
+			sVal1 = (const char *) block.GetMemberData( 1 );
+
+			//we can do this I guess since the roff is loaded on the server.
+			theROFFSystem.Cache((char *)sVal1, qfalse);
+		}
+		break;
+
+	//Run commands
+	case ID_RUN:
+
+		sVal1 = (const char *) block.GetMemberData( 0 );
+
+		COM_StripExtension( sVal1, (char *) temp, sizeof( temp ) );
+		ICARUS_InterrogateScript( (const char *) &temp );
+
+		break;
+
+	case ID_SOUND:
+		//We can't just call over to S_RegisterSound or whatever because this is on the server.
+		sVal1 = (const char *) block.GetMemberData( 1 );	//0 is channel, 1 is filename
+		ICARUS_SoundPrecache(sVal1);
+		break;
+
+	case ID_SET:
+		blockMember = block.GetMember( 0 );
+
+		//NOTENOTE: This will not catch special case get() inlines! (There's not really a good way to do that)
+
+		//Make sure we're testing against strings
+		if ( blockMember->GetID() == TK_STRING )
+		{
+			sVal1 = (const char *) block.GetMemberData( 0 );
+			sVal2 = (const char *) block.GetMemberData( 1 );
+
+			//Get the id for this set identifier
+			setID = ICARUS_GetIDForString( sVal1 );
+
+			//Check against valid types
+			switch ( setID )
+			{
+			case SET_SPAWNSCRIPT:
+			case SET_USESCRIPT:
+			case SET_AWAKESCRIPT:
+			case SET_ANGERSCRIPT:
+			case SET_ATTACKSCRIPT:
+			case SET_VICTORYSCRIPT:
+			case SET_LOSTENEMYSCRIPT:
+			case SET_PAINSCRIPT:
+			case SET_FLEESCRIPT:
+			case SET_DEATHSCRIPT:
+			case SET_DELAYEDSCRIPT:
+			case SET_BLOCKEDSCRIPT:
+			case SET_FFIRESCRIPT:
+			case SET_FFDEATHSCRIPT:
+			case SET_MINDTRICKSCRIPT:
+			case SET_CINEMATIC_SKIPSCRIPT:
+				//Recursively obtain all embedded scripts
+				ICARUS_InterrogateScript( sVal2 );
+				break;
+			case SET_LOOPSOUND:		//like ID_SOUND, but set's looping
+				ICARUS_SoundPrecache(sVal2);
+				break;
+			case SET_VIDEO_PLAY:	//in game cinematic
+				//do nothing for MP.
+				break;
+			case SET_ADDRHANDBOLT_MODEL:
+			case SET_ADDLHANDBOLT_MODEL:
+				//do nothing for MP
+				break;
+			default:
+				break;
+			}
+		}
+		break;
+
+	default:
+		break;
+	}
+}
+
 /*
 -------------------------
 ICARUS_InterrogateScript
@@ -444,8 +630,8 @@ ICARUS_InterrogateScript
 void ICARUS_InterrogateScript( const char *filename )
 {
 	CBlockStream	stream;
-	CBlockMember	*blockMember;
-	CBlock			block;
+	CBlock			*block;
+	pscript_t		*pscript;
 
 	if (!Q_stricmp(filename,"NULL") || !Q_stricmp(filename,"default"))
 		return;
@@ -472,136 +658,58 @@ void ICARUS_InterrogateScript( const char *filename )
 	if ( ICARUS_RegisterScript( sFilename, qtrue ) == false )	// true = bCalledDuringInterrogate
 		return;
 
-	char	*buf;
-	long	len;
-
 	//Attempt to retrieve the new script data
-	if ( ( len = ICARUS_GetScript ( sFilename,  &buf ) ) == 0 )
-		return;
+	bufferlist_t::iterator ei = ICARUS_BufferList.find( sFilename );
 
-	//Open the stream
-	if ( stream.Open( buf, len ) == qfalse )
+	if ( ei == ICARUS_BufferList.end() )
 		return;
 
-	const char	*sVal1, *sVal2;
-	char		temp[1024];
-	int			setID;
+	pscript = (*ei).second;
 
-	//Now iterate through all blocks of the script, searching for keywords
-	while ( stream.BlockAvailable() )
+	//Decode the script the first time its contents are seen, keeping only the blocks
+	//that need precaching, later maps and scripts with the same contents reuse them
+	if ( pscript->interrogated == false )
 	{
-		//Get a block
-		if ( stream.ReadBlock( &block ) == qfalse )
+		pscript->interrogated = true;
+
+		//Open the stream
+		if ( stream.Open( pscript->buffer, pscript->length ) == qfalse )
 			return;
 
-		//Determine what type of block this is
-		switch( block.GetBlockID() )
+		while ( stream.BlockAvailable() )
 		{
-		case ID_CAMERA:	// to cache ROFF files
-			{
-				float f = *(float *) block.GetMemberData( 0 );
+			block = new CBlock;
 
-				if (f == TYPE_PATH)
-				{
-					sVal1 = (const char *) block.GetMemberData( 1 );
-
-					//we can do this I guess since the roff is loaded on the server.
-					theROFFSystem.Cache((char *)sVal1, qfalse);
-				}
-			}
-			break;
-
-		case ID_PLAY:	// to cache ROFF files
-
-			sVal1 = (const char *) block.GetMemberData( 0 );
-
-			if (!Q_stricmp(sVal1,"PLAY_ROFF"))
+			if ( stream.ReadBlock( block ) == qfalse )
 			{
-				sVal1 = (const char *) block.GetMemberData( 1 );
-
-				//we can do this I guess since the roff is loaded on the server.
-				theROFFSystem.Cache((char *)sVal1, qfalse);
+				delete block;
+				break;
 			}
-			break;
-
-		//Run commands
-		case ID_RUN:
-
-			sVal1 = (const char *) block.GetMemberData( 0 );
-
-			COM_StripExtension( sVal1, (char *) temp, sizeof( temp ) );
-			ICARUS_InterrogateScript( (const char *) &temp );
 
-			break;
-
-		case ID_SOUND:
-			//We can't just call over to S_RegisterSound or whatever because this is on the server.
-			sVal1 = (const char *) block.GetMemberData( 1 );	//0 is channel, 1 is filename
-			ICARUS_SoundPrecache(sVal1);
-			break;
-
-		case ID_SET:
-			blockMember = block.GetMember( 0 );
-
-			//NOTENOTE: This will not catch special case get() inlines! (There's not really a good way to do that)
-
-			//Make sure we're testing against strings
-			if ( blockMember->GetID() == TK_STRING )
+			switch( block->GetBlockID() )
 			{
-				sVal1 = (const char *) block.GetMemberData( 0 );
-				sVal2 = (const char *) block.GetMemberData( 1 );
-
-				//Get the id for this set identifier
-				setID = ICARUS_GetIDForString( sVal1 );
-
-				//Check against valid types
-				switch ( setID )
-				{
-				case SET_SPAWNSCRIPT:
-				case SET_USESCRIPT:
-				case SET_AWAKESCRIPT:
-				case SET_ANGERSCRIPT:
-				case SET_ATTACKSCRIPT:
-				case SET_VICTORYSCRIPT:
-				case SET_LOSTENEMYSCRIPT:
-				case SET_PAINSCRIPT:
-				case SET_FLEESCRIPT:
-				case SET_DEATHSCRIPT:
-				case SET_DELAYEDSCRIPT:
-				case SET_BLOCKEDSCRIPT:
-				case SET_FFIRESCRIPT:
-				case SET_FFDEATHSCRIPT:
-				case SET_MINDTRICKSCRIPT:
-				case SET_CINEMATIC_SKIPSCRIPT:
-					//Recursively obtain all embedded scripts
-					ICARUS_InterrogateScript( sVal2 );
-					break;
-				case SET_LOOPSOUND:		//like ID_SOUND, but set's looping
-					ICARUS_SoundPrecache(sVal2);
-					break;
-				case SET_VIDEO_PLAY:	//in game cinematic
-					//do nothing for MP.
-					break;
-				case SET_ADDRHANDBOLT_MODEL:
-				case SET_ADDLHANDBOLT_MODEL:
-					//do nothing for MP
-					break;
-				default:
-					break;
-				}
+			case ID_CAMERA:
+			case ID_PLAY:
+			case ID_RUN:
+			case ID_SOUND:
+			case ID_SET:
+				pscript->precache.push_back( block );
+				break;
+
+			default:
+				delete block;
+				break;
 			}
-			break;
-
-		default:
-			break;
 		}
 
-		//Clean out the block for the next pass
-		block.Free();
+		stream.Free();
 	}
 
-	//All done
-	stream.Free();
+	//Now go through the blocks of the script, searching for keywords
+	for ( size_t i = 0; i < pscript->precache.size(); i++ )
+	{
+		ICARUS_InterrogateBlock( *pscript->precache[i] );
+	}
 }
 
 stringID_table_t BSTable[] =
@@ -24,15 +24,27 @@ along with this program; if not, see <http://www.gnu.org/licenses/>.
 
 #include <map>
 #include <string>
+#include <vector>
 
+class CBlock;
+
+// One loaded script. Scripts are kept by content, several names with the same
+// file contents share an entry, and with sv_icarusCache the entries outlive the
+// ICARUS session that loaded them.
 typedef struct pscript_s
 {
 	char	*buffer;
 	long	length;
+	uint32_t	checksum;		//Com_BlockChecksum of the buffer
+	int		session;			//Last ICARUS session that registered it
+
+	bool	interrogated;
+	std::vector< CBlock * >	precache;	//The blocks ICARUS_InterrogateScript acts on, decoded once
 } pscript_t;
 
 typedef	std::map < std::string, int >		entlist_t;
 typedef std::map < std::string, pscript_t* >	bufferlist_t;
+typedef std::multimap < uint32_t, pscript_t* >	scriptcache_t;
 
 //ICARUS includes
 extern	interface_export_t	interface_export;
@@ -41,38 +41,27 @@ CTask
 
 CTask::CTask( void )
 {
+	m_id		= 0;
+	m_timeStamp	= 0;
+	m_block		= NULL;
+	m_poolIndex	= -1;
 }
 
 CTask::~CTask( void )
 {
 }
 
-CTask *CTask::Create( int GUID, CBlock *block )
-{
-	CTask *task = new CTask;
-
-	//TODO: Emit warning
-	assert( task );
-	if ( task == NULL )
-		return NULL;
-
-	task->SetTimeStamp( 0 );
-	task->SetBlock( block );
-	task->SetGUID( GUID );
-
-	return task;
-}
-
 /*
 -------------------------
-Free
+Init
 -------------------------
 */
 
-void CTask::Free( void )
+void CTask::Init( int GUID, CBlock *block )
 {
-	//NOTENOTE: The block is not consumed by the task, it is the sequencer's job to clean blocks up
-	delete this;
+	SetTimeStamp( 0 );
+	SetBlock( block );
+	SetGUID( GUID );
 }
 
 /*
@@ -129,7 +118,24 @@ Add
 
 int CTaskGroup::Add( CTask *task )
 {
-	m_completedTasks[ task->GetGUID() ] = false;
+	taskCallback_t	callback;
+
+	callback.id			= task->GetGUID();
+	callback.completed	= false;
+
+	//GUIDs are handed out in order, so this is nearly always an append
+	taskCallback_v::iterator tci = m_completedTasks.end();
+
+	while ( tci != m_completedTasks.begin() && (tci - 1)->id >= callback.id )
+		--tci;
+
+	if ( tci != m_completedTasks.end() && tci->id == callback.id )
+	{
+		tci->completed = false;
+		return TASK_OK;
+	}
+
+	m_completedTasks.insert( tci, callback );
 	return TASK_OK;
 }
 
@@ -141,9 +147,21 @@ MarkTaskComplete
 
 bool CTaskGroup::MarkTaskComplete( int id )
 {
-	if ( (m_completedTasks.find( id )) != m_completedTasks.end() )
+	int	low = 0, high = (int)m_completedTasks.size();
+
+	while ( low < high )
 	{
-		m_completedTasks[ id ] = true;
+		int mid = ( low + high ) >> 1;
+
+		if ( m_completedTasks[ mid ].id < id )
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	if ( low < (int)m_completedTasks.size() && m_completedTasks[ low ].id == id )
+	{
+		m_completedTasks[ low ].completed = true;
 		m_numCompleted++;
 
 		return true;
@@ -215,7 +233,7 @@ int CTaskManager::Free( void )
 	//Clear out all pending tasks
 	for ( ti = m_tasks.begin(); ti != m_tasks.end(); ++ti )
 	{
-		(*ti)->Free();
+		FreeTask( *ti );
 	}
 
 	m_tasks.clear();
@@ -228,7 +246,6 @@ int CTaskManager::Free( void )
 
 	m_taskGroups.clear();
 	m_taskGroupNameMap.clear();
-	m_taskGroupIDMap.clear();
 
 	return TASK_OK;
 }
@@ -283,11 +300,11 @@ CTaskGroup *CTaskManager::AddTaskGroup( const char *name )
 
 	//Setup the internal information
 	group->SetGUID( m_GUID++ );
+	group->SetName( name );
 
 	//Add it to the list and associate it for retrieval later
 	m_taskGroups.insert( m_taskGroups.end(), group );
-	m_taskGroupNameMap[ name ] = group;
-	m_taskGroupIDMap[ group->GetGUID() ] = group;
+	m_taskGroupNameMap[ group->GetName() ] = group;
 
 	return group;
 }
@@ -315,17 +332,25 @@ CTaskGroup *CTaskManager::GetTaskGroup( const char *name )
 
 CTaskGroup *CTaskManager::GetTaskGroup( int id )
 {
-	taskGroupID_m::iterator	tgi;
+	int	low = 0, high = (int)m_taskGroups.size();
 
-	tgi = m_taskGroupIDMap.find( id );
+	while ( low < high )
+	{
+		int mid = ( low + high ) >> 1;
 
-	if ( tgi == m_taskGroupIDMap.end() )
+		if ( m_taskGroups[ mid ]->GetGUID() < id )
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	if ( low == (int)m_taskGroups.size() || m_taskGroups[ low ]->GetGUID() != id )
 	{
 		(m_owner->GetInterface())->I_DPrintf( WL_WARNING, "Could not find task group \"%d\"\n", id );
 		return NULL;
 	}
 
-	return (*tgi).second;
+	return m_taskGroups[ low ];
 }
 
 /*
@@ -829,7 +854,7 @@ int	CTaskManager::Go( void )
 
 		default:
 			assert(0);
-			task->Free();
+			FreeTask( task );
 			(m_owner->GetInterface())->I_DPrintf( WL_ERROR, "Found unknown task type!\n" );
 			return TASK_FAILED;
 			break;
@@ -838,7 +863,7 @@ int	CTaskManager::Go( void )
 		//Pump the sequencer for another task
 		CallbackCommand( task, TASK_RETURN_COMPLETE );
 
-		task->Free();
+		FreeTask( task );
 	}
 
 	//FIXME: A command surge limiter could be implemented at this point to be sure a script doesn't
@@ -855,7 +880,7 @@ SetCommand
 
 int	CTaskManager::SetCommand( CBlock *command, int type )
 {
-	CTask	*task = CTask::Create( m_GUID++, command );
+	CTask	*task = AllocTask( m_GUID++, command );
 
 	//If this is part of a task group, add it in
 	if ( m_curGroup )
@@ -972,7 +997,7 @@ CBlock *CTaskManager::RecallTask( void )
 	{
 	// fixed 2/12/2 to free the task that has been popped (called from sequencer Recall)
 		CBlock* retBlock = task->GetBlock();
-		task->Free();
+		FreeTask( task );
 
 		return retBlock;
 	//	return task->GetBlock();
@@ -994,13 +1019,13 @@ int	CTaskManager::PushTask( CTask *task, int flag )
 	switch ( flag )
 	{
 	case PUSH_FRONT:
-		m_tasks.insert(m_tasks.begin(), task);
+		m_tasks.push_front( task );
 
 		return TASK_OK;
 		break;
 
 	case PUSH_BACK:
-		m_tasks.insert(m_tasks.end(), task);
+		m_tasks.push_back( task );
 
 		return TASK_OK;
 		break;
@@ -1046,6 +1071,47 @@ CTask *CTaskManager::PopTask( int flag )
 	return NULL;
 }
 
+/*
+-------------------------
+AllocTask
+-------------------------
+*/
+
+CTask *CTaskManager::AllocTask( int GUID, CBlock *block )
+{
+	CTask	*task;
+
+	if ( m_freeTasks.empty() )
+	{
+		//Growing the back of a deque never moves the tasks already handed out
+		m_taskPool.push_back( CTask() );
+
+		task = &m_taskPool.back();
+		task->SetPoolIndex( (int)m_taskPool.size() - 1 );
+	}
+	else
+	{
+		task = &m_taskPool[ m_freeTasks.back() ];
+		m_freeTasks.pop_back();
+	}
+
+	task->Init( GUID, block );
+
+	return task;
+}
+
+/*
+-------------------------
+FreeTask
+-------------------------
+*/
+
+void CTaskManager::FreeTask( CTask *task )
+{
+	//NOTENOTE: The block is not consumed by the task, it is the sequencer's job to clean blocks up
+	m_freeTasks.push_back( task->GetPoolIndex() );
+}
+
 /*
 -------------------------
 GetCurrentTask
@@ -1060,7 +1126,7 @@ CBlock *CTaskManager::GetCurrentTask( void )
 		return NULL;
 // fixed 2/12/2 to free the task that has been popped (called from sequencer Interrupt)
 	CBlock* retBlock = task->GetBlock();
-	task->Free();
+	FreeTask( task );
 
 	return retBlock;
 //	return task->GetBlock();
@@ -0,0 +1,128 @@
+/*
+===========================================================================
+Copyright (C) 2013 - 2015, OpenJK contributors
+
+This file is part of the OpenJK source code.
+
+OpenJK is free software; you can redistribute it and/or modify it
+under the terms of the GNU General Public License version 2 as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, see <http://www.gnu.org/licenses/>.
+===========================================================================
+*/
+
+#pragma once
+
+// Ring Queue Header File
+
+// A double ended queue of pointers kept in one circular array. Tasks and
+// commands are pushed and popped at both ends every frame, this only
+// allocates when the queue grows past the largest size it has held.
+
+#include <stddef.h>
+#include <vector>
+
+template < class T >
+class CRingQueue
+{
+public:
+
+	class iterator
+	{
+	public:
+
+		iterator( void ) : m_queue( NULL ), m_index( 0 ) {}
+		iterator( const CRingQueue *queue, int index ) : m_queue( queue ), m_index( index ) {}
+
+		T			operator*( void )	const	{	return (*m_queue)[ m_index ];	}
+		iterator	&operator++( void )			{	m_index++; return *this;		}
+
+		bool operator==( const iterator &other )	const	{	return ( m_index == other.m_index );	}
+		bool operator!=( const iterator &other )	const	{	return ( m_index != other.m_index );	}
+
+	private:
+
+		const CRingQueue	*m_queue;
+		int					m_index;
+	};
+
+	CRingQueue( void ) : m_head( 0 ), m_count( 0 ) {}
+
+	bool	empty( void )	const	{	return ( m_count == 0 );	}
+	int		size( void )	const	{	return m_count;				}
+
+	iterator	begin( void )	const	{	return iterator( this, 0 );			}
+	iterator	end( void )		const	{	return iterator( this, m_count );	}
+
+	//Element i counted from the front
+	T operator[]( int i )	const	{	return m_items[ ( m_head + i ) & ( m_items.size() - 1 ) ];	}
+
+	T front( void )	const	{	return (*this)[ 0 ];			}
+	T back( void )	const	{	return (*this)[ m_count - 1 ];	}
+
+	void push_front( T item )
+	{
+		Reserve( m_count + 1 );
+		m_head = ( m_head - 1 ) & ( m_items.size() - 1 );
+		m_items[ m_head ] = item;
+		m_count++;
+	}
+
+	void push_back( T item )
+	{
+		Reserve( m_count + 1 );
+		m_items[ ( m_head + m_count ) & ( m_items.size() - 1 ) ] = item;
+		m_count++;
+	}
+
+	void pop_front( void )
+	{
+		m_head = ( m_head + 1 ) & ( m_items.size() - 1 );
+		m_count--;
+	}
+
+	void pop_back( void )
+	{
+		m_count--;
+	}
+
+	//Keeps the storage for the next use
+	void clear( void )
+	{
+		m_head = 0;
+		m_count = 0;
+	}
+
+private:
+
+	//The size of the array is always a power of two, so indices wrap with a mask
+	void Reserve( int count )
+	{
+		if ( count <= (int)m_items.size() )
+			return;
+
+		size_t newSize = m_items.empty() ? 8 : m_items.size() * 2;
+
+		while ( newSize < (size_t)count )
+			newSize *= 2;
+
+		std::vector< T > items( newSize );
+
+		for ( int i = 0; i < m_count; i++ )
+			items[ i ] = (*this)[ i ];
+
+		m_items.swap( items );
+		m_head = 0;
+	}
+
+	std::vector< T >	m_items;
+	int					m_head;
+	int					m_count;
+};
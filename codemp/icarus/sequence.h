@@ -27,6 +27,7 @@ along with this program; if not, see <http://www.gnu.org/licenses/>.
 #include "blockstream.h"
 #include "interface.h"
 #include "taskmanager.h"
+#include "ringqueue.h"
 
 class ICARUS_Instance;
 
@@ -35,7 +36,7 @@ class CSequence
 
 	typedef std::list < CSequence * >	sequence_l;
 	typedef	std::map	< int, CSequence *> sequenceID_m;
-	typedef std::list < CBlock * >		block_l;
+	typedef CRingQueue < CBlock * >		block_l;
 
 public:
 
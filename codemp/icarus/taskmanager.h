@@ -24,9 +24,12 @@ along with this program; if not, see <http://www.gnu.org/licenses/>.
 
 // Task Manager header file
 
+#include <deque>
 #include <map>
 #include <string>
+#include <vector>
 
+#include "ringqueue.h"
 #include "sequencer.h"
 class CSequencer;
 
@@ -59,24 +62,25 @@ public:
 	CTask();
 	~CTask();
 
-	static CTask *Create( int GUID, CBlock *block );
-
-	void	Free( void );
+	void	Init( int GUID, CBlock *block );
 
 	unsigned int	GetTimeStamp( void )	const	{	return m_timeStamp;				}
 	CBlock	*GetBlock( void )		const	{	return m_block;					}
 	int		GetGUID( void)			const	{	return m_id;					}
 	int		GetID( void )			const	{	return m_block->GetBlockID();	}
+	int		GetPoolIndex( void )	const	{	return m_poolIndex;				}
 
 	void	SetTimeStamp( unsigned int	timeStamp )		{	m_timeStamp = timeStamp;	}
 	void	SetBlock( CBlock *block )			{	m_block = block;			}
 	void	SetGUID( int id )					{	m_id = id;					}
+	void	SetPoolIndex( int index )			{	m_poolIndex = index;		}
 
 protected:
 
 	int		m_id;
 	unsigned int	m_timeStamp;
 	CBlock	*m_block;
+	int		m_poolIndex;	//Slot in the owning task manager's pool
 };
 
 // CTaskGroup
@@ -85,7 +89,14 @@ class CTaskGroup
 {
 public:
 
-	typedef std::map < int, bool > taskCallback_m;
+	struct taskCallback_t
+	{
+		int		id;
+		bool	completed;
+	};
+
+	//Sorted by task GUID, which only ever grows
+	typedef std::vector < taskCallback_t > taskCallback_v;
 
 	CTaskGroup( void );
 	~CTaskGroup( void );
@@ -95,6 +106,7 @@ public:
 	int Add( CTask *task );
 
 	void SetGUID( int GUID );
+	void SetName( const char *name )	{	m_name = name;		}
 	void SetParent( CTaskGroup *group )	{	m_parent = group;	}
 
 	bool Complete(void)		const { return ( m_numCompleted == (int)m_completedTasks.size() ); }
@@ -103,10 +115,12 @@ public:
 
 	CTaskGroup *GetParent( void )	const	{	return m_parent;	}
 	int	GetGUID( void )				const	{	return m_GUID;		}
+	const char *GetName( void )		const	{	return m_name.c_str();	}
 
 //protected:
 
-	taskCallback_m	m_completedTasks;
+	taskCallback_v	m_completedTasks;
+	std::string		m_name;
 
 	CTaskGroup	*m_parent;
 
@@ -119,11 +133,18 @@ public:
 class CTaskManager
 {
 
-	typedef	std::map < int, CTask * >			taskID_m;
-	typedef std::map < std::string, CTaskGroup * >	taskGroupName_m;
-	typedef std::map < int, CTaskGroup * >		taskGroupID_m;
+	//Group names are looked up every frame by waiting tasks, the keys point at the
+	//name held by each group so a lookup never builds a string
+	struct groupNameLess
+	{
+		bool operator()( const char *a, const char *b ) const	{	return ( strcmp( a, b ) < 0 );	}
+	};
+
+	typedef std::map < const char *, CTaskGroup *, groupNameLess >	taskGroupName_m;
 	typedef std::vector < CTaskGroup * >			taskGroup_v;
-	typedef std::list < CTask *>					tasks_l;
+	typedef CRingQueue < CTask * >					tasks_l;
+	typedef std::deque < CTask >					taskPool_d;
+	typedef std::vector < int >						taskFree_v;
 
 public:
 
@@ -169,6 +190,9 @@ protected:
 	int	PushTask( CTask *task, int flag );
 	CTask *PopTask( int flag );
 
+	CTask *AllocTask( int GUID, CBlock *block );
+	void FreeTask( CTask *task );
+
 	// Task functions
 	int Rotate( CTask *task );
 	int Remove( CTask *task );
@@ -196,14 +220,16 @@ protected:
 
 	CTaskGroup				*m_curGroup;
 
-	taskGroup_v				m_taskGroups;
+	taskGroup_v				m_taskGroups;		//Sorted by GUID, groups are only ever appended
 	tasks_l					m_tasks;
 
+	taskPool_d				m_taskPool;			//Every task this manager has made, reused through m_freeTasks
+	taskFree_v				m_freeTasks;
+
 	int						m_GUID;
 	int						m_count;
 
 	taskGroupName_m			m_taskGroupNameMap;
-	taskGroupID_m			m_taskGroupIDMap;
 
 	bool					m_resident;
 
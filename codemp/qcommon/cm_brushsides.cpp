@@ -0,0 +1,402 @@
+/*
+===========================================================================
+Copyright (C) 1999 - 2005, Id Software, Inc.
+Copyright (C) 2000 - 2013, Raven Software, Inc.
+Copyright (C) 2001 - 2013, Activision, Inc.
+Copyright (C) 2013 - 2015, OpenJK contributors
+
+This file is part of the OpenJK source code.
+
+OpenJK is free software; you can redistribute it and/or modify it
+under the terms of the GNU General Public License version 2 as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, see <http://www.gnu.org/licenses/>.
+===========================================================================
+*/
+
+#include "cm_local.h"
+
+/*
+===============================================================================
+
+BRUSH SIDE TESTS
+
+The distances of a trace to the sides of a brush, four sides at a time where
+the brush has a cbrushPlanes_t copy of its planes.  Each lane does the same
+float operations in the same order as the scalar code, so both give the same
+results to the bit.  That only holds where the scalar code uses SSE math
+without fused multiply-adds, so everywhere else only the scalar code is built.
+
+===============================================================================
+*/
+
+#if ( defined(__SSE2_MATH__) && !defined(__FMA__) ) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 )
+	#include <emmintrin.h>
+	#define CM_SIMD_SSE
+#endif
+
+#ifdef CM_SIMD_SSE
+
+typedef __m128 simd4_t;
+
+static inline simd4_t Simd_Load( const float *f ) { return _mm_loadu_ps( f ); }
+static inline simd4_t Simd_Splat( float f ) { return _mm_set1_ps( f ); }
+static inline simd4_t Simd_Add( simd4_t a, simd4_t b ) { return _mm_add_ps( a, b ); }
+static inline simd4_t Simd_Sub( simd4_t a, simd4_t b ) { return _mm_sub_ps( a, b ); }
+static inline simd4_t Simd_Mul( simd4_t a, simd4_t b ) { return _mm_mul_ps( a, b ); }
+static inline void Simd_Store( float *f, simd4_t a ) { _mm_storeu_ps( f, a ); }
+
+// mask ? a : b, mask lanes being ~0 or 0
+static inline simd4_t Simd_Select( simd4_t mask, simd4_t a, simd4_t b ) {
+	return _mm_or_ps( _mm_and_ps( mask, a ), _mm_andnot_ps( mask, b ) );
+}
+static inline simd4_t Simd_LoadMask( const int *mask ) {
+	return _mm_castsi128_ps( _mm_loadu_si128( (const __m128i *)mask ) );
+}
+static inline simd4_t Simd_GreaterThanZero( simd4_t a ) { return _mm_cmpgt_ps( a, _mm_setzero_ps() ); }
+static inline simd4_t Simd_Or( simd4_t a, simd4_t b ) { return _mm_or_ps( a, b ); }
+
+// bit n set when lane n of mask is set
+static inline int Simd_Bits( simd4_t mask ) { return _mm_movemask_ps( mask ); }
+
+#endif
+
+/*
+================
+CM_NumBrushPlaneBlocks
+
+How many cbrushPlanes_t a brush with numsides sides needs
+================
+*/
+int CM_NumBrushPlaneBlocks( int numsides ) {
+	return ( numsides + 3 ) / 4;
+}
+
+/*
+================
+CM_SetBrushPlanes
+
+Copies the planes of brush into blocks, which has room for
+CM_NumBrushPlaneBlocks( brush->numsides ).  The unused lanes of the last
+block get a plane that every point is behind.
+================
+*/
+void CM_SetBrushPlanes( cbrush_t *brush, cbrushPlanes_t *blocks ) {
+	int			i, j, k;
+	cplane_t	*plane;
+
+	for ( i = 0 ; i < CM_NumBrushPlaneBlocks( brush->numsides ) ; i++ ) {
+		for ( j = 0 ; j < 4 ; j++ ) {
+			if ( i*4 + j >= brush->numsides ) {
+				for ( k = 0 ; k < 3 ; k++ ) {
+					blocks[i].normal[k][j] = 0.0f;
+					blocks[i].sign[k][j] = 0;
+				}
+				blocks[i].dist[j] = 1.0f;
+				continue;
+			}
+			plane = brush->sides[i*4 + j].plane;
+			for ( k = 0 ; k < 3 ; k++ ) {
+				blocks[i].normal[k][j] = plane->normal[k];
+				blocks[i].sign[k][j] = ( plane->signbits & ( 1 << k ) ) ? ~0 : 0;
+			}
+			blocks[i].dist[j] = plane->dist;
+		}
+	}
+	brush->planes = blocks;
+}
+
+/*
+================
+CM_SideCollision
+
+The part of the trace against one brush side that follows from the
+distances d1 and d2 of start and end in front of it
+
+  Returns false for a quick getout
+================
+*/
+static inline bool CM_SideCollision( traceWork_t *tw, cbrushside_t *side, float d1, float d2 )
+{
+	float			f;
+	cplane_t		*plane = side->plane;
+
+	if (d2 > 0.0f)
+	{
+		// endpoint is not in solid
+		tw->getout = true;
+	}
+	if (d1 > 0.0f)
+	{
+		// startpoint is not in solid
+		tw->startout = true;
+	}
+
+	// if completely in front of face, no intersection with the entire brush
+	if ((d1 > 0.0f) && ( (d2 >= SURFACE_CLIP_EPSILON) || (d2 >= d1) ) )
+	{
+		return(false);
+	}
+
+	// if it doesn't cross the plane, the plane isn't relevent
+	if ((d1 <= 0.0f) && (d2 <= 0.0f))
+	{
+		return(true);
+	}
+	// crosses face
+	if (d1 > d2)
+	{	// enter
+		f = (d1 - SURFACE_CLIP_EPSILON);
+		if ( f < 0.0f )
+		{
+			f = 0.0f;
+			if (f > tw->enterFrac)
+			{
+				tw->enterFrac = f;
+				tw->clipplane = plane;
+				tw->leadside = side;
+			}
+		}
+		else if (f > tw->enterFrac * (d1 - d2) )
+		{
+			tw->enterFrac = f / (d1 - d2);
+			tw->clipplane = plane;
+			tw->leadside = side;
+		}
+	}
+	else
+	{	// leave
+		f = (d1 + SURFACE_CLIP_EPSILON);
+		if ( f < (d1 - d2) )
+		{
+			f = 1.0f;
+			if (f < tw->leaveFrac)
+			{
+				tw->leaveFrac = f;
+			}
+		}
+		else if (f > tw->leaveFrac * (d1 - d2) )
+		{
+			tw->leaveFrac = f / (d1 - d2);
+		}
+	}
+	return(true);
+}
+
+/*
+================
+CM_PlaneCollision
+
+  Returns false for a quick getout
+================
+*/
+static bool CM_PlaneCollision(traceWork_t *tw, cbrushside_t *side)
+{
+	float			dist;
+	float			d1, d2;
+
+	cplane_t		*plane = side->plane;
+
+	// adjust the plane distance appropriately for mins/maxs
+	dist = plane->dist - DotProduct( tw->offsets[ plane->signbits ], plane->normal );
+
+	d1 = DotProduct( tw->start, plane->normal ) - dist;
+	d2 = DotProduct( tw->end, plane->normal ) - dist;
+
+	return CM_SideCollision( tw, side, d1, d2 );
+}
+
+#ifdef CM_SIMD_SSE
+
+/*
+================
+CM_BlockDistances
+
+d1 and d2 of CM_PlaneCollision for the four planes of block
+================
+*/
+static inline void CM_BlockDistances( const traceWork_t *tw, const cbrushPlanes_t *block, simd4_t &d1, simd4_t &d2 ) {
+	simd4_t		nx, ny, nz;
+	simd4_t		ox, oy, oz;
+	simd4_t		dist;
+
+	nx = Simd_Load( block->normal[0] );
+	ny = Simd_Load( block->normal[1] );
+	nz = Simd_Load( block->normal[2] );
+
+	// offsets[signbits][k] is size[1][k] where signbits has bit k
+	ox = Simd_Select( Simd_LoadMask( block->sign[0] ), Simd_Splat( tw->offsets[7][0] ), Simd_Splat( tw->offsets[0][0] ) );
+	oy = Simd_Select( Simd_LoadMask( block->sign[1] ), Simd_Splat( tw->offsets[7][1] ), Simd_Splat( tw->offsets[0][1] ) );
+	oz = Simd_Select( Simd_LoadMask( block->sign[2] ), Simd_Splat( tw->offsets[7][2] ), Simd_Splat( tw->offsets[0][2] ) );
+
+	dist = Simd_Sub( Simd_Load( block->dist ),
+		Simd_Add( Simd_Add( Simd_Mul( ox, nx ), Simd_Mul( oy, ny ) ), Simd_Mul( oz, nz ) ) );
+
+	d1 = Simd_Sub( Simd_Add( Simd_Add(
+		Simd_Mul( Simd_Splat( tw->start[0] ), nx ),
+		Simd_Mul( Simd_Splat( tw->start[1] ), ny ) ),
+		Simd_Mul( Simd_Splat( tw->start[2] ), nz ) ), dist );
+	d2 = Simd_Sub( Simd_Add( Simd_Add(
+		Simd_Mul( Simd_Splat( tw->end[0] ), nx ),
+		Simd_Mul( Simd_Splat( tw->end[1] ), ny ) ),
+		Simd_Mul( Simd_Splat( tw->end[2] ), nz ) ), dist );
+}
+
+#endif
+
+/*
+================
+CM_ClipToBrushSides
+
+Compares the trace against all planes of the brush, finding the latest time
+the trace crosses a plane towards the interior and the earliest time the
+trace crosses a plane towards the exterior
+
+  Returns false when the trace is completely outside the brush
+================
+*/
+bool CM_ClipToBrushSides( traceWork_t *tw, cbrush_t *brush ) {
+	int				i;
+
+#ifdef CM_SIMD_SSE
+	if ( brush->planes ) {
+		int				j, active;
+		simd4_t			d1, d2;
+		float			d1s[4], d2s[4];
+
+		for ( i = 0 ; i < brush->numsides ; i += 4 ) {
+			CM_BlockDistances( tw, &brush->planes[i / 4], d1, d2 );
+
+			// sides with start and end behind them change nothing
+			active = Simd_Bits( Simd_Or( Simd_GreaterThanZero( d1 ), Simd_GreaterThanZero( d2 ) ) );
+			if ( !active ) {
+				continue;
+			}
+
+			Simd_Store( d1s, d1 );
+			Simd_Store( d2s, d2 );
+			for ( j = 0 ; j < 4 ; j++ ) {
+				if ( ( active & ( 1 << j ) ) && !CM_SideCollision( tw, brush->sides + i + j, d1s[j], d2s[j] ) ) {
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+#endif
+
+	for ( i = 0 ; i < brush->numsides ; i++ ) {
+		if ( !CM_PlaneCollision( tw, brush->sides + i ) ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/*
+================
+CM_BoxInBrushSides
+
+Whether the trace's start box (or capsule) is behind all the non-axial
+planes of the brush.  The first six planes are the axial planes, which the
+caller already tested against the brush bounds.
+================
+*/
+bool CM_BoxInBrushSides( const traceWork_t *tw, const cbrush_t *brush ) {
+	int			i;
+	cplane_t	*plane;
+	float		dist;
+	float		d1;
+	float		t;
+	vec3_t		startp;
+
+#ifdef CM_SIMD_SSE
+	if ( brush->planes ) {
+		int			valid;
+		simd4_t		nx, ny, nz;
+		simd4_t		d1v, d2v;
+
+		// sides 4 and 5 share the first tested block
+		for ( i = 4 ; i < brush->numsides ; i += 4 ) {
+			const cbrushPlanes_t *block = &brush->planes[i / 4];
+
+			valid = ( i == 4 ) ? 0xc : 0xf;
+			if ( tw->sphere.use ) {
+				simd4_t		tv, sel, px, py, pz;
+
+				nx = Simd_Load( block->normal[0] );
+				ny = Simd_Load( block->normal[1] );
+				nz = Simd_Load( block->normal[2] );
+
+				// find the closest point on the capsule to the plane
+				tv = Simd_Add( Simd_Add(
+					Simd_Mul( nx, Simd_Splat( tw->sphere.offset[0] ) ),
+					Simd_Mul( ny, Simd_Splat( tw->sphere.offset[1] ) ) ),
+					Simd_Mul( nz, Simd_Splat( tw->sphere.offset[2] ) ) );
+				sel = Simd_GreaterThanZero( tv );
+				px = Simd_Select( sel, Simd_Splat( tw->start[0] - tw->sphere.offset[0] ), Simd_Splat( tw->start[0] + tw->sphere.offset[0] ) );
+				py = Simd_Select( sel, Simd_Splat( tw->start[1] - tw->sphere.offset[1] ), Simd_Splat( tw->start[1] + tw->sphere.offset[1] ) );
+				pz = Simd_Select( sel, Simd_Splat( tw->start[2] - tw->sphere.offset[2] ), Simd_Splat( tw->start[2] + tw->sphere.offset[2] ) );
+
+				// adjust the plane distance appropriately for radius
+				d1v = Simd_Sub( Simd_Add( Simd_Add( Simd_Mul( px, nx ), Simd_Mul( py, ny ) ), Simd_Mul( pz, nz ) ),
+					Simd_Add( Simd_Load( block->dist ), Simd_Splat( tw->sphere.radius ) ) );
+			} else {
+				CM_BlockDistances( tw, block, d1v, d2v );
+			}
+
+			// if completely in front of face, no intersection
+			if ( Simd_Bits( Simd_GreaterThanZero( d1v ) ) & valid ) {
+				return false;
+			}
+		}
+		return true;
+	}
+#endif
+
+	if ( tw->sphere.use ) {
+		for ( i = 6 ; i < brush->numsides ; i++ ) {
+			plane = brush->sides[i].plane;
+
+			// adjust the plane distance appropriately for radius
+			dist = plane->dist + tw->sphere.radius;
+			// find the closest point on the capsule to the plane
+			t = DotProduct( plane->normal, tw->sphere.offset );
+			if ( t > 0 )
+			{
+				VectorSubtract( tw->start, tw->sphere.offset, startp );
+			}
+			else
+			{
+				VectorAdd( tw->start, tw->sphere.offset, startp );
+			}
+			d1 = DotProduct( startp, plane->normal ) - dist;
+			// if completely in front of face, no intersection
+			if ( d1 > 0 ) {
+				return false;
+			}
+		}
+	} else {
+		for ( i = 6 ; i < brush->numsides ; i++ ) {
+			plane = brush->sides[i].plane;
+
+			// adjust the plane distance appropriately for mins/maxs
+			dist = plane->dist - DotProduct( tw->offsets[ plane->signbits ], plane->normal );
+
+			d1 = DotProduct( tw->start, plane->normal ) - dist;
+
+			// if completely in front of face, no intersection
+			if ( d1 > 0 ) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
@@ -55,7 +55,7 @@ void SetPlaneSignbits (cplane_t *out) {
 
 clipMap_t	cmg; //rwwRMG - changed from cm
 int			c_pointcontents;
-int			c_traces, c_brush_traces, c_patch_traces;
+int			c_brush_traces;
 
 
 byte		*cmod_base;
@@ -65,6 +65,7 @@ cvar_t		*cm_noAreas;
 cvar_t		*cm_noCurves;
 cvar_t		*cm_playerCurveClip;
 cvar_t		*cm_extraVerbose;
+cvar_t		*cm_debugSurfaceUpdate;
 #endif
 
 cmodel_t	box_model;
@@ -250,6 +251,8 @@ void CMod_LoadBrushes( const lump_t *l, clipMap_t &cm ) {
 	dbrush_t	*in;
 	cbrush_t	*out;
 	int			i, count;
+	int			numBlocks;
+	cbrushPlanes_t	*blocks;
 
 	in = (dbrush_t *)(cmod_base + l->fileofs);
 	if (l->filelen % sizeof(*in)) {
@@ -275,6 +278,16 @@ void CMod_LoadBrushes( const lump_t *l, clipMap_t &cm ) {
 		CM_BoundBrush( out );
 	}
 
+	// copy the planes of each brush for testing its sides four at a time
+	numBlocks = 0;
+	for ( i=0 ; i<count ; i++ ) {
+		numBlocks += CM_NumBrushPlaneBlocks( cm.brushes[i].numsides );
+	}
+	blocks = (cbrushPlanes_t *)Hunk_Alloc( numBlocks * sizeof( *blocks ), h_high );
+	for ( i=0 ; i<count ; i++ ) {
+		CM_SetBrushPlanes( &cm.brushes[i], blocks );
+		blocks += CM_NumBrushPlaneBlocks( cm.brushes[i].numsides );
+	}
 }
 
 /*
@@ -635,6 +648,7 @@ static void CM_LoadMap_Actual( const char *name, qboolean clientload, int *check
 	cm_noCurves = Cvar_Get ("cm_noCurves", "0", CVAR_CHEAT);
 	cm_playerCurveClip = Cvar_Get ("cm_playerCurveClip", "1", CVAR_ARCHIVE_ND|CVAR_CHEAT );
 	cm_extraVerbose = Cvar_Get ("cm_extraVerbose", "0", CVAR_TEMP );
+	cm_debugSurfaceUpdate = Cvar_Get ("r_debugSurfaceUpdate", "1", 0 );
 #endif
 	Com_DPrintf( "CM_LoadMap( %s, %i )\n", name, clientload );
 
@@ -663,6 +677,7 @@ static void CM_LoadMap_Actual( const char *name, qboolean clientload, int *check
 		cm.cmodels = (struct cmodel_s *)Hunk_Alloc( sizeof( *cm.cmodels ), h_high );
 		if ( checksum )
 			*checksum = 0;
+		CM_ResizeTraceContexts();
 		return;
 	}
 
@@ -775,6 +790,7 @@ static void CM_LoadMap_Actual( const char *name, qboolean clientload, int *check
 #endif
 
 	CM_FloodAreaConnections (cm);
+	CM_ResizeTraceContexts();
 
 	// allow this to be cached if it is loaded by the server
 	if ( !clientload ) {
@@ -814,6 +830,8 @@ void CM_ClearMap( void )
 	}
 	NumSubBSP = 0;
 	TotalSubModels = 0;
+
+	CM_ResizeTraceContexts();
 }
 
 /*
@@ -914,49 +932,43 @@ int		CM_LeafArea( int leafnum ) {
 
 /*
 ===================
-CM_InitBoxHull
+CM_SetupBoxHull
 
 Set up the planes and nodes so that the six floats of a bounding box
 can just be stored out and get a proper clipping hull structure.
 ===================
 */
-void CM_InitBoxHull (void)
+void CM_SetupBoxHull( cmodel_t *model, cbrush_t *brush, cbrushside_t *sides, cplane_t *planes, int shaderNum )
 {
 	int			i;
 	int			side;
 	cplane_t	*p;
 	cbrushside_t	*s;
 
-	box_planes = &cmg.planes[cmg.numPlanes];
-
-	box_brush = &cmg.brushes[cmg.numBrushes];
-	box_brush->numsides = 6;
-	box_brush->sides = cmg.brushsides + cmg.numBrushSides;
-	box_brush->contents = CONTENTS_BODY;
+	brush->numsides = 6;
+	brush->sides = sides;
+	brush->contents = CONTENTS_BODY;
 
-	box_model.firstNode = -1;
-	box_model.leaf.numLeafBrushes = 1;
-//	box_model.leaf.firstLeafBrush = cmg.numBrushes;
-	box_model.leaf.firstLeafBrush = cmg.numLeafBrushes;
-	cmg.leafbrushes[cmg.numLeafBrushes] = cmg.numBrushes;
+	model->firstNode = -1;
+	model->leaf.numLeafBrushes = 1;
 
 	for (i=0 ; i<6 ; i++)
 	{
 		side = i&1;
 
 		// brush sides
-		s = &cmg.brushsides[cmg.numBrushSides+i];
-		s->plane = 	cmg.planes + (cmg.numPlanes+i*2+side);
-		s->shaderNum = cmg.numShaders;
+		s = &sides[i];
+		s->plane = planes + (i*2+side);
+		s->shaderNum = shaderNum;
 
 		// planes
-		p = &box_planes[i*2];
+		p = &planes[i*2];
 		p->type = i>>1;
 		p->signbits = 0;
 		VectorClear (p->normal);
 		p->normal[i>>1] = 1;
 
-		p = &box_planes[i*2+1];
+		p = &planes[i*2+1];
 		p->type = 3 + (i>>1);
 		p->signbits = 0;
 		VectorClear (p->normal);
@@ -966,6 +978,30 @@ void CM_InitBoxHull (void)
 	}
 }
 
+/*
+===================
+CM_InitBoxHull
+
+The box model of the default trace context lives in the extra indexes
+at the end of the map's arrays.
+===================
+*/
+void CM_InitBoxHull (void)
+{
+	box_planes = &cmg.planes[cmg.numPlanes];
+	box_brush = &cmg.brushes[cmg.numBrushes];
+
+	CM_SetupBoxHull( &box_model, box_brush, cmg.brushsides + cmg.numBrushSides, box_planes, cmg.numShaders );
+//	box_model.leaf.firstLeafBrush = cmg.numBrushes;
+	box_model.leaf.firstLeafBrush = cmg.numLeafBrushes;
+	cmg.leafbrushes[cmg.numLeafBrushes] = cmg.numBrushes;
+
+	cm_defaultTrace.boxMap = &cmg;
+	cm_defaultTrace.boxModel = &box_model;
+	cm_defaultTrace.boxBrush = box_brush;
+	cm_defaultTrace.boxPlanes = box_planes;
+}
+
 /*
 ===================
 CM_TempBoxModel
@@ -975,34 +1011,39 @@ BSP trees instead of being compared directly.
 Capsules are handled differently though.
 ===================
 */
-clipHandle_t CM_TempBoxModel( const vec3_t mins, const vec3_t maxs, int capsule ) {
+clipHandle_t CM_TempBoxModelCtx( traceContext_t *tc, const vec3_t mins, const vec3_t maxs, int capsule ) {
+	cplane_t	*planes = tc->boxPlanes;
 
-	VectorCopy( mins, box_model.mins );
-	VectorCopy( maxs, box_model.maxs );
+	VectorCopy( mins, tc->boxModel->mins );
+	VectorCopy( maxs, tc->boxModel->maxs );
 
 	if ( capsule ) {
 		return CAPSULE_MODEL_HANDLE;
 	}
 
-	box_planes[0].dist = maxs[0];
-	box_planes[1].dist = -maxs[0];
-	box_planes[2].dist = mins[0];
-	box_planes[3].dist = -mins[0];
-	box_planes[4].dist = maxs[1];
-	box_planes[5].dist = -maxs[1];
-	box_planes[6].dist = mins[1];
-	box_planes[7].dist = -mins[1];
-	box_planes[8].dist = maxs[2];
-	box_planes[9].dist = -maxs[2];
-	box_planes[10].dist = mins[2];
-	box_planes[11].dist = -mins[2];
-
-	VectorCopy( mins, box_brush->bounds[0] );
-	VectorCopy( maxs, box_brush->bounds[1] );
+	planes[0].dist = maxs[0];
+	planes[1].dist = -maxs[0];
+	planes[2].dist = mins[0];
+	planes[3].dist = -mins[0];
+	planes[4].dist = maxs[1];
+	planes[5].dist = -maxs[1];
+	planes[6].dist = mins[1];
+	planes[7].dist = -mins[1];
+	planes[8].dist = maxs[2];
+	planes[9].dist = -maxs[2];
+	planes[10].dist = mins[2];
+	planes[11].dist = -mins[2];
+
+	VectorCopy( mins, tc->boxBrush->bounds[0] );
+	VectorCopy( maxs, tc->boxBrush->bounds[1] );
 
 	return BOX_MODEL_HANDLE;
 }
 
+clipHandle_t CM_TempBoxModel( const vec3_t mins, const vec3_t maxs, int capsule ) {
+	return CM_TempBoxModelCtx( &cm_defaultTrace, mins, maxs, capsule );
+}
+
 /*
 ===================
 CM_ModelBounds
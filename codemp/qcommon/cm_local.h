@@ -63,13 +63,20 @@ typedef struct cbrushside_s {
 	int			shaderNum;
 } cbrushside_t;
 
+// the planes of four brush sides, for testing them together
+typedef struct cbrushPlanes_s {
+	float		normal[3][4];
+	float		dist[4];
+	int			sign[3][4];		// ~0 where the plane's signbits has the bit for that axis
+} cbrushPlanes_t;
+
 typedef struct cbrush_s {
 	int					shaderNum;		// the shader that determined the contents
 	int					contents;
 	vec3_t				bounds[2];
 	cbrushside_t		*sides;
 	unsigned short		numsides;
-	unsigned short		checkcount;		// to avoid repeated testings
+	cbrushPlanes_t		*planes;		// copy of the sides' planes, NULL for brushes that get moved (box brushes)
 } cbrush_t;
 
 class CCMShader
@@ -87,7 +94,6 @@ public:
 };
 
 typedef struct cPatch_s {
-	int			checkcount;				// to avoid repeated testings
 	int			surfaceFlags;
 	int			contents;
 	struct patchCollide_s	*pc;
@@ -145,7 +151,6 @@ typedef struct clipMap_s {
 	cPatch_t	**surfaces;			// non-patches will be NULL
 
 	int			floodvalid;
-	int			checkcount;					// incremented on each trace
 } clipMap_t;
 
 
@@ -154,12 +159,14 @@ typedef struct clipMap_s {
 #define	SURFACE_CLIP_EPSILON	(0.125)
 
 extern	clipMap_t	cmg; //rwwRMG - changed from cm
+extern	clipMap_t	SubBSP[MAX_SUB_BSP];
 extern	int			c_pointcontents;
-extern	int			c_traces, c_brush_traces, c_patch_traces;
+extern	int			c_brush_traces;
 extern	cvar_t		*cm_noAreas;
 extern	cvar_t		*cm_noCurves;
 extern	cvar_t		*cm_playerCurveClip;
 extern	cvar_t		*cm_extraVerbose;
+extern	cvar_t		*cm_debugSurfaceUpdate;
 
 // cm_test.c
 
@@ -171,7 +178,58 @@ typedef struct sphere_s {
 	vec3_t		offset;
 } sphere_t;
 
+#define	MAX_POSITION_LEAFS	1024
+
+// checkcount of the last test of each brush and patch of one clip map,
+// so a trace that touches them in several leafs only tests them once
+typedef struct traceStamps_s {
+	int			*brushes;
+	int			maxBrushes;
+	int			*patches;		// indexed like clipMap_t::surfaces
+	int			maxPatches;
+
+	// for batched traces: which rays of the batch already tested it,
+	// valid where the stamp is the batch's checkcount (cmg only)
+	uint64_t	*brushRays;
+	uint64_t	*patchRays;
+} traceStamps_t;
+
+// Everything a trace writes while it walks the clip maps.  Traces and box
+// queries on different contexts can run at the same time, as long as each
+// context is only used by one thread at a time and no map is (re)loaded
+// meanwhile.  The plain CM_* functions use cm_defaultTrace.
+struct traceContext_s {
+	int				checkcount;					// incremented on each trace
+	traceStamps_t	stamps[1+MAX_SUB_BSP];		// cmg, then SubBSP[]
+	traceStamps_t	boxStamps;					// for boxMap, unless that is cmg
+
+	// box model for CM_TempBoxModelCtx; the default context uses the one
+	// that lives at the end of cmg, the others bring their own
+	clipMap_t		*boxMap;
+	cmodel_t		*boxModel;
+	cbrush_t		*boxBrush;
+	cplane_t		*boxPlanes;
+
+	clipMap_t		ownBoxMap;
+	cmodel_t		ownBoxModel;
+	cbrush_t		ownBoxBrush;
+	cbrushside_t	ownBoxSides[6];
+	cplane_t		ownBoxPlanes[12];
+	int				ownBoxLeafBrush;
+	int				ownBoxStamp;
+
+	int				leafs[MAX_POSITION_LEAFS];	// for CM_PositionTest
+
+	int				traces;						// statistics, see CM_TraceCounts
+	int				patchTraces;
+
+	traceContext_t	*next;						// all allocated contexts
+};
+
+extern	traceContext_t	cm_defaultTrace;
+
 typedef struct traceWork_s { //rwwRMG - modified
+	traceContext_t	*tc;
 	vec3_t		start;
 	vec3_t		end;
 	vec3_t		size[2];	// size of the box being swept through the model
@@ -207,6 +265,7 @@ typedef struct leafList_s {
 	vec3_t	bounds[2];
 	int		lastLeaf;		// for overflows where each leaf can't be stored individually
 	void	(*storeLeafs)( struct leafList_s *ll, int nodenum );
+	traceContext_t	*tc;	// only needed by CM_StoreBrushes
 } leafList_t;
 
 void CM_StoreLeafs( leafList_t *ll, int nodenum );
@@ -215,6 +274,17 @@ void CM_StoreBrushes( leafList_t *ll, int nodenum );
 void CM_BoxLeafnums_r( leafList_t *ll, int nodenum );
 
 cmodel_t	*CM_ClipHandleToModel( clipHandle_t handle, clipMap_t **clipMap = 0 );
+void		CM_SetupBoxHull( cmodel_t *model, cbrush_t *brush, cbrushside_t *sides, cplane_t *planes, int shaderNum );
+
+// cm_brushsides.cpp
+int		CM_NumBrushPlaneBlocks( int numsides );
+void	CM_SetBrushPlanes( cbrush_t *brush, cbrushPlanes_t *blocks );
+bool	CM_ClipToBrushSides( traceWork_t *tw, cbrush_t *brush );
+bool	CM_BoxInBrushSides( const traceWork_t *tw, const cbrush_t *brush );
+
+// cm_trace.cpp
+traceStamps_t	*CM_TraceStamps( traceContext_t *tc, const clipMap_t *local );
+void			CM_ResizeTraceContexts( void );
 
 // cm_patch.c
 
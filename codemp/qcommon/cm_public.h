@@ -44,6 +44,21 @@ int			CM_TransformedPointContents( const vec3_t p, clipHandle_t model, const vec
 void		CM_BoxTrace ( trace_t *results, const vec3_t start, const vec3_t end, const vec3_t mins, const vec3_t maxs, clipHandle_t model, int brushmask, int capsule );
 void		CM_TransformedBoxTrace( trace_t *results, const vec3_t start, const vec3_t end, const vec3_t mins, const vec3_t maxs, clipHandle_t model, int brushmask, const vec3_t origin, const vec3_t angles, int capsule );
 
+// reentrant traces: each thread that traces needs a context of its own,
+// allocated and freed on the main thread
+typedef struct traceContext_s traceContext_t;
+
+traceContext_t *CM_AllocTraceContext( void );
+void		CM_FreeTraceContext( traceContext_t *tc );
+clipHandle_t CM_TempBoxModelCtx( traceContext_t *tc, const vec3_t mins, const vec3_t maxs, int capsule );
+void		CM_BoxTraceCtx( traceContext_t *tc, trace_t *results, const vec3_t start, const vec3_t end, const vec3_t mins, const vec3_t maxs, clipHandle_t model, int brushmask, int capsule );
+void		CM_TransformedBoxTraceCtx( traceContext_t *tc, trace_t *results, const vec3_t start, const vec3_t end, const vec3_t mins, const vec3_t maxs, clipHandle_t model, int brushmask, const vec3_t origin, const vec3_t angles, int capsule );
+void		CM_TraceCounts( int *traces, int *patchTraces );
+
+// traces many rays through the world at once, sharing the tree walk
+void		CM_BoxTraceBatch( trace_t *results, const traceRequest_t *requests, int numRequests, int capsule );
+void		CM_BoxTraceBatchCtx( traceContext_t *tc, trace_t *results, const traceRequest_t *requests, int numRequests, int capsule );
+
 byte		*CM_ClusterPVS (int cluster);
 
 int			CM_PointLeafnum( const vec3_t p );
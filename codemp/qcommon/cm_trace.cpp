@@ -33,6 +33,249 @@ along with this program; if not, see <http://www.gnu.org/licenses/>.
 /*
 ===============================================================================
 
+TRACE CONTEXTS
+
+===============================================================================
+*/
+
+// used by the plain CM_* functions, and the head of the list of all contexts
+traceContext_t	cm_defaultTrace;
+
+/*
+================
+CM_TraceStamps
+
+The stamps tc keeps for the brushes and patches of local
+================
+*/
+traceStamps_t *CM_TraceStamps( traceContext_t *tc, const clipMap_t *local ) {
+	if ( local == &cmg ) {
+		return &tc->stamps[0];
+	}
+	if ( local >= SubBSP && local < SubBSP + MAX_SUB_BSP ) {
+		return &tc->stamps[1 + (local - SubBSP)];
+	}
+	return &tc->boxStamps;
+}
+
+/*
+================
+CM_ResizeStamps
+================
+*/
+static void CM_ResizeStamps( traceStamps_t *stamps, int numBrushes, int numPatches ) {
+	if ( numBrushes > stamps->maxBrushes ) {
+		if ( stamps->brushes ) {
+			Z_Free( stamps->brushes );
+		}
+		stamps->brushes = (int *)Z_Malloc( numBrushes * sizeof( *stamps->brushes ), TAG_BSP, qtrue );
+		stamps->maxBrushes = numBrushes;
+	}
+	if ( numPatches > stamps->maxPatches ) {
+		if ( stamps->patches ) {
+			Z_Free( stamps->patches );
+		}
+		stamps->patches = (int *)Z_Malloc( numPatches * sizeof( *stamps->patches ), TAG_BSP, qtrue );
+		stamps->maxPatches = numPatches;
+	}
+}
+
+/*
+================
+CM_ClearStamps
+
+Called when checkcount is about to wrap
+================
+*/
+static void CM_ClearStamps( traceContext_t *tc ) {
+	int		i;
+
+	for ( i = 0 ; i < 1+MAX_SUB_BSP ; i++ ) {
+		if ( tc->stamps[i].brushes ) {
+			memset( tc->stamps[i].brushes, 0, tc->stamps[i].maxBrushes * sizeof( int ) );
+		}
+		if ( tc->stamps[i].patches ) {
+			memset( tc->stamps[i].patches, 0, tc->stamps[i].maxPatches * sizeof( int ) );
+		}
+	}
+	tc->ownBoxStamp = 0;
+	tc->checkcount = 0;
+}
+
+/*
+================
+CM_NextCheckcount
+================
+*/
+static void CM_NextCheckcount( traceContext_t *tc ) {
+	if ( tc->checkcount == INT_MAX ) {
+		CM_ClearStamps( tc );
+	}
+	tc->checkcount++;
+}
+
+/*
+================
+CM_ResizeTraceContext
+================
+*/
+static void CM_ResizeTraceContext( traceContext_t *tc ) {
+	int		i;
+
+	// one extra brush for the default context's box
+	CM_ResizeStamps( &tc->stamps[0], cmg.numBrushes + 1, cmg.numSurfaces );
+	if ( tc->stamps[0].brushRays ) {
+		Z_Free( tc->stamps[0].brushRays );
+		Z_Free( tc->stamps[0].patchRays );
+	}
+	tc->stamps[0].brushRays = (uint64_t *)Z_Malloc( tc->stamps[0].maxBrushes * sizeof( uint64_t ), TAG_BSP, qtrue );
+	tc->stamps[0].patchRays = (uint64_t *)Z_Malloc( ( tc->stamps[0].maxPatches + 1 ) * sizeof( uint64_t ), TAG_BSP, qtrue );
+	for ( i = 0 ; i < MAX_SUB_BSP ; i++ ) {
+		CM_ResizeStamps( &tc->stamps[1+i], SubBSP[i].numBrushes, SubBSP[i].numSurfaces );
+	}
+
+	if ( tc->boxMap == &tc->ownBoxMap ) {
+		// the box uses the spare shader at the end of cmg.shaders, and like
+		// the default box it hits nothing while no map is loaded
+		for ( i = 0 ; i < 6 ; i++ ) {
+			tc->ownBoxSides[i].shaderNum = cmg.numShaders;
+		}
+		tc->ownBoxMap.numNodes = cmg.numNodes ? 1 : 0;
+	}
+}
+
+/*
+================
+CM_ResizeTraceContexts
+
+Called whenever a clip map is loaded or cleared, so traces never allocate
+================
+*/
+void CM_ResizeTraceContexts( void ) {
+	traceContext_t	*tc;
+
+	for ( tc = &cm_defaultTrace ; tc ; tc = tc->next ) {
+		CM_ResizeTraceContext( tc );
+	}
+}
+
+/*
+================
+CM_AllocTraceContext
+================
+*/
+traceContext_t *CM_AllocTraceContext( void ) {
+	traceContext_t	*tc;
+
+	tc = (traceContext_t *)Z_Malloc( sizeof( *tc ), TAG_BSP, qtrue );
+
+	CM_SetupBoxHull( &tc->ownBoxModel, &tc->ownBoxBrush, tc->ownBoxSides, tc->ownBoxPlanes, 0 );
+	tc->ownBoxModel.leaf.firstLeafBrush = 0;
+	tc->ownBoxLeafBrush = 0;
+	tc->ownBoxMap.leafbrushes = &tc->ownBoxLeafBrush;
+	tc->ownBoxMap.numLeafBrushes = 1;
+	tc->ownBoxMap.brushes = &tc->ownBoxBrush;
+	tc->ownBoxMap.numBrushes = 1;
+	tc->boxStamps.brushes = &tc->ownBoxStamp;
+	tc->boxStamps.maxBrushes = 1;
+
+	tc->boxMap = &tc->ownBoxMap;
+	tc->boxModel = &tc->ownBoxModel;
+	tc->boxBrush = &tc->ownBoxBrush;
+	tc->boxPlanes = tc->ownBoxPlanes;
+
+	CM_ResizeTraceContext( tc );
+
+	tc->next = cm_defaultTrace.next;
+	cm_defaultTrace.next = tc;
+	return tc;
+}
+
+/*
+================
+CM_FreeTraceContext
+================
+*/
+void CM_FreeTraceContext( traceContext_t *tc ) {
+	traceContext_t	*prev;
+	int				i;
+
+	if ( !tc || tc == &cm_defaultTrace ) {
+		return;
+	}
+
+	for ( prev = &cm_defaultTrace ; prev->next != tc ; prev = prev->next ) {
+		if ( !prev->next ) {
+			Com_Error( ERR_FATAL, "CM_FreeTraceContext: unknown context" );
+		}
+	}
+	prev->next = tc->next;
+
+	if ( tc->stamps[0].brushRays ) {
+		Z_Free( tc->stamps[0].brushRays );
+		Z_Free( tc->stamps[0].patchRays );
+	}
+	for ( i = 0 ; i < 1+MAX_SUB_BSP ; i++ ) {
+		if ( tc->stamps[i].brushes ) {
+			Z_Free( tc->stamps[i].brushes );
+		}
+		if ( tc->stamps[i].patches ) {
+			Z_Free( tc->stamps[i].patches );
+		}
+	}
+	Z_Free( tc );
+}
+
+/*
+================
+CM_TraceCounts
+
+Adds up and zeroes the statistics of all contexts
+================
+*/
+void CM_TraceCounts( int *traces, int *patchTraces ) {
+	traceContext_t	*tc;
+
+	*traces = *patchTraces = 0;
+	for ( tc = &cm_defaultTrace ; tc ; tc = tc->next ) {
+		*traces += tc->traces;
+		*patchTraces += tc->patchTraces;
+		tc->traces = tc->patchTraces = 0;
+	}
+}
+
+/*
+================
+CM_TraceModel
+
+Like CM_ClipHandleToModel, but the box model is the context's own
+================
+*/
+static cmodel_t *CM_TraceModel( traceContext_t *tc, clipHandle_t handle, clipMap_t **local ) {
+	if ( handle == BOX_MODEL_HANDLE ) {
+		*local = tc->boxMap;
+		return tc->boxModel;
+	}
+	return CM_ClipHandleToModel( handle, local );
+}
+
+/*
+================
+CM_TraceModelBounds
+================
+*/
+static void CM_TraceModelBounds( traceContext_t *tc, clipHandle_t model, vec3_t mins, vec3_t maxs ) {
+	clipMap_t	*local;
+	cmodel_t	*cmod;
+
+	cmod = CM_TraceModel( tc, model, &local );
+	VectorCopy( cmod->mins, mins );
+	VectorCopy( cmod->maxs, maxs );
+}
+
+/*
+===============================================================================
+
 BASIC MATH
 
 ===============================================================================
@@ -130,14 +373,6 @@ CM_TestBoxInBrush
 ================
 */
 void CM_TestBoxInBrush( traceWork_t *tw, trace_t &trace, cbrush_t *brush ) {
-	int			i;
-	cplane_t	*plane;
-	float		dist;
-	float		d1;
-	cbrushside_t	*side;
-	float		t;
-	vec3_t		startp;
-
 	if (!brush->numsides) {
 		return;
 	}
@@ -153,48 +388,8 @@ void CM_TestBoxInBrush( traceWork_t *tw, trace_t &trace, cbrush_t *brush ) {
 		return;
 	}
 
-   if ( tw->sphere.use ) {
-		// the first six planes are the axial planes, so we only
-		// need to test the remainder
-		for ( i = 6 ; i < brush->numsides ; i++ ) {
-			side = brush->sides + i;
-			plane = side->plane;
-
-			// adjust the plane distance appropriately for radius
-			dist = plane->dist + tw->sphere.radius;
-			// find the closest point on the capsule to the plane
-			t = DotProduct( plane->normal, tw->sphere.offset );
-			if ( t > 0 )
-			{
-				VectorSubtract( tw->start, tw->sphere.offset, startp );
-			}
-			else
-			{
-				VectorAdd( tw->start, tw->sphere.offset, startp );
-			}
-			d1 = DotProduct( startp, plane->normal ) - dist;
-			// if completely in front of face, no intersection
-			if ( d1 > 0 ) {
-				return;
-			}
-		}
-	} else {
-		// the first six planes are the axial planes, so we only
-		// need to test the remainder
-		for ( i = 6 ; i < brush->numsides ; i++ ) {
-			side = brush->sides + i;
-			plane = side->plane;
-
-			// adjust the plane distance appropriately for mins/maxs
-			dist = plane->dist - DotProduct( tw->offsets[ plane->signbits ], plane->normal );
-
-			d1 = DotProduct( tw->start, plane->normal ) - dist;
-
-			// if completely in front of face, no intersection
-			if ( d1 > 0 ) {
-				return;
-			}
-		}
+	if ( !CM_BoxInBrushSides( tw, brush ) ) {
+		return;
 	}
 
 	// inside this brush
@@ -212,18 +407,20 @@ CM_TestInLeaf
 void CM_TestInLeaf( traceWork_t *tw, trace_t &trace, cLeaf_t *leaf, clipMap_t *local )
 {
 	int			k;
-	int			brushnum;
+	int			brushnum, patchnum;
 	cbrush_t	*b;
 	cPatch_t	*patch;
+	traceStamps_t	*stamps = CM_TraceStamps( tw->tc, local );
+	int			checkcount = tw->tc->checkcount;
 
 	// test box position against all brushes in the leaf
 	for (k=0 ; k<leaf->numLeafBrushes ; k++) {
 		brushnum = local->leafbrushes[leaf->firstLeafBrush+k];
 		b = &local->brushes[brushnum];
-		if (b->checkcount == local->checkcount) {
+		if (stamps->brushes[brushnum] == checkcount) {
 			continue;	// already checked this brush in another leaf
 		}
-		b->checkcount = local->checkcount;
+		stamps->brushes[brushnum] = checkcount;
 
 		if ( !(b->contents & tw->contents)) {
 			continue;
@@ -242,14 +439,15 @@ void CM_TestInLeaf( traceWork_t *tw, trace_t &trace, cLeaf_t *leaf, clipMap_t *l
 	if ( !cm_noCurves->integer ) {
 #endif //BSPC
 		for ( k = 0 ; k < leaf->numLeafSurfaces ; k++ ) {
-			patch = local->surfaces[ local->leafsurfaces[ leaf->firstLeafSurface + k ] ];
+			patchnum = local->leafsurfaces[ leaf->firstLeafSurface + k ];
+			patch = local->surfaces[ patchnum ];
 			if ( !patch ) {
 				continue;
 			}
-			if ( patch->checkcount == local->checkcount ) {
+			if ( stamps->patches[patchnum] == checkcount ) {
 				continue;	// already checked this brush in another leaf
 			}
-			patch->checkcount = local->checkcount;
+			stamps->patches[patchnum] = checkcount;
 
 			if ( !(patch->contents & tw->contents)) {
 				continue;
@@ -280,7 +478,7 @@ void CM_TestCapsuleInCapsule( traceWork_t *tw, trace_t &trace, clipHandle_t mode
 	vec3_t offset, symetricSize[2];
 	float radius, halfwidth, halfheight, offs, r;
 
-	CM_ModelBounds(model, mins, maxs);
+	CM_TraceModelBounds(tw->tc, model, mins, maxs);
 
 	VectorAdd(tw->start, tw->sphere.offset, top);
 	VectorSubtract(tw->start, tw->sphere.offset, bottom);
@@ -345,10 +543,11 @@ void CM_TestBoundingBoxInCapsule( traceWork_t *tw, trace_t &trace, clipHandle_t
 	vec3_t mins, maxs, offset, size[2];
 	clipHandle_t h;
 	cmodel_t *cmod;
+	clipMap_t *local;
 	int i;
 
 	// mins maxs of the capsule
-	CM_ModelBounds(model, mins, maxs);
+	CM_TraceModelBounds(tw->tc, model, mins, maxs);
 
 	// offset for capsule center
 	for ( i = 0 ; i < 3 ; i++ ) {
@@ -366,10 +565,10 @@ void CM_TestBoundingBoxInCapsule( traceWork_t *tw, trace_t &trace, clipHandle_t
 	VectorSet( tw->sphere.offset, 0, 0, size[1][2] - tw->sphere.radius );
 
 	// replace the capsule with the bounding box
-	h = CM_TempBoxModel(tw->size[0], tw->size[1], qfalse);
+	h = CM_TempBoxModelCtx(tw->tc, tw->size[0], tw->size[1], qfalse);
 	// calculate collision
-	cmod = CM_ClipHandleToModel( h );
-	CM_TestInLeaf( tw, trace, &cmod->leaf, &cmg );
+	cmod = CM_TraceModel( tw->tc, h, &local );
+	CM_TestInLeaf( tw, trace, &cmod->leaf, local );
 }
 
 /*
@@ -377,9 +576,8 @@ void CM_TestBoundingBoxInCapsule( traceWork_t *tw, trace_t &trace, clipHandle_t
 CM_PositionTest
 ==================
 */
-#define	MAX_POSITION_LEAFS	1024
 void CM_PositionTest( traceWork_t *tw, trace_t &trace ) {
-	int		leafs[MAX_POSITION_LEAFS];
+	int		*leafs = tw->tc->leafs;
 	int		i;
 	leafList_t	ll;
 
@@ -398,14 +596,10 @@ void CM_PositionTest( traceWork_t *tw, trace_t &trace ) {
 	ll.storeLeafs = CM_StoreLeafs;
 	ll.lastLeaf = 0;
 	ll.overflowed = qfalse;
-
-	cmg.checkcount++;
+	ll.tc = tw->tc;
 
 	CM_BoxLeafnums_r( &ll, 0 );
 
-
-	cmg.checkcount++;
-
 	// test the contents of the leafs
 	for (i=0 ; i < ll.count ; i++) {
 		CM_TestInLeaf( tw, trace, &cmg.leafs[leafs[i]], &cmg );
@@ -433,7 +627,7 @@ CM_TraceThroughPatch
 void CM_TraceThroughPatch( traceWork_t *tw, trace_t &trace, cPatch_t *patch ) {
 	float		oldFrac;
 
-	c_patch_traces++;
+	tw->tc->patchTraces++;
 
 	oldFrac = trace.fraction;
 
@@ -445,89 +639,6 @@ void CM_TraceThroughPatch( traceWork_t *tw, trace_t &trace, cPatch_t *patch ) {
 	}
 }
 
-/*
-================
-CM_PlaneCollision
-
-  Returns false for a quick getout
-================
-*/
-
-bool CM_PlaneCollision(traceWork_t *tw, cbrushside_t *side)
-{
-	float			dist, f;
-	float			d1, d2;
-
-	cplane_t		*plane = side->plane;
-
-	// adjust the plane distance appropriately for mins/maxs
-	dist = plane->dist - DotProduct( tw->offsets[ plane->signbits ], plane->normal );
-
-	d1 = DotProduct( tw->start, plane->normal ) - dist;
-	d2 = DotProduct( tw->end, plane->normal ) - dist;
-
-	if (d2 > 0.0f)
-	{
-		// endpoint is not in solid
-		tw->getout = true;
-	}
-	if (d1 > 0.0f)
-	{
-		// startpoint is not in solid
-		tw->startout = true;
-	}
-
-	// if completely in front of face, no intersection with the entire brush
-	if ((d1 > 0.0f) && ( (d2 >= SURFACE_CLIP_EPSILON) || (d2 >= d1) ) )
-	{
-		return(false);
-	}
-
-	// if it doesn't cross the plane, the plane isn't relevent
-	if ((d1 <= 0.0f) && (d2 <= 0.0f))
-	{
-		return(true);
-	}
-	// crosses face
-	if (d1 > d2)
-	{	// enter
-		f = (d1 - SURFACE_CLIP_EPSILON);
-		if ( f < 0.0f )
-		{
-			f = 0.0f;
-			if (f > tw->enterFrac)
-			{
-				tw->enterFrac = f;
-				tw->clipplane = plane;
-				tw->leadside = side;
-			}
-		}
-		else if (f > tw->enterFrac * (d1 - d2) )
-		{
-			tw->enterFrac = f / (d1 - d2);
-			tw->clipplane = plane;
-			tw->leadside = side;
-		}
-	}
-	else
-	{	// leave
-		f = (d1 + SURFACE_CLIP_EPSILON);
-		if ( f < (d1 - d2) )
-		{
-			f = 1.0f;
-			if (f < tw->leaveFrac)
-			{
-				tw->leaveFrac = f;
-			}
-		}
-		else if (f > tw->leaveFrac * (d1 - d2) )
-		{
-			tw->leaveFrac = f / (d1 - d2);
-		}
-	}
-	return(true);
-}
-
 /*
 ================
 CM_TraceThroughBrush
@@ -535,9 +646,6 @@ CM_TraceThroughBrush
 */
 void CM_TraceThroughBrush( traceWork_t *tw, trace_t &trace, cbrush_t *brush, bool infoOnly )
 {
-	int				i;
-	cbrushside_t	*side;
-
 	tw->enterFrac = -1.0f;
 	tw->leaveFrac = 1.0f;
 	tw->clipplane = NULL;
@@ -569,14 +677,9 @@ void CM_TraceThroughBrush( traceWork_t *tw, trace_t &trace, cbrush_t *brush, boo
 	// find the latest time the trace crosses a plane towards the interior
 	// and the earliest time the trace crosses a plane towards the exterior
 	//
-	for (i = 0; i < brush->numsides; i++)
+	if ( !CM_ClipToBrushSides( tw, brush ) )
 	{
-		side = brush->sides + i;
-
-		if(!CM_PlaneCollision(tw, side))
-		{
-			return;
-		}
+		return;
 	}
 
 	//
@@ -650,19 +753,21 @@ CM_TraceThroughLeaf
 */
 void CM_TraceThroughLeaf( traceWork_t *tw, trace_t &trace, clipMap_t *local, cLeaf_t *leaf ) {
 	int			k;
-	int			brushnum;
+	int			brushnum, patchnum;
 	cbrush_t	*b;
 	cPatch_t	*patch;
+	traceStamps_t	*stamps = CM_TraceStamps( tw->tc, local );
+	int			checkcount = tw->tc->checkcount;
 
 	// trace line against all brushes in the leaf
 	for ( k = 0 ; k < leaf->numLeafBrushes ; k++ ) {
 		brushnum = local->leafbrushes[leaf->firstLeafBrush+k];
 
 		b = &local->brushes[brushnum];
-		if ( b->checkcount == local->checkcount ) {
+		if ( stamps->brushes[brushnum] == checkcount ) {
 			continue;	// already checked this brush in another leaf
 		}
-		b->checkcount = local->checkcount;
+		stamps->brushes[brushnum] = checkcount;
 
 		if ( !(b->contents & tw->contents) ) {
 			continue;
@@ -682,14 +787,15 @@ void CM_TraceThroughLeaf( traceWork_t *tw, trace_t &trace, clipMap_t *local, cLe
 	if ( !cm_noCurves->integer ) {
 #endif
 		for ( k = 0 ; k < leaf->numLeafSurfaces ; k++ ) {
-			patch = local->surfaces[ local->leafsurfaces[ leaf->firstLeafSurface + k ] ];
+			patchnum = local->leafsurfaces[ leaf->firstLeafSurface + k ];
+			patch = local->surfaces[ patchnum ];
 			if ( !patch ) {
 				continue;
 			}
-			if ( patch->checkcount == local->checkcount ) {
+			if ( stamps->patches[patchnum] == checkcount ) {
 				continue;	// already checked this patch in another leaf
 			}
-			patch->checkcount = local->checkcount;
+			stamps->patches[patchnum] = checkcount;
 
 			if ( !(patch->contents & tw->contents) ) {
 				continue;
@@ -910,7 +1016,7 @@ void CM_TraceCapsuleThroughCapsule( traceWork_t *tw, trace_t &trace, clipHandle_
 	vec3_t offset, symetricSize[2];
 	float radius, halfwidth, halfheight, offs, h;
 
-	CM_ModelBounds(model, mins, maxs);
+	CM_TraceModelBounds(tw->tc, model, mins, maxs);
 	// test trace bounds vs. capsule bounds
 	if ( tw->bounds[0][0] > maxs[0] + RADIUS_EPSILON
 		|| tw->bounds[0][1] > maxs[1] + RADIUS_EPSILON
@@ -969,10 +1075,11 @@ void CM_TraceBoundingBoxThroughCapsule( traceWork_t *tw, trace_t &trace, clipHan
 	vec3_t mins, maxs, offset, size[2];
 	clipHandle_t h;
 	cmodel_t *cmod;
+	clipMap_t *local;
 	int i;
 
 	// mins maxs of the capsule
-	CM_ModelBounds(model, mins, maxs);
+	CM_TraceModelBounds(tw->tc, model, mins, maxs);
 
 	// offset for capsule center
 	for ( i = 0 ; i < 3 ; i++ ) {
@@ -990,10 +1097,10 @@ void CM_TraceBoundingBoxThroughCapsule( traceWork_t *tw, trace_t &trace, clipHan
 	VectorSet( tw->sphere.offset, 0, 0, size[1][2] - tw->sphere.radius );
 
 	// replace the capsule with the bounding box
-	h = CM_TempBoxModel(tw->size[0], tw->size[1], qfalse);
+	h = CM_TempBoxModelCtx(tw->tc, tw->size[0], tw->size[1], qfalse);
 	// calculate collision
-	cmod = CM_ClipHandleToModel( h );
-	CM_TraceThroughLeaf( tw, trace, &cmg, &cmod->leaf );
+	cmod = CM_TraceModel( tw->tc, h, &local );
+	CM_TraceThroughLeaf( tw, trace, local, &cmod->leaf );
 }
 
 //=========================================================================================
@@ -1006,9 +1113,11 @@ CM_TraceToLeaf
 void CM_TraceToLeaf( traceWork_t *tw, trace_t &trace, cLeaf_t *leaf, clipMap_t *local )
 {
 	int			k;
-	int			brushnum;
+	int			brushnum, patchnum;
 	cbrush_t	*b;
 	cPatch_t	*patch;
+	traceStamps_t	*stamps = CM_TraceStamps( tw->tc, local );
+	int			checkcount = tw->tc->checkcount;
 
 	// trace line against all brushes in the leaf
 	for ( k = 0 ; k < leaf->numLeafBrushes ; k++ )
@@ -1016,11 +1125,11 @@ void CM_TraceToLeaf( traceWork_t *tw, trace_t &trace, cLeaf_t *leaf, clipMap_t *
 		brushnum = local->leafbrushes[leaf->firstLeafBrush + k];
 
 		b = &local->brushes[brushnum];
-		if ( b->checkcount == local->checkcount )
+		if ( stamps->brushes[brushnum] == checkcount )
 		{
 			continue;	// already checked this brush in another leaf
 		}
-		b->checkcount = local->checkcount;
+		stamps->brushes[brushnum] = checkcount;
 
 		if ( !(b->contents & tw->contents) )
 		{
@@ -1041,14 +1150,15 @@ void CM_TraceToLeaf( traceWork_t *tw, trace_t &trace, cLeaf_t *leaf, clipMap_t *
 	if ( !cm_noCurves->integer ) {
 #endif
 		for ( k = 0 ; k < leaf->numLeafSurfaces ; k++ ) {
-			patch = local->surfaces[ local->leafsurfaces[ leaf->firstLeafSurface + k ] ];
+			patchnum = local->leafsurfaces[ leaf->firstLeafSurface + k ];
+			patch = local->surfaces[ patchnum ];
 			if ( !patch ) {
 				continue;
 			}
-			if ( patch->checkcount == local->checkcount ) {
+			if ( stamps->patches[patchnum] == checkcount ) {
 				continue;	// already checked this patch in another leaf
 			}
-			patch->checkcount = local->checkcount;
+			stamps->patches[patchnum] = checkcount;
 
 			if ( !(patch->contents & tw->contents) ) {
 				continue;
@@ -1211,33 +1321,15 @@ void CM_CalcExtents(const vec3_t start, const vec3_t end, const traceWork_t *tw,
 
 /*
 ==================
-CM_Trace
+CM_TraceSetup
+
+Fills in the parts of tw that only depend on the sweep
 ==================
 */
-void CM_Trace( trace_t *trace, const vec3_t start, const vec3_t end,
-						  const vec3_t mins, const vec3_t maxs,
-						  clipHandle_t model, const vec3_t origin, int brushmask, int capsule, sphere_t *sphere ) {
+static void CM_TraceSetup( traceWork_t *tw, const vec3_t start, const vec3_t end,
+						  const vec3_t mins, const vec3_t maxs, int brushmask, int capsule, sphere_t *sphere ) {
 	int			i;
-	traceWork_t	tw;
 	vec3_t		offset;
-	cmodel_t	*cmod;
-	clipMap_t	*local = 0;
-
-	cmod = CM_ClipHandleToModel( model, &local );
-
-	local->checkcount++;		// for multi-check avoidance
-
-	c_traces++;				// for statistics, may be zeroed
-
-	// fill in a default trace
-	Com_Memset( &tw, 0, sizeof(tw) );
-	memset(trace, 0, sizeof(*trace));
-	trace->fraction = 1;	// assume it goes the entire distance until shown otherwise
-	VectorCopy(origin, tw.modelOrigin);
-
-	if (!local->numNodes) {
-		return;	// map not loaded, shouldn't happen
-	}
 
 	// allow NULL to be passed in for 0,0,0
 	if ( !mins ) {
@@ -1248,90 +1340,172 @@ void CM_Trace( trace_t *trace, const vec3_t start, const vec3_t end,
 	}
 
 	// set basic parms
-	tw.contents = brushmask;
+	tw->contents = brushmask;
 
 	// adjust so that mins and maxs are always symetric, which
 	// avoids some complications with plane expanding of rotated
 	// bmodels
 	for ( i = 0 ; i < 3 ; i++ ) {
 		offset[i] = ( mins[i] + maxs[i] ) * 0.5;
-		tw.size[0][i] = mins[i] - offset[i];
-		tw.size[1][i] = maxs[i] - offset[i];
-		tw.start[i] = start[i] + offset[i];
-		tw.end[i] = end[i] + offset[i];
+		tw->size[0][i] = mins[i] - offset[i];
+		tw->size[1][i] = maxs[i] - offset[i];
+		tw->start[i] = start[i] + offset[i];
+		tw->end[i] = end[i] + offset[i];
 	}
 
 	// if a sphere is already specified
 	if ( sphere ) {
-		tw.sphere = *sphere;
+		tw->sphere = *sphere;
 	}
 	else {
-		tw.sphere.use = (qboolean)capsule;
-		tw.sphere.radius = ( tw.size[1][0] > tw.size[1][2] ) ? tw.size[1][2]: tw.size[1][0];
-		tw.sphere.halfheight = tw.size[1][2];
-		VectorSet( tw.sphere.offset, 0, 0, tw.size[1][2] - tw.sphere.radius );
+		tw->sphere.use = (qboolean)capsule;
+		tw->sphere.radius = ( tw->size[1][0] > tw->size[1][2] ) ? tw->size[1][2]: tw->size[1][0];
+		tw->sphere.halfheight = tw->size[1][2];
+		VectorSet( tw->sphere.offset, 0, 0, tw->size[1][2] - tw->sphere.radius );
 	}
 
-	tw.maxOffset = tw.size[1][0] + tw.size[1][1] + tw.size[1][2];
+	tw->maxOffset = tw->size[1][0] + tw->size[1][1] + tw->size[1][2];
 
-	// tw.offsets[signbits] = vector to appropriately corner from origin
-	tw.offsets[0][0] = tw.size[0][0];
-	tw.offsets[0][1] = tw.size[0][1];
-	tw.offsets[0][2] = tw.size[0][2];
+	// tw->offsets[signbits] = vector to appropriately corner from origin
+	tw->offsets[0][0] = tw->size[0][0];
+	tw->offsets[0][1] = tw->size[0][1];
+	tw->offsets[0][2] = tw->size[0][2];
 
-	tw.offsets[1][0] = tw.size[1][0];
-	tw.offsets[1][1] = tw.size[0][1];
-	tw.offsets[1][2] = tw.size[0][2];
+	tw->offsets[1][0] = tw->size[1][0];
+	tw->offsets[1][1] = tw->size[0][1];
+	tw->offsets[1][2] = tw->size[0][2];
 
-	tw.offsets[2][0] = tw.size[0][0];
-	tw.offsets[2][1] = tw.size[1][1];
-	tw.offsets[2][2] = tw.size[0][2];
+	tw->offsets[2][0] = tw->size[0][0];
+	tw->offsets[2][1] = tw->size[1][1];
+	tw->offsets[2][2] = tw->size[0][2];
 
-	tw.offsets[3][0] = tw.size[1][0];
-	tw.offsets[3][1] = tw.size[1][1];
-	tw.offsets[3][2] = tw.size[0][2];
+	tw->offsets[3][0] = tw->size[1][0];
+	tw->offsets[3][1] = tw->size[1][1];
+	tw->offsets[3][2] = tw->size[0][2];
 
-	tw.offsets[4][0] = tw.size[0][0];
-	tw.offsets[4][1] = tw.size[0][1];
-	tw.offsets[4][2] = tw.size[1][2];
+	tw->offsets[4][0] = tw->size[0][0];
+	tw->offsets[4][1] = tw->size[0][1];
+	tw->offsets[4][2] = tw->size[1][2];
 
-	tw.offsets[5][0] = tw.size[1][0];
-	tw.offsets[5][1] = tw.size[0][1];
-	tw.offsets[5][2] = tw.size[1][2];
+	tw->offsets[5][0] = tw->size[1][0];
+	tw->offsets[5][1] = tw->size[0][1];
+	tw->offsets[5][2] = tw->size[1][2];
 
-	tw.offsets[6][0] = tw.size[0][0];
-	tw.offsets[6][1] = tw.size[1][1];
-	tw.offsets[6][2] = tw.size[1][2];
+	tw->offsets[6][0] = tw->size[0][0];
+	tw->offsets[6][1] = tw->size[1][1];
+	tw->offsets[6][2] = tw->size[1][2];
 
-	tw.offsets[7][0] = tw.size[1][0];
-	tw.offsets[7][1] = tw.size[1][1];
-	tw.offsets[7][2] = tw.size[1][2];
+	tw->offsets[7][0] = tw->size[1][0];
+	tw->offsets[7][1] = tw->size[1][1];
+	tw->offsets[7][2] = tw->size[1][2];
 
 	//
 	// calculate bounds
 	//
-	if ( tw.sphere.use ) {
+	if ( tw->sphere.use ) {
 		for ( i = 0 ; i < 3 ; i++ ) {
-			if ( tw.start[i] < tw.end[i] ) {
-				tw.bounds[0][i] = tw.start[i] - fabs(tw.sphere.offset[i]) - tw.sphere.radius;
-				tw.bounds[1][i] = tw.end[i] + fabs(tw.sphere.offset[i]) + tw.sphere.radius;
+			if ( tw->start[i] < tw->end[i] ) {
+				tw->bounds[0][i] = tw->start[i] - fabs(tw->sphere.offset[i]) - tw->sphere.radius;
+				tw->bounds[1][i] = tw->end[i] + fabs(tw->sphere.offset[i]) + tw->sphere.radius;
 			} else {
-				tw.bounds[0][i] = tw.end[i] - fabs(tw.sphere.offset[i]) - tw.sphere.radius;
-				tw.bounds[1][i] = tw.start[i] + fabs(tw.sphere.offset[i]) + tw.sphere.radius;
+				tw->bounds[0][i] = tw->end[i] - fabs(tw->sphere.offset[i]) - tw->sphere.radius;
+				tw->bounds[1][i] = tw->start[i] + fabs(tw->sphere.offset[i]) + tw->sphere.radius;
 			}
 		}
 	}
 	else {
 		for ( i = 0 ; i < 3 ; i++ ) {
-			if ( tw.start[i] < tw.end[i] ) {
-				tw.bounds[0][i] = tw.start[i] + tw.size[0][i];
-				tw.bounds[1][i] = tw.end[i] + tw.size[1][i];
+			if ( tw->start[i] < tw->end[i] ) {
+				tw->bounds[0][i] = tw->start[i] + tw->size[0][i];
+				tw->bounds[1][i] = tw->end[i] + tw->size[1][i];
 			} else {
-				tw.bounds[0][i] = tw.end[i] + tw.size[0][i];
-				tw.bounds[1][i] = tw.start[i] + tw.size[1][i];
+				tw->bounds[0][i] = tw->end[i] + tw->size[0][i];
+				tw->bounds[1][i] = tw->start[i] + tw->size[1][i];
 			}
 		}
 	}
+}
+
+/*
+==================
+CM_TraceExtents
+
+For sweeps, as opposed to position tests
+==================
+*/
+static void CM_TraceExtents( traceWork_t *tw ) {
+	//
+	// check for point special case
+	//
+	if ( tw->size[0][0] == 0 && tw->size[0][1] == 0 && tw->size[0][2] == 0 )
+	{
+		tw->isPoint = qtrue;
+		VectorClear( tw->extents );
+	}
+	else
+	{
+		tw->isPoint = qfalse;
+		tw->extents[0] = tw->size[1][0];
+		tw->extents[1] = tw->size[1][1];
+		tw->extents[2] = tw->size[1][2];
+	}
+}
+
+/*
+==================
+CM_TraceEndpos
+==================
+*/
+static void CM_TraceEndpos( trace_t *trace, const vec3_t start, const vec3_t end ) {
+	int			i;
+
+	// generate endpos from the original, unmodified start/end
+	if ( trace->fraction == 1 ) {
+		VectorCopy (end, trace->endpos);
+	} else {
+		for ( i=0 ; i<3 ; i++ ) {
+			trace->endpos[i] = start[i] + trace->fraction * (end[i] - start[i]);
+		}
+	}
+
+        // If allsolid is set (was entirely inside something solid), the plane is not valid.
+        // If fraction == 1.0, we never hit anything, and thus the plane is not valid.
+        // Otherwise, the normal on the plane should have unit length
+        assert(trace->allsolid ||
+               trace->fraction == 1.0 ||
+               VectorLengthSquared(trace->plane.normal) > 0.9999);
+}
+
+/*
+==================
+CM_Trace
+==================
+*/
+void CM_Trace( traceContext_t *tc, trace_t *trace, const vec3_t start, const vec3_t end,
+						  const vec3_t mins, const vec3_t maxs,
+						  clipHandle_t model, const vec3_t origin, int brushmask, int capsule, sphere_t *sphere ) {
+	traceWork_t	tw;
+	cmodel_t	*cmod;
+	clipMap_t	*local = 0;
+
+	cmod = CM_TraceModel( tc, model, &local );
+
+	CM_NextCheckcount( tc );	// for multi-check avoidance
+
+	tc->traces++;			// for statistics, may be zeroed
+
+	// fill in a default trace
+	Com_Memset( &tw, 0, sizeof(tw) );
+	memset(trace, 0, sizeof(*trace));
+	tw.tc = tc;
+	trace->fraction = 1;	// assume it goes the entire distance until shown otherwise
+	VectorCopy(origin, tw.modelOrigin);
+
+	if (!local->numNodes) {
+		return;	// map not loaded, shouldn't happen
+	}
+
+	CM_TraceSetup( &tw, start, end, mins, maxs, brushmask, capsule, sphere );
 
 	//
 	// check for position test special case
@@ -1382,21 +1556,7 @@ void CM_Trace( trace_t *trace, const vec3_t start, const vec3_t end,
 	}
 	else
 	{
-		//
-		// check for point special case
-		//
-		if ( tw.size[0][0] == 0 && tw.size[0][1] == 0 && tw.size[0][2] == 0 )
-		{
-			tw.isPoint = qtrue;
-			VectorClear( tw.extents );
-		}
-		else
-		{
-			tw.isPoint = qfalse;
-			tw.extents[0] = tw.size[1][0];
-			tw.extents[1] = tw.size[1][1];
-			tw.extents[2] = tw.size[1][2];
-		}
+		CM_TraceExtents( &tw );
 
 		//
 		// general sweeping through world
@@ -1439,21 +1599,7 @@ void CM_Trace( trace_t *trace, const vec3_t start, const vec3_t end,
 		}
 	}
 
-	// generate endpos from the original, unmodified start/end
-	if ( trace->fraction == 1 ) {
-		VectorCopy (end, trace->endpos);
-	} else {
-		for ( i=0 ; i<3 ; i++ ) {
-			trace->endpos[i] = start[i] + trace->fraction * (end[i] - start[i]);
-		}
-	}
-
-        // If allsolid is set (was entirely inside something solid), the plane is not valid.
-        // If fraction == 1.0, we never hit anything, and thus the plane is not valid.
-        // Otherwise, the normal on the plane should have unit length
-        assert(trace->allsolid ||
-               trace->fraction == 1.0 ||
-               VectorLengthSquared(trace->plane.normal) > 0.9999);
+	CM_TraceEndpos( trace, start, end );
 }
 
 /*
@@ -1461,10 +1607,16 @@ void CM_Trace( trace_t *trace, const vec3_t start, const vec3_t end,
 CM_BoxTrace
 ==================
 */
+void CM_BoxTraceCtx( traceContext_t *tc, trace_t *results, const vec3_t start, const vec3_t end,
+						  const vec3_t mins, const vec3_t maxs,
+						  clipHandle_t model, int brushmask, int capsule ) {
+	CM_Trace( tc, results, start, end, mins, maxs, model, vec3_origin, brushmask, capsule, NULL );
+}
+
 void CM_BoxTrace( trace_t *results, const vec3_t start, const vec3_t end,
 						  const vec3_t mins, const vec3_t maxs,
 						  clipHandle_t model, int brushmask, int capsule ) {
-	CM_Trace( results, start, end, mins, maxs, model, vec3_origin, brushmask, capsule, NULL );
+	CM_Trace( &cm_defaultTrace, results, start, end, mins, maxs, model, vec3_origin, brushmask, capsule, NULL );
 }
 
 /*
@@ -1475,7 +1627,7 @@ Handles offseting and rotation of the end points for moving and
 rotating entities
 ==================
 */
-void CM_TransformedBoxTrace( trace_t *trace, const vec3_t start, const vec3_t end,
+void CM_TransformedBoxTraceCtx( traceContext_t *tc, trace_t *trace, const vec3_t start, const vec3_t end,
 						  const vec3_t mins, const vec3_t maxs,
 						  clipHandle_t model, int brushmask,
 						  const vec3_t origin, const vec3_t angles, int capsule ) {
@@ -1548,7 +1700,7 @@ void CM_TransformedBoxTrace( trace_t *trace, const vec3_t start, const vec3_t en
 	}
 
 	// sweep the box through the model
-	CM_Trace( trace, start_l, end_l, symetricSize[0], symetricSize[1], model, origin, brushmask, capsule, &sphere );
+	CM_Trace( tc, trace, start_l, end_l, symetricSize[0], symetricSize[1], model, origin, brushmask, capsule, &sphere );
 
 	// if the bmodel was rotated and there was a collision
 	if ( rotated && trace->fraction != 1.0 ) {
@@ -1564,6 +1716,428 @@ void CM_TransformedBoxTrace( trace_t *trace, const vec3_t start, const vec3_t en
 	trace->endpos[2] = start[2] + trace->fraction * (end[2] - start[2]);
 }
 
+void CM_TransformedBoxTrace( trace_t *trace, const vec3_t start, const vec3_t end,
+						  const vec3_t mins, const vec3_t maxs,
+						  clipHandle_t model, int brushmask,
+						  const vec3_t origin, const vec3_t angles, int capsule ) {
+	CM_TransformedBoxTraceCtx( &cm_defaultTrace, trace, start, end, mins, maxs, model, brushmask, origin, angles, capsule );
+}
+
+/*
+===============================================================================
+
+BATCHED TRACES
+
+Rays that are traced together walk the tree together: each node is only
+visited once for all the rays that reach it, and as long as all of them
+are on the same side of the planes they are not looked at one by one.
+Each ray still sees the nodes, leafs and brushes in the order a
+CM_BoxTrace of its own would, so the results are the same.
+
+===============================================================================
+*/
+
+#define	MAX_BATCH_RAYS		64		// one bit each in traceStamps_t::brushRays
+
+typedef struct batchSegment_s {
+	int			ray;
+	float		p1f, p2f;
+	vec3_t		p1, p2;
+} batchSegment_t;
+
+typedef struct traceBatch_s {
+	traceContext_t	*tc;
+	traceStamps_t	*stamps;
+	traceWork_t		tw[MAX_BATCH_RAYS];
+	trace_t			*trace[MAX_BATCH_RAYS];
+	float			extents[MAX_BATCH_RAYS][4];	// tw extents, [3] is -1 for points, kept together for the tree walk
+	vec3_t			maxExtents;		// of all rays
+} traceBatch_t;
+
+/*
+================
+CM_TraceBatchThroughLeaf
+
+One ray after another, so its traceWork_t stays in the cache, while the
+leaf's brushes stay in the cache for all of them
+================
+*/
+static void CM_TraceBatchThroughLeaf( traceBatch_t *tb, cLeaf_t *leaf, const batchSegment_t *const *segs, int numSegs ) {
+	int			i, k;
+	int			brushnum, patchnum, ray;
+	uint64_t	bit;
+	traceWork_t	*tw;
+	trace_t		*trace;
+	cbrush_t	*b;
+	cPatch_t	*patch;
+	traceStamps_t	*stamps = tb->stamps;
+	int			checkcount = tb->tc->checkcount;
+
+	for ( i = 0 ; i < numSegs ; i++ ) {
+		ray = segs[i]->ray;
+		bit = (uint64_t)1 << ray;
+		tw = &tb->tw[ray];
+		trace = tb->trace[ray];
+		if ( trace->fraction <= segs[i]->p1f ) {
+			continue;	// already hit something nearer
+		}
+
+		// trace the ray against all brushes in the leaf
+		for ( k = 0 ; k < leaf->numLeafBrushes ; k++ ) {
+			brushnum = cmg.leafbrushes[leaf->firstLeafBrush+k];
+
+			b = &cmg.brushes[brushnum];
+			if ( stamps->brushes[brushnum] != checkcount ) {
+				stamps->brushes[brushnum] = checkcount;
+				stamps->brushRays[brushnum] = 0;
+			} else if ( stamps->brushRays[brushnum] & bit ) {
+				continue;	// already checked this brush in another leaf
+			}
+			stamps->brushRays[brushnum] |= bit;
+
+			if ( !(b->contents & tw->contents) ) {
+				continue;
+			}
+
+			CM_TraceThroughBrush( tw, *trace, b, false );
+
+			if ( !trace->fraction ) {
+				break;
+			}
+		}
+		if ( !trace->fraction ) {
+			continue;
+		}
+
+		// trace the ray against all patches in the leaf
+#ifdef BSPC
+		if (1) {
+#else
+		if ( !cm_noCurves->integer ) {
+#endif
+			for ( k = 0 ; k < leaf->numLeafSurfaces ; k++ ) {
+				patchnum = cmg.leafsurfaces[ leaf->firstLeafSurface + k ];
+				patch = cmg.surfaces[ patchnum ];
+				if ( !patch ) {
+					continue;
+				}
+				if ( stamps->patches[patchnum] != checkcount ) {
+					stamps->patches[patchnum] = checkcount;
+					stamps->patchRays[patchnum] = 0;
+				} else if ( stamps->patchRays[patchnum] & bit ) {
+					continue;	// already checked this patch in another leaf
+				}
+				stamps->patchRays[patchnum] |= bit;
+
+				if ( !(patch->contents & tw->contents) ) {
+					continue;
+				}
+
+				CM_TraceThroughPatch( tw, *trace, patch );
+				if ( !trace->fraction ) {
+					break;
+				}
+			}
+		}
+	}
+}
+
+/*
+================
+CM_SplitSegment
+
+The part of seg on the near or far side of frac, computed the way
+CM_TraceThroughTree splits a trace at a node
+================
+*/
+static void CM_SplitSegment( const batchSegment_t *seg, float frac, bool nearSide, batchSegment_t *out ) {
+	float	midf;
+	vec3_t	mid;
+
+	midf = seg->p1f + (seg->p2f - seg->p1f)*frac;
+
+	mid[0] = seg->p1[0] + frac*(seg->p2[0] - seg->p1[0]);
+	mid[1] = seg->p1[1] + frac*(seg->p2[1] - seg->p1[1]);
+	mid[2] = seg->p1[2] + frac*(seg->p2[2] - seg->p1[2]);
+
+	out->ray = seg->ray;
+	if ( nearSide ) {
+		out->p1f = seg->p1f;
+		out->p2f = midf;
+		VectorCopy( seg->p1, out->p1 );
+		VectorCopy( mid, out->p2 );
+	} else {
+		out->p1f = midf;
+		out->p2f = seg->p2f;
+		VectorCopy( mid, out->p1 );
+		VectorCopy( seg->p2, out->p2 );
+	}
+}
+
+/*
+================
+CM_AddSegment
+================
+*/
+typedef struct segmentList_s {
+	const batchSegment_t	*segs[MAX_BATCH_RAYS];
+	int						numSegs;
+	vec3_t					bounds[2];
+} segmentList_t;
+
+static QINLINE void CM_AddSegment( segmentList_t *list, const batchSegment_t *seg ) {
+	int		i;
+
+	list->segs[list->numSegs++] = seg;
+	for ( i = 0 ; i < 3 ; i++ ) {
+		list->bounds[0][i] = Q_min( list->bounds[0][i], Q_min( seg->p1[i], seg->p2[i] ) );
+		list->bounds[1][i] = Q_max( list->bounds[1][i], Q_max( seg->p1[i], seg->p2[i] ) );
+	}
+}
+
+/*
+================
+CM_TraceBatchThroughTree
+
+Like CM_TraceThroughTree for all segments at once.  The list's bounds
+enclose the start and end points of all its segments: when that box is
+clear of an axial plane, so is every segment, and all of them go down the
+same side without looking at them one by one.
+
+Otherwise a segment that only touches one side goes there, one that
+crosses the plane goes to its near side and then its far side, so the
+children are visited as children[0] (front, and the near part of rays
+going back), children[1] (back, the near part of rays going forward and
+the far part of rays going back) and children[0] again (the far part of
+rays going forward).
+================
+*/
+static void CM_TraceBatchThroughTree( traceBatch_t *tb, int num, const segmentList_t *list ) {
+	cNode_t		*node;
+	cplane_t	*plane;
+	const batchSegment_t	*seg;
+	float		t1, t2, offset;
+	float		idist;
+	float		frac, frac2;
+	segmentList_t	child[3];
+	batchSegment_t	split[2*MAX_BATCH_RAYS];
+	int			i, numSplit;
+
+	// the whole batch on one side of an axial plane
+	while ( num >= 0 ) {
+		node = cmg.nodes + num;
+		plane = node->plane;
+		if ( plane->type >= 3 ) {
+			break;
+		}
+		offset = tb->maxExtents[plane->type];
+		if ( list->bounds[0][plane->type] - plane->dist >= offset + 1 ) {
+			num = node->children[0];
+		} else if ( list->bounds[1][plane->type] - plane->dist < -offset - 1 ) {
+			num = node->children[1];
+		} else {
+			break;
+		}
+	}
+
+	// if < 0, we are in a leaf node
+	if ( num < 0 ) {
+		CM_TraceBatchThroughLeaf( tb, &cmg.leafs[-1-num], list->segs, list->numSegs );
+		return;
+	}
+
+	node = cmg.nodes + num;
+	plane = node->plane;
+
+	for ( i = 0 ; i < 3 ; i++ ) {
+		child[i].numSegs = 0;
+		ClearBounds( child[i].bounds[0], child[i].bounds[1] );
+	}
+	numSplit = 0;
+
+	for ( i = 0 ; i < list->numSegs ; i++ ) {
+		seg = list->segs[i];
+		if ( tb->trace[seg->ray]->fraction <= seg->p1f ) {
+			continue;	// already hit something nearer
+		}
+
+		// adjust the plane distance appropriately for mins/maxs
+		if ( plane->type < 3 ) {
+			t1 = seg->p1[plane->type] - plane->dist;
+			t2 = seg->p2[plane->type] - plane->dist;
+			offset = tb->extents[seg->ray][plane->type];
+		} else {
+			t1 = DotProduct (plane->normal, seg->p1) - plane->dist;
+			t2 = DotProduct (plane->normal, seg->p2) - plane->dist;
+			if ( tb->extents[seg->ray][3] < 0 ) {
+				offset = 0;
+			} else {
+				// this is silly
+				offset = 2048;
+			}
+		}
+
+		// see which sides we need to consider
+		if ( t1 >= offset + 1 && t2 >= offset + 1 ) {
+			CM_AddSegment( &child[0], seg );
+			continue;
+		}
+		if ( t1 < -offset - 1 && t2 < -offset - 1 ) {
+			CM_AddSegment( &child[1], seg );
+			continue;
+		}
+
+		// put the crosspoint SURFACE_CLIP_EPSILON pixels on the near side
+		if ( t1 < t2 ) {
+			idist = 1.0/(t1-t2);
+			frac2 = (t1 + offset + SURFACE_CLIP_EPSILON)*idist;
+			frac = (t1 - offset + SURFACE_CLIP_EPSILON)*idist;
+		} else if (t1 > t2) {
+			idist = 1.0/(t1-t2);
+			frac2 = (t1 - offset - SURFACE_CLIP_EPSILON)*idist;
+			frac = (t1 + offset + SURFACE_CLIP_EPSILON)*idist;
+		} else {
+			frac = 1;
+			frac2 = 0;
+		}
+
+		// move up to the node
+		if ( frac < 0 ) {
+			frac = 0;
+		}
+		if ( frac > 1 ) {
+			frac = 1;
+		}
+
+		// go past the node
+		if ( frac2 < 0 ) {
+			frac2 = 0;
+		}
+		if ( frac2 > 1 ) {
+			frac2 = 1;
+		}
+
+		CM_SplitSegment( seg, frac, true, &split[numSplit] );
+		CM_SplitSegment( seg, frac2, false, &split[numSplit+1] );
+		if ( t1 < t2 ) {
+			// starts behind
+			CM_AddSegment( &child[1], &split[numSplit] );
+			CM_AddSegment( &child[2], &split[numSplit+1] );
+		} else {
+			CM_AddSegment( &child[0], &split[numSplit] );
+			CM_AddSegment( &child[1], &split[numSplit+1] );
+		}
+		numSplit += 2;
+	}
+
+	if ( child[0].numSegs ) {
+		CM_TraceBatchThroughTree( tb, node->children[0], &child[0] );
+	}
+	if ( child[1].numSegs ) {
+		CM_TraceBatchThroughTree( tb, node->children[1], &child[1] );
+	}
+	if ( child[2].numSegs ) {
+		CM_TraceBatchThroughTree( tb, node->children[0], &child[2] );
+	}
+}
+
+/*
+================
+CM_TraceBatch
+
+Up to MAX_BATCH_RAYS rays through the world
+================
+*/
+static void CM_TraceBatch( traceBatch_t *tb, trace_t *results, const traceRequest_t *requests, int numRequests, int capsule ) {
+	batchSegment_t	segs[MAX_BATCH_RAYS];
+	segmentList_t	list;
+	traceWork_t		*tw;
+	const traceRequest_t	*req;
+	int				i;
+
+	CM_NextCheckcount( tb->tc );	// for multi-check avoidance
+	VectorClear( tb->maxExtents );
+	list.numSegs = 0;
+	ClearBounds( list.bounds[0], list.bounds[1] );
+	tb->tc->traces += numRequests;	// for statistics, may be zeroed
+
+	for ( i = 0 ; i < numRequests ; i++ ) {
+		req = &requests[i];
+		tw = &tb->tw[i];
+
+		// fill in a default trace
+		Com_Memset( tw, 0, sizeof(*tw) );
+		memset( &results[i], 0, sizeof(results[i]) );
+		tw->tc = tb->tc;
+		tb->trace[i] = &results[i];
+		results[i].fraction = 1;	// assume it goes the entire distance until shown otherwise
+
+		if ( !cmg.numNodes ) {
+			continue;	// map not loaded, shouldn't happen
+		}
+
+		CM_TraceSetup( tw, req->start, req->end, req->mins, req->maxs, req->contentmask, capsule, NULL );
+
+		// position tests keep the extents cleared, as in CM_Trace
+		if ( !VectorCompare( req->start, req->end ) ||
+			tw->size[0][0] != 0 || tw->size[0][1] != 0 || tw->size[0][2] != 0 ) {
+			CM_TraceExtents( tw );
+		}
+
+		VectorCopy( tw->extents, tb->extents[i] );
+		tb->extents[i][3] = tw->isPoint ? -1 : 0;
+		tb->maxExtents[0] = Q_max( tb->maxExtents[0], tw->extents[0] );
+		tb->maxExtents[1] = Q_max( tb->maxExtents[1], tw->extents[1] );
+		tb->maxExtents[2] = Q_max( tb->maxExtents[2], tw->extents[2] );
+
+		segs[i].ray = i;
+		segs[i].p1f = 0;
+		segs[i].p2f = 1;
+		VectorCopy( tw->start, segs[i].p1 );
+		VectorCopy( tw->end, segs[i].p2 );
+		CM_AddSegment( &list, &segs[i] );
+	}
+
+	if ( !cmg.numNodes ) {
+		return;
+	}
+
+	CM_TraceBatchThroughTree( tb, cmg.cmodels[0].firstNode, &list );
+
+	for ( i = 0 ; i < numRequests ; i++ ) {
+		CM_TraceEndpos( &results[i], requests[i].start, requests[i].end );
+	}
+}
+
+/*
+==================
+CM_BoxTraceBatch
+
+The same as a CM_BoxTrace against the world for each request
+==================
+*/
+void CM_BoxTraceBatchCtx( traceContext_t *tc, trace_t *results, const traceRequest_t *requests, int numRequests, int capsule ) {
+	traceBatch_t	tb;
+	int				i, n;
+
+	tb.tc = tc;
+	tb.stamps = &tc->stamps[0];
+
+	for ( i = 0 ; i < numRequests ; i += n ) {
+		n = Q_min( numRequests - i, MAX_BATCH_RAYS );
+		if ( n == 1 ) {
+			// nothing to share
+			CM_Trace( tc, &results[i], requests[i].start, requests[i].end, requests[i].mins, requests[i].maxs, 0, vec3_origin, requests[i].contentmask, capsule, NULL );
+			continue;
+		}
+		CM_TraceBatch( &tb, results + i, requests + i, n, capsule );
+	}
+}
+
+void CM_BoxTraceBatch( trace_t *results, const traceRequest_t *requests, int numRequests, int capsule ) {
+	CM_BoxTraceBatchCtx( &cm_defaultTrace, results, requests, numRequests, capsule );
+}
+
 /*
 =================
 CM_CullBox
@@ -1881,14 +1881,14 @@ void Com_Frame( void ) {
 		//
 		if ( com_showtrace->integer ) {
 
-			extern	int c_traces, c_brush_traces, c_patch_traces;
+			extern	int c_brush_traces;
 			extern	int	c_pointcontents;
+			int		c_traces, c_patch_traces;
 
+			CM_TraceCounts( &c_traces, &c_patch_traces );
 			Com_Printf ("%4i traces  (%ib %ip) %4i points\n", c_traces,
 				c_brush_traces, c_patch_traces, c_pointcontents);
-			c_traces = 0;
 			c_brush_traces = 0;
-			c_patch_traces = 0;
 			c_pointcontents = 0;
 		}
 
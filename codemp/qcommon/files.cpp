@@ -30,10 +30,14 @@ along with this program; if not, see <http://www.gnu.org/licenses/>.
  *
  *****************************************************************************/
 
+#include <algorithm>
+#include <chrono>
 #include <condition_variable>
-#include <deque>
 #include <mutex>
+#include <string>
 #include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "qcommon/qcommon.h"
@@ -56,6 +60,12 @@ along with this program; if not, see <http://www.gnu.org/licenses/>.
 	#include <unistd.h>
 #endif
 
+// for writev
+#if !defined(_WIN32)
+	#include <errno.h>
+	#include <sys/uio.h>
+#endif
+
 /*
 =============================================================================
 
@@ -220,6 +230,7 @@ typedef struct pack_s {
 	int				hashSize;					// hash table size (power of 2)
 	fileInPack_t*	*hashTable;					// hash table
 	fileInPack_t*	buildBuffer;				// buffer with the filenames etc.
+	struct fileInIndex_s	*indexFiles;		// buildBuffer's entries in the global file index
 } pack_t;
 
 typedef struct directory_s {
@@ -257,6 +268,22 @@ static int			fs_readCount;			// total bytes read
 static int			fs_loadCount;			// total files read
 static int			fs_packFiles = 0;		// total number of files in packs
 
+#define MAX_FILEINDEX_SIZE	(1<<20)
+
+// one file of a pk3 in the index of the files of all pk3s on the search path
+typedef struct fileInIndex_s {
+	fileInPack_t			*file;
+	pack_t					*pack;
+	struct fileInIndex_s	*next;		// next name in the hash
+	struct fileInIndex_s	*nextPack;	// the same name in a later pack on the search path
+	struct fileInIndex_s	*first;		// the same name in the first pack that has it
+} fileInIndex_t;
+
+static fileInIndex_t	**fs_indexTable;		// first pack's file of each name
+static int				fs_indexSize;			// hash table size (power of 2)
+static fileInIndex_t	*fs_indexFiles;			// all files, in search path order
+static qboolean			fs_indexValid;			// cleared when the search paths change
+
 static int			fs_fakeChkSum;
 static int			fs_checksumFeed;
 
@@ -270,12 +297,28 @@ typedef struct qfile_us {
 	qboolean	unique;
 } qfile_ut;
 
+// Writes to async handles are copied into chunks from a shared pool and
+// written out by one thread that serves every async handle.
+#define ASYNC_CHUNK_SIZE		16384
+#define ASYNC_MAX_FREE_CHUNKS	256		// keep up to 4MB around for reuse
+#define ASYNC_FLUSH_MSEC		50		// how long partly filled chunks may wait
+
+typedef struct asyncChunk_s {
+	struct asyncChunk_s	*next;
+	int					size;
+	byte				data[ASYNC_CHUNK_SIZE];
+} asyncChunk_t;
+
 typedef struct fileHandleData_s {
 	fileHandleData_s() :
 			handleFiles({}),
 			handleSync(qfalse),
 			handleAsync(qfalse),
-			writerThread(nullptr),
+			asyncHead(nullptr),
+			asyncTail(nullptr),
+			asyncOpened(qfalse),
+			asyncDone(qfalse),
+			asyncPosition(0),
 			closed(qfalse),
 			fileSize(0),
 			zipFilePos(0),
@@ -287,10 +330,11 @@ typedef struct fileHandleData_s {
 	qfile_ut	handleFiles;
 	qboolean	handleSync;
 	qboolean	handleAsync;
-	std::thread	*writerThread;
-	std::mutex	writeLock;
-	std::condition_variable	cv;
-	std::deque<std::vector<byte> > writes;
+	asyncChunk_t	*asyncHead;		// queued writes, guarded by fsAsync.lock
+	asyncChunk_t	*asyncTail;
+	qboolean	asyncOpened;		// the writer thread has tried to open the file
+	qboolean	asyncDone;			// the writer thread has closed the file and is done with the handle
+	int			asyncPosition;		// bytes written so far, for FS_FTell
 	qboolean	closed;
 	char		ospath[MAX_OSPATH];
 	int			fileSize;
@@ -302,6 +346,28 @@ typedef struct fileHandleData_s {
 
 static fileHandleData_t	fsh[MAX_FILE_HANDLES];
 
+static struct {
+	std::thread				*thread;
+	std::mutex				lock;
+	std::condition_variable	wake;			// signalled when there is work for the writer thread
+	std::condition_variable	done;			// signalled when the writer thread finished a handle
+	qboolean				work;
+	qboolean				stop;			// FS_AsyncShutdown wants the writer thread to exit
+	qboolean				active[MAX_FILE_HANDLES];	// handles the writer thread still has to finish
+
+	asyncChunk_t			*freeChunks;
+	int						numFreeChunks;
+	int						numChunks;		// chunks currently allocated
+
+	// statistics for fs_asyncinfo
+	int						chunkAllocs;
+	int						flushes;
+	int						syscalls;
+	int						peakChunks;
+} fsAsync;
+
+static void FS_AsyncStartWriter( void );
+
 // TTimo - https://zerowing.idsoftware.com/bugzilla/show_bug.cgi?id=540
 // wether we did a reorder on the current search path when joining the server
 static qboolean fs_reordered = qfalse;
@@ -342,12 +408,14 @@ FILE*		missingFiles = NULL;
 #endif
 
 static void FS_ResetFileHandleData( fileHandleData_t *f ) {
-	assert(f->writerThread == nullptr);
+	assert(f->asyncHead == nullptr);
 	f->handleFiles = {};
 	f->handleSync = qfalse;
 	f->handleAsync = qfalse;
-	f->writerThread = nullptr;
-	f->writes.clear();
+	f->asyncHead = f->asyncTail = nullptr;
+	f->asyncOpened = qfalse;
+	f->asyncDone = qfalse;
+	f->asyncPosition = 0;
 	f->closed = qfalse;
 	f->ospath[0] = '\0';
 	f->fileSize = 0;
@@ -409,6 +477,23 @@ qboolean FS_PakIsPure( pack_t *pack ) {
 	return qtrue;
 }
 
+/*
+=================
+FS_PakHandle
+
+Opens the zip of a pak that was loaded from the cache
+=================
+*/
+static unzFile FS_PakHandle( pack_t *pack ) {
+	if ( !pack->handle ) {
+		pack->handle = unzOpen( pack->pakFilename );
+		if ( !pack->handle ) {
+			Com_Error( ERR_FATAL, "Couldn't open %s", pack->pakFilename );
+		}
+	}
+	return pack->handle;
+}
+
 /*
 ================
 return a hash value for the filename
@@ -434,6 +519,145 @@ static long FS_HashFileName( const char *fname, int hashSize ) {
 	return hash;
 }
 
+/*
+================
+FS_HashPath
+
+return a hash value for the whole path, the same for all
+names FS_FilenameCompare considers equal
+================
+*/
+static unsigned int FS_HashPath( const char *fname ) {
+	unsigned int	hash = 2166136261u;
+	int				c;
+
+	for ( ; *fname ; fname++ ) {
+		c = *fname;
+		if ( c >= 'A' && c <= 'Z' ) {
+			c += 'a' - 'A';
+		}
+		if ( c == '\\' || c == ':' ) {
+			c = '/';
+		}
+		hash = ( hash ^ c ) * 16777619u;
+	}
+	return hash;
+}
+
+/*
+================
+FS_FreeFileIndex
+================
+*/
+static void FS_FreeFileIndex( void ) {
+	if ( fs_indexTable ) {
+		Z_Free( fs_indexTable );
+		Z_Free( fs_indexFiles );
+	}
+	fs_indexTable = NULL;
+	fs_indexFiles = NULL;
+	fs_indexSize = 0;
+	fs_indexValid = qfalse;
+}
+
+/*
+================
+FS_BuildFileIndex
+
+Puts the files of all pk3s on the search path into one hash table, so a
+lookup doesn't have to probe every pack.  Each name is in the table once,
+the packs further down the search path that have it too are chained to it.
+================
+*/
+static void FS_BuildFileIndex( void ) {
+	searchpath_t	*search;
+	fileInIndex_t	*f, *other;
+	int				numFiles, i;
+	unsigned int	hash;
+
+	FS_FreeFileIndex();
+
+	numFiles = 0;
+	for ( search = fs_searchpaths ; search ; search = search->next ) {
+		if ( search->pack ) {
+			numFiles += search->pack->numfiles;
+		}
+	}
+
+	for ( fs_indexSize = 1 ; fs_indexSize < numFiles && fs_indexSize < MAX_FILEINDEX_SIZE ; fs_indexSize <<= 1 ) {
+	}
+	fs_indexTable = (fileInIndex_t **)Z_Malloc( fs_indexSize * sizeof( *fs_indexTable ), TAG_FILESYS, qtrue );
+	fs_indexFiles = (fileInIndex_t *)Z_Malloc( ( numFiles + 1 ) * sizeof( *fs_indexFiles ), TAG_FILESYS, qtrue );
+
+	f = fs_indexFiles;
+	for ( search = fs_searchpaths ; search ; search = search->next ) {
+		if ( !search->pack ) {
+			continue;
+		}
+
+		search->pack->indexFiles = f;
+		for ( i = 0 ; i < search->pack->numfiles ; i++, f++ ) {
+			f->file = &search->pack->buildBuffer[i];
+			f->pack = search->pack;
+
+			hash = FS_HashPath( f->file->name ) & ( fs_indexSize - 1 );
+			for ( other = fs_indexTable[hash] ; other ; other = other->next ) {
+				if ( !FS_FilenameCompare( other->file->name, f->file->name ) ) {
+					break;
+				}
+			}
+
+			if ( other ) {
+				f->first = other;
+				while ( other->nextPack ) {
+					other = other->nextPack;
+				}
+				other->nextPack = f;
+
+				// like with the pack's own hash, the last of the same
+				// name in one pk3 wins
+				if ( other->pack == f->pack ) {
+					other->file = f->file;
+				}
+			} else {
+				f->first = f;
+				f->next = fs_indexTable[hash];
+				fs_indexTable[hash] = f;
+			}
+		}
+	}
+
+	fs_indexValid = qtrue;
+}
+
+/*
+================
+FS_IndexedFile
+
+Returns the file of the first pure pk3 on the search path that has
+filename, NULL if none has it
+================
+*/
+static fileInIndex_t *FS_IndexedFile( const char *filename ) {
+	fileInIndex_t	*f;
+
+	if ( !fs_indexValid ) {
+		FS_BuildFileIndex();
+	}
+
+	for ( f = fs_indexTable[FS_HashPath( filename ) & ( fs_indexSize - 1 )] ; f ; f = f->next ) {
+		if ( !FS_FilenameCompare( f->file->name, filename ) ) {
+			for ( ; f ; f = f->nextPack ) {
+				if ( FS_PakIsPure( f->pack ) ) {
+					return f;
+				}
+			}
+			return NULL;
+		}
+	}
+	return NULL;
+}
+
 static fileHandle_t FS_HandleForFile(void) {
 	int		i;
 
@@ -1087,6 +1311,9 @@ void FS_Rename( const char *from, const char *to ) {
 
 void FS_FCloseAio( int handle ) {
 	fileHandle_t f = (fileHandle_t) handle;
+	if ( f < 1 || f >= MAX_FILE_HANDLES ) {
+		Com_Error( ERR_FATAL, "FCloseAio called with invalid handle %d\n", f );
+	}
 	if (!fsh[f].closed || !fsh[f].handleAsync) {
 		if (fs_debug->integer) {
 			// This can happen if we were forced to sync close a file, for example 
@@ -1097,12 +1324,11 @@ void FS_FCloseAio( int handle ) {
 		}
 		return;
 	}
-	if ( f < 1 || f >= MAX_FILE_HANDLES ) {
-		Com_Error( ERR_FATAL, "FCloseAio called with invalid handle %d\n", f );
+
+	std::unique_lock<std::mutex> l( fsAsync.lock );
+	while ( !fsh[f].asyncDone ) {
+		fsAsync.done.wait( l );
 	}
-	fsh[f].writerThread->join();
-	delete fsh[f].writerThread;
-	fsh[f].writerThread = nullptr;
 	if (fs_debug->integer) {
 		Com_Printf("FS_FCloseAio: %s closed.\n", fsh[f].name);
 	}
@@ -1129,7 +1355,6 @@ There are three cases handled:
 ===========
 */
 void FS_FCloseFile( fileHandle_t f ) {
-	qboolean handleWasNull = qfalse;
 	FS_AssertInitialised();
 
 	if (fsh[f].zipFile == qtrue) {
@@ -1141,41 +1366,29 @@ void FS_FCloseFile( fileHandle_t f ) {
 		return;
 	} 
 	
-	if (!fsh[f].handleFiles.file.o) {
-		handleWasNull = qtrue;
+	if ( fsh[f].handleAsync ) {
 		if (fs_debug->integer) {
-			Com_Printf("FS_FCloseFile: fsh[f].handleFiles.file.o is NULL (%s).\n", fsh[f].name);
+			Com_Printf("FS_FCloseFile: Requesting async close of %s.\n", fsh[f].name);
 		}
+		// queue the file to be closed after all pending operations are completed.
+		{
+			std::lock_guard<std::mutex> l( fsAsync.lock );
+			fsh[f].closed = qtrue;
+			fsAsync.work = qtrue;
+			FS_AsyncStartWriter();
+		}
+		fsAsync.wake.notify_one();
+		return;
 	}
 
 	// we didn't find it as a pak, so close it as a unique file
-	if (!handleWasNull || fsh[f].handleAsync) { 
-		// || fsh[f].handleAsync because we cannot merely check that file.io is not NULL, since 
-		// a race condition (although it is rare, happening maybe once every few hours at worst) 
-		// can result in it being NULL due to fopen() inside the writer thread
-		// not yet having returned the proper FILE* value. 
-		if ( fsh[f].handleAsync ) {
-			if (fs_debug->integer) {
-				if (handleWasNull) {
-					Com_Printf("FS_FCloseFile: Requesting async close of %s (handle was NULL, fopen not yet returned?).\n", fsh[f].name);
-				}
-				else {
-					Com_Printf("FS_FCloseFile: Requesting async close of %s.\n", fsh[f].name);
-				}
-			}
-			// queue the file to be closed after all pending operations are completed.
-			{
-				std::lock_guard<std::mutex> l( fsh[f].writeLock );
-				fsh[f].closed = qtrue;
-			}
-			fsh[f].cv.notify_one();
-			return;
-		} else {
-			if (fs_debug->integer) {
-				Com_Printf("FS_FCloseFile: Sync closing %s.\n", fsh[f].name);
-			}
-			fclose (fsh[f].handleFiles.file.o);
+	if (fsh[f].handleFiles.file.o) {
+		if (fs_debug->integer) {
+			Com_Printf("FS_FCloseFile: Sync closing %s.\n", fsh[f].name);
 		}
+		fclose (fsh[f].handleFiles.file.o);
+	} else if (fs_debug->integer) {
+		Com_Printf("FS_FCloseFile: fsh[f].handleFiles.file.o is NULL (%s).\n", fsh[f].name);
 	}
 	FS_ResetFileHandleData( &fsh[f] );
 }
@@ -1197,55 +1410,227 @@ void FS_AsyncAssureFileClosed(const char* ospath) {
 	}
 }
 
-extern void Com_PushEvent( sysEvent_t *event );
-void FS_AsyncWriterThread( fileHandle_t h ) {
-	qboolean fileOpenFailed = qfalse;
-	fileHandleData_t *f = &fsh[h];
-	if ( !FS_CreatePath( f->ospath ) ) {
-		if (fs_debug->integer) {
-			Com_Printf("FS_AsyncWriterThread: Opening %s.\n", f->name);
+/*
+===========
+FS_AsyncAllocChunk / FS_AsyncFreeChunks
+
+Called with fsAsync.lock held
+===========
+*/
+static asyncChunk_t *FS_AsyncAllocChunk( void ) {
+	asyncChunk_t *chunk = fsAsync.freeChunks;
+
+	if ( chunk ) {
+		fsAsync.freeChunks = chunk->next;
+		fsAsync.numFreeChunks--;
+	} else {
+		chunk = new asyncChunk_t;
+		fsAsync.chunkAllocs++;
+	}
+	chunk->next = nullptr;
+	chunk->size = 0;
+
+	if ( ++fsAsync.numChunks > fsAsync.peakChunks ) {
+		fsAsync.peakChunks = fsAsync.numChunks;
+	}
+	return chunk;
+}
+
+static void FS_AsyncFreeChunks( asyncChunk_t *chunk ) {
+	asyncChunk_t *next;
+
+	for ( ; chunk ; chunk = next ) {
+		next = chunk->next;
+		fsAsync.numChunks--;
+		if ( fsAsync.numFreeChunks < ASYNC_MAX_FREE_CHUNKS ) {
+			chunk->next = fsAsync.freeChunks;
+			fsAsync.freeChunks = chunk;
+			fsAsync.numFreeChunks++;
+		} else {
+			delete chunk;
 		}
-		f->handleFiles.file.o = fopen( f->ospath, "wb" );
 	}
-	if ( f->handleFiles.file.o == nullptr ) {
-		Com_Printf( "Warning: failed to open file %s\n", f->name );
-		fileOpenFailed = qtrue;
-		//return;
-		// Don't return here, it's likely to cause issues.
+}
+
+/*
+===========
+FS_AsyncWriteChunks
+
+Writes a handle's queued chunks, as few system calls as possible
+===========
+*/
+static void FS_AsyncWriteChunks( fileHandleData_t *f, asyncChunk_t *chunks ) {
+#ifdef _WIN32
+	for ( ; chunks ; chunks = chunks->next ) {
+		fwrite( chunks->data, 1, chunks->size, f->handleFiles.file.o );
+		fsAsync.syscalls++;
 	}
+#else
+	struct iovec	iov[64];
+	struct iovec	*v;
+	int				fd = fileno( f->handleFiles.file.o );
+	int				n;
+	ssize_t			written;
+
+	while ( chunks ) {
+		for ( n = 0 ; chunks && n < (int)ARRAY_LEN( iov ) ; chunks = chunks->next, n++ ) {
+			iov[n].iov_base = chunks->data;
+			iov[n].iov_len = chunks->size;
+		}
+
+		for ( v = iov ; n ; ) {
+			written = writev( fd, v, n );
+			fsAsync.syscalls++;
+			if ( written < 0 ) {
+				if ( errno == EINTR ) {
+					continue;
+				}
+				Com_Printf( "Warning: failed to write to %s\n", f->name );
+				return;
+			}
+			// skip what made it, a partial write continues in the middle of a chunk
+			while ( n && written >= (ssize_t)v->iov_len ) {
+				written -= v->iov_len;
+				v++;
+				n--;
+			}
+			if ( n ) {
+				v->iov_base = (byte *)v->iov_base + written;
+				v->iov_len -= written;
+			}
+		}
+	}
+#endif
+}
+
+/*
+===========
+FS_AsyncWriterThread
+
+Serves every async handle: opens the file, writes out whatever was queued
+and closes it once FS_FCloseFile was called and nothing is left. Full
+chunks and closes wake it up right away, partly filled chunks are picked
+up every ASYNC_FLUSH_MSEC while any handle is active. When told to stop it
+makes one last pass and exits, handles that are still open stay active for
+the next writer thread.
+===========
+*/
+extern void Com_PushEvent( sysEvent_t *event );
+static void FS_AsyncWriterThread( void ) {
+	std::unique_lock<std::mutex> l( fsAsync.lock );
+	qboolean anyActive = qtrue;
+
 	while ( qtrue ) {
-		std::vector<byte> write;
-		{
-			std::unique_lock<std::mutex> l( f->writeLock );
-			while ( f->writes.empty() && !f->closed ) {
-				f->cv.wait( l );
+		if ( !fsAsync.work && !fsAsync.stop ) {
+			if ( anyActive ) {
+				fsAsync.wake.wait_for( l, std::chrono::milliseconds( ASYNC_FLUSH_MSEC ) );
+			} else {
+				fsAsync.wake.wait( l, []{ return fsAsync.work || fsAsync.stop; } );
 			}
-			if ( f->closed && f->writes.empty() ) {
-				break;
+		}
+		fsAsync.work = qfalse;
+		anyActive = qfalse;
+
+		for ( int h = 1 ; h < MAX_FILE_HANDLES ; h++ ) {
+			fileHandleData_t	*f = &fsh[h];
+			asyncChunk_t		*chunks;
+			qboolean			open, closing;
+
+			if ( !fsAsync.active[h] ) {
+				continue;
+			}
+			anyActive = qtrue;
+
+			chunks = f->asyncHead;
+			f->asyncHead = f->asyncTail = nullptr;
+			open = f->asyncOpened ? qfalse : qtrue;
+			f->asyncOpened = qtrue;
+			closing = f->closed;
+			if ( !chunks && !open && !closing ) {
+				continue;
+			}
+
+			l.unlock();
+			if ( open && !FS_CreatePath( f->ospath ) ) {
+				if (fs_debug->integer) {
+					Com_Printf("FS_AsyncWriterThread: Opening %s.\n", f->name);
+				}
+				f->handleFiles.file.o = fopen( f->ospath, "wb" );
+			}
+			if ( open && f->handleFiles.file.o == nullptr ) {
+				// The demo writing code has to assume that fopen() was successful, lest we want to
+				// fopen() synchronously and potentially hang gameplay. So we keep throwing away
+				// whatever is written and close the handle normally once we are told to.
+				Com_Printf( "Warning: failed to open file %s\n", f->name );
+			}
+			if ( chunks && f->handleFiles.file.o ) {
+				FS_AsyncWriteChunks( f, chunks );
+			}
+			if ( closing && f->handleFiles.file.o ) {
+				fclose( f->handleFiles.file.o );
+			}
+			l.lock();
+
+			if ( chunks ) {
+				FS_AsyncFreeChunks( chunks );
+				fsAsync.flushes++;
+			}
+			if ( closing ) {
+				fsAsync.active[h] = qfalse;
+				f->asyncDone = qtrue;
+				fsAsync.done.notify_all();
+
+				l.unlock();
+				sysEvent_t event;
+				Com_Memset( &event, 0, sizeof( event ) );
+				event.evType = SE_AIO_FCLOSE;
+				event.evValue = h;
+				Com_PushEvent( &event );
+				l.lock();
 			}
-			write = std::move(f->writes.front());
-			f->writes.pop_front();
 		}
-		if (!fileOpenFailed) {
-			// This is pretty cringe but lest we want to fopen() synchronously and potentially hang
-			// gameplay, the demo writing code kinda just has to assume that fopen() was successful.
-			// So we have to kinda go through the motions here and pretend that everything is ok
-			// so that once the demo is "closing" we can clean up properly 
-			// and not cause a crash somehow.
-			// It's sad in that the game will assume the demo recording is working when it isn't.
-			// On the flipside, I'm not aware of this actually happening ever, so it's more of a hypothetical
-			// to begin with.
-			fwrite( &write[0], 1, write.size(), f->handleFiles.file.o );
+
+		if ( fsAsync.stop ) {
+			break;
 		}
 	}
-	if (!fileOpenFailed) {
-		fclose(f->handleFiles.file.o);
+}
+
+/*
+===========
+FS_AsyncStartWriter
+
+One writer thread for all async files, started the first time it is needed
+and again after FS_AsyncShutdown. Called with fsAsync.lock held
+===========
+*/
+static void FS_AsyncStartWriter( void ) {
+	if ( !fsAsync.thread ) {
+		fsAsync.thread = new std::thread( FS_AsyncWriterThread );
+	}
+}
+
+/*
+===========
+FS_AsyncShutdown
+
+Lets the writer thread flush what is queued and waits for it to exit
+===========
+*/
+static void FS_AsyncShutdown( void ) {
+	if ( !fsAsync.thread ) {
+		return;
 	}
-	sysEvent_t event;
-	Com_Memset( &event, 0, sizeof( event ) );
-	event.evType = SE_AIO_FCLOSE;
-	event.evValue = h;
-	Com_PushEvent( &event );
+
+	{
+		std::lock_guard<std::mutex> l( fsAsync.lock );
+		fsAsync.stop = qtrue;
+	}
+	fsAsync.wake.notify_one();
+	fsAsync.thread->join();
+	delete fsAsync.thread;
+	fsAsync.thread = nullptr;
+	fsAsync.stop = qfalse;
 }
 
 // Call with safe==qtrue to make sure the file isn't open in another async file handle anymore
@@ -1264,9 +1649,14 @@ fileHandle_t FS_FOpenFileWriteAsync( const char *filename, qboolean safe ) {
 	}
 
 	Q_strncpyz( fsh[f].name, filename, sizeof( fsh[f].name ) );
-	fsh[f].handleAsync = qtrue;
-	// spawn writer thread
-	fsh[f].writerThread = new std::thread( FS_AsyncWriterThread, f );
+	{
+		std::lock_guard<std::mutex> l( fsAsync.lock );
+		fsh[f].handleAsync = qtrue;
+		fsAsync.active[f] = qtrue;
+		fsAsync.work = qtrue;
+		FS_AsyncStartWriter();
+	}
+	fsAsync.wake.notify_one();
 	return f;
 }
 
@@ -1533,15 +1923,13 @@ long FS_FOpenFileRead( const char *filename, fileHandle_t *file, qboolean unique
 	char			*netpath;
 	pack_t			*pak;
 	fileInPack_t	*pakFile;
+	fileInIndex_t	*indexed;
 	directory_t		*dir;
-	long			hash;
 	//unz_s			*zfi;
 	//void			*temp;
 	int				l;
 	bool			isUserConfig = false;
 
-	hash = 0;
-
 	FS_AssertInitialised();
 
 	if ( file == NULL ) {
@@ -1574,6 +1962,11 @@ long FS_FOpenFileRead( const char *filename, fileHandle_t *file, qboolean unique
 
 	isUserConfig = !Q_stricmp( filename, "autoexec.cfg" ) || !Q_stricmp( filename, Q3CONFIG_CFG );
 
+	// autoexec.cfg and openjk.cfg can only be loaded outside of pk3 files.
+	// Otherwise only the first pure pak that has the file needs to be
+	// looked at, the directories before it on the path still come first
+	indexed = isUserConfig ? NULL : FS_IndexedFile( filename );
+
 	//
 	// search through the path, one element at a time
 	//
@@ -1593,132 +1986,115 @@ long FS_FOpenFileRead( const char *filename, fileHandle_t *file, qboolean unique
 		bFasterToReOpenUsingNewLocalFile = qfalse;
 
 		for ( search = fs_searchpaths ; search ; search = search->next ) {
-			//
-			if ( search->pack ) {
-				hash = FS_HashFileName(filename, search->pack->hashSize);
-			}
 			// is the element a pak file?
-			if ( search->pack && search->pack->hashTable[hash] ) {
-				// disregard if it doesn't match one of the allowed pure pak files
-				if ( !FS_PakIsPure(search->pack) ) {
-					continue;
-				}
-
-				// autoexec.cfg and openjk.cfg can only be loaded outside of pk3 files.
-				if ( isUserConfig ) {
+			if ( search->pack ) {
+				if ( !indexed || search->pack != indexed->pack ) {
 					continue;
 				}
 
-				// look through all the pak file elements
+				// found it!
 				pak = search->pack;
-				pakFile = pak->hashTable[hash];
-				do {
-					// case and separator insensitive comparisons
-					if ( !FS_FilenameCompare( pakFile->name, filename ) ) {
-						// found it!
-
-						// mark the pak as having been referenced and mark specifics on cgame and ui
-						// shaders, txt, arena files  by themselves do not count as a reference as
-						// these are loaded from all pk3s
-						// from every pk3 file..
-
-						// The x86.dll suffixes are needed in order for sv_pure to continue to
-						// work on non-x86/windows systems...
-
-						// reference lists
-						if ( !pak->noref ) {
-							// JK2MV automatically references pk3's in three cases:
-							// 1. A .bsp file is loaded from it (and thus it is expected to be a map)
-							// 2. cgame.qvm or ui.qvm is loaded from it (expected to be a clientside)
-							// 3. pk3 is located in fs_game != base (standard jk2 behavior)
-							// All others need to be referenced manually by the use of reflists.
-
-							if (!Q_stricmp(get_filename_ext(filename), "bsp")) {
-								pak->referenced |= FS_GENERAL_REF;
-							}
+				pakFile = indexed->file;
+
+				// mark the pak as having been referenced and mark specifics on cgame and ui
+				// shaders, txt, arena files  by themselves do not count as a reference as
+				// these are loaded from all pk3s
+				// from every pk3 file..
+
+				// The x86.dll suffixes are needed in order for sv_pure to continue to
+				// work on non-x86/windows systems...
+
+				// reference lists
+				if ( !pak->noref ) {
+					// JK2MV automatically references pk3's in three cases:
+					// 1. A .bsp file is loaded from it (and thus it is expected to be a map)
+					// 2. cgame.qvm or ui.qvm is loaded from it (expected to be a clientside)
+					// 3. pk3 is located in fs_game != base (standard jk2 behavior)
+					// All others need to be referenced manually by the use of reflists.
+
+					if (!Q_stricmp(get_filename_ext(filename), "bsp")) {
+						pak->referenced |= FS_GENERAL_REF;
+					}
 
-							if (!Q_stricmp(filename, "vm/cgame.qvm") || !Q_stricmp( filename, "cgamex86.dll" )) {
-								pak->referenced |= FS_CGAME_REF;
-							}
+					if (!Q_stricmp(filename, "vm/cgame.qvm") || !Q_stricmp( filename, "cgamex86.dll" )) {
+						pak->referenced |= FS_CGAME_REF;
+					}
 
-							if (!Q_stricmp(filename, "vm/ui.qvm") || !Q_stricmp( filename, "uix86.dll" )) {
-								pak->referenced |= FS_UI_REF;
-							}
+					if (!Q_stricmp(filename, "vm/ui.qvm") || !Q_stricmp( filename, "uix86.dll" )) {
+						pak->referenced |= FS_UI_REF;
+					}
 
-							// OLD Ref:
-							/*
-							l = strlen( filename );
-							if ( !(pak->referenced & FS_GENERAL_REF)) {
-								if( !FS_IsExt(filename, ".shader", l) &&
-								    !FS_IsExt(filename, ".txt", l) &&
-								    !FS_IsExt(filename, ".str", l) &&
-								    !FS_IsExt(filename, ".cfg", l) &&
-								    !FS_IsExt(filename, ".config", l) &&
-								    !FS_IsExt(filename, ".bot", l) &&
-								    !FS_IsExt(filename, ".arena", l) &&
-								    !FS_IsExt(filename, ".menu", l) &&
-								    !FS_IsExt(filename, ".fcf", l) &&
-								    Q_stricmp(filename, "jampgamex86.dll") != 0 &&
-								    //Q_stricmp(filename, "vm/qagame.qvm") != 0 &&
-								    !strstr(filename, "levelshots"))
-								{
-									pak->referenced |= FS_GENERAL_REF;
-								}
-							}
-							*/
+					// OLD Ref:
+					/*
+					l = strlen( filename );
+					if ( !(pak->referenced & FS_GENERAL_REF)) {
+						if( !FS_IsExt(filename, ".shader", l) &&
+						    !FS_IsExt(filename, ".txt", l) &&
+						    !FS_IsExt(filename, ".str", l) &&
+						    !FS_IsExt(filename, ".cfg", l) &&
+						    !FS_IsExt(filename, ".config", l) &&
+						    !FS_IsExt(filename, ".bot", l) &&
+						    !FS_IsExt(filename, ".arena", l) &&
+						    !FS_IsExt(filename, ".menu", l) &&
+						    !FS_IsExt(filename, ".fcf", l) &&
+						    Q_stricmp(filename, "jampgamex86.dll") != 0 &&
+						    //Q_stricmp(filename, "vm/qagame.qvm") != 0 &&
+						    !strstr(filename, "levelshots"))
+						{
+							pak->referenced |= FS_GENERAL_REF;
 						}
+					}
+					*/
+				}
 
-						if ( uniqueFILE ) {
-							// open a new file on the pakfile
-							fsh[*file].handleFiles.file.z = unzOpen (pak->pakFilename);
-							if (fsh[*file].handleFiles.file.z == NULL) {
-								Com_Error (ERR_FATAL, "Couldn't open %s", pak->pakFilename);
-							}
-						} else {
-							fsh[*file].handleFiles.file.z = pak->handle;
-						}
-						Q_strncpyz( fsh[*file].name, filename, sizeof( fsh[*file].name ) );
-						fsh[*file].zipFile = qtrue;
+				if ( uniqueFILE ) {
+					// open a new file on the pakfile
+					fsh[*file].handleFiles.file.z = unzOpen (pak->pakFilename);
+					if (fsh[*file].handleFiles.file.z == NULL) {
+						Com_Error (ERR_FATAL, "Couldn't open %s", pak->pakFilename);
+					}
+				} else {
+					fsh[*file].handleFiles.file.z = FS_PakHandle( pak );
+				}
+				Q_strncpyz( fsh[*file].name, filename, sizeof( fsh[*file].name ) );
+				fsh[*file].zipFile = qtrue;
 
-						// set the file position in the zip file (also sets the current file info)
-						unzSetOffset(fsh[*file].handleFiles.file.z, pakFile->pos);
+				// set the file position in the zip file (also sets the current file info)
+				unzSetOffset(fsh[*file].handleFiles.file.z, pakFile->pos);
 
-						// open the file in the zip
-						unzOpenCurrentFile(fsh[*file].handleFiles.file.z);
+				// open the file in the zip
+				unzOpenCurrentFile(fsh[*file].handleFiles.file.z);
 
 #if 0
-						zfi = (unz_s *)fsh[*file].handleFiles.file.z;
-						// in case the file was new
-						temp = zfi->filestream;
-						// set the file position in the zip file (also sets the current file info)
-						unzSetOffset(pak->handle, pakFile->pos);
-						// copy the file info into the unzip structure
-						Com_Memcpy( zfi, pak->handle, sizeof(unz_s) );
-						// we copy this back into the structure
-						zfi->filestream = temp;
-						// open the file in the zip
-						unzOpenCurrentFile( fsh[*file].handleFiles.file.z );
+				zfi = (unz_s *)fsh[*file].handleFiles.file.z;
+				// in case the file was new
+				temp = zfi->filestream;
+				// set the file position in the zip file (also sets the current file info)
+				unzSetOffset(pak->handle, pakFile->pos);
+				// copy the file info into the unzip structure
+				Com_Memcpy( zfi, pak->handle, sizeof(unz_s) );
+				// we copy this back into the structure
+				zfi->filestream = temp;
+				// open the file in the zip
+				unzOpenCurrentFile( fsh[*file].handleFiles.file.z );
 #endif
-						fsh[*file].zipFilePos = pakFile->pos;
-						fsh[*file].zipFileLen = pakFile->len;
+				fsh[*file].zipFilePos = pakFile->pos;
+				fsh[*file].zipFileLen = pakFile->len;
 
-						if ( fs_debug->integer ) {
-							Com_Printf( "FS_FOpenFileRead: %s (found in '%s')\n",
-								filename, pak->pakFilename );
-						}
+				if ( fs_debug->integer ) {
+					Com_Printf( "FS_FOpenFileRead: %s (found in '%s')\n",
+						filename, pak->pakFilename );
+				}
 	#ifndef DEDICATED
 	#ifndef FINAL_BUILD
-						// Check for unprecached files when in game but not in the menus
-						if((cls.state == CA_ACTIVE) && !(Key_GetCatcher( ) & KEYCATCH_UI))
-						{
-							Com_Printf(S_COLOR_YELLOW "WARNING: File %s not precached\n", filename);
-						}
+				// Check for unprecached files when in game but not in the menus
+				if((cls.state == CA_ACTIVE) && !(Key_GetCatcher( ) & KEYCATCH_UI))
+				{
+					Com_Printf(S_COLOR_YELLOW "WARNING: File %s not precached\n", filename);
+				}
 	#endif
 	#endif // DEDICATED
-						return pakFile->len;
-					}
-					pakFile = pakFile->next;
-				} while(pakFile != NULL);
+				return pakFile->len;
 			} else if ( search->dir ) {
 				// check a file in the directory tree
 
@@ -1956,11 +2332,36 @@ int FS_Write( const void *buffer, int len, fileHandle_t h ) {
 	buf = (byte *)buffer;
 
 	if ( fsh[h].handleAsync ) {
+		qboolean	chunkFull = qfalse;
 		{
-			std::lock_guard<std::mutex> l( fsh[h].writeLock );
-			fsh[h].writes.emplace_back( buf, buf + len );
+			std::lock_guard<std::mutex> l( fsAsync.lock );
+			remaining = len;
+			while ( remaining ) {
+				asyncChunk_t *chunk = fsh[h].asyncTail;
+				if ( !chunk || chunk->size == ASYNC_CHUNK_SIZE ) {
+					if ( chunk ) {
+						chunk->next = FS_AsyncAllocChunk();
+						chunkFull = qtrue;
+					} else {
+						fsh[h].asyncHead = FS_AsyncAllocChunk();
+					}
+					chunk = fsh[h].asyncTail = chunk ? chunk->next : fsh[h].asyncHead;
+				}
+				block = Q_min( remaining, ASYNC_CHUNK_SIZE - chunk->size );
+				Com_Memcpy( chunk->data + chunk->size, buf, block );
+				chunk->size += block;
+				buf += block;
+				remaining -= block;
+			}
+			if ( chunkFull ) {
+				fsAsync.work = qtrue;
+				FS_AsyncStartWriter();
+			}
+		}
+		fsh[h].asyncPosition += len;
+		if ( chunkFull ) {
+			fsAsync.wake.notify_one();
 		}
-		fsh[h].cv.notify_one();
 		return len;
 	} else {
 		f = FS_FileForHandle( h );
@@ -2108,10 +2509,7 @@ CONVENIENCE FUNCTIONS FOR ENTIRE FILES
 */
 
 int	FS_FileIsInPAK(const char *filename, int *pChecksum ) {
-	searchpath_t	*search;
-	pack_t			*pak;
-	fileInPack_t	*pakFile;
-	long			hash = 0;
+	fileInIndex_t	*indexed;
 
 	FS_AssertInitialised();
 
@@ -2131,45 +2529,21 @@ int	FS_FileIsInPAK(const char *filename, int *pChecksum ) {
 		return -1;
 	}
 
-	//
-	// search through the path, one element at a time
-	//
-
-	for ( search = fs_searchpaths ; search ; search = search->next ) {
-		//
-		if (search->pack) {
-			hash = FS_HashFileName(filename, search->pack->hashSize);
-		}
-		// is the element a pak file?
-		if ( search->pack && search->pack->hashTable[hash] ) {
-			// disregard if it doesn't match one of the allowed pure pak files
-			if ( !FS_PakIsPure(search->pack) ) {
-				continue;
-			}
+	indexed = FS_IndexedFile( filename );
+	if ( !indexed ) {
+		return -1;
+	}
 
-			// look through all the pak file elements
-			pak = search->pack;
-			pakFile = pak->hashTable[hash];
-			do {
-				// case and separator insensitive comparisons
-				if ( !FS_FilenameCompare( pakFile->name, filename ) ) {
-					if (pChecksum) {
-						*pChecksum = pak->pure_checksum;
-					}
-					return 1;
-				}
-				pakFile = pakFile->next;
-			} while(pakFile != NULL);
-		}
+	if (pChecksum) {
+		*pChecksum = indexed->pack->pure_checksum;
 	}
-	return -1;
+	return 1;
 }
 
 long FS_ReadDLLInPAK(const char *filename, void **buffer) {
-	searchpath_t	*search;
+	fileInIndex_t	*indexed;
 	pack_t			*pak;
 	fileInPack_t	*pakFile;
-	long			hash = 0;
 	fileHandle_t	file;
 	byte*			buf = NULL;
 	long			len = 0;
@@ -2199,50 +2573,30 @@ long FS_ReadDLLInPAK(const char *filename, void **buffer) {
 	file = FS_HandleForFile();
 	fsh[file].handleFiles.unique = qfalse;
 
-	for (search = fs_searchpaths; search; search = search->next) {
-		qboolean breakSearch = qfalse;
-		if (search->pack) {
-			hash = FS_HashFileName(filename, search->pack->hashSize);
-		}
-		// is the element a pak file?
-		if (search->pack && search->pack->hashTable[hash]) {
-			// disregard if it doesn't match one of the allowed pure pak files
-			if (!FS_PakIsPure(search->pack)) {
-				continue;
-			}
+	indexed = FS_IndexedFile(filename);
+	if (indexed) {
+		pak = indexed->pack;
+		pakFile = indexed->file;
 
-			// look through all the pak file elements
-			pak = search->pack;
-			pakFile = pak->hashTable[hash];
-			do {
-				// case and separator insensitive comparisons
-				if (!FS_FilenameCompare(pakFile->name, filename)) {
-					fsh[file].handleFiles.file.z = pak->handle;
-					Q_strncpyz(fsh[file].name, filename, sizeof(fsh[file].name));
-					fsh[file].zipFile = qtrue;
-
-					// set the file position in the zip file (also sets the current file info)
-					unzSetOffset(fsh[file].handleFiles.file.z, pakFile->pos);
-
-					// open the file in the zip
-					unzOpenCurrentFile(fsh[file].handleFiles.file.z);
-
-					fsh[file].zipFilePos = pakFile->pos;
-					fsh[file].zipFileLen = pakFile->len;
-
-					if (fs_debug->integer) {
-						Com_Printf("FS_ReadDLLInPAK: %s (found in '%s')\n",
-							filename, pak->pakFilename);
-					}
+		fsh[file].handleFiles.file.z = FS_PakHandle(pak);
+		Q_strncpyz(fsh[file].name, filename, sizeof(fsh[file].name));
+		fsh[file].zipFile = qtrue;
 
-					len = pakFile->len;
-					breakSearch = qtrue;
-					break;
-				}
-				pakFile = pakFile->next;
-			} while (pakFile != NULL);
+		// set the file position in the zip file (also sets the current file info)
+		unzSetOffset(fsh[file].handleFiles.file.z, pakFile->pos);
+
+		// open the file in the zip
+		unzOpenCurrentFile(fsh[file].handleFiles.file.z);
+
+		fsh[file].zipFilePos = pakFile->pos;
+		fsh[file].zipFileLen = pakFile->len;
+
+		if (fs_debug->integer) {
+			Com_Printf("FS_ReadDLLInPAK: %s (found in '%s')\n",
+				filename, pak->pakFilename);
 		}
-		if (breakSearch) break;
+
+		len = pakFile->len;
 	}
 
 	if (file == 0) {
@@ -2318,123 +2672,464 @@ long FS_ReadFile( const char *qpath, void **buffer ) {
 				return len;
 			}
 
-			buf = (unsigned char *)Hunk_AllocateTempMemory(len+1);
-			*buffer = buf;
+			buf = (unsigned char *)Hunk_AllocateTempMemory(len+1);
+			*buffer = buf;
+
+			r = FS_Read( buf, len, com_journalDataFile );
+			if ( r != len ) {
+				Com_Error( ERR_FATAL, "Read from journalDataFile failed" );
+			}
+
+			fs_loadCount++;
+
+			// guarantee that it will have a trailing 0 for string operations
+			buf[len] = 0;
+
+			return len;
+		}
+	} else {
+		isConfig = qfalse;
+	}
+
+	// look for it in the filesystem or pack files
+	len = FS_FOpenFileRead( qpath, &h, qfalse );
+	if ( h == 0 ) {
+		if ( buffer ) {
+			*buffer = NULL;
+		}
+		// if we are journalling and it is a config file, write a zero to the journal file
+		if ( isConfig && com_journal && com_journal->integer == 1 ) {
+			Com_DPrintf( "Writing zero for %s to journal file.\n", qpath );
+			len = 0;
+			FS_Write( &len, sizeof( len ), com_journalDataFile );
+			FS_Flush( com_journalDataFile );
+		}
+		return -1;
+	}
+
+	if ( !buffer ) {
+		if ( isConfig && com_journal && com_journal->integer == 1 ) {
+			Com_DPrintf( "Writing len for %s to journal file.\n", qpath );
+			FS_Write( &len, sizeof( len ), com_journalDataFile );
+			FS_Flush( com_journalDataFile );
+		}
+		FS_FCloseFile( h);
+		return len;
+	}
+
+	fs_loadCount++;
+
+	buf = (byte*)Z_Malloc( len+1, TAG_FILESYS, qfalse);
+	buf[len]='\0';	// because we're not calling Z_Malloc with optional trailing 'bZeroIt' bool
+	*buffer = buf;
+
+//	Z_Label(buf, qpath);
+
+	FS_Read (buf, len, h);
+
+	// guarantee that it will have a trailing 0 for string operations
+	buf[len] = 0;
+	FS_FCloseFile( h );
+
+	// if we are journalling and it is a config file, write it to the journal file
+	if ( isConfig && com_journal && com_journal->integer == 1 ) {
+		Com_DPrintf( "Writing %s to journal file.\n", qpath );
+		FS_Write( &len, sizeof( len ), com_journalDataFile );
+		FS_Write( buf, len, com_journalDataFile );
+		FS_Flush( com_journalDataFile );
+	}
+	return len;
+}
+
+/*
+=============
+FS_FreeFile
+=============
+*/
+void FS_FreeFile( void *buffer ) {
+	FS_AssertInitialised();
+	if ( !buffer ) {
+		Com_Error( ERR_FATAL, "FS_FreeFile( NULL )" );
+	}
+
+	Z_Free( buffer );
+}
+
+/*
+============
+FS_WriteFile
+
+Filename are reletive to the quake search path
+============
+*/
+void FS_WriteFile( const char *qpath, const void *buffer, int size ) {
+	fileHandle_t f;
+
+	FS_AssertInitialised();
+
+	if ( !qpath || !buffer ) {
+		Com_Error( ERR_FATAL, "FS_WriteFile: NULL parameter" );
+	}
+
+	f = FS_FOpenFileWrite( qpath );
+	if ( !f ) {
+		Com_Printf( "Failed to open %s\n", qpath );
+		return;
+	}
+
+	FS_Write( buffer, size, f );
+
+	FS_FCloseFile( f );
+}
+
+/*
+==========================================================================
+
+ZIP FILE LOADING
+
+==========================================================================
+*/
+
+/*
+=================================================================================
+
+PK3 HEADER CACHE
+
+What FS_LoadZipFile reads from the central directory of each pk3, kept in
+fs_homepath between runs and looked up by the pk3's path, size and time
+
+=================================================================================
+*/
+
+#define PAKCACHE_NAME		"pk3cache.dat"
+#define PAKCACHE_MAGIC		0x43334b50		// "PK3C"
+#define PAKCACHE_VERSION	1
+
+// each record starts with this, then the path, the crcs that go into the
+// checksums, a pakCacheFile_t for each file and the file names
+typedef struct pakCacheRecord_s {
+	int64_t		size;
+	int64_t		mtime;
+	int			length;			// of the whole record
+	int			pathLength;		// including the trailing 0
+	int			numFiles;
+	int			numCrcs;
+	int			namesLength;
+	int			pad;
+} pakCacheRecord_t;
+
+typedef struct pakCacheFile_s {
+	uint64_t	pos;
+	uint64_t	len;
+} pakCacheFile_t;
+
+static cvar_t		*fs_pakCache;
+
+static struct {
+	qboolean								loaded;
+	std::vector<byte>						file;		// records read from the cache file
+	std::unordered_map<std::string, size_t>	records;	// path to record offset in file
+	std::vector<byte>						added;		// records of pk3s that weren't cached
+	std::unordered_set<std::string>			addedPaths;
+} fsPakCache;
+
+/*
+=================
+FS_PakCachePath
+=================
+*/
+static const char *FS_PakCachePath( void ) {
+	return FS_BuildOSPath( fs_homepath->string, PAKCACHE_NAME );
+}
+
+/*
+=================
+FS_LoadPakCache
+=================
+*/
+static void FS_LoadPakCache( void ) {
+	FILE				*f;
+	long				length;
+	int					header[2];
+	size_t				offset;
+	pakCacheRecord_t	record;
+
+	fsPakCache.loaded = qtrue;
+	fsPakCache.file.clear();
+	fsPakCache.records.clear();
+
+	f = fopen( FS_PakCachePath(), "rb" );
+	if ( !f ) {
+		return;
+	}
+
+	length = FS_fplength( f );
+	if ( length < (long)sizeof( header ) || fread( header, sizeof( header ), 1, f ) != 1
+		|| header[0] != PAKCACHE_MAGIC || header[1] != PAKCACHE_VERSION ) {
+		fclose( f );
+		return;
+	}
+
+	fsPakCache.file.resize( length - sizeof( header ) );
+	if ( fsPakCache.file.size() && fread( fsPakCache.file.data(), fsPakCache.file.size(), 1, f ) != 1 ) {
+		fsPakCache.file.clear();
+	}
+	fclose( f );
+
+	// a truncated or damaged record ends the cache
+	for ( offset = 0 ; offset + sizeof( record ) <= fsPakCache.file.size() ; offset += record.length ) {
+		memcpy( &record, &fsPakCache.file[offset], sizeof( record ) );
+		if ( record.pathLength < 1 || record.numFiles < 0 || record.numCrcs < 0 || record.namesLength < 0
+			|| record.length != (int)( sizeof( record ) + record.pathLength + record.numCrcs * sizeof( int )
+				+ record.numFiles * sizeof( pakCacheFile_t ) + record.namesLength )
+			|| offset + record.length > fsPakCache.file.size()
+			|| fsPakCache.file[offset + sizeof( record ) + record.pathLength - 1] != 0
+			|| ( record.namesLength && fsPakCache.file[offset + record.length - 1] != 0 ) ) {
+			break;
+		}
+		fsPakCache.records[(const char *)&fsPakCache.file[offset + sizeof( record )]] = offset;
+	}
+}
+
+/*
+=================
+FS_SavePakCache
+
+Writes the pk3s that weren't in the cache yet, and keeps the cached ones
+that are still there, like the pk3s of other mods
+=================
+*/
+static void FS_SavePakCache( void ) {
+	FILE				*f;
+	int					header[2] = { PAKCACHE_MAGIC, PAKCACHE_VERSION };
+	pakCacheRecord_t	record;
+	int64_t				size;
+	time_t				mtime;
+	char				tempPath[MAX_OSPATH];
+	qboolean			ok;
+
+	if ( fsPakCache.added.empty() ) {
+		fsPakCache.loaded = qfalse;
+		fsPakCache.file.clear();
+		fsPakCache.records.clear();
+		return;
+	}
+
+	Com_sprintf( tempPath, sizeof( tempPath ), "%s.tmp", FS_PakCachePath() );
+	f = fopen( tempPath, "wb" );
+	if ( f ) {
+		ok = (qboolean)( fwrite( header, sizeof( header ), 1, f ) == 1 );
+		ok = (qboolean)( ok && fwrite( fsPakCache.added.data(), fsPakCache.added.size(), 1, f ) == 1 );
+
+		for ( const auto &it : fsPakCache.records ) {
+			if ( !ok ) {
+				break;
+			}
+			if ( fsPakCache.addedPaths.count( it.first ) ) {
+				continue;
+			}
+
+			memcpy( &record, &fsPakCache.file[it.second], sizeof( record ) );
+			if ( !Sys_FileStat( it.first.c_str(), &size, &mtime ) || size != record.size || (int64_t)mtime != record.mtime ) {
+				continue;	// deleted or changed since
+			}
+			ok = (qboolean)( fwrite( &fsPakCache.file[it.second], record.length, 1, f ) == 1 );
+		}
 
-			r = FS_Read( buf, len, com_journalDataFile );
-			if ( r != len ) {
-				Com_Error( ERR_FATAL, "Read from journalDataFile failed" );
+		if ( fclose( f ) || !ok ) {
+			remove( tempPath );
+		} else {
+			remove( FS_PakCachePath() );
+			if ( rename( tempPath, FS_PakCachePath() ) ) {
+				remove( tempPath );
 			}
+		}
+	}
 
-			fs_loadCount++;
+	fsPakCache.loaded = qfalse;
+	fsPakCache.file.clear();
+	fsPakCache.records.clear();
+	fsPakCache.added.clear();
+	fsPakCache.addedPaths.clear();
+}
 
-			// guarantee that it will have a trailing 0 for string operations
-			buf[len] = 0;
+/*
+=================
+FS_AllocPak
+=================
+*/
+static pack_t *FS_AllocPak( const char *zipfile, const char *basename, int numfiles ) {
+	pack_t	*pack;
+	int		i;
 
-			return len;
+	// get the hash table size from the number of files in the zip
+	// because lots of custom pk3 files have less than 32 or 64 files
+	for (i = 1; i <= MAX_FILEHASH_SIZE; i <<= 1) {
+		if (i > numfiles) {
+			break;
 		}
-	} else {
-		isConfig = qfalse;
 	}
 
-	// look for it in the filesystem or pack files
-	len = FS_FOpenFileRead( qpath, &h, qfalse );
-	if ( h == 0 ) {
-		if ( buffer ) {
-			*buffer = NULL;
-		}
-		// if we are journalling and it is a config file, write a zero to the journal file
-		if ( isConfig && com_journal && com_journal->integer == 1 ) {
-			Com_DPrintf( "Writing zero for %s to journal file.\n", qpath );
-			len = 0;
-			FS_Write( &len, sizeof( len ), com_journalDataFile );
-			FS_Flush( com_journalDataFile );
-		}
-		return -1;
+	pack = (pack_t *)Z_Malloc( sizeof( pack_t ) + i * sizeof(fileInPack_t *), TAG_FILESYS, qtrue );
+	pack->hashSize = i;
+	pack->hashTable = (fileInPack_t **) (((char *) pack) + sizeof( pack_t ));
+	for(int j = 0; j < pack->hashSize; j++) {
+		pack->hashTable[j] = NULL;
 	}
 
-	if ( !buffer ) {
-		if ( isConfig && com_journal && com_journal->integer == 1 ) {
-			Com_DPrintf( "Writing len for %s to journal file.\n", qpath );
-			FS_Write( &len, sizeof( len ), com_journalDataFile );
-			FS_Flush( com_journalDataFile );
-		}
-		FS_FCloseFile( h);
-		return len;
+	Q_strncpyz( pack->pakFilename, zipfile, sizeof( pack->pakFilename ) );
+	Q_strncpyz( pack->pakBasename, basename, sizeof( pack->pakBasename ) );
+
+	// strip .pk3 if needed
+	if ( strlen( pack->pakBasename ) > 4 && !Q_stricmp( pack->pakBasename + strlen( pack->pakBasename ) - 4, ".pk3" ) ) {
+		pack->pakBasename[strlen( pack->pakBasename ) - 4] = 0;
 	}
 
-	fs_loadCount++;
+	pack->numfiles = numfiles;
+	return pack;
+}
 
-	buf = (byte*)Z_Malloc( len+1, TAG_FILESYS, qfalse);
-	buf[len]='\0';	// because we're not calling Z_Malloc with optional trailing 'bZeroIt' bool
-	*buffer = buf;
+/*
+=================
+FS_SetPakChecksums
 
-//	Z_Label(buf, qpath);
+crcs are the LittleLong crcs of the pk3's non-empty files
+=================
+*/
+static void FS_SetPakChecksums( pack_t *pack, const int *crcs, int numCrcs ) {
+	int		*fs_headerLongs;
 
-	FS_Read (buf, len, h);
+	fs_headerLongs = (int *)Z_Malloc( ( numCrcs + 1 ) * sizeof(int), TAG_FILESYS, qtrue );
+	fs_headerLongs[0] = LittleLong( fs_checksumFeed );
+	memcpy( fs_headerLongs + 1, crcs, numCrcs * sizeof(int) );
 
-	// guarantee that it will have a trailing 0 for string operations
-	buf[len] = 0;
-	FS_FCloseFile( h );
+	pack->checksum = Com_BlockChecksum( &fs_headerLongs[ 1 ], sizeof(*fs_headerLongs) * numCrcs );
+	pack->pure_checksum = Com_BlockChecksum( fs_headerLongs, sizeof(*fs_headerLongs) * ( numCrcs + 1 ) );
+	pack->checksum = LittleLong( pack->checksum );
+	pack->pure_checksum = LittleLong( pack->pure_checksum );
 
-	// if we are journalling and it is a config file, write it to the journal file
-	if ( isConfig && com_journal && com_journal->integer == 1 ) {
-		Com_DPrintf( "Writing %s to journal file.\n", qpath );
-		FS_Write( &len, sizeof( len ), com_journalDataFile );
-		FS_Write( buf, len, com_journalDataFile );
-		FS_Flush( com_journalDataFile );
-	}
-	return len;
+	Z_Free(fs_headerLongs);
 }
 
 /*
-=============
-FS_FreeFile
-=============
+=================
+FS_LoadCachedZipFile
+
+Builds the pak_t from the cache instead of the zip, the zip file itself
+is only opened when a file is read from it
+=================
 */
-void FS_FreeFile( void *buffer ) {
-	FS_AssertInitialised();
-	if ( !buffer ) {
-		Com_Error( ERR_FATAL, "FS_FreeFile( NULL )" );
+static pack_t *FS_LoadCachedZipFile( const char *zipfile, const char *basename, int64_t size, time_t mtime ) {
+	pakCacheRecord_t	record;
+	const byte			*data;
+	pakCacheFile_t		file;
+	fileInPack_t		*buildBuffer;
+	pack_t				*pack;
+	char				*namePtr;
+	long				hash;
+	int					i;
+
+	if ( !fsPakCache.loaded ) {
+		FS_LoadPakCache();
+	}
+
+	auto it = fsPakCache.records.find( zipfile );
+	if ( it == fsPakCache.records.end() ) {
+		return NULL;
 	}
 
-	Z_Free( buffer );
-}
+	data = &fsPakCache.file[it->second];
+	memcpy( &record, data, sizeof( record ) );
+	if ( record.size != size || record.mtime != (int64_t)mtime ) {
+		return NULL;
+	}
+	data += sizeof( record ) + record.pathLength;
 
-/*
-============
-FS_WriteFile
+	const byte *names = data + record.numCrcs * sizeof(int) + record.numFiles * sizeof( pakCacheFile_t );
+	if ( std::count( names, names + record.namesLength, 0 ) != record.numFiles ) {
+		return NULL;
+	}
 
-Filename are reletive to the quake search path
-============
-*/
-void FS_WriteFile( const char *qpath, const void *buffer, int size ) {
-	fileHandle_t f;
+	pack = FS_AllocPak( zipfile, basename, record.numFiles );
 
-	FS_AssertInitialised();
+	// the checksums depend on fs_checksumFeed, so only the crcs are cached
+	std::vector<int> crcs( record.numCrcs + 1 );
+	memcpy( crcs.data(), data, record.numCrcs * sizeof(int) );
+	data += record.numCrcs * sizeof(int);
+	FS_SetPakChecksums( pack, crcs.data(), record.numCrcs );
 
-	if ( !qpath || !buffer ) {
-		Com_Error( ERR_FATAL, "FS_WriteFile: NULL parameter" );
-	}
+	buildBuffer = (struct fileInPack_s *)Z_Malloc( (record.numFiles * sizeof( fileInPack_t )) + record.namesLength, TAG_FILESYS, qtrue );
+	namePtr = ((char *) buildBuffer) + record.numFiles * sizeof( fileInPack_t );
+	memcpy( namePtr, data + record.numFiles * sizeof( pakCacheFile_t ), record.namesLength );
 
-	f = FS_FOpenFileWrite( qpath );
-	if ( !f ) {
-		Com_Printf( "Failed to open %s\n", qpath );
-		return;
+	for (i = 0; i < record.numFiles; i++)
+	{
+		memcpy( &file, data + i * sizeof( file ), sizeof( file ) );
+		hash = FS_HashFileName(namePtr, pack->hashSize);
+		buildBuffer[i].name = namePtr;
+		namePtr += strlen(namePtr) + 1;
+		buildBuffer[i].pos = (unsigned long)file.pos;
+		buildBuffer[i].len = (unsigned long)file.len;
+		buildBuffer[i].next = pack->hashTable[hash];
+		pack->hashTable[hash] = &buildBuffer[i];
 	}
 
-	FS_Write( buffer, size, f );
-
-	FS_FCloseFile( f );
+	pack->buildBuffer = buildBuffer;
+	return pack;
 }
 
 /*
-==========================================================================
-
-ZIP FILE LOADING
+=================
+FS_CachePak
 
-==========================================================================
+Adds what was read from a zip to the records FS_SavePakCache writes
+=================
 */
+static void FS_CachePak( const pack_t *pack, const int *crcs, int numCrcs, int64_t size, time_t mtime ) {
+	pakCacheRecord_t	record;
+	pakCacheFile_t		file;
+	size_t				offset;
+	int					i;
+
+	if ( fsPakCache.addedPaths.count( pack->pakFilename ) ) {
+		return;
+	}
+
+	memset( &record, 0, sizeof( record ) );
+	record.size = size;
+	record.mtime = mtime;
+	record.pathLength = strlen( pack->pakFilename ) + 1;
+	record.numFiles = pack->numfiles;
+	record.numCrcs = numCrcs;
+	for ( i = 0 ; i < pack->numfiles ; i++ ) {
+		record.namesLength += strlen( pack->buildBuffer[i].name ) + 1;
+	}
+	record.length = sizeof( record ) + record.pathLength + numCrcs * sizeof(int)
+		+ pack->numfiles * sizeof( pakCacheFile_t ) + record.namesLength;
+
+	offset = fsPakCache.added.size();
+	fsPakCache.added.resize( offset + record.length );
+	byte *data = &fsPakCache.added[offset];
+
+	memcpy( data, &record, sizeof( record ) );
+	data += sizeof( record );
+	memcpy( data, pack->pakFilename, record.pathLength );
+	data += record.pathLength;
+	memcpy( data, crcs, numCrcs * sizeof(int) );
+	data += numCrcs * sizeof(int);
+	for ( i = 0 ; i < pack->numfiles ; i++, data += sizeof( file ) ) {
+		file.pos = pack->buildBuffer[i].pos;
+		file.len = pack->buildBuffer[i].len;
+		memcpy( data, &file, sizeof( file ) );
+	}
+	for ( i = 0 ; i < pack->numfiles ; i++ ) {
+		int length = strlen( pack->buildBuffer[i].name ) + 1;
+		memcpy( data, pack->buildBuffer[i].name, length );
+		data += length;
+	}
+
+	fsPakCache.addedPaths.insert( pack->pakFilename );
+}
 
 /*
 =================
@@ -2459,6 +3154,17 @@ static pack_t *FS_LoadZipFile( const char *zipfile, const char *basename )
 	int				fs_numHeaderLongs;
 	int				*fs_headerLongs;
 	char			*namePtr;
+	int64_t			size;
+	time_t			mtime;
+	qboolean		cacheable;
+
+	cacheable = (qboolean)( fs_pakCache && fs_pakCache->integer && Sys_FileStat( zipfile, &size, &mtime ) );
+	if ( cacheable ) {
+		pack = FS_LoadCachedZipFile( zipfile, basename, size, mtime );
+		if ( pack ) {
+			return pack;
+		}
+	}
 
 	fs_numHeaderLongs = 0;
 
@@ -2483,39 +3189,17 @@ static pack_t *FS_LoadZipFile( const char *zipfile, const char *basename )
 	buildBuffer = (struct fileInPack_s *)Z_Malloc( (gi.number_entry * sizeof( fileInPack_t )) + len, TAG_FILESYS, qtrue );
 	namePtr = ((char *) buildBuffer) + gi.number_entry * sizeof( fileInPack_t );
 	fs_headerLongs = (int *)Z_Malloc( ( gi.number_entry + 1 ) * sizeof(int), TAG_FILESYS, qtrue );
-	fs_headerLongs[ fs_numHeaderLongs++ ] = LittleLong( fs_checksumFeed );
-
-	// get the hash table size from the number of files in the zip
-	// because lots of custom pk3 files have less than 32 or 64 files
-	for (i = 1; i <= MAX_FILEHASH_SIZE; i <<= 1) {
-		if (i > gi.number_entry) {
-			break;
-		}
-	}
-
-	pack = (pack_t *)Z_Malloc( sizeof( pack_t ) + i * sizeof(fileInPack_t *), TAG_FILESYS, qtrue );
-	pack->hashSize = i;
-	pack->hashTable = (fileInPack_t **) (((char *) pack) + sizeof( pack_t ));
-	for(int j = 0; j < pack->hashSize; j++) {
-		pack->hashTable[j] = NULL;
-	}
-
-	Q_strncpyz( pack->pakFilename, zipfile, sizeof( pack->pakFilename ) );
-	Q_strncpyz( pack->pakBasename, basename, sizeof( pack->pakBasename ) );
-
-	// strip .pk3 if needed
-	if ( strlen( pack->pakBasename ) > 4 && !Q_stricmp( pack->pakBasename + strlen( pack->pakBasename ) - 4, ".pk3" ) ) {
-		pack->pakBasename[strlen( pack->pakBasename ) - 4] = 0;
-	}
 
+	pack = FS_AllocPak( zipfile, basename, gi.number_entry );
 	pack->handle = uf;
-	pack->numfiles = gi.number_entry;
 	unzGoToFirstFile(uf);
 
 	for (i = 0; i < gi.number_entry; i++)
 	{
 		err = unzGetCurrentFileInfo(uf, &file_info, filename_inzip, sizeof(filename_inzip), NULL, 0, NULL, 0);
 		if (err != UNZ_OK) {
+			// only cache complete directories
+			cacheable = qfalse;
 			break;
 		}
 		if (file_info.uncompressed_size > 0) {
@@ -2534,14 +3218,15 @@ static pack_t *FS_LoadZipFile( const char *zipfile, const char *basename )
 		unzGoToNextFile(uf);
 	}
 
-	pack->checksum = Com_BlockChecksum( &fs_headerLongs[ 1 ], sizeof(*fs_headerLongs) * ( fs_numHeaderLongs - 1 ) );
-	pack->pure_checksum = Com_BlockChecksum( fs_headerLongs, sizeof(*fs_headerLongs) * fs_numHeaderLongs );
-	pack->checksum = LittleLong( pack->checksum );
-	pack->pure_checksum = LittleLong( pack->pure_checksum );
+	FS_SetPakChecksums( pack, fs_headerLongs, fs_numHeaderLongs );
+	pack->buildBuffer = buildBuffer;
+
+	if ( cacheable ) {
+		FS_CachePak( pack, fs_headerLongs, fs_numHeaderLongs, size, mtime );
+	}
 
 	Z_Free(fs_headerLongs);
 
-	pack->buildBuffer = buildBuffer;
 	return pack;
 }
 
@@ -2555,7 +3240,9 @@ Frees a pak structure and releases all associated resources
 
 void FS_FreePak(pack_t *thepak)
 {
-	unzClose(thepak->handle);
+	if (thepak->handle) {
+		unzClose(thepak->handle);
+	}
 	Z_Free(thepak->buildBuffer);
 	Z_Free(thepak);
 }
@@ -2644,6 +3331,41 @@ static int FS_AddFileToList( char *name, char *list[MAX_FOUND_FILES], int nfiles
 	return nfiles;
 }
 
+/*
+==================
+FS_AppendFileToList
+
+For names that can't be in the list yet
+==================
+*/
+static int FS_AppendFileToList( char *name, char *list[MAX_FOUND_FILES], int nfiles ) {
+	if ( nfiles == MAX_FOUND_FILES - 1 ) {
+		return nfiles;
+	}
+	list[nfiles] = CopyString( name );
+
+	return nfiles + 1;
+}
+
+/*
+==================
+FS_IndexedEarlier
+
+Returns qtrue if a pure pak before the one of f on the search path has
+a file with the same name
+==================
+*/
+static qboolean FS_IndexedEarlier( const fileInIndex_t *f ) {
+	const fileInIndex_t	*other;
+
+	for ( other = f->first ; other != f ; other = other->nextPack ) {
+		if ( FS_PakIsPure( other->pack ) ) {
+			return qtrue;
+		}
+	}
+	return qfalse;
+}
+
 /*
 ===============
 FS_ListFilteredFiles
@@ -2662,8 +3384,9 @@ char **FS_ListFilteredFiles( const char *path, const char *extension, char *filt
 	int				extensionLength;
 	int				length, pathDepth, temp;
 	pack_t			*pak;
-	fileInPack_t	*buildBuffer;
+	fileInIndex_t	*indexFiles;
 	char			zpath[MAX_ZPATH];
+	qboolean		dirFiles;
 
 	if ( !fs_searchpaths ) {
 		Com_Error( ERR_FATAL, "Filesystem call made without initialization\n" );
@@ -2683,8 +3406,13 @@ char **FS_ListFilteredFiles( const char *path, const char *extension, char *filt
 	}
 	extensionLength = strlen( extension );
 	nfiles = 0;
+	dirFiles = qfalse;
 	FS_ReturnPath(path, zpath, &pathDepth);
 
+	if ( !fs_indexValid ) {
+		FS_BuildFileIndex();
+	}
+
 	//
 	// search through the path, one element at a time, adding to list
 	//
@@ -2698,28 +3426,36 @@ char **FS_ListFilteredFiles( const char *path, const char *extension, char *filt
 				continue;
 			}
 
-			// look through all the pak file elements
+			// look through all the pak file elements, the global index
+			// knows which ones an earlier pak already listed
 			pak = search->pack;
-			buildBuffer = pak->buildBuffer;
+			indexFiles = pak->indexFiles;
 			for (i = 0; i < pak->numfiles; i++) {
 				char	*name;
 				int		zpathLen, depth;
 
+				if ( FS_IndexedEarlier( &indexFiles[i] ) ) {
+					continue;
+				}
+
 				// check for directory match
-				name = buildBuffer[i].name;
+				name = indexFiles[i].file->name;
 				//
 				if (filter) {
 					// case insensitive
 					if (!Com_FilterPath( filter, name, qfalse ))
 						continue;
 					// unique the match
-					nfiles = FS_AddFileToList( name, list, nfiles );
+					nfiles = dirFiles ? FS_AddFileToList( name, list, nfiles ) : FS_AppendFileToList( name, list, nfiles );
 				}
 				else {
+					if ( Q_stricmpn( name, path, pathLength ) ) {
+						continue;
+					}
 
 					zpathLen = FS_ReturnPath(name, zpath, &depth);
 
-					if ( (depth-pathDepth)>2 || pathLength > zpathLen || Q_stricmpn( name, path, pathLength ) ) {
+					if ( (depth-pathDepth)>2 || pathLength > zpathLen ) {
 						continue;
 					}
 
@@ -2738,7 +3474,13 @@ char **FS_ListFilteredFiles( const char *path, const char *extension, char *filt
 					if (pathLength) {
 						temp++;		// include the '/'
 					}
-					nfiles = FS_AddFileToList( name + temp, list, nfiles );
+					// names that only match the start of a directory's name can
+					// end up the same as another pak file's without the path
+					if ( dirFiles || ( pathLength && name[pathLength] != '/' ) ) {
+						nfiles = FS_AddFileToList( name + temp, list, nfiles );
+					} else {
+						nfiles = FS_AppendFileToList( name + temp, list, nfiles );
+					}
 				}
 			}
 		} else if (search->dir) { // scan for files in the filesystem
@@ -2763,6 +3505,7 @@ char **FS_ListFilteredFiles( const char *path, const char *extension, char *filt
 					name = sysFiles[i];
 					nfiles = FS_AddFileToList( name, list, nfiles );
 				}
+				dirFiles = (qboolean)( dirFiles || numSysFiles > 0 );
 				Sys_FreeFileList( sysFiles );
 			}
 		}
@@ -3259,6 +4002,144 @@ void FS_TouchFile_f( void ) {
 	}
 }
 
+/*
+============
+FS_AsyncBench_f
+
+Writes demo-like traffic to a number of async files at a fixed frame rate
+and shows how long the frames spent in FS_Write
+============
+*/
+void FS_AsyncBench_f( void ) {
+	typedef std::chrono::steady_clock clock;
+	static byte		message[8192];
+	fileHandle_t	files[64];
+	int				numFiles, numFrames, fps, i, frame;
+	unsigned int	seed = 1;
+	double			bytes = 0, total = 0;
+
+	numFiles = Cmd_Argc() > 1 ? Com_Clampi( 1, ARRAY_LEN( files ), atoi( Cmd_Argv( 1 ) ) ) : 32;
+	numFrames = Cmd_Argc() > 2 ? Q_max( 1, atoi( Cmd_Argv( 2 ) ) ) : 10;
+	fps = Cmd_Argc() > 3 ? Com_Clampi( 1, 1000, atoi( Cmd_Argv( 3 ) ) ) : 40;
+	numFrames *= fps;
+
+	for ( i = 0 ; i < (int)sizeof( message ) ; i++ ) {
+		message[i] = (byte)( i * 131 );
+	}
+
+	int chunkAllocs = fsAsync.chunkAllocs;
+	int syscalls = fsAsync.syscalls;
+	std::vector<int> frameUsec;
+	frameUsec.reserve( numFrames );
+
+	clock::time_point start = clock::now();
+	for ( i = 0 ; i < numFiles ; i++ ) {
+		files[i] = FS_FOpenFileWriteAsync( va( "asyncbench/%i.dat", i ), qtrue );
+	}
+	int openUsec = (int)std::chrono::duration_cast<std::chrono::microseconds>( clock::now() - start ).count();
+
+	clock::time_point next = clock::now();
+	for ( frame = 0 ; frame < numFrames ; frame++ ) {
+		start = clock::now();
+		// the three writes SV_WriteDemoMessage makes, a big non-delta snapshot every few seconds
+		for ( i = 0 ; i < numFiles ; i++ ) {
+			int len, swlen;
+
+			seed = seed * 1664525 + 1013904223;
+			len = ( frame % ( fps * 5 ) == 0 ) ? (int)sizeof( message ) : 100 + (int)( ( seed >> 8 ) % 1300 );
+
+			swlen = LittleLong( frame );
+			FS_Write( &swlen, 4, files[i] );
+			swlen = LittleLong( len );
+			FS_Write( &swlen, 4, files[i] );
+			FS_Write( message, len, files[i] );
+			bytes += 8 + len;
+		}
+		frameUsec.push_back( (int)std::chrono::duration_cast<std::chrono::microseconds>( clock::now() - start ).count() );
+		total += frameUsec.back();
+
+		next += std::chrono::microseconds( 1000000 / fps );
+		std::this_thread::sleep_until( next );
+	}
+
+	start = clock::now();
+	for ( i = 0 ; i < numFiles ; i++ ) {
+		FS_FCloseFile( files[i] );
+	}
+	int closeUsec = (int)std::chrono::duration_cast<std::chrono::microseconds>( clock::now() - start ).count();
+	for ( i = 0 ; i < numFiles ; i++ ) {
+		FS_FCloseAio( files[i] );
+	}
+	int drainUsec = (int)std::chrono::duration_cast<std::chrono::microseconds>( clock::now() - start ).count();
+	FS_HomeRmdir( "asyncbench", qtrue );
+
+	std::sort( frameUsec.begin(), frameUsec.end() );
+	Com_Printf( "%i files, %i frames at %i fps, %.1f MB written\n", numFiles, numFrames, fps, bytes / ( 1024.0 * 1024.0 ) );
+	Com_Printf( "FS_Write per frame: mean %.1f us, median %i us, 99th %i us, max %i us\n", total / numFrames,
+		frameUsec[numFrames / 2], frameUsec[numFrames * 99 / 100], frameUsec[numFrames - 1] );
+	Com_Printf( "open %i us, close %i us, close and drain %i us\n", openUsec, closeUsec, drainUsec );
+	Com_Printf( "%i chunks allocated (%i pooled), %i write calls\n",
+		fsAsync.chunkAllocs - chunkAllocs, fsAsync.numFreeChunks, fsAsync.syscalls - syscalls );
+}
+
+/*
+============
+FS_LookupBench_f
+
+Looks up every file of every pk3 and as many names no pk3 has, and lists
+a few directories, like a map load does
+============
+*/
+void FS_LookupBench_f( void ) {
+	typedef std::chrono::steady_clock clock;
+	static const char *listings[][2] = { { "shaders", ".shader" }, { "maps", ".bsp" }, { "models/players", "/" }, { "sound", ".wav" } };
+	searchpath_t	*search;
+	std::vector<const char *> names;
+	int				rounds, found, listed, i, r;
+
+	rounds = Cmd_Argc() > 1 ? Q_max( 1, atoi( Cmd_Argv( 1 ) ) ) : 1;
+
+	for ( search = fs_searchpaths ; search ; search = search->next ) {
+		if ( search->pack ) {
+			for ( i = 0 ; i < search->pack->numfiles ; i++ ) {
+				names.push_back( search->pack->buildBuffer[i].name );
+			}
+		}
+	}
+
+	clock::time_point start = clock::now();
+	FS_BuildFileIndex();
+	double indexMsec = std::chrono::duration<double, std::milli>( clock::now() - start ).count();
+
+	found = 0;
+	start = clock::now();
+	for ( r = 0 ; r < rounds ; r++ ) {
+		for ( const char *name : names ) {
+			found += FS_FileIsInPAK( name, NULL ) == 1;
+			found += FS_FileIsInPAK( va( "%sx", name ), NULL ) == 1;
+		}
+	}
+	double lookupMsec = std::chrono::duration<double, std::milli>( clock::now() - start ).count();
+
+	listed = 0;
+	start = clock::now();
+	for ( r = 0 ; r < rounds ; r++ ) {
+		for ( i = 0 ; i < (int)ARRAY_LEN( listings ) ; i++ ) {
+			int numFiles;
+			char **list = FS_ListFiles( listings[i][0], listings[i][1], &numFiles );
+
+			listed += numFiles;
+			FS_FreeFileList( list );
+		}
+	}
+	double listMsec = std::chrono::duration<double, std::milli>( clock::now() - start ).count();
+
+	Com_Printf( "%i files in pk3s, index built in %.2f msec\n", (int)names.size(), indexMsec );
+	Com_Printf( "%i lookups (%i found) in %.2f msec, %.3f usec each\n", (int)names.size() * 2 * rounds, found, lookupMsec,
+		names.size() ? 1000.0 * lookupMsec / ( names.size() * 2 * rounds ) : 0.0 );
+	Com_Printf( "%i listings (%i files) in %.2f msec\n", (int)ARRAY_LEN( listings ) * rounds, listed, listMsec );
+}
+
 /*
 ============
 FS_Which_f
@@ -3266,6 +4147,7 @@ FS_Which_f
 */
 void FS_Which_f( void ) {
 	searchpath_t	*search;
+	fileInIndex_t	*indexed;
 	char		*filename;
 	//qboolean	isDLL;
 
@@ -3290,27 +4172,15 @@ void FS_Which_f( void ) {
 
 	//isDLL = FS_IsExt(filename, ".dll", strlen(filename));
 
+	indexed = FS_IndexedFile( filename );
+
 	// just wants to see if file is there
 	for ( search=fs_searchpaths; search; search=search->next ) {
 		if (search->pack) {
-			long hash = FS_HashFileName( filename, search->pack->hashSize );
-
-			// is the element a pak file?
-			if ( search->pack->hashTable[hash]) {
-				// look through all the pak file elements
-				pack_t* pak = search->pack;
-				fileInPack_t* pakFile = pak->hashTable[hash];
-
-				do {
-					// case and separator insensitive comparisons
-					if ( !FS_FilenameCompare( pakFile->name, filename ) ) {
-						// found it!
-						Com_Printf( "File \"%s\" found in \"%s\"\n", filename, pak->pakFilename );
-						return;
-					}
-
-					pakFile = pakFile->next;
-				} while ( pakFile != NULL );
+			// is the element the first pak file that has it?
+			if ( indexed && search->pack == indexed->pack ) {
+				Com_Printf( "File \"%s\" found in \"%s\"\n", filename, search->pack->pakFilename );
+				return;
 			}
 		} else if (search->dir) {
 			directory_t* dir = search->dir;
@@ -3444,9 +4314,7 @@ static void FS_AddGameDirectory( const char *path, const char *dir ) {
 
 			if (!found) {
 				// server has no interest in the file
-				unzClose(pak->handle);
-				Z_Free(pak->buildBuffer);
-				Z_Free(pak);
+				FS_FreePak(pak);
 				continue;
 			}
 		}
@@ -3486,6 +4354,8 @@ static void FS_AddGameDirectory( const char *path, const char *dir ) {
 
 	// done
 	Sys_FreeFileList( pakfiles );
+
+	fs_indexValid = qfalse;
 }
 
 /*
@@ -3695,7 +4565,11 @@ void FS_Shutdown( qboolean closemfp, qboolean keepModuleFiles ) {
 		}
 	}
 
+	FS_AsyncShutdown();
+
 	// free everything
+	FS_FreeFileIndex();
+
 	for ( p = fs_searchpaths ; p ; p = next ) {
 		next = p->next;
 
@@ -3716,6 +4590,8 @@ void FS_Shutdown( qboolean closemfp, qboolean keepModuleFiles ) {
 	Cmd_RemoveCommand( "fdir" );
 	Cmd_RemoveCommand( "touchFile" );
 	Cmd_RemoveCommand( "which" );
+	Cmd_RemoveCommand( "fs_asyncbench" );
+	Cmd_RemoveCommand( "fs_lookupbench" );
 	Cmd_RemoveCommand( "fs_restart" );
 
 #ifdef FS_MISSING
@@ -3763,6 +4639,8 @@ void FS_UpdateGamedir(void)
 		}
 		Q_strncpyz( fs_gamedir, fs_forcegame->string, sizeof( fs_gamedir ) );
 	}
+
+	FS_SavePakCache();
 }
 
 /*
@@ -3799,6 +4677,7 @@ static void FS_ReorderPurePaks()
 				*p_insert_index = s;
 				// increment insert list
 				p_insert_index = &s->next;
+				fs_indexValid = qfalse;
 				break; // iterate to next server pack
 			}
 			p_previous = &s->next;
@@ -3925,6 +4804,8 @@ void FS_Startup( const char *gameName ) {
 
 	fs_dirbeforepak = Cvar_Get("fs_dirbeforepak", "0", CVAR_INIT|CVAR_PROTECTED, "Prioritize directories before paks if not pure" );
 
+	fs_pakCache = Cvar_Get( "fs_pakCache", "1", CVAR_ARCHIVE_ND, "Keep the file lists and checksums of pk3 files in " PAKCACHE_NAME " for a faster startup" );
+
 #ifdef DEDICATED
 	fs_forcegame = Cvar_Get ("fs_forcegame", "", CVAR_INIT, "Folder to use for overriding of fs_game (can not be set by the server)." );
 #else
@@ -4000,12 +4881,16 @@ void FS_Startup( const char *gameName ) {
 		Q_strncpyz( fs_gamedir, fs_forcegame->string, sizeof( fs_gamedir ) );
 	}
 
+	FS_SavePakCache();
+
 	// add our commands
 	Cmd_AddCommand ("path", FS_Path_f, "Lists search paths" );
 	Cmd_AddCommand ("dir", FS_Dir_f, "Lists a folder" );
 	Cmd_AddCommand ("fdir", FS_NewDir_f, "Lists a folder with filters" );
 	Cmd_AddCommand ("touchFile", FS_TouchFile_f, "Touches a file" );
 	Cmd_AddCommand ("which", FS_Which_f, "Determines which search path a file was loaded from" );
+	Cmd_AddCommand ("fs_asyncbench", FS_AsyncBench_f, "Times async file writes, call with [files] [seconds] [fps]" );
+	Cmd_AddCommand ("fs_lookupbench", FS_LookupBench_f, "Times pk3 file lookups and directory listings, call with [rounds]" );
 	Cmd_AddCommand ("fs_restart", FS_Restart_f, "Restarts the filesystem if no module is currently using files from a pk3" );
 
 	// https://zerowing.idsoftware.com/bugzilla/show_bug.cgi?id=506
@@ -4580,7 +5465,9 @@ int		FS_FOpenFileByMode( const char *qpath, fileHandle_t *f, fsMode_t mode ) {
 
 int		FS_FTell( fileHandle_t f ) {
 	int pos;
-	if (fsh[f].zipFile == qtrue) {
+	if (fsh[f].handleAsync) {
+		pos = fsh[f].asyncPosition;
+	} else if (fsh[f].zipFile == qtrue) {
 		pos = unztell(fsh[f].handleFiles.file.z);
 	} else {
 		pos = ftell(fsh[f].handleFiles.file.o);
@@ -4589,6 +5476,9 @@ int		FS_FTell( fileHandle_t f ) {
 }
 
 void	FS_Flush( fileHandle_t f ) {
+	if (fsh[f].handleAsync) {
+		return; // the writer thread owns the file
+	}
 	fflush(fsh[f].handleFiles.file.o);
 }
 
@@ -27,27 +27,69 @@ along with this program; if not, see <http://www.gnu.org/licenses/>.
 
 #include "qcommon/qcommon.h"
 
+// only used by the adaptive Huff_Compress/Huff_Decompress, the offset based
+// functions below keep their position in the caller's offset so they can be
+// used on different messages from several threads at once
 static int			bloc = 0;
 
 void	Huff_putBit( int bit, byte *fout, int *offset) {
-	bloc = *offset;
-	if ((bloc&7) == 0) {
-		fout[(bloc>>3)] = 0;
+	int b = *offset;
+	if ((b&7) == 0) {
+		fout[(b>>3)] = 0;
 	}
-	fout[(bloc>>3)] |= bit << (bloc&7);
-	bloc++;
-	*offset = bloc;
+	fout[(b>>3)] |= bit << (b&7);
+	*offset = b + 1;
 }
 
 int		Huff_getBit( byte *fin, int *offset) {
 	int t;
-	bloc = *offset;
-	t = (fin[(bloc>>3)] >> (bloc&7)) & 0x1;
-	bloc++;
-	*offset = bloc;
+	int b = *offset;
+	t = (fin[(b>>3)] >> (b&7)) & 0x1;
+	*offset = b + 1;
 	return t;
 }
 
+/* Up to 32 bits at once, low bit first, the same as that many Huff_putBit
+ * or Huff_getBit calls.  Only the bytes the bits land in are touched. */
+void	Huff_putBits( unsigned value, int bits, byte *fout, int *offset ) {
+	int			b = *offset;
+	int			shift = b & 7;
+	int			n = (shift + bits + 7) >> 3;
+	byte		*out = fout + (b >> 3);
+	uint64_t	acc;
+
+	// like Huff_putBit, add to the byte that was started and clear the new ones
+	acc = ((uint64_t)value & ((1ULL << bits) - 1)) << shift;
+	if (shift) {
+		acc |= out[0];
+	}
+	if (n <= 2) {
+		// the odd bits of a field: one or two bytes, without a loop to mispredict
+		out[n - 1] = (byte)(acc >> ((n - 1) * 8));
+		out[0] = (byte)acc;
+	} else {
+		do {
+			*out++ = (byte)acc;
+			acc >>= 8;
+		} while (--n);
+	}
+	*offset = b + bits;
+}
+
+unsigned Huff_getBits( const byte *fin, int bits, int *offset ) {
+	int			b = *offset;
+	int			shift = b & 7;
+	int			i, n = (shift + bits + 7) >> 3;
+	const byte	*in = fin + (b >> 3);
+	uint64_t	acc = in[0] | ((uint64_t)in[n - 1] << ((n - 1) * 8));
+
+	for (i = 1; i < n - 1; i++) {
+		acc |= (uint64_t)in[i] << (i * 8);
+	}
+	*offset = b + bits;
+	return (unsigned)((acc >> shift) & ((1ULL << bits) - 1));
+}
+
 /* Add a bit to the output file (buffered) */
 static void add_bit (char bit, byte *fout) {
 	if ((bloc&7) == 0) {
@@ -270,18 +312,19 @@ int Huff_Receive (node_t *node, int *ch, byte *fin) {
 
 /* Get a symbol */
 void Huff_offsetReceive (node_t *node, int *ch, byte *fin, int *offset, int maxoffset) {
-	bloc = *offset;
+	int b = *offset;
 	while (node && node->symbol == INTERNAL_NODE) {
-		if (bloc >= maxoffset) {
+		if (b >= maxoffset) {
 			*ch = 0;
 			*offset = maxoffset + 1;
 			return;
 		}
-		if (get_bit(fin)) {
+		if ((fin[(b>>3)] >> (b&7)) & 0x1) {
 			node = node->right;
 		} else {
 			node = node->left;
 		}
+		b++;
 	}
 	if (!node) {
 		*ch = 0;
@@ -289,24 +332,20 @@ void Huff_offsetReceive (node_t *node, int *ch, byte *fin, int *offset, int maxo
 //		Com_Error(ERR_DROP, "Illegal tree!\n");
 	}
 	*ch = node->symbol;
-	*offset = bloc;
+	*offset = b;
 }
 
 /* Send the prefix code for this node */
-static void send(node_t *node, node_t *child, byte *fout, int maxoffset) {
+static void send(node_t *node, node_t *child, byte *fout, int *offset, int maxoffset) {
 	if (node->parent) {
-		send(node->parent, node, fout, maxoffset);
+		send(node->parent, node, fout, offset, maxoffset);
 	}
 	if (child) {
-		if (bloc >= maxoffset) {
-			bloc = maxoffset + 1;
+		if (*offset >= maxoffset) {
+			*offset = maxoffset + 1;
 			return;
 		}
-		if (node->right == child) {
-			add_bit(1, fout);
-		} else {
-			add_bit(0, fout);
-		}
+		Huff_putBit(node->right == child ? 1 : 0, fout, offset);
 	}
 }
 
@@ -320,14 +359,120 @@ void Huff_transmit (huff_t *huff, int ch, byte *fout, int maxoffset) {
 			add_bit((char)((ch >> i) & 0x1), fout);
 		}
 	} else {
-		send(huff->loc[ch], NULL, fout, maxoffset);
+		send(huff->loc[ch], NULL, fout, &bloc, maxoffset);
 	}
 }
 
 void Huff_offsetTransmit (huff_t *huff, int ch, byte *fout, int *offset, int maxoffset) {
-	bloc = *offset;
-	send(huff->loc[ch], NULL, fout, maxoffset);
-	*offset = bloc;
+	send(huff->loc[ch], NULL, fout, offset, maxoffset);
+}
+
+/* Fill the decode entries of all bit patterns that start with the code of node */
+static void fill_decode(huffTable_t *table, node_t *node, unsigned int code, int depth) {
+	int i;
+
+	if (!node || depth > HUFF_TABLE_BITS) {
+		return;
+	}
+	if (node->symbol == INTERNAL_NODE) {
+		fill_decode(table, node->left, code, depth + 1);
+		fill_decode(table, node->right, code | (1 << depth), depth + 1);
+		return;
+	}
+	for (i = 0; i < 1 << (HUFF_TABLE_BITS - depth); i++) {
+		table->decode[code | (i << depth)] = node->symbol | (depth << 9);
+	}
+}
+
+/* Turn the finished trees into lookup tables */
+void Huff_BuildTable( huffTable_t *table, huff_t *compressor, huff_t *decompressor ) {
+	node_t			*node;
+	unsigned int	code;
+	int				ch, length;
+
+	Com_Memset(table, 0, sizeof(*table));
+	table->compressor = compressor;
+	table->tree = decompressor->tree;
+
+	for (ch = 0; ch <= HMAX; ch++) {
+		if (!compressor->loc[ch]) {
+			continue;
+		}
+		length = 0;
+		for (node = compressor->loc[ch]; node->parent; node = node->parent) {
+			length++;
+		}
+		if (length > 32) {
+			continue;
+		}
+		// the bit next to the root goes first
+		code = 0;
+		for (node = compressor->loc[ch]; node->parent; node = node->parent) {
+			code = (code << 1) | (node->parent->right == node ? 1 : 0);
+		}
+		table->code[ch] = code;
+		table->codeLength[ch] = length;
+	}
+
+	fill_decode(table, decompressor->tree, 0, 0);
+}
+
+/* Get a symbol */
+void Huff_tableReceive( const huffTable_t *table, int *ch, byte *fin, int *offset, int maxoffset ) {
+	int				b = *offset;
+	int				in, end, entry, length;
+	unsigned int	bits;
+
+	if (b >= maxoffset) {
+		Huff_offsetReceive(table->tree, ch, fin, offset, maxoffset);
+		return;
+	}
+
+	// the next HUFF_TABLE_BITS bits, without reading past maxoffset
+	in = b >> 3;
+	end = (maxoffset + 7) >> 3;
+	bits = fin[in];
+	if (in + 1 < end) {
+		bits |= fin[in + 1] << 8;
+		if (in + 2 < end) {
+			bits |= fin[in + 2] << 16;
+		}
+	}
+	entry = table->decode[(bits >> (b & 7)) & ((1 << HUFF_TABLE_BITS) - 1)];
+
+	length = entry >> 9;
+	if (!length || b + length > maxoffset) {
+		Huff_offsetReceive(table->tree, ch, fin, offset, maxoffset);
+		return;
+	}
+	*ch = entry & 0x1ff;
+	*offset = b + length;
+}
+
+/* Send a symbol */
+void Huff_tableTransmit( const huffTable_t *table, int ch, byte *fout, int *offset, int maxoffset ) {
+	int			b = *offset;
+	int			length = table->codeLength[ch];
+	int			shift, i;
+	byte		*out;
+	uint64_t	acc;
+
+	if (!length || b + length > maxoffset) {
+		Huff_offsetTransmit(table->compressor, ch, fout, offset, maxoffset);
+		return;
+	}
+
+	// like Huff_putBit, add to the byte that was started and clear the new ones
+	out = fout + (b >> 3);
+	shift = b & 7;
+	acc = (uint64_t)table->code[ch] << shift;
+	if (shift) {
+		acc |= out[0];
+	}
+	for (i = 0; i < (shift + length + 7) >> 3; i++) {
+		out[i] = (byte)(acc >> (i * 8));
+	}
+	*offset = b + length;
 }
 
 void Huff_Decompress(msg_t *mbuf, int offset) {
@@ -382,7 +527,7 @@ void Huff_Decompress(msg_t *mbuf, int offset) {
 	Com_Memcpy(mbuf->data + offset, seq, cch);
 }
 
-extern 	int oldsize;
+extern thread_local int oldsize;
 
 void Huff_Compress(msg_t *mbuf, int offset) {
 	int			i, ch, size;
@@ -30,6 +30,7 @@ along with this program; if not, see <http://www.gnu.org/licenses/>.
 //#define _USINGNEWHUFFTABLE_		// Build a new frequency table to cut and paste.
 
 static huffman_t		msgHuff;
+static huffTable_t		msgHuffTable;
 
 static qboolean			msgInit = qfalse;
 #ifdef _NEWHUFFTABLE_
@@ -45,11 +46,17 @@ Handles byte ordering and avoids alignment errors
 ==============================================================================
 */
 
+// The statistics below are per thread, snapshots can be encoded on
+// several threads at once
 #ifndef FINAL_BUILD
-	int gLastBitIndex = 0;
+	thread_local int gLastBitIndex = 0;
 #endif
 
-int oldsize = 0;
+thread_local int oldsize = 0;
+
+// Set while the thread writes messages as a server job, see MSG_BeginJob
+static thread_local qboolean	msgInJob = qfalse;
+static thread_local int			msgJobWarnings = 0;
 
 bool g_nOverrideChecked = false;
 void MSG_CheckNETFPSFOverrides(qboolean psfOverrides);
@@ -80,17 +87,6 @@ void MSG_Init( msg_t *buf, byte *data, int length ) {
 
 
 
-void MSG_FromBuffered(msg_t* dst, bufferedMsg_t* src) {
-	dst->allowoverflow = src->allowoverflow;
-	dst->overflowed = src->overflowed;
-	dst->oob = src->oob;
-	dst->maxsize = src->maxsize;
-	dst->cursize = src->cursize;
-	dst->readcount = src->readcount;
-	dst->bit = src->bit;
-	Com_Memcpy(dst->data, src->data, src->cursize);
-}
-
 void MSG_InitOOB( msg_t *buf, byte *data, int length ) {
 	if (!g_nOverrideChecked)
 	{
@@ -144,7 +140,27 @@ bit functions
 =============================================================================
 */
 
-int	overflows;
+thread_local int	overflows;
+
+/*
+=================
+MSG_BeginJob
+
+Job threads must not print or touch shared state, between MSG_BeginJob
+and MSG_EndJob the calling thread does not count field changes and only
+counts the warnings, MSG_EndJob returns how many there were so the main
+thread can report them.
+=================
+*/
+void MSG_BeginJob( void ) {
+	msgInJob = qtrue;
+	msgJobWarnings = 0;
+}
+
+int MSG_EndJob( void ) {
+	msgInJob = qfalse;
+	return msgJobWarnings;
+}
 
 // negative bit values include signs
 void MSG_WriteBits( msg_t *msg, int value, int bits ) {
@@ -217,10 +233,8 @@ void MSG_WriteBits( msg_t *msg, int value, int bits ) {
 				msg->overflowed = qtrue;
 				return;
 			}
-			for(i=0;i<nbits;i++) {
-				Huff_putBit((value&1), msg->data, &msg->bit);
-				value = (value>>1);
-			}
+			Huff_putBits(value, nbits, msg->data, &msg->bit);
+			value = (value>>nbits);
 			bits = bits - nbits;
 		}
 		if (bits) {
@@ -228,7 +242,7 @@ void MSG_WriteBits( msg_t *msg, int value, int bits ) {
 #ifdef _NEWHUFFTABLE_
 				fwrite(&value, 1, 1, fp);
 #endif // _NEWHUFFTABLE_
-				Huff_offsetTransmit (&msgHuff.compressor, (value&0xff), msg->data, &msg->bit, msg->maxsize << 3);
+				Huff_tableTransmit (&msgHuffTable, (value&0xff), msg->data, &msg->bit, msg->maxsize << 3);
 				value = (value>>8);
 
 				if ( msg->bit > msg->maxsize << 3 ) {
@@ -241,6 +255,52 @@ void MSG_WriteBits( msg_t *msg, int value, int bits ) {
 	}
 }
 
+/*
+==================
+MSG_WriteEncodedBits
+
+Appends bits that were already written by MSG_WriteBits to another
+(non OOB) message, e.g. a cached entity delta. The bits are Huffman
+coded one at a time, so they are the same wherever they land in the
+message. Bits past numBits in the last byte of data must be zero.
+==================
+*/
+void MSG_WriteEncodedBits( msg_t *msg, const byte *data, int numBits ) {
+	int			i, numBytes, out, shift, endBit;
+	unsigned	acc;
+
+	if ( msg->overflowed || numBits <= 0 ) {
+		return;
+	}
+
+	if ( msg->oob ) {
+		Com_Error( ERR_DROP, "MSG_WriteEncodedBits: OOB message" );
+	}
+
+	endBit = msg->bit + numBits;
+	if ( endBit > msg->maxsize << 3 ) {
+		msg->overflowed = qtrue;
+		return;
+	}
+
+	shift = msg->bit & 7;
+	out = msg->bit >> 3;
+	acc = shift ? ( msg->data[out] & ( ( 1 << shift ) - 1 ) ) : 0;
+
+	numBytes = ( numBits + 7 ) >> 3;
+	for ( i = 0 ; i < numBytes ; i++ ) {
+		acc |= data[i] << shift;
+		msg->data[out++] = acc & 0xff;
+		acc >>= 8;
+	}
+	if ( out <= ( endBit - 1 ) >> 3 ) {
+		msg->data[out] = acc;
+	}
+
+	msg->bit = endBit;
+	msg->cursize = ( endBit >> 3 ) + 1;
+}
+
 int MSG_ReadBits( msg_t *msg, int bits ) {
 	int			value;
 	int			get;
@@ -292,14 +352,12 @@ int MSG_ReadBits( msg_t *msg, int bits ) {
 				msg->readcount = msg->cursize + 1;
 				return 0;
 			}
-			for(i=0;i<nbits;i++) {
-				value |= (Huff_getBit(msg->data, &msg->bit)<<i);
-			}
+			value = Huff_getBits(msg->data, nbits, &msg->bit);
 			bits = bits - nbits;
 		}
 		if (bits) {
 			for(i=0;i<bits;i+=8) {
-				Huff_offsetReceive (msgHuff.decompressor.tree, &get, msg->data, &msg->bit, msg->cursize<<3);
+				Huff_tableReceive (&msgHuffTable, &get, msg->data, &msg->bit, msg->cursize<<3);
 #ifdef _NEWHUFFTABLE_
 				fwrite(&get, 1, 1, fp);
 #endif // _NEWHUFFTABLE_
@@ -383,7 +441,11 @@ void MSG_WriteString( msg_t *sb, const char *s ) {
 
 		l = strlen( s );
 		if ( l >= MAX_STRING_CHARS ) {
-			Com_Printf( "MSG_WriteString: MAX_STRING_CHARS" );
+			if ( msgInJob ) {
+				msgJobWarnings++;
+			} else {
+				Com_Printf( "MSG_WriteString: MAX_STRING_CHARS" );
+			}
 			MSG_WriteData (sb, "", 1);
 			return;
 		}
@@ -411,7 +473,11 @@ void MSG_WriteBigString( msg_t *sb, const char *s ) {
 
 		l = strlen( s );
 		if ( l >= BIG_INFO_STRING ) {
-			Com_Printf( "MSG_WriteString: BIG_INFO_STRING" );
+			if ( msgInJob ) {
+				msgJobWarnings++;
+			} else {
+				Com_Printf( "MSG_WriteString: BIG_INFO_STRING" );
+			}
 			MSG_WriteData (sb, "", 1);
 			return;
 		}
@@ -1089,7 +1155,9 @@ void MSG_WriteDeltaEntity( msg_t *msg, struct entityState_s *from, struct entity
 		if ( *fromF != *toF ) {
 			lc = i+1;
 #ifndef FINAL_BUILD
-			field->mCount++;
+			if ( !msgInJob ) {
+				field->mCount++;
+			}
 #endif
 		}
 	}
@@ -2164,7 +2232,9 @@ void MSG_WriteDeltaPlayerstate( msg_t *msg, struct playerState_s *from, struct p
 		if ( *fromF != *toF ) {
 			lc = i+1;
 #ifndef FINAL_BUILD
-			field->mCount++;
+			if ( !msgInJob ) {
+				field->mCount++;
+			}
 #endif
 		}
 	}
@@ -3087,6 +3157,7 @@ void MSG_initHuffman() {
 			Huff_addRef(&msgHuff.decompressor,	(byte)i);			// Do update
 		}
 	}
+	Huff_BuildTable(&msgHuffTable, &msgHuff.compressor, &msgHuff.decompressor);
 }
 
 #else
@@ -3121,6 +3192,7 @@ void MSG_initHuffman() {
 		Com_Printf("%d,			// %d\n", array[i], i);
 	}
 	Com_Printf("};\n");
+	Huff_BuildTable(&msgHuffTable, &msgHuff.compressor, &msgHuff.decompressor);
 	FS_FreeFile( data );
 	Cbuf_AddText( "condump dump.txt\n" );
 }
@@ -71,6 +71,11 @@ along with this program; if not, see <http://www.gnu.org/licenses/>.
 #include <sys/filio.h>
 #endif
 
+#ifdef __linux__
+// receive and send several packets per syscall with recvmmsg/sendmmsg
+#define NET_BATCH_IO
+#endif
+
 typedef int SOCKET;
 #define INVALID_SOCKET                -1
 #define SOCKET_ERROR                        -1
@@ -97,6 +102,8 @@ static cvar_t	*net_port;
 
 static cvar_t	*net_dropsim;
 
+static cvar_t	*net_batch;
+
 static struct sockaddr_in	socksRelayAddr;
 
 static SOCKET	ip_socket = INVALID_SOCKET;
@@ -106,6 +113,37 @@ static SOCKET	socks_socket = INVALID_SOCKET;
 static	int		numIP;
 static	byte	localIP[MAX_IPS][4];
 
+// syscalls and the packets they moved, see NET_Stats_f
+static struct netStats_s {
+	int		recvCalls;
+	int		recvPackets;
+	int		sendCalls;
+	int		sendPackets;
+} netStats;
+
+#ifdef NET_BATCH_IO
+#define	NET_BATCH_PACKETS	32
+#define	NET_BATCH_SENDLEN	1536	// larger packets are sent on their own
+
+// packets recvmmsg read ahead for NET_GetPacket, or packets waiting for
+// NET_FlushPacketBatch to hand them to sendmmsg
+typedef struct packetBatch_s {
+	int					count;
+	int					next;		// next received packet to hand out
+	struct mmsghdr		headers[NET_BATCH_PACKETS];
+	struct iovec		iov[NET_BATCH_PACKETS];
+	struct sockaddr_in	addr[NET_BATCH_PACKETS];
+	netadrtype_t		type[NET_BATCH_PACKETS];	// of the destinations
+} packetBatch_t;
+
+static packetBatch_t	recvBatch;
+static byte				recvData[NET_BATCH_PACKETS][MAX_MSGLEN + 1];
+
+static packetBatch_t	sendBatch;
+static byte				sendData[NET_BATCH_PACKETS][NET_BATCH_SENDLEN];
+static qboolean			sendBatching = qfalse;
+#endif
+
 //=============================================================================
 
 /*
@@ -236,6 +274,83 @@ qboolean Sys_StringToAdr( const char *s, netadr_t *a ) {
 
 //=============================================================================
 
+/*
+==================
+NET_ReadPacket
+
+Fills in net_from for a packet of length ret that was received into
+net_message from the address from
+==================
+*/
+static qboolean NET_ReadPacket( struct sockaddr_in *from, socklen_t fromlen, int ret, netadr_t *net_from, msg_t *net_message ) {
+	memset( from->sin_zero, 0, 8 );
+
+	if ( usingSocks && memcmp( from, &socksRelayAddr, fromlen ) == 0 ) {
+		if ( ret < 10 || net_message->data[0] != 0 || net_message->data[1] != 0 || net_message->data[2] != 0 || net_message->data[3] != 1 ) {
+			return qfalse;
+		}
+		net_from->type = NA_IP;
+		net_from->ip[0] = net_message->data[4];
+		net_from->ip[1] = net_message->data[5];
+		net_from->ip[2] = net_message->data[6];
+		net_from->ip[3] = net_message->data[7];
+		memcpy( &net_from->port, &net_message->data[8], 2 );
+		net_message->readcount = 10;
+	}
+	else {
+		SockadrToNetadr( from, net_from );
+		net_message->readcount = 0;
+	}
+
+	if( ret >= net_message->maxsize ) {
+		Com_Printf( "Oversize packet from %s\n", NET_AdrToString (net_from) );
+		return qfalse;
+	}
+
+	net_message->cursize = ret;
+	return qtrue;
+}
+
+#ifdef NET_BATCH_IO
+/*
+==================
+NET_ReceiveBatch
+
+Reads as many waiting packets from s as recvBatch holds, returns how many
+==================
+*/
+static int NET_ReceiveBatch( SOCKET s ) {
+	int		i, ret;
+
+	for ( i = 0 ; i < NET_BATCH_PACKETS ; i++ ) {
+		recvBatch.iov[i].iov_base = recvData[i];
+		recvBatch.iov[i].iov_len = sizeof( recvData[i] );
+		memset( &recvBatch.headers[i], 0, sizeof( recvBatch.headers[i] ) );
+		recvBatch.headers[i].msg_hdr.msg_name = &recvBatch.addr[i];
+		recvBatch.headers[i].msg_hdr.msg_namelen = sizeof( recvBatch.addr[i] );
+		recvBatch.headers[i].msg_hdr.msg_iov = &recvBatch.iov[i];
+		recvBatch.headers[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	recvBatch.next = recvBatch.count = 0;
+	ret = recvmmsg( s, recvBatch.headers, NET_BATCH_PACKETS, MSG_DONTWAIT, NULL );
+	netStats.recvCalls++;
+
+	if ( ret == SOCKET_ERROR ) {
+		int err = socketError;
+
+		if( err != EAGAIN && err != ECONNRESET ) {
+			Com_Printf( "NET_GetPacket: %s\n", NET_ErrorString() );
+		}
+		return 0;
+	}
+
+	netStats.recvPackets += ret;
+	recvBatch.count = ret;
+	return ret;
+}
+#endif
+
 /*
 ==================
 NET_GetPacket
@@ -252,7 +367,40 @@ qboolean NET_GetPacket( netadr_t *net_from, msg_t *net_message, fd_set *fdr ) {
 	socklen_t fromlen;
 	struct sockaddr_in from;
 
-	if ( ip_socket == INVALID_SOCKET || !FD_ISSET(ip_socket, fdr) ) {
+	if ( ip_socket == INVALID_SOCKET ) {
+		return qfalse;
+	}
+
+#ifdef NET_BATCH_IO
+	// hand out what the last recvmmsg read before reading more. Those packets
+	// are out of the kernel queue, so select won't report them again and a
+	// rejected one must not end the batch
+	while ( 1 ) {
+		int i;
+
+		if ( recvBatch.next == recvBatch.count ) {
+			if ( !net_batch->integer || !FD_ISSET( ip_socket, fdr ) || !NET_ReceiveBatch( ip_socket ) ) {
+				break;
+			}
+		}
+
+		i = recvBatch.next++;
+		ret = recvBatch.headers[i].msg_len;
+		if ( ret > net_message->maxsize ) {
+			ret = net_message->maxsize;
+		}
+		memcpy( net_message->data, recvData[i], ret );
+		from = recvBatch.addr[i];
+		if ( NET_ReadPacket( &from, recvBatch.headers[i].msg_hdr.msg_namelen, ret, net_from, net_message ) ) {
+			return qtrue;
+		}
+	}
+	if ( net_batch->integer ) {
+		return qfalse;
+	}
+#endif
+
+	if ( !FD_ISSET( ip_socket, fdr ) ) {
 		return qfalse;
 	}
 
@@ -261,6 +409,7 @@ qboolean NET_GetPacket( netadr_t *net_from, msg_t *net_message, fd_set *fdr ) {
 	recvfromCount++;		// performance check
 #endif
 	ret = recvfrom( ip_socket, (char *)net_message->data, net_message->maxsize, 0, (struct sockaddr *)&from, &fromlen );
+	netStats.recvCalls++;
 
 	if ( ret == SOCKET_ERROR ) {
 		err = socketError;
@@ -272,37 +421,117 @@ qboolean NET_GetPacket( netadr_t *net_from, msg_t *net_message, fd_set *fdr ) {
 		return qfalse;
 	}
 
-	memset( from.sin_zero, 0, 8 );
+	netStats.recvPackets++;
+	return NET_ReadPacket( &from, fromlen, ret, net_from, net_message );
+}
 
-	if ( usingSocks && memcmp( &from, &socksRelayAddr, fromlen ) == 0 ) {
-		if ( ret < 10 || net_message->data[0] != 0 || net_message->data[1] != 0 || net_message->data[2] != 0 || net_message->data[3] != 1 ) {
-			return qfalse;
-		}
-		net_from->type = NA_IP;
-		net_from->ip[0] = net_message->data[4];
-		net_from->ip[1] = net_message->data[5];
-		net_from->ip[2] = net_message->data[6];
-		net_from->ip[3] = net_message->data[7];
-		memcpy( &net_from->port, &net_message->data[8], 2 );
-		net_message->readcount = 10;
+//=============================================================================
+
+static char socksBuf[4096];
+
+/*
+==================
+NET_SendError
+==================
+*/
+static void NET_SendError( int err, netadrtype_t type ) {
+	// wouldblock is silent
+	if( err == EAGAIN ) {
+		return;
 	}
-	else {
-		SockadrToNetadr( &from, net_from );
-		net_message->readcount = 0;
+
+	// some PPP links do not allow broadcasts and return an error
+	if( err == EADDRNOTAVAIL && type == NA_BROADCAST ) {
+		return;
 	}
 
-	if( ret >= net_message->maxsize ) {
-		Com_Printf( "Oversize packet from %s\n", NET_AdrToString (net_from) );
-		return qfalse;
+	Com_Printf( "NET_SendPacket: %s\n", NET_ErrorString() );
+}
+
+#ifdef NET_BATCH_IO
+/*
+==================
+NET_SendBatch
+
+Sends all packets of sendBatch from s
+==================
+*/
+static void NET_SendBatch( SOCKET s ) {
+	int		i, ret;
+
+	for ( i = 0 ; i < sendBatch.count ; ) {
+		ret = sendmmsg( s, sendBatch.headers + i, sendBatch.count - i, 0 );
+		netStats.sendCalls++;
+
+		if ( ret == SOCKET_ERROR ) {
+			// sendmmsg only fails for the first packet, skip it
+			NET_SendError( socketError, sendBatch.type[i] );
+			i++;
+			continue;
+		}
+		netStats.sendPackets += ret;
+		i += ret;
 	}
+	sendBatch.count = 0;
+}
 
-	net_message->cursize = ret;
-	return qtrue;
+/*
+==================
+NET_QueuePacket
+==================
+*/
+static void NET_QueuePacket( SOCKET s, int length, const void *data, const struct sockaddr_in *to, netadrtype_t type ) {
+	int		i;
+
+	if ( sendBatch.count == NET_BATCH_PACKETS ) {
+		NET_SendBatch( s );
+	}
+
+	i = sendBatch.count++;
+	memcpy( sendData[i], data, length );
+	sendBatch.addr[i] = *to;
+	sendBatch.type[i] = type;
+	sendBatch.iov[i].iov_base = sendData[i];
+	sendBatch.iov[i].iov_len = length;
+	memset( &sendBatch.headers[i], 0, sizeof( sendBatch.headers[i] ) );
+	sendBatch.headers[i].msg_hdr.msg_name = &sendBatch.addr[i];
+	sendBatch.headers[i].msg_hdr.msg_namelen = sizeof( sendBatch.addr[i] );
+	sendBatch.headers[i].msg_hdr.msg_iov = &sendBatch.iov[i];
+	sendBatch.headers[i].msg_hdr.msg_iovlen = 1;
 }
+#endif
 
-//=============================================================================
+/*
+==================
+NET_BeginPacketBatch
 
-static char socksBuf[4096];
+Until NET_FlushPacketBatch, Sys_SendPacket only queues the packets, so
+they can leave in as few syscalls as possible
+==================
+*/
+void NET_BeginPacketBatch( void ) {
+#ifdef NET_BATCH_IO
+	if ( sendBatching ) {
+		NET_FlushPacketBatch();
+	}
+	sendBatching = (qboolean)( net_batch && net_batch->integer && ip_socket != INVALID_SOCKET );
+#endif
+}
+
+/*
+==================
+NET_FlushPacketBatch
+==================
+*/
+void NET_FlushPacketBatch( void ) {
+#ifdef NET_BATCH_IO
+	if ( sendBatch.count && ip_socket != INVALID_SOCKET ) {
+		NET_SendBatch( ip_socket );
+	}
+	sendBatch.count = 0;
+	sendBatching = qfalse;
+#endif
+}
 
 /*
 ==================
@@ -332,26 +561,29 @@ void Sys_SendPacket( int length, const void *data, const netadr_t *to ) {
 		memcpy( &socksBuf[4], &addr.sin_addr, 4 );
 		memcpy( &socksBuf[8], &addr.sin_port, 2 );
 		memcpy( &socksBuf[10], data, length );
-		ret = sendto( ip_socket, socksBuf, length+10, 0, (sockaddr *)&socksRelayAddr, sizeof(socksRelayAddr) );
-	}
-	else {
-		ret = sendto( ip_socket, (const char *)data, length, 0, (sockaddr *)&addr, sizeof(addr) );
+		data = socksBuf;
+		length += 10;
+		addr = socksRelayAddr;
 	}
-	if( ret == SOCKET_ERROR ) {
-		int err = socketError;
-
-		// wouldblock is silent
-		if( err == EAGAIN ) {
-			return;
-		}
 
-		// some PPP links do not allow broadcasts and return an error
-		if( err == EADDRNOTAVAIL && to->type == NA_BROADCAST ) {
-			return;
-		}
+#ifdef NET_BATCH_IO
+	if ( sendBatching && length <= NET_BATCH_SENDLEN ) {
+		NET_QueuePacket( ip_socket, length, data, &addr, to->type );
+		return;
+	}
+	// keep the order when a packet doesn't fit the batch
+	if ( sendBatch.count ) {
+		NET_SendBatch( ip_socket );
+	}
+#endif
 
-		Com_Printf( "NET_SendPacket: %s\n", NET_ErrorString() );
+	ret = sendto( ip_socket, (const char *)data, length, 0, (sockaddr *)&addr, sizeof(addr) );
+	netStats.sendCalls++;
+	if( ret == SOCKET_ERROR ) {
+		NET_SendError( socketError, to->type );
+		return;
 	}
+	netStats.sendPackets++;
 }
 
 //=============================================================================
@@ -909,6 +1141,8 @@ static qboolean NET_GetCvars( void ) {
 
 	net_dropsim = Cvar_Get( "net_dropsim", "", CVAR_TEMP);
 
+	net_batch = Cvar_Get( "net_batch", "1", CVAR_ARCHIVE_ND, "Receive and send several packets per syscall where the system supports it" );
+
 	return modified ? qtrue : qfalse;
 }
 
@@ -955,6 +1189,10 @@ void NET_Config( qboolean enableNetworking ) {
 	}
 
 	if ( stop ) {
+		NET_FlushPacketBatch();
+#ifdef NET_BATCH_IO
+		recvBatch.next = recvBatch.count = 0;
+#endif
 		if ( ip_socket != INVALID_SOCKET ) {
 			closesocket( ip_socket );
 			ip_socket = INVALID_SOCKET;
@@ -973,6 +1211,120 @@ void NET_Config( qboolean enableNetworking ) {
 	}
 }
 
+/*
+====================
+NET_Stats_f
+====================
+*/
+static void NET_Stats_f( void ) {
+	Com_Printf( "received %i packets in %i syscalls (%.2f per call)\n", netStats.recvPackets, netStats.recvCalls,
+		netStats.recvCalls ? (float)netStats.recvPackets / netStats.recvCalls : 0.0f );
+	Com_Printf( "sent %i packets in %i syscalls (%.2f per call)\n", netStats.sendPackets, netStats.sendCalls,
+		netStats.sendCalls ? (float)netStats.sendPackets / netStats.sendCalls : 0.0f );
+	Com_Printf( "batching: %s\n",
+#ifdef NET_BATCH_IO
+		net_batch->integer ? "on" : "off"
+#else
+		"not supported"
+#endif
+		);
+
+	memset( &netStats, 0, sizeof( netStats ) );
+}
+
+#ifdef NET_BATCH_IO
+/*
+====================
+NET_Bench_f
+
+Sends packets over loopback between two sockets of its own, a burst at a
+time, once a packet per syscall and once batched
+====================
+*/
+static void NET_Bench_f( void ) {
+	SOCKET		from, to;
+	struct sockaddr_in	addr;
+	socklen_t	addrlen = sizeof( addr );
+	byte		packet[NET_BATCH_SENDLEN];
+	int			total, burst = 256, pass, err, i;
+	struct netStats_s	stats;
+
+	total = Cmd_Argc() > 1 ? atoi( Cmd_Argv( 1 ) ) : 100000;
+	if ( total < burst ) {
+		total = burst;
+	}
+
+	from = NET_IPSocket( "127.0.0.1", PORT_ANY, &err );
+	to = NET_IPSocket( "127.0.0.1", PORT_ANY, &err );
+	if ( from == INVALID_SOCKET || to == INVALID_SOCKET || getsockname( to, (struct sockaddr *)&addr, &addrlen ) == SOCKET_ERROR ) {
+		Com_Printf( "net_bench: couldn't open loopback sockets\n" );
+		if ( from != INVALID_SOCKET ) closesocket( from );
+		if ( to != INVALID_SOCKET ) closesocket( to );
+		return;
+	}
+	// leave the server's numbers alone
+	stats = netStats;
+
+	i = 4 << 20;
+	setsockopt( to, SOL_SOCKET, SO_RCVBUF, (char *)&i, sizeof( i ) );
+
+	for ( i = 0 ; i < (int)sizeof( packet ) ; i++ ) {
+		packet[i] = (byte)i;
+	}
+
+	for ( pass = 0 ; pass < 2 ; pass++ ) {
+		int		sent = 0, received = 0, sendCalls = 0, recvCalls = 0;
+		int		start = Sys_Milliseconds();
+
+		while ( sent < total ) {
+			for ( i = 0 ; i < burst ; i++, sent++ ) {
+				// snapshot sized packets
+				int length = 100 + ( sent * 37 ) % 1200;
+
+				if ( pass ) {
+					NET_QueuePacket( from, length, packet, &addr, NA_IP );
+				} else {
+					sendto( from, (const char *)packet, length, 0, (struct sockaddr *)&addr, sizeof( addr ) );
+					sendCalls++;
+				}
+			}
+			if ( pass ) {
+				int calls = netStats.sendCalls;
+				NET_SendBatch( from );
+				sendCalls += netStats.sendCalls - calls;
+			}
+
+			while ( 1 ) {
+				if ( pass ) {
+					int got = NET_ReceiveBatch( to );
+					recvCalls++;
+					if ( !got ) {
+						break;
+					}
+					received += got;
+				} else {
+					recvCalls++;
+					if ( recv( to, (char *)recvData[0], sizeof( recvData[0] ), 0 ) == SOCKET_ERROR ) {
+						break;
+					}
+					received++;
+				}
+			}
+		}
+
+		int msec = Sys_Milliseconds() - start;
+		Com_Printf( "%s: %i of %i packets received, %.2f syscalls per packet, %.3f usec per packet\n",
+			pass ? "batched" : "single", received, sent, (float)( sendCalls + recvCalls ) / sent,
+			1000.0f * msec / sent );
+	}
+
+	recvBatch.next = recvBatch.count = 0;
+	netStats = stats;
+	closesocket( from );
+	closesocket( to );
+}
+#endif
+
 /*
 ====================
 NET_Init
@@ -993,6 +1345,10 @@ void NET_Init( void ) {
 	NET_Config( qtrue );
 
 	Cmd_AddCommand ("net_restart", NET_Restart_f, "Restart the networking sub-system" );
+	Cmd_AddCommand ("net_stats", NET_Stats_f, "Print packets per syscall since the last net_stats" );
+#ifdef NET_BATCH_IO
+	Cmd_AddCommand ("net_bench", NET_Bench_f, "Time loopback packets sent one per syscall and batched" );
+#endif
 }
 
 /*
@@ -1081,6 +1437,13 @@ void NET_Sleep( int msec ) {
 	}
 #endif
 
+#ifdef NET_BATCH_IO
+	// packets already read by recvmmsg don't make the socket readable
+	if ( recvBatch.next < recvBatch.count ) {
+		msec = 0;
+	}
+#endif
+
 	timeout.tv_sec = msec/1000;
 	timeout.tv_usec = (msec%1000)*1000;
 
@@ -1090,6 +1453,10 @@ void NET_Sleep( int msec ) {
 		Com_Printf("Warning: select() syscall failed: %s\n", NET_ErrorString());
 	else if(retval > 0)
 		NET_Event(&fdset);
+#ifdef NET_BATCH_IO
+	else if ( recvBatch.next < recvBatch.count )
+		NET_Event(&fdset);
+#endif
 }
 
 /*
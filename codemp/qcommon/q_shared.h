@@ -832,6 +832,16 @@ Ghoul2 Insert End
 // trace->entityNum can also be 0 to (MAX_GENTITIES-1)
 // or ENTITYNUM_NONE, ENTITYNUM_WORLD
 
+// one trace of a batch, see SV_TraceBatch
+typedef struct traceRequest_s {
+	vec3_t		start;
+	vec3_t		mins;
+	vec3_t		maxs;
+	vec3_t		end;
+	int			passEntityNum;
+	int			contentmask;
+} traceRequest_t;
+
 
 // markfragments are returned by CM_MarkFragments()
 typedef struct markFragment_s {
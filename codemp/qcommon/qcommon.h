@@ -57,6 +57,7 @@ struct entityState_s;
 struct playerState_s;
 
 void MSG_WriteBits( msg_t *msg, int value, int bits );
+void MSG_WriteEncodedBits( msg_t *msg, const byte *data, int numBits );
 
 void MSG_WriteChar (msg_t *sb, int c);
 void MSG_WriteByte (msg_t *sb, int c);
@@ -103,6 +104,9 @@ void MSG_ReadDeltaPlayerstate( msg_t *msg, struct playerState_s *from, struct pl
 void MSG_ReportChangeVectors_f( void );
 #endif
 
+void MSG_BeginJob( void );
+int MSG_EndJob( void );
+
 //============================================================================
 
 /*
@@ -168,6 +172,8 @@ const char	*NET_AdrToString (const netadr_t *a);
 qboolean	NET_StringToAdr ( const char *s, netadr_t *a);
 qboolean	NET_GetLoopPacket (netsrc_t sock, netadr_t *net_from, msg_t *net_message);
 void		NET_Sleep(int msec);
+void		NET_BeginPacketBatch( void );
+void		NET_FlushPacketBatch( void );
 
 void		Sys_SendPacket( int length, const void *data, const netadr_t *to );
 //Does NOT parse port numbers, only base addresses.
@@ -185,59 +191,6 @@ void		Sys_ShowIP(void);
 #define MAX_DOWNLOAD_BLKSIZE		2048	// 2048 byte block chunks
 
 
-/*
-* Buffered messages (structs that actually contain the data array) for buffering/prerecording
-*/
-
-typedef struct bufferedMsg_s {
-	qboolean	allowoverflow;	// if false, do a Com_Error
-	qboolean	overflowed;		// set to true if the buffer size failed (with allowoverflow set)
-	qboolean	oob;			// set to true if the buffer size failed (with allowoverflow set)
-	byte*	data;
-	int		maxsize;
-	int		cursize;
-	int		readcount;
-	int		bit;				// for bitwise reads and writes
-public:
-	bufferedMsg_s(msg_t* src) {
-		allowoverflow = src->allowoverflow;
-		overflowed = src->overflowed;
-		oob = src->oob;
-		maxsize = src->maxsize;
-		cursize = src->cursize;
-		readcount = src->readcount;
-		bit = src->bit;
-		data = new byte[src->cursize];
-		Com_Memcpy(data, src->data, src->cursize);
-	}
-	~bufferedMsg_s() {
-		if (data) {
-			delete[] data;
-			data = NULL;
-		}
-	}
-} bufferedMsg_t;
-
-typedef struct bufferedMessageContainer_s {
-	bufferedMsg_t msg;
-	int msgNum; // Message number
-	int lastClientCommand; // Need this if we are writing metadata with pre-recording as it is the first thing writen in any message.
-	int time; // So we can discard very old buffered messages. Or for clientside recording, so we don't have to wait infinitely for old messages to arrive (which they never may).
-	//qboolean containsFullSnapshot; // Doesn't matter for serverside pre-Recording because we have the keyframes. Comment back in for clientside buffered recording.
-	qboolean isKeyframe; // Is a gamestate message as typical for writing at the start of demos.
-public:
-	bufferedMessageContainer_s(msg_t* src) : msg(src){
-		msgNum = 0;
-		lastClientCommand = 0;
-		time = 0;
-		//containsFullSnapshot = qfalse;
-		isKeyframe = qfalse;
-	}
-} bufferedMessageContainer_t;
-
-void MSG_FromBuffered(msg_t* dst, bufferedMsg_t* src);
-
-
 /*
 Netchan handles packet fragmentation and out of order / duplicate suppression
 */
@@ -1120,6 +1073,19 @@ typedef struct huffman_s {
 	huff_t		decompressor;
 } huffman_t;
 
+// Lookup tables for a tree that doesn't adapt any more.  Codes that don't fit
+// them, and codes that would cross maxoffset, go through the tree instead, so
+// the results are the same as Huff_offsetTransmit/Huff_offsetReceive.
+#define HUFF_TABLE_BITS		11
+
+typedef struct huffTable_s {
+	huff_t			*compressor;
+	node_t			*tree;								// of the decompressor
+	unsigned int	code[HMAX+1];						// first bit sent in bit 0
+	byte			codeLength[HMAX+1];					// 0 for codes longer than 32 bits
+	unsigned short	decode[1<<HUFF_TABLE_BITS];			// symbol | length << 9, by the next bits, 0 for longer codes
+} huffTable_t;
+
 void	Huff_Compress(msg_t *buf, int offset);
 void	Huff_Decompress(msg_t *buf, int offset);
 void	Huff_Init(huffman_t *huff);
@@ -1128,8 +1094,13 @@ int		Huff_Receive (node_t *node, int *ch, byte *fin);
 void	Huff_transmit (huff_t *huff, int ch, byte *fout, int maxoffset);
 void	Huff_offsetReceive (node_t *node, int *ch, byte *fin, int *offset, int maxoffset);
 void	Huff_offsetTransmit (huff_t *huff, int ch, byte *fout, int *offset, int maxoffset);
+void	Huff_BuildTable( huffTable_t *table, huff_t *compressor, huff_t *decompressor );
+void	Huff_tableReceive( const huffTable_t *table, int *ch, byte *fin, int *offset, int maxoffset );
+void	Huff_tableTransmit( const huffTable_t *table, int ch, byte *fout, int *offset, int maxoffset );
 void	Huff_putBit( int bit, byte *fout, int *offset);
 int		Huff_getBit( byte *fout, int *offset);
+void	Huff_putBits( unsigned value, int bits, byte *fout, int *offset );
+unsigned Huff_getBits( const byte *fin, int bits, int *offset );
 
 extern huffman_t clientHuffTables;
 
@@ -105,15 +105,11 @@ CNode::CNode( void )
 {
 	m_numEdges		= 0;
 	m_radius		= 0;
-	m_ranks			= NULL;
 }
 
 CNode::~CNode( void )
 {
 	m_edges.clear();
-
-	if ( m_ranks )
-		delete [] m_ranks;
 }
 
 /*
@@ -205,19 +201,6 @@ int CNode::GetEdgeNumToNode( int ID )
 	return -1;
 }
 
-/*
--------------------------
-AddRank
--------------------------
-*/
-
-void CNode::AddRank( int ID, int rank )
-{
-	assert( m_ranks );
-
-	m_ranks[ ID ] = rank;
-}
-
 /*
 -------------------------
 Draw
@@ -243,23 +226,10 @@ GetEdge
 
 int CNode::GetEdge( int edgeNum )
 {
-	if ( edgeNum > m_numEdges )
+	if ( edgeNum < 0 || edgeNum >= m_numEdges )
 		return -1;
 
-	int count = 0;
-
-	edge_v::iterator	ei;
-	STL_ITERATE( ei, m_edges )
-	{
-		if ( count == edgeNum )
-		{
-			return (*ei).ID;
-		}
-
-		count++;
-	}
-
-	return -1;
+	return m_edges[edgeNum].ID;
 }
 
 /*
@@ -270,23 +240,10 @@ GetEdgeCost
 
 int CNode::GetEdgeCost( int edgeNum )
 {
-	if ( edgeNum > m_numEdges )
+	if ( edgeNum < 0 || edgeNum >= m_numEdges )
 		return Q3_INFINITE; // return -1;
 
-	int count = 0;
-
-	edge_v::iterator	ei;
-	STL_ITERATE( ei, m_edges )
-	{
-		if ( count == edgeNum )
-		{
-			return (*ei).cost;
-		}
-
-		count++;
-	}
-
-	return Q3_INFINITE; // return -1;
+	return m_edges[edgeNum].cost;
 }
 
 /*
@@ -297,23 +254,10 @@ GetEdgeFlags
 
 byte CNode::GetEdgeFlags( int edgeNum )
 {
-	if ( edgeNum > m_numEdges )
+	if ( edgeNum < 0 || edgeNum >= m_numEdges )
 		return 0;
 
-	int count = 0;
-
-	edge_v::iterator	ei;
-	STL_ITERATE( ei, m_edges )
-	{
-		if ( count == edgeNum )
-		{
-			return (*ei).flags;
-		}
-
-		count++;
-	}
-
-	return 0;
+	return m_edges[edgeNum].flags;
 }
 
 /*
@@ -324,65 +268,18 @@ SetEdgeFlags
 
 void CNode::SetEdgeFlags( int edgeNum, int newFlags )
 {
-	if ( edgeNum > m_numEdges )
+	if ( edgeNum < 0 || edgeNum >= m_numEdges )
 		return;
 
-	int count = 0;
-
-	edge_v::iterator	ei;
-	STL_ITERATE( ei, m_edges )
-	{
-		if ( count == edgeNum )
-		{
-			(*ei).flags = newFlags;
-			return;
-		}
-
-		count++;
-	}
-
-}
-/*
--------------------------
-InitRanks
--------------------------
-*/
-
-void CNode::InitRanks( int size )
-{
-	//Clear it if it's already allocated
-	if ( m_ranks != NULL )
-	{
-		delete [] m_ranks;
-		m_ranks = NULL;
-	}
-
-	m_ranks = new int[size];
-
-	memset( m_ranks, -1, sizeof(int)*size );
+	m_edges[edgeNum].flags = newFlags;
 }
-
-/*
--------------------------
-GetRank
--------------------------
-*/
-
-int CNode::GetRank( int ID )
-{
-	assert( m_ranks );
-
-	return m_ranks[ ID ];
-}
-
-
 /*
 -------------------------
 Save
 -------------------------
 */
 
-int	CNode::Save( int numNodes, fileHandle_t file )
+int	CNode::Save( fileHandle_t file )
 {
 	//Write out the header
 	unsigned int header = NODE_HEADER_ID;
@@ -406,14 +303,6 @@ int	CNode::Save( int numNodes, fileHandle_t file )
 		FS_Write( &(*ei), sizeof( edge_t ), file );
 	}
 
-	//Write out the node ranks
-	FS_Write( &numNodes, sizeof( numNodes ), file );
-
-	for ( i = 0; i < numNodes; i++ )
-	{
-		FS_Write( &m_ranks[i], sizeof( int ), file );
-	}
-
 	return true;
 }
 
@@ -423,7 +312,7 @@ Load
 -------------------------
 */
 
-int CNode::Load( int numNodes, fileHandle_t file )
+int CNode::Load( fileHandle_t file )
 {
 	unsigned int header;
 	FS_Read( &header, sizeof(header), file );
@@ -453,19 +342,6 @@ int CNode::Load( int numNodes, fileHandle_t file )
 		STL_INSERT( m_edges, edge );
 	}
 
-	//Read the node ranks
-	int	numRanks;
-
-	FS_Read( &numRanks, sizeof( numRanks ), file );
-
-	//Allocate the memory
-	InitRanks( numRanks );
-
-	for ( i = 0; i < numRanks; i++ )
-	{
-		FS_Read( &m_ranks[i], sizeof( int ), file );
-	}
-
 	return true;
 }
 
@@ -477,6 +353,8 @@ CNavigator
 
 CNavigator::CNavigator( void )
 {
+	m_numRanks = 0;
+
 #if 0 // RAVEN... why u make it so hard to double link list cvars
 	if (!d_altRoutes || !d_patched)
 	{
@@ -598,6 +476,74 @@ void CNavigator::Free( void )
 
 	m_nodes.clear();
 	m_edgeLookupMap.clear();
+
+	m_gridHeads.assign( NODE_GRID_BUCKETS, NODE_NONE );
+	m_gridNext.clear();
+	m_gridCells.clear();
+
+	m_numRanks = 0;
+	m_ranks16.clear();
+	m_ranks32.clear();
+}
+
+/*
+-------------------------
+InitRanks
+-------------------------
+*/
+
+void CNavigator::InitRanks( int numNodes )
+{
+	m_numRanks = numNodes;
+	m_ranks16.clear();
+	m_ranks32.clear();
+
+	//ranks go up to numNodes-1, with NODE_NONE for nodes that can't be reached
+	if ( numNodes <= 32768 )
+	{
+		m_ranks16.assign( (size_t)numNodes * numNodes, NODE_NONE );
+	}
+	else
+	{
+		m_ranks32.assign( (size_t)numNodes * numNodes, NODE_NONE );
+	}
+}
+
+/*
+-------------------------
+SetRank
+-------------------------
+*/
+
+void CNavigator::SetRank( int nodeID, int ID, int rank )
+{
+	size_t	index = (size_t)nodeID * m_numRanks + ID;
+
+	if ( m_ranks16.empty() )
+	{
+		m_ranks32[index] = rank;
+	}
+	else
+	{
+		m_ranks16[index] = (short)rank;
+	}
+}
+
+/*
+-------------------------
+GetRank
+-------------------------
+*/
+
+int CNavigator::GetRank( int nodeID, int ID ) const
+{
+	//paths haven't been calculated for this node
+	if ( nodeID >= m_numRanks || ID >= m_numRanks )
+		return NODE_NONE;
+
+	size_t	index = (size_t)nodeID * m_numRanks + ID;
+
+	return m_ranks16.empty() ? m_ranks32[index] : m_ranks16[index];
 }
 
 /*
@@ -640,17 +586,42 @@ bool CNavigator::Load( const char *filename, int checksum )
 
 	int numNodes = GetInt( file );
 
+	InitRanks( numNodes );
+
+	std::vector<int>	ranks( numNodes );
+
 	for ( int i = 0; i < numNodes; i++ )
 	{
 		CNode	*node = CNode::Create();
 
-		if ( node->Load( numNodes, file ) == false )
+		if ( node->Load( file ) == false )
 		{
+			delete node;
 			FS_FCloseFile( file );
 			return false;
 		}
 
 		STL_INSERT( m_nodes, node );
+		AddToGrid( node );
+
+		//Read the node ranks, a row at a time
+		int	numRanks = GetInt( file );
+
+		if ( numRanks != numNodes )
+		{
+			FS_FCloseFile( file );
+			return false;
+		}
+
+		if ( numNodes )
+		{
+			FS_Read( &ranks[0], sizeof( int ) * numNodes, file );
+		}
+
+		for ( int j = 0; j < numNodes; j++ )
+		{
+			SetRank( i, j, ranks[j] );
+		}
 	}
 
 	//read in the failed edges
@@ -695,12 +666,24 @@ bool CNavigator::Save( const char *filename, int checksum )
 	//Write out the number of nodes to follow
 	FS_Write( &numNodes, sizeof(numNodes), file );
 
-	//Write out all the nodes
-	node_v::iterator	ni;
+	//Write out all the nodes, each followed by its ranks
+	std::vector<int>	ranks( numNodes );
 
-	STL_ITERATE( ni, m_nodes )
+	for ( int i = 0; i < numNodes; i++ )
 	{
-		(*ni)->Save( numNodes, file );
+		m_nodes[i]->Save( file );
+
+		FS_Write( &numNodes, sizeof( numNodes ), file );
+
+		for ( int j = 0; j < numNodes; j++ )
+		{
+			ranks[j] = GetRank( i, j );
+		}
+
+		if ( numNodes )
+		{
+			FS_Write( &ranks[0], sizeof( int ) * numNodes, file );
+		}
 	}
 
 	//write out failed edges
@@ -731,10 +714,52 @@ int CNavigator::AddRawPoint( vec3_t point, int flags, int radius )
 	//TODO: Correct stuck waypoints
 
 	STL_INSERT( m_nodes, node );
+	AddToGrid( node );
 
 	return node->GetID();
 }
 
+/*
+-------------------------
+AddToGrid
+-------------------------
+*/
+
+static inline int NodeGridCell( float coord )
+{
+	return (int) floorf( coord / NODE_GRID_CELL_SIZE );
+}
+
+static inline int NodeGridBucket( int x, int y )
+{
+	return ( (unsigned) x * 73856093u ^ (unsigned) y * 19349663u ) & ( NODE_GRID_BUCKETS - 1 );
+}
+
+void CNavigator::AddToGrid( CNode *node )
+{
+	vec3_t	position;
+	int		id = node->GetID();
+
+	if ( m_gridHeads.empty() )
+	{
+		m_gridHeads.assign( NODE_GRID_BUCKETS, NODE_NONE );
+	}
+
+	node->GetPosition( position );
+
+	int	x = NodeGridCell( position[0] );
+	int	y = NodeGridCell( position[1] );
+	int	bucket = NodeGridBucket( x, y );
+
+	m_gridCells.resize( id * 2 + 2 );
+	m_gridCells[id * 2] = x;
+	m_gridCells[id * 2 + 1] = y;
+
+	m_gridNext.resize( id + 1 );
+	m_gridNext[id] = m_gridHeads[bucket];
+	m_gridHeads[bucket] = id;
+}
+
 /*
 -------------------------
 GetEdgeCost
@@ -821,20 +846,34 @@ CalculatePath
 -------------------------
 */
 
+//the closest edge on top, like std::priority_queue
+class EdgeCostGreater
+{
+public:
+	bool operator()( const CEdge &first, const CEdge &second ) const {
+		return( first.m_cost > second.m_cost );
+	}
+};
+
 void CNavigator::CalculatePath( CNode *node )
 {
-	int	curRank = 0;
+	std::vector<CEdge>	heap;
+	std::vector<byte>	checked;
+
+	CalculatePath( node, heap, checked );
+}
 
-	CPriorityQueue	*pathList = new CPriorityQueue();
-	byte			*checked;
+void CNavigator::CalculatePath( CNode *node, std::vector<CEdge> &heap, std::vector<byte> &checked )
+{
+	int	curRank = 0;
 
 	//Init the completion table
-	checked = new byte[ m_nodes.size() ];
-	memset( checked, 0, m_nodes.size() );
+	checked.assign( m_nodes.size(), 0 );
+	heap.clear();
 
 	//Mark this node as checked
 	checked[ node->GetID() ] = true;
-	node->AddRank( node->GetID(), curRank++ );
+	SetRank( node->GetID(), node->GetID(), curRank++ );
 
 	//Add all initial nodes
 	int i;
@@ -845,22 +884,21 @@ void CNavigator::CalculatePath( CNode *node )
 
 		checked[ nextNode->GetID() ] = true;
 
-		pathList->Push( new CEdge( nextNode->GetID(), nextNode->GetID(), node->GetEdgeCost(i) ) );
+		heap.push_back( CEdge( nextNode->GetID(), nextNode->GetID(), node->GetEdgeCost(i) ) );
+		std::push_heap( heap.begin(), heap.end(), EdgeCostGreater() );
 	}
 
-	//float				minDist;
-	CEdge				*test;
-
 	//Now flood fill all the others
-	while ( !pathList->Empty() )
+	while ( !heap.empty() )
 	{
-		//minDist = Q3_INFINITE;
-		test	 = pathList->Pop();
+		std::pop_heap( heap.begin(), heap.end(), EdgeCostGreater() );
+		CEdge	test = heap.back();
+		heap.pop_back();
 
-		CNode	*testNode = m_nodes[ (*test).m_first ];
+		CNode	*testNode = m_nodes[ test.m_first ];
 		assert( testNode );
 
-		node->AddRank( testNode->GetID(), curRank++ );
+		SetRank( node->GetID(), testNode->GetID(), curRank++ );
 
 		//Add in all the new edges
 		for ( i = 0; i < testNode->GetNumEdges(); i++ )
@@ -871,19 +909,39 @@ void CNavigator::CalculatePath( CNode *node )
 			if ( checked[ addNode->GetID() ] )
 				continue;
 
-			int	newDist = (*test).m_cost + testNode->GetEdgeCost(i);
-			pathList->Push( new CEdge( addNode->GetID(), (*test).m_second, newDist ) );
+			int	newDist = test.m_cost + testNode->GetEdgeCost(i);
+			heap.push_back( CEdge( addNode->GetID(), test.m_second, newDist ) );
+			std::push_heap( heap.begin(), heap.end(), EdgeCostGreater() );
 
 			checked[ addNode->GetID() ] = true;
 		}
-		delete test;
-
 	}
 
 	node->RemoveFlag( NF_RECALC );
+}
+
+/*
+-------------------------
+CalculatePathsJob
+-------------------------
+*/
+
+#define	PATHS_PER_JOB	16
+
+void CNavigator::CalculatePathsJob( int jobNum, void *data )
+{
+	CNavigator			*nav = (CNavigator *)data;
+	std::vector<CEdge>	heap;
+	std::vector<byte>	checked;
+	int					numNodes = (int)nav->m_nodes.size();
+
+	heap.reserve( numNodes );
 
-	delete pathList;
-	delete [] checked;
+	//each path only writes its own node's row of ranks
+	for ( int i = jobNum * PATHS_PER_JOB; i < numNodes && i < ( jobNum + 1 ) * PATHS_PER_JOB; i++ )
+	{
+		nav->CalculatePath( nav->m_nodes[i], heap, checked );
+	}
 }
 
 /*
@@ -897,16 +955,10 @@ void CNavigator::CalculatePaths( qboolean recalc )
 #else
 #endif
 
-	for ( size_t i = 0; i < m_nodes.size(); i++ )
-	{
-		//Allocate the needed memory
-		m_nodes[i]->InitRanks( m_nodes.size() );
-	}
+	//Allocate the needed memory
+	InitRanks( m_nodes.size() );
 
-	for ( size_t i = 0; i < m_nodes.size(); i++ )
-	{
-		CalculatePath( m_nodes[i] );
-	}
+	SV_RunJobs( ( (int)m_nodes.size() + PATHS_PER_JOB - 1 ) / PATHS_PER_JOB, CalculatePathsJob, this );
 
 	if(!recalc)	//Mike says doesn't need to happen on recalc
 	{
@@ -1257,15 +1309,52 @@ CollectNearestNodes
 
 int CNavigator::CollectNearestNodes( vec3_t origin, int radius, int maxCollect, nodeChain_l &nodeChain )
 {
+	std::vector<int>::iterator	ci;
 	node_v::iterator	ni;
 	float				dist;
 	vec3_t				position;
 	int					collected = 0;
 	bool				added = false;
 
-	//Get a distance rating for each node in the system
-	STL_ITERATE( ni, m_nodes )
+	//Only the nodes in the grid cells touching the radius can be in range.
+	//Visit them in ID order, so ties come out the same as checking every node
+	m_gridCollect.clear();
+
+	int	minX = NodeGridCell( origin[0] - radius ), maxX = NodeGridCell( origin[0] + radius );
+	int	minY = NodeGridCell( origin[1] - radius ), maxY = NodeGridCell( origin[1] + radius );
+
+	if ( (maxX - minX + 1) * (maxY - minY + 1) >= (int)m_nodes.size() )
 	{
+		for ( int i = 0; i < (int)m_nodes.size(); i++ )
+		{
+			m_gridCollect.push_back( i );
+		}
+	}
+	else
+	{
+		for ( int x = minX; x <= maxX; x++ )
+		{
+			for ( int y = minY; y <= maxY; y++ )
+			{
+				for ( int id = m_gridHeads[NodeGridBucket( x, y )]; id != NODE_NONE; id = m_gridNext[id] )
+				{
+					//Other cells can share the bucket
+					if ( m_gridCells[id * 2] == x && m_gridCells[id * 2 + 1] == y )
+					{
+						m_gridCollect.push_back( id );
+					}
+				}
+			}
+		}
+
+		std::sort( m_gridCollect.begin(), m_gridCollect.end() );
+	}
+
+	//Get a distance rating for each of those nodes
+	STL_ITERATE( ci, m_gridCollect )
+	{
+		ni = m_nodes.begin() + (*ci);
+
 		//If we've got our quota, then stop looking
 		//Get the distance to the node
 		(*ni)->GetPosition( position );
@@ -2013,7 +2102,7 @@ void CNavigator::AddFailedEdge( int entID, int startID, int endID )
 					continue;
 				}
 
-				if ( nextID == endID || end->GetRank( nextID ) >= 0 )
+				if ( nextID == endID || GetRank( end->GetID(), nextID ) >= 0 )
 				{//neighbor of or route to end
 					//There's an alternate route, so don't check this one for 10 seconds
 					failedEdges[j].checkTime = svs.time + CHECK_FAILED_EDGE_INTITIAL;
@@ -2232,7 +2321,7 @@ qboolean CNavigator::RouteBlocked( int startID, int testEdgeID, int endID, int r
 			}
 
 			//Still going...
-			testRank = end->GetRank( edgeID );
+			testRank = GetRank( end->GetID(), edgeID );
 
 			if ( testRank < 0 )
 			{//No route this way
@@ -2409,7 +2498,7 @@ int CNavigator::GetBestNode( int startID, int endID, int rejectID )
 		{
 			if ( start->GetEdge(i) == rejectID )
 			{
-				rejectRank = end->GetRank( start->GetEdge(i) );
+				rejectRank = GetRank( end->GetID(), start->GetEdge(i) );
 				break;
 			}
 		}
@@ -2423,7 +2512,7 @@ int CNavigator::GetBestNode( int startID, int endID, int rejectID )
 		if ( edgeID == endID )
 			return edgeID;
 
-		testRank = end->GetRank( edgeID );
+		testRank = GetRank( end->GetID(), edgeID );
 
 		//Found one
 		if ( testRank <= rejectRank )
@@ -2529,7 +2618,7 @@ bool CNavigator::Connected( int startID, int endID )
 		if ( edgeID == endID )
 			return true;
 
-		if ( ( end->GetRank( edgeID ) ) != NODE_NONE )
+		if ( ( GetRank( end->GetID(), edgeID ) ) != NODE_NONE )
 			return true;
 	}
 
@@ -2589,7 +2678,7 @@ unsigned int CNavigator::GetPathCost( int startID, int endID )
 				return pathCost + moveNode->GetEdgeCost( i );
 			}
 
-			testRank = endNode->GetRank( edgeID );
+			testRank = GetRank( endNode->GetID(), edgeID );
 
 			//No possible connection
 			if ( testRank == NODE_NONE )
@@ -2693,100 +2782,3 @@ int CNavigator::GetProjectedNode( vec3_t origin, int nodeID )
 
 	return bestNode;
 }
-
-// This is the PriorityQueue stuff for lists of connections
-// better than linear		(1/21/02 BJG)
-//////////////////////////////////////////////////////////////////
-// Helper pop_mHeap algorithm class
-//////////////////////////////////////////////////////////////////
-class NodeTotalGreater
-{
-public:
-   bool operator()( CEdge * first, CEdge * second ) const {
-      return( first->m_cost > second->m_cost );
-   }
-};
-
-
-//////////////////////////////////////////////////////////////////
-// Destructor - Deallocate any remaining pointers in the queue
-//////////////////////////////////////////////////////////////////
-CPriorityQueue::~CPriorityQueue()
-{
-	while (!Empty())
-	{
-		delete Pop();
-	}
-}
-
-//////////////////////////////////////////////////////////////////
-// Standard Iterative Search
-//////////////////////////////////////////////////////////////////
-CEdge* CPriorityQueue::Find(int npNum)
-{
-	for(std::vector<CEdge*>::iterator HeapIter=mHeap.begin(); HeapIter!=mHeap.end(); ++HeapIter)
-	{
-		if ((*HeapIter)->m_first == npNum)
-		{
-			return *HeapIter;
-		}
-	}
-	return 0;
-}
-
-//////////////////////////////////////////////////////////////////
-// Remove Node And Resort
-//////////////////////////////////////////////////////////////////
-CEdge* CPriorityQueue::Pop()
-{
-   CEdge *edge = mHeap.front();
-
-   //pop_mHeap will move the node at the front to the position N
-   //and then sort the mHeap to make positions 1 through N-1 correct
-   //(STL makes no assumptions about your data and doesn't want to change
-   //the size of the container.)
-   std::pop_heap(mHeap.begin(), mHeap.end(), NodeTotalGreater() );
-
-   //pop_back() will actually remove the last element from the mHeap
-   //now the mHeap is sorted for positions 1 through N
-   mHeap.pop_back();
-
-   return( edge );
-}
-
-//////////////////////////////////////////////////////////////////
-// Add New Node And Resort
-//////////////////////////////////////////////////////////////////
-void CPriorityQueue::Push(CEdge* theEdge )
-{
-   //Pushes the node onto the back of the mHeap
-   mHeap.push_back( theEdge );
-
-   //Sorts the new element into the mHeap
-   std::push_heap( mHeap.begin(), mHeap.end(), NodeTotalGreater() );
-}
-
-//////////////////////////////////////////////////////////////////
-// Find The Node In Question And Resort mHeap Around It
-//////////////////////////////////////////////////////////////////
-void CPriorityQueue::Update( CEdge* edge )
-{
-   for(std::vector<CEdge*>::iterator i=mHeap.begin(); i!=mHeap.end(); ++i)
-   {
-      if( (*i)->m_first == edge->m_first )
-      {  //Found node - resort from this position in the mHeap
-         //(its total value was changed before this function was called)
-         std::push_heap( mHeap.begin(), i+1, NodeTotalGreater() );
-         return;
-      }
-   }
-}
-
-//////////////////////////////////////////////////////////////////
-// Just a wrapper for stl empty function.
-//////////////////////////////////////////////////////////////////
-bool CPriorityQueue::Empty()
-{
-   return( mHeap.empty() );
-};
-
@@ -48,6 +48,10 @@ along with this program; if not, see <http://www.gnu.org/licenses/>.
 #define	NAV_HEADER_ID	INT_ID('J','N','V','5')
 #define	NODE_HEADER_ID	INT_ID('N','O','D','E')
 
+//Node lookup grid, buckets of cells on the xy plane
+#define	NODE_GRID_CELL_SIZE		256
+#define	NODE_GRID_BUCKETS		1024
+
 typedef std::multimap<int, int> EdgeMultimap;
 typedef EdgeMultimap::iterator EdgeMultimapIt;
 
@@ -98,7 +102,6 @@ public:
 	static CNode *Create( void );
 
 	void AddEdge( int ID, int cost, int flags = EFLAG_NONE );
-	void AddRank( int ID, int rank );
 
 	void Draw( qboolean radius );
 
@@ -113,15 +116,12 @@ public:
 	void SetEdgeFlags( int edgeNum, int newFlags );
 	int	GetRadius( void )				const	{	return m_radius;	}
 
-	void InitRanks( int size );
-	int GetRank( int ID );
-
 	int	GetFlags( void )				const	{	return m_flags;	}
 	void AddFlag( int newFlag )			{	m_flags |= newFlag;	}
 	void RemoveFlag( int oldFlag )		{	m_flags &= ~oldFlag; }
 
-	int	Save( int numNodes, fileHandle_t file );
-	int Load( int numNodes, fileHandle_t file );
+	int	Save( fileHandle_t file );
+	int Load( fileHandle_t file );
 
 protected:
 
@@ -132,7 +132,6 @@ protected:
 
 	edge_v	m_edges;
 
-	int		*m_ranks;
 	int		m_numEdges;
 };
 
@@ -194,6 +193,8 @@ public:
 
 	int GetNumNodes( void )		const	{	return (int)m_nodes.size();		}
 
+	int GetRank( int nodeID, int ID ) const;
+
 	bool Connected( int startID, int endID );
 
 	unsigned int GetPathCost( int startID, int endID );
@@ -247,7 +248,14 @@ protected:
 	int		GetEdgeCost( CNode *first, CNode *second );
 	void	AddNodeEdges( CNode *node, int addDist, edge_l &edgeList, bool *checkedNodes );
 
+	void	AddToGrid( CNode *node );
+
+	void	InitRanks( int numNodes );
+	void	SetRank( int nodeID, int ID, int rank );
+
 	void	CalculatePath( CNode *node );
+	void	CalculatePath( CNode *node, std::vector<CEdge> &heap, std::vector<byte> &checked );
+	static void CalculatePathsJob( int jobNum, void *data );
 
 	//rww - made failedEdges private as it doesn't seem to need to be public.
 	//And I'd rather shoot myself than have to devise a way of setting/accessing this
@@ -256,33 +264,19 @@ protected:
 
 	node_v			m_nodes;
 	EdgeMultimap	m_edgeLookupMap;
-};
-
-//////////////////////////////////////////////////////////////////////
-// class Priority Queue
-//////////////////////////////////////////////////////////////////////
-class CPriorityQueue
-{
-// CONSTRUCTION /DESTRUCTION
-//--------------------------------------------------------------
-public:
-	CPriorityQueue() {};
-	~CPriorityQueue();
-
-// Functionality
-//--------------------------------------------------------------
-public:
-	CEdge*	Pop();
-	CEdge*	Find(int npNum);
-	void	Push( CEdge* theEdge );
-	void	Update(CEdge* edge );
-	bool	Empty();
-
 
-// DATA
-//--------------------------------------------------------------
-private:
-	std::vector<CEdge*>	mHeap;
+	//nodes sorted into grid cells so nearby ones can be found without
+	//looking at every node, chained through m_gridNext by node ID
+	std::vector<int>	m_gridHeads;
+	std::vector<int>	m_gridNext;
+	std::vector<int>	m_gridCells;		//x and y cell of every node
+	std::vector<int>	m_gridCollect;
+
+	//the order every node is reached in from every other node, one row per
+	//node, in shorts unless there are too many nodes for them
+	int					m_numRanks;
+	std::vector<short>	m_ranks16;
+	std::vector<int>	m_ranks32;
 };
 
 extern CNavigator navigator;
@@ -49,7 +49,6 @@ typedef struct svEntity_s {
 	int			clusternums[MAX_ENT_CLUSTERS];
 	int			lastCluster;		// if all the clusters don't fit in clusternums
 	int			areanum, areanum2;
-	int			snapshotCounter;	// used to prevent double adding from portal views
 } svEntity_t;
 
 typedef enum {
@@ -64,7 +63,6 @@ typedef struct server_s {
 	int				serverId;			// changes each server start
 	int				restartedServerId;	// serverId before a map_restart
 	int				checksumFeed;		//
-	int				snapshotCounter;	// incremented for each snapshot built
 	int				timeResidual;		// <= 1000 / sv_frame->value
 	int				nextFrameTime;		// when time > nextFrameTime, process world
 	char			*configstrings[MAX_CONFIGSTRINGS];
@@ -134,6 +132,8 @@ typedef struct {
 	qboolean	demowaiting;	// don't record until a non-delta message is sent
 	int			minDeltaFrame;	// the first non-delta frame stored in the demo.  cannot delta against frames older than this
 	fileHandle_t	demofile;
+	fileHandle_t	indexfile;		// sv_demoIndex: offsets of the demo's gamestate and non-delta snapshots
+	qboolean	nonDeltaFrame;		// the snapshot that is being sent is not delta compressed
 	qboolean	isBot;
 	int			botReliableAcknowledge; // for bots, need to maintain a separate reliableAcknowledge to record server messages into the demo file
 	struct  {
@@ -147,7 +147,19 @@ typedef struct {
 #endif
 
 #ifdef DEDICATED
-typedef std::vector<std::unique_ptr<bufferedMessageContainer_t>>::iterator demoPreRecordBufferIt;
+// a message kept for demo pre-recording, the data lives in the client's ring buffer
+typedef struct {
+	int			offset;
+	int			cursize;
+	int			maxsize;
+	int			bit;
+	qboolean	oob;
+	int			msgNum;
+	int			lastClientCommand;	// Need this if we are writing metadata with pre-recording as it is the first thing writen in any message.
+	int			time;
+	qboolean	isKeyframe;			// Gamestate message that can start a demo
+	qboolean	nonDelta;			// Contains a non-delta snapshot
+} preRecordMessage_t;
 #endif
 
 typedef struct client_s {
@@ -327,10 +339,17 @@ extern	cvar_t	*sv_demoPreRecord;
 extern	cvar_t	*sv_demoPreRecordBots;
 extern	cvar_t	*sv_demoPreRecordTime;
 extern	cvar_t	*sv_demoPreRecordKeyframeDistance;
+extern	cvar_t	*sv_demoPreRecordMemory;
+extern	cvar_t	*sv_demoIndex;
 extern	cvar_t	*sv_demoWriteMeta;
 #endif
 
 extern	cvar_t	*sv_snapShotDuelCull;
+extern	cvar_t	*sv_snapshotVisCache;
+extern	cvar_t	*sv_threads;
+extern	cvar_t	*sv_deltaCache;
+extern	cvar_t	*sv_broadphase;
+extern	cvar_t	*sv_icarusCache;
 
 extern	cvar_t	*sv_pingFix;
 extern	cvar_t	*sv_hibernateTime;
@@ -455,6 +474,34 @@ void SV_WriteFrameToClient (client_t *client, msg_t *msg);
 void SV_SendMessageToClient( msg_t *msg, client_t *client );
 void SV_SendClientMessages( void );
 void SV_SendClientSnapshot( client_t *client );
+void SV_SnapshotBench_f( void );
+void SV_DeltaCacheInfo_f( void );
+
+#ifdef DEDICATED
+//
+// sv_prerecord.cpp
+//
+qboolean SV_PreRecordStore( client_t *cl, msg_t *msg, int msgNum, qboolean isKeyframe );
+void SV_PreRecordTrim( client_t *cl, int maxAge );
+void SV_PreRecordCheckNewest( client_t *cl );
+void SV_PreRecordReset( client_t *cl );
+void SV_PreRecordFree( client_t *cl );
+void SV_PreRecordFreeAll( void );
+int SV_PreRecordFirstKeyframe( client_t *cl, int time );
+int SV_PreRecordNumMessages( client_t *cl );
+const preRecordMessage_t *SV_PreRecordMessage( client_t *cl, int index, msg_t *dst );
+void SV_DemoPreRecordInfo_f( void );
+#endif
+
+//
+// sv_jobs.cpp
+//
+typedef void (*jobFunc_t)( int jobNum, void *data );
+
+void SV_JobsInit( void );
+void SV_JobsShutdown( void );
+int SV_NumJobThreads( void );
+void SV_RunJobs( int numJobs, jobFunc_t func, void *data );
 
 //
 // sv_game.c
@@ -509,6 +556,8 @@ clipHandle_t SV_ClipHandleForEntity( const sharedEntity_t *ent );
 
 
 void SV_SectorList_f( void );
+void SV_BroadphaseInfo_f( void );
+void SV_BroadphaseBench_f( void );
 
 
 int SV_AreaEntities( const vec3_t mins, const vec3_t maxs, int *entityList, int maxcount );
@@ -525,6 +574,8 @@ int SV_PointContents( const vec3_t p, int passEntityNum );
 
 
 void SV_Trace( trace_t *results, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end, int passEntityNum, int contentmask, int capsule, int traceFlags, int useLod );
+void SV_TraceBatch( trace_t *results, const traceRequest_t *requests, int numRequests, int capsule, int traceFlags, int useLod );
+void SV_TraceBench_f( void );
 // mins and maxs are relative
 
 // if the entire move stays in a solid volume, trace.allsolid will be set,
@@ -31,7 +31,6 @@ along with this program; if not, see <http://www.gnu.org/licenses/>.
 #include <ctime>
 
 #ifdef DEDICATED
-extern std::vector<std::unique_ptr<bufferedMessageContainer_t>> demoPreRecordBuffer[MAX_CLIENTS];
 extern std::map<std::string, std::string> demoMetaData[MAX_CLIENTS];
 #endif
 
@@ -1523,9 +1522,29 @@ static void SV_KillServer_f( void ) {
 }
 
 #ifdef DEDICATED
+/*
+====================
+SV_WriteDemoIndex
+
+Notes where the next message starts in the demo's .idx file. type is 'g' for
+a gamestate and 's' for a non-delta snapshot, either of which a tool can
+start playback from.
+====================
+*/
+static void SV_WriteDemoIndex( client_t *cl, char type, int messageNum, int serverTime ) {
+	if ( !cl->demo.indexfile ) {
+		return;
+	}
+	FS_Printf( cl->demo.indexfile, "%c %i %i %i\n", type, FS_FTell( cl->demo.demofile ), messageNum, serverTime );
+}
+
 void SV_WriteDemoMessage ( client_t *cl, msg_t *msg, int headerBytes ) {
 	int		len, swlen;
 
+	if ( cl->demo.nonDeltaFrame ) {
+		SV_WriteDemoIndex( cl, 's', cl->netchan.outgoingSequence, sv.time );
+	}
+
 	// write the packet sequence
 	len = cl->netchan.outgoingSequence;
 	swlen = LittleLong( len );
@@ -1625,6 +1644,10 @@ void SV_StopRecordDemo( client_t *cl ) {
 	FS_Write (&len, 4, cl->demo.demofile);
 	FS_FCloseFile (cl->demo.demofile);
 	cl->demo.demofile = 0;
+	if ( cl->demo.indexfile ) {
+		FS_FCloseFile( cl->demo.indexfile );
+		cl->demo.indexfile = 0;
+	}
 	cl->demo.demorecording = qfalse;
 	if (com_developer->integer)
 		Com_Printf ("Stopped demo for client %d.\n", cl - svs.clients);
@@ -1637,7 +1660,7 @@ void SV_ClearClientDemoMeta( client_t *cl ) {
 
 void SV_ClearClientDemoPreRecord( client_t *cl ) {
 
-	demoPreRecordBuffer[cl - svs.clients].clear();
+	SV_PreRecordReset(cl);
 	Com_Memset(&cl->demo.preRecord,0,sizeof(cl->demo.preRecord));
 	cl->demo.preRecord.lastKeyframeTime = -(1000*sv_demoPreRecordKeyframeDistance->integer) * 2; // Make sure that restarting recording will immediately create a keyframe.
 }
@@ -1718,6 +1741,13 @@ void SV_RenameDemo_f(void) {
 	}
 
 	FS_Rename(from, to);
+
+	// and the seek index if there is one
+	Q_strcat(from, sizeof(from), ".idx");
+	Q_strcat(to, sizeof(to), ".idx");
+	if (FS_FileExists(from)) {
+		FS_Rename(from, to);
+	}
 }
 
 /*
@@ -1785,6 +1815,7 @@ void SV_RecordDemo( client_t *cl, char *demoName ) {
 		return;
 	}
 	cl->demo.demorecording = qtrue;
+	cl->demo.indexfile = sv_demoIndex->integer ? FS_FOpenFileWriteAsync( va( "%s.idx", name ), qtrue ) : 0;
 
 	cl->demo.isBot = (cl->netchan.remoteAddress.type == NA_BOT) ? qtrue : qfalse;
 	cl->demo.botReliableAcknowledge = cl->reliableSent;
@@ -1826,39 +1857,32 @@ void SV_RecordDemo( client_t *cl, char *demoName ) {
 	// already takes care of that
 	if (sv_demoPreRecord->integer) {
 		// Pre-recording is enabled. Let's check for the oldest available keyframe.
-		demoPreRecordBufferIt firstOldKeyframe;
-		qboolean firstOldKeyframeFound = qfalse;
-		for (demoPreRecordBufferIt it = demoPreRecordBuffer[cl - svs.clients].begin(); it != demoPreRecordBuffer[cl - svs.clients].end(); it++) {
-			if (it->get()->isKeyframe && it->get()->time < sv.time) {
-				firstOldKeyframe = it;
-				firstOldKeyframeFound = qtrue;
-				break;
-			}
-		}
-		if (firstOldKeyframeFound) {
-			int index = 0;
+		int firstOldKeyframe = SV_PreRecordFirstKeyframe(cl, sv.time);
+		if (firstOldKeyframe != -1) {
+			int numMessages = SV_PreRecordNumMessages(cl);
 			// Dump this keyframe (gamestate message) and all following non-keyframes into the demo.
-			for (demoPreRecordBufferIt it = firstOldKeyframe; it != demoPreRecordBuffer[cl - svs.clients].end(); it++,index++) {
+			for (int index = firstOldKeyframe; index < numMessages; index++) {
 				static byte preRecordBufData[MAX_MSGLEN]; // I make these static so they don't sit on the stack.
 				static msg_t		preRecordMsg;
 
-				if ((!it->get()->isKeyframe || index == 0) && it->get()->msgNum <= cl->netchan.outgoingSequence && it->get()->time <= sv.time) { // Check against outgoing sequence and server time too, *just in case* we ended up with some old messages
+				preRecordMsg.data = preRecordBufData;
+				const preRecordMessage_t *prm = SV_PreRecordMessage(cl, index, &preRecordMsg);
+				if ((!prm->isKeyframe || index == firstOldKeyframe) && prm->msgNum <= cl->netchan.outgoingSequence && prm->time <= sv.time) { // Check against outgoing sequence and server time too, *just in case* we ended up with some old messages
 					// We only want a keyframe at the beginning of the demo, none after.
-					Com_Memset(&preRecordMsg, 0, sizeof(msg_t));
-					Com_Memset(&preRecordBufData, 0, sizeof(preRecordBufData));
-					preRecordMsg.data = preRecordBufData;
-					MSG_FromBuffered(&preRecordMsg, &it->get()->msg);
 					MSG_WriteByte(&preRecordMsg, svc_EOF); // We didn't do that for the ones we put into the buffer, so we do it now.
-					if (index == 0 && sv_demoWriteMeta->integer) {
+					if (index == firstOldKeyframe && sv_demoWriteMeta->integer) {
 						// This goes before the first messsage
 
-						ssMeta << ",\"ost\":" << ((int64_t)std::time(nullptr) - ((sv.time - it->get()->time)/1000)); // Original start time. When was demo recording started?
-						ssMeta << ",\"prso\":" << (sv.time-it->get()->time); // Pre-recording start offset. Offset from start of demo to when the command to start recording was called
+						ssMeta << ",\"ost\":" << ((int64_t)std::time(nullptr) - ((sv.time - prm->time)/1000)); // Original start time. When was demo recording started?
+						ssMeta << ",\"prso\":" << (sv.time-prm->time); // Pre-recording start offset. Offset from start of demo to when the command to start recording was called
 
 						ssMeta << "}"; // End JSON object
-						SV_WriteEmptyMessageWithMetadata(it->get()->lastClientCommand, cl->demo.demofile,ssMeta.str().c_str(),it->get()->msgNum-1);
+						SV_WriteEmptyMessageWithMetadata(prm->lastClientCommand, cl->demo.demofile,ssMeta.str().c_str(),prm->msgNum-1);
+					}
+					if (index == firstOldKeyframe || prm->nonDelta) {
+						SV_WriteDemoIndex(cl, index == firstOldKeyframe ? 'g' : 's', prm->msgNum, prm->time);
 					}
-					SV_WriteDemoMessage(cl,&preRecordMsg,0,it->get()->msgNum);
+					SV_WriteDemoMessage(cl,&preRecordMsg,0,prm->msgNum);
 				}
 			}
 			return; // No need to go through the whole normal demo procedure with demowaiting etc.
@@ -1887,6 +1911,7 @@ void SV_RecordDemo( client_t *cl, char *demoName ) {
 	}
 
 	// write it to the demo file
+	SV_WriteDemoIndex( cl, 'g', cl->netchan.outgoingSequence - 1, sv.time );
 	len = LittleLong( cl->netchan.outgoingSequence - 1 );
 	FS_Write( &len, 4, cl->demo.demofile );
 
@@ -2325,6 +2350,11 @@ void SV_AddOperatorCommands( void ) {
 	Cmd_AddCommand ("dumpuser", SV_DumpUser_f, "Prints the userinfo for a given userid" );
 	Cmd_AddCommand ("map_restart", SV_MapRestart_f, "Restart the current map" );
 	Cmd_AddCommand ("sectorlist", SV_SectorList_f);
+	Cmd_AddCommand ("broadphaseinfo", SV_BroadphaseInfo_f, "Shows how entities are spread over the sector tree and the loose grid" );
+	Cmd_AddCommand ("broadphasebench", SV_BroadphaseBench_f, "Times entity area queries, \"save <name>\" and \"load <name>\" record and replay entity layouts" );
+	Cmd_AddCommand ("tracebench", SV_TraceBench_f, "Times rays traced one at a time against the same rays traced in batches, call with [rays] [fan]" );
+	Cmd_AddCommand ("snapshotbench", SV_SnapshotBench_f, "Times snapshot entity selection with and without sv_snapshotVisCache" );
+	Cmd_AddCommand ("deltacacheinfo", SV_DeltaCacheInfo_f, "Shows hits and misses of the entity delta cache, \"reset\" clears them" );
 	Cmd_AddCommand ("map", SV_Map_f, "Load a new map with cheats disabled" );
 	Cmd_SetCommandCompletionFunc( "map", SV_CompleteMapName );
 	Cmd_AddCommand ("devmap", SV_Map_f, "Load a new map with cheats enabled" );
@@ -2345,6 +2375,7 @@ void SV_AddOperatorCommands( void ) {
 	Cmd_AddCommand ("svdemometa", SV_DemoMeta_f, "Sets a new metadata entry for server-side demos for one player. Call with clientnum, metakey, [data]");
 	Cmd_AddCommand ("svdemoclearmeta", SV_DemoClearMeta_f, "Clears metadata for server-side demos for one player. Call with clientnum.");
 	Cmd_AddCommand ("svdemoclearprerecord", SV_DemoClearPreRecord_f, "Clears pre-record data for a particular client. Call with clientnum.");
+	Cmd_AddCommand ("svdemoprerecordinfo", SV_DemoPreRecordInfo_f, "Shows the memory each client's demo pre-record buffer uses");
 	Cmd_AddCommand ("svrenamedemo", SV_RenameDemo_f, "Rename a server-side demo");
 	Cmd_AddCommand("sv_listrecording", SV_ListRecording_f, "Lists demos being recorded");
 #endif
@@ -420,6 +420,7 @@ void SV_DropClient( client_t *drop, const char *reason ) {
 		SV_StopRecordDemo( drop );
 	}
 	SV_ClearClientDemoPreRecord(drop); // Happens on (re)connect too but let's be safe/clean :)
+	SV_PreRecordFree(drop); // Don't hold on to the memory while the slot is empty
 	SV_ClearClientDemoMeta(drop);
 #endif
 
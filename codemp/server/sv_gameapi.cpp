@@ -2780,6 +2780,10 @@ intptr_t SV_GameSystemCalls( intptr_t *args ) {
 		SV_BotCalculatePaths(args[1]);
 		return 0;
 
+	case G_TRACE_BATCH:
+		SV_TraceBatch( (trace_t *)VMA(1), (const traceRequest_t *)VMA(2), args[3], args[4], args[5], args[6] );
+		return 0;
+
 	case G_GET_ENTITY_TOKEN:
 		return SV_GetEntityToken((char *)VMA(1), args[2]);
 
@@ -3158,6 +3162,8 @@ void SV_BindGame( void ) {
 		gi.G2API_OverrideServer					= SV_G2API_OverrideServer;
 		gi.G2API_GetSurfaceName					= SV_G2API_GetSurfaceName;
 
+		gi.TraceBatch							= SV_TraceBatch;
+
 		GetGameAPI = (GetGameAPI_t)gvm->GetModuleAPI;
 		ret = GetGameAPI( GAME_API_VERSION, &gi );
 		if ( !ret ) {
@@ -1057,10 +1057,19 @@ void SV_Init (void) {
 	sv_demoPreRecordBots = Cvar_Get("sv_demoPreRecordBots", "0", CVAR_ARCHIVE, "Do demo pre-recording for bots as well");
 	sv_demoPreRecordTime = Cvar_Get("sv_demoPreRecordTime", "15", CVAR_ARCHIVE, "How many seconds of past packets should be stored for server demo pre-recording?");
 	sv_demoPreRecordKeyframeDistance = Cvar_Get("sv_demoPreRecordKeyframeDistance", "5", CVAR_ARCHIVE, "A demo can only start with a gamestate and full non-delta snapshot. How often should we save such a gamestate message? The shorter the distance, the more precisely the pre-record duration will be kept, but also the higher the RAM usage and regularity of non-delta frames being sent to the clients.");
+	sv_demoPreRecordMemory = Cvar_Get("sv_demoPreRecordMemory", "4096", CVAR_ARCHIVE, "Kilobytes of memory per client for demo pre-recording. Should hold sv_demoPreRecordTime plus sv_demoPreRecordKeyframeDistance seconds of messages, older keyframes are dropped early when it runs out.");
+	sv_demoIndex = Cvar_Get("sv_demoIndex", "0", CVAR_ARCHIVE, "Writes a .idx file next to each server demo with the file offsets of its gamestate and non-delta snapshots, so tools can seek without parsing the whole demo. With sv_demoPreRecord there is a non-delta snapshot at least every sv_demoPreRecordKeyframeDistance seconds.");
 	sv_demoWriteMeta = Cvar_Get("sv_demoWriteMeta", "1", CVAR_ARCHIVE, "Enables writing metadata to demos, which can be set by the server/game. This is invisible to normal clients and can be used for storing information about when the demo was recorded, start of the recording, and so on.");
 #endif
 
 	sv_snapShotDuelCull = Cvar_Get("sv_snapShotDuelCull", "1", CVAR_NONE, "Snapshot-based duel isolation");
+	sv_snapshotVisCache = Cvar_Get("sv_snapshotVisCache", "1", CVAR_ARCHIVE_ND, "Collect snapshot entities once per server frame instead of scanning all entities for every client");
+	sv_threads = Cvar_Get("sv_threads", "0", CVAR_ARCHIVE_ND, "Worker threads for building client snapshots and bot and NPC paths, -1 for one per extra core, 0 to build them on the main thread");
+	sv_deltaCache = Cvar_Get("sv_deltaCache", "1", CVAR_ARCHIVE_ND, "Reuse entity deltas that were already encoded for another client in the same frame");
+	sv_broadphase = Cvar_Get("sv_broadphase", "0", CVAR_ARCHIVE_ND, "Entity lookup for traces and area queries, 0 for the sector tree, 1 for a loose grid");
+	sv_icarusCache = Cvar_Get("sv_icarusCache", "1", CVAR_ARCHIVE_ND, "Keep loaded ICARUS scripts and what was precached from them across map loads, a script whose file contents are unchanged is not decoded again");
+	// the game import table has TraceBatch, game modules check this before calling it
+	Cvar_Get("sv_traceBatch", "1", CVAR_ROM);
 
 	sv_pingFix = Cvar_Get("sv_pingFix", "1", CVAR_ARCHIVE_ND, "Improved scoreboard client ping calculation");
 	sv_hibernateTime = Cvar_Get("sv_hibernateTime", "0", CVAR_ARCHIVE_ND, "Time after which server will enter hibernation mode");
@@ -1148,6 +1157,7 @@ void SV_Shutdown( char *finalmsg )
 	SV_MasterShutdown();
 	SV_ChallengeShutdown();
 	SV_ShutdownGameProgs();
+	SV_JobsShutdown();
 	svs.gameStarted = qfalse;
 /*
 Ghoul2 Insert Start
@@ -1166,6 +1176,7 @@ Ghoul2 Insert Start
 #ifdef DEDICATED
 	SV_StopAutoRecordDemos();
 	SV_ClearAllDemoPreRecord();
+	SV_PreRecordFreeAll();
 #endif
 
 	// free server static data
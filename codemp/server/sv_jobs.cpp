@@ -0,0 +1,200 @@
+/*
+===========================================================================
+Copyright (C) 2013 - 2016, OpenJK contributors
+
+This file is part of the OpenJK source code.
+
+OpenJK is free software; you can redistribute it and/or modify it
+under the terms of the GNU General Public License version 2 as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, see <http://www.gnu.org/licenses/>.
+===========================================================================
+*/
+
+// sv_jobs.cpp -- small worker pool for splitting server frame work across cores
+
+#include "server.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define MAX_JOB_THREADS		16
+
+static struct {
+	std::vector<std::thread>	threads;
+	std::mutex					lock;
+	std::condition_variable		wake;		// signalled when a new batch is posted
+	std::condition_variable		done;		// signalled when the last worker finishes a batch
+	unsigned int				batch;		// incremented for every SV_RunJobs
+	int							busy;		// workers still working on the current batch
+	bool						quit;
+
+	jobFunc_t					func;
+	void						*data;
+	int							numJobs;
+	std::atomic<int>			nextJob;
+} svJobs;
+
+/*
+====================
+SV_DoJobs
+
+Takes jobs off the current batch until there are none left.
+====================
+*/
+static void SV_DoJobs( void ) {
+	int		job;
+
+	while ( (job = svJobs.nextJob++) < svJobs.numJobs ) {
+		svJobs.func( job, svJobs.data );
+	}
+}
+
+/*
+====================
+SV_JobThread
+====================
+*/
+static void SV_JobThread( void ) {
+	unsigned int	batch = 0;
+
+	while ( 1 ) {
+		{
+			std::unique_lock<std::mutex> l( svJobs.lock );
+			while ( !svJobs.quit && svJobs.batch == batch ) {
+				svJobs.wake.wait( l );
+			}
+			if ( svJobs.quit ) {
+				return;
+			}
+			batch = svJobs.batch;
+		}
+
+		SV_DoJobs();
+
+		{
+			std::lock_guard<std::mutex> l( svJobs.lock );
+			if ( --svJobs.busy == 0 ) {
+				svJobs.done.notify_one();
+			}
+		}
+	}
+}
+
+/*
+====================
+SV_JobsShutdown
+====================
+*/
+void SV_JobsShutdown( void ) {
+	if ( svJobs.threads.empty() ) {
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> l( svJobs.lock );
+		svJobs.quit = true;
+	}
+	svJobs.wake.notify_all();
+
+	for ( size_t i = 0 ; i < svJobs.threads.size() ; i++ ) {
+		svJobs.threads[i].join();
+	}
+	svJobs.threads.clear();
+	svJobs.quit = false;
+	svJobs.batch = 0;
+
+	// start them again the next time they are needed
+	if ( sv_threads ) {
+		sv_threads->modified = qtrue;
+	}
+}
+
+/*
+====================
+SV_JobsInit
+
+(Re)starts the pool with sv_threads workers. The calling thread always
+works on the jobs as well, so 0 workers means everything runs serially.
+====================
+*/
+void SV_JobsInit( void ) {
+	int		numThreads;
+
+	SV_JobsShutdown();
+	sv_threads->modified = qfalse;
+
+	numThreads = sv_threads->integer;
+	if ( numThreads < 0 ) {
+		numThreads = (int)std::thread::hardware_concurrency() - 1;
+	}
+	if ( numThreads > MAX_JOB_THREADS ) {
+		numThreads = MAX_JOB_THREADS;
+	}
+
+	for ( int i = 0 ; i < numThreads ; i++ ) {
+		svJobs.threads.push_back( std::thread( SV_JobThread ) );
+	}
+}
+
+/*
+====================
+SV_NumJobThreads
+
+Number of worker threads besides the calling thread
+====================
+*/
+int SV_NumJobThreads( void ) {
+	if ( sv_threads->modified ) {
+		SV_JobsInit();
+	}
+	return (int)svJobs.threads.size();
+}
+
+/*
+====================
+SV_RunJobs
+
+Calls func( 0 .. numJobs-1, data ) spread over the pool and returns once
+all of them are finished. Jobs may run in any order and must not touch
+anything another job writes, print, or raise errors.
+====================
+*/
+void SV_RunJobs( int numJobs, jobFunc_t func, void *data ) {
+	int		i;
+
+	if ( !SV_NumJobThreads() || numJobs < 2 ) {
+		for ( i = 0 ; i < numJobs ; i++ ) {
+			func( i, data );
+		}
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> l( svJobs.lock );
+		svJobs.func = func;
+		svJobs.data = data;
+		svJobs.numJobs = numJobs;
+		svJobs.nextJob = 0;
+		svJobs.busy = (int)svJobs.threads.size();
+		svJobs.batch++;
+	}
+	svJobs.wake.notify_all();
+
+	SV_DoJobs();
+
+	std::unique_lock<std::mutex> l( svJobs.lock );
+	while ( svJobs.busy ) {
+		svJobs.done.wait( l );
+	}
+}
@@ -82,10 +82,17 @@ cvar_t	*sv_demoPreRecord; // Activate demo pre-recording
 cvar_t	*sv_demoPreRecordBots; // Activates demo pre-recording for bots
 cvar_t	*sv_demoPreRecordTime; // How many seconds of past packets should be stored so demos can be retroactively recorded for that duration?
 cvar_t	*sv_demoPreRecordKeyframeDistance; // A demo can only start with a gamestate and full non-delta snapshot. How often should we save such a gamestate message (in seconds)? The shorter the distance, the more precisely the pre-record duration will be kept.
+cvar_t	*sv_demoPreRecordMemory; // Kilobytes of pre-recorded messages kept per client
+cvar_t	*sv_demoIndex; // Write a seek index next to server demos
 cvar_t	*sv_demoWriteMeta; // Enables writing metadata to demos, which can be set by the server/game. This is invisible to normal clients and can be used for storing information about when the demo was recorded, start of the recording, and so on.
 #endif
 
 cvar_t	*sv_snapShotDuelCull;
+cvar_t	*sv_snapshotVisCache;
+cvar_t	*sv_threads;
+cvar_t	*sv_deltaCache;
+cvar_t	*sv_broadphase;
+cvar_t	*sv_icarusCache;
 
 cvar_t	*sv_pingFix;
 cvar_t	*sv_hibernateTime;
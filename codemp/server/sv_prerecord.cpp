@@ -0,0 +1,440 @@
+/*
+===========================================================================
+Copyright (C) 2013 - 2016, OpenJK contributors
+
+This file is part of the OpenJK source code.
+
+OpenJK is free software; you can redistribute it and/or modify it
+under the terms of the GNU General Public License version 2 as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, see <http://www.gnu.org/licenses/>.
+===========================================================================
+*/
+
+// sv_prerecord.cpp -- per client ring buffers for server demo pre-recording
+
+#include "server.h"
+
+#ifdef DEDICATED
+
+// Every client gets one arena of sv_demoPreRecordMemory kilobytes, allocated
+// the first time a message is stored and kept until the client leaves or
+// pre-recording is turned off. Messages are copied into it back to back and
+// wrap around at the end, so storing a snapshot never allocates.
+//
+// The buffer is split into segments, each starting at a keyframe. Old data
+// is only ever dropped a whole segment at a time, which keeps a keyframe at
+// the front and makes trimming a matter of moving the tail.
+
+#define MIN_PRERECORD_MEMORY	(4 * MAX_MSGLEN)
+#define MIN_PRERECORD_MESSAGES	1024
+#define PRERECORD_MESSAGE_BYTES	512		// expected average message size, decides the message slots per arena
+
+typedef struct {
+	byte				*data;
+	int					dataSize;
+	int					head;			// where the next message goes
+	int					tail;			// start of the oldest message
+	int					used;			// bytes of stored messages, without wrap padding
+
+	preRecordMessage_t	*messages;		// ring of message slots, indexed by message id
+	int					messageMask;
+	unsigned int		firstMessage;	// id of the oldest stored message
+	unsigned int		nextMessage;	// id the next stored message gets
+
+	unsigned int		*keyframes;		// ring of keyframe message ids, same size as messages
+	unsigned int		firstKeyframe;
+	unsigned int		nextKeyframe;
+
+	int					peakUsed;
+	int					overruns;		// segments dropped for room before they got old
+	int					skipped;		// messages that did not fit at all
+} preRecordBuffer_t;
+
+static preRecordBuffer_t svPreRecord[MAX_CLIENTS];
+
+static preRecordBuffer_t *SV_PreRecordBuffer( const client_t *cl ) {
+	return &svPreRecord[cl - svs.clients];
+}
+
+static int SV_PreRecordMemorySize( void ) {
+	int size = sv_demoPreRecordMemory->integer * 1024;
+
+	if ( size < MIN_PRERECORD_MEMORY ) {
+		size = MIN_PRERECORD_MEMORY;
+	}
+	return size;
+}
+
+static int SV_PreRecordNumStored( const preRecordBuffer_t *buf ) {
+	return (int)( buf->nextMessage - buf->firstMessage );
+}
+
+static int SV_PreRecordNumKeyframes( const preRecordBuffer_t *buf ) {
+	return (int)( buf->nextKeyframe - buf->firstKeyframe );
+}
+
+static preRecordMessage_t *SV_PreRecordSlot( const preRecordBuffer_t *buf, unsigned int id ) {
+	return &buf->messages[id & buf->messageMask];
+}
+
+static void SV_PreRecordEmpty( preRecordBuffer_t *buf ) {
+	buf->head = buf->tail = buf->used = 0;
+	buf->firstMessage = buf->nextMessage = 0;
+	buf->firstKeyframe = buf->nextKeyframe = 0;
+}
+
+/*
+====================
+SV_PreRecordAlloc
+====================
+*/
+static void SV_PreRecordAlloc( preRecordBuffer_t *buf, int size ) {
+	int		numMessages;
+
+	numMessages = MIN_PRERECORD_MESSAGES;
+	while ( numMessages < size / PRERECORD_MESSAGE_BYTES ) {
+		numMessages <<= 1;
+	}
+
+	Com_Memset( buf, 0, sizeof( *buf ) );
+	buf->data = (byte *)Z_Malloc( size, TAG_CLIENTS, qfalse );
+	buf->dataSize = size;
+	buf->messages = (preRecordMessage_t *)Z_Malloc( numMessages * sizeof( preRecordMessage_t ), TAG_CLIENTS, qfalse );
+	buf->keyframes = (unsigned int *)Z_Malloc( numMessages * sizeof( unsigned int ), TAG_CLIENTS, qfalse );
+	buf->messageMask = numMessages - 1;
+}
+
+static void SV_PreRecordRelease( preRecordBuffer_t *buf ) {
+	if ( buf->data ) {
+		Z_Free( buf->data );
+		Z_Free( buf->messages );
+		Z_Free( buf->keyframes );
+	}
+	Com_Memset( buf, 0, sizeof( *buf ) );
+}
+
+/*
+====================
+SV_PreRecordDropTo
+
+Forgets every message older than id.
+====================
+*/
+static void SV_PreRecordDropTo( preRecordBuffer_t *buf, unsigned int id ) {
+	while ( buf->firstKeyframe != buf->nextKeyframe && (int)( buf->keyframes[buf->firstKeyframe & buf->messageMask] - id ) < 0 ) {
+		buf->firstKeyframe++;
+	}
+	for ( ; buf->firstMessage != id ; buf->firstMessage++ ) {
+		buf->used -= SV_PreRecordSlot( buf, buf->firstMessage )->cursize;
+	}
+
+	if ( buf->firstMessage == buf->nextMessage ) {
+		SV_PreRecordEmpty( buf );
+	} else {
+		buf->tail = SV_PreRecordSlot( buf, buf->firstMessage )->offset;
+	}
+}
+
+/*
+====================
+SV_PreRecordDropSegment
+
+Drops the oldest segment: the messages before the first keyframe, or the
+first keyframe and everything up to the next one. Returns qfalse when that
+took the last keyframe with it.
+====================
+*/
+static qboolean SV_PreRecordDropSegment( preRecordBuffer_t *buf ) {
+	int		numKeyframes = SV_PreRecordNumKeyframes( buf );
+	unsigned int firstKeyframe;
+
+	if ( !numKeyframes ) {
+		SV_PreRecordEmpty( buf );
+		return qfalse;
+	}
+
+	firstKeyframe = buf->keyframes[buf->firstKeyframe & buf->messageMask];
+	if ( firstKeyframe != buf->firstMessage ) {
+		SV_PreRecordDropTo( buf, firstKeyframe );
+		return qtrue;
+	}
+	if ( numKeyframes == 1 ) {
+		SV_PreRecordEmpty( buf );
+		return qfalse;
+	}
+	SV_PreRecordDropTo( buf, buf->keyframes[( buf->firstKeyframe + 1 ) & buf->messageMask] );
+	return qtrue;
+}
+
+/*
+====================
+SV_PreRecordFindSpace
+
+Returns where size bytes can be stored without overwriting anything, or -1
+====================
+*/
+static int SV_PreRecordFindSpace( const preRecordBuffer_t *buf, int size ) {
+	if ( buf->firstMessage == buf->nextMessage ) {
+		return size <= buf->dataSize ? 0 : -1;
+	}
+	if ( SV_PreRecordNumStored( buf ) > buf->messageMask ) {
+		return -1; // out of message slots
+	}
+	if ( buf->head > buf->tail ) {
+		if ( buf->head + size <= buf->dataSize ) {
+			return buf->head;
+		}
+		return size <= buf->tail ? 0 : -1; // wrap around, leaving the end unused
+	}
+	return buf->head + size <= buf->tail ? buf->head : -1;
+}
+
+/*
+====================
+SV_PreRecordStore
+
+Appends a copy of msg. Older segments are dropped while there is no room
+for it. Returns qfalse if that left the buffer without a keyframe, in which
+case the caller should store a new one soon.
+====================
+*/
+qboolean SV_PreRecordStore( client_t *cl, msg_t *msg, int msgNum, qboolean isKeyframe ) {
+	preRecordBuffer_t	*buf = SV_PreRecordBuffer( cl );
+	preRecordMessage_t	*slot;
+	qboolean			haveKeyframe = qtrue;
+	int					size = SV_PreRecordMemorySize();
+	int					offset;
+
+	if ( buf->dataSize != size ) {
+		SV_PreRecordRelease( buf );
+		SV_PreRecordAlloc( buf, size );
+	}
+
+	if ( msg->cursize > buf->dataSize ) {
+		buf->skipped++;
+		return SV_PreRecordNumKeyframes( buf ) ? qtrue : qfalse;
+	}
+
+	while ( ( offset = SV_PreRecordFindSpace( buf, msg->cursize ) ) == -1 ) {
+		buf->overruns++;
+		if ( !SV_PreRecordDropSegment( buf ) ) {
+			haveKeyframe = qfalse;
+		}
+	}
+
+	slot = SV_PreRecordSlot( buf, buf->nextMessage );
+	slot->offset = offset;
+	slot->cursize = msg->cursize;
+	slot->maxsize = msg->maxsize;
+	slot->bit = msg->bit;
+	slot->oob = msg->oob;
+	slot->msgNum = msgNum;
+	slot->lastClientCommand = cl->lastClientCommand;
+	slot->time = sv.time;
+	slot->isKeyframe = isKeyframe;
+	slot->nonDelta = isKeyframe ? qfalse : cl->demo.nonDeltaFrame;
+	Com_Memcpy( buf->data + offset, msg->data, msg->cursize );
+
+	if ( isKeyframe ) {
+		buf->keyframes[buf->nextKeyframe++ & buf->messageMask] = buf->nextMessage;
+		haveKeyframe = qtrue;
+	}
+	if ( buf->firstMessage == buf->nextMessage ) {
+		buf->tail = offset;
+	}
+	buf->nextMessage++;
+	buf->head = offset + msg->cursize;
+	buf->used += msg->cursize;
+	if ( buf->used > buf->peakUsed ) {
+		buf->peakUsed = buf->used;
+	}
+
+	return haveKeyframe;
+}
+
+/*
+====================
+SV_PreRecordTrim
+
+Keeps at least maxAge milliseconds: drops everything before the newest
+keyframe that is older than that.
+====================
+*/
+void SV_PreRecordTrim( client_t *cl, int maxAge ) {
+	preRecordBuffer_t	*buf = SV_PreRecordBuffer( cl );
+	unsigned int		keyframe;
+
+	while ( SV_PreRecordNumKeyframes( buf ) ) {
+		keyframe = buf->keyframes[buf->firstKeyframe & buf->messageMask];
+		if ( keyframe == buf->firstMessage ) {
+			if ( SV_PreRecordNumKeyframes( buf ) < 2 ) {
+				break;
+			}
+			keyframe = buf->keyframes[( buf->firstKeyframe + 1 ) & buf->messageMask];
+		}
+		if ( SV_PreRecordSlot( buf, keyframe )->time + maxAge >= sv.time ) {
+			break;
+		}
+		SV_PreRecordDropTo( buf, keyframe );
+	}
+}
+
+/*
+====================
+SV_PreRecordCheckNewest
+
+Messages are stored in order, so if the newest one claims to come from the
+future (a server time or sequence restart the buffer was not cleared for)
+none of them can be trusted.
+====================
+*/
+void SV_PreRecordCheckNewest( client_t *cl ) {
+	preRecordBuffer_t	*buf = SV_PreRecordBuffer( cl );
+	preRecordMessage_t	*newest;
+
+	if ( buf->firstMessage == buf->nextMessage ) {
+		return;
+	}
+
+	newest = SV_PreRecordSlot( buf, buf->nextMessage - 1 );
+	if ( newest->msgNum > cl->netchan.outgoingSequence || newest->time > sv.time ) {
+		Com_Printf( "Found evil old messages in demo pre-record buffer. This shouldn't happen.\n" );
+		SV_PreRecordEmpty( buf );
+	}
+}
+
+/*
+====================
+SV_PreRecordReset
+
+Forgets all messages but keeps the memory for the next client in the slot
+====================
+*/
+void SV_PreRecordReset( client_t *cl ) {
+	SV_PreRecordEmpty( SV_PreRecordBuffer( cl ) );
+}
+
+/*
+====================
+SV_PreRecordFree
+====================
+*/
+void SV_PreRecordFree( client_t *cl ) {
+	SV_PreRecordRelease( SV_PreRecordBuffer( cl ) );
+}
+
+/*
+====================
+SV_PreRecordFreeAll
+====================
+*/
+void SV_PreRecordFreeAll( void ) {
+	for ( int i = 0 ; i < MAX_CLIENTS ; i++ ) {
+		SV_PreRecordRelease( &svPreRecord[i] );
+	}
+}
+
+/*
+====================
+SV_PreRecordFirstKeyframe
+
+Index of the oldest keyframe stored before time, or -1. Indices count from
+the oldest stored message up to SV_PreRecordNumMessages.
+====================
+*/
+int SV_PreRecordFirstKeyframe( client_t *cl, int time ) {
+	preRecordBuffer_t	*buf = SV_PreRecordBuffer( cl );
+	unsigned int		i, id;
+
+	for ( i = buf->firstKeyframe ; i != buf->nextKeyframe ; i++ ) {
+		id = buf->keyframes[i & buf->messageMask];
+		if ( SV_PreRecordSlot( buf, id )->time < time ) {
+			return (int)( id - buf->firstMessage );
+		}
+	}
+	return -1;
+}
+
+int SV_PreRecordNumMessages( client_t *cl ) {
+	return SV_PreRecordNumStored( SV_PreRecordBuffer( cl ) );
+}
+
+/*
+====================
+SV_PreRecordMessage
+
+Copies stored message index into dst, which must have room for MAX_MSGLEN
+bytes, and returns its bookkeeping.
+====================
+*/
+const preRecordMessage_t *SV_PreRecordMessage( client_t *cl, int index, msg_t *dst ) {
+	preRecordBuffer_t	*buf = SV_PreRecordBuffer( cl );
+	preRecordMessage_t	*slot = SV_PreRecordSlot( buf, buf->firstMessage + index );
+
+	dst->allowoverflow = qfalse;
+	dst->overflowed = qfalse;
+	dst->oob = slot->oob;
+	dst->maxsize = slot->maxsize;
+	dst->cursize = slot->cursize;
+	dst->readcount = 0;
+	dst->bit = slot->bit;
+	Com_Memcpy( dst->data, buf->data + slot->offset, slot->cursize );
+
+	return slot;
+}
+
+/*
+====================
+SV_DemoPreRecordInfo_f
+
+Shows how much pre-record memory each client holds.
+====================
+*/
+void SV_DemoPreRecordInfo_f( void ) {
+	client_t	*cl;
+	int			i, numClients = 0, totalAlloc = 0, totalUsed = 0;
+
+	if ( !svs.clients ) {
+		Com_Printf( "Server is not running.\n" );
+		return;
+	}
+
+	Com_Printf( "cl   msgs keys  secs   used KB  peak KB alloc KB overruns skipped name\n" );
+	Com_Printf( "-- ------ ---- ----- --------- -------- -------- -------- ------- ----\n" );
+	for ( i = 0, cl = svs.clients ; i < sv_maxclients->integer ; i++, cl++ ) {
+		preRecordBuffer_t *buf = SV_PreRecordBuffer( cl );
+		float seconds = 0.0f;
+		int allocated;
+
+		if ( !buf->data ) {
+			continue;
+		}
+
+		if ( buf->firstMessage != buf->nextMessage ) {
+			seconds = ( sv.time - SV_PreRecordSlot( buf, buf->firstMessage )->time ) * 0.001f;
+		}
+		allocated = buf->dataSize + ( buf->messageMask + 1 ) * (int)( sizeof( preRecordMessage_t ) + sizeof( unsigned int ) );
+
+		Com_Printf( "%2i %6i %4i %5.1f %9.1f %8.1f %8i %8i %7i %s\n", i,
+			SV_PreRecordNumStored( buf ), SV_PreRecordNumKeyframes( buf ), seconds,
+			buf->used / 1024.0f, buf->peakUsed / 1024.0f, allocated / 1024,
+			buf->overruns, buf->skipped, cl->state >= CS_CONNECTED ? cl->name : "" );
+
+		numClients++;
+		totalAlloc += allocated;
+		totalUsed += buf->used;
+	}
+
+	Com_Printf( "%i buffers, %.1f of %.1f MB in use, %i KB per client (sv_demoPreRecordMemory)\n",
+		numClients, totalUsed / ( 1024.0f * 1024.0f ), totalAlloc / ( 1024.0f * 1024.0f ), SV_PreRecordMemorySize() / 1024 );
+}
+
+#endif
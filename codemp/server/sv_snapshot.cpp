@@ -24,8 +24,9 @@ along with this program; if not, see <http://www.gnu.org/licenses/>.
 #include "server.h"
 #include "qcommon/cm_public.h"
 
+#include <mutex>
+
 #ifdef DEDICATED
-std::vector<std::unique_ptr<bufferedMessageContainer_t>> demoPreRecordBuffer[MAX_CLIENTS];
 std::map<std::string,std::string> demoMetaData[MAX_CLIENTS];
 #endif
 
@@ -51,6 +52,189 @@ A normal server packet will look like:
 =============================================================================
 */
 
+/*
+=============================================================================
+
+Entity delta cache
+
+Most clients are sent the same entity from the same old state in a
+frame, e.g. everyone who already had the entity's state of the last
+frame. The first client's encoded delta is kept for the rest of the
+frame and later clients get a copy of its bits. Entries are matched on
+the complete from and to states, so the output is exactly what
+MSG_WriteDeltaEntity would write.
+
+=============================================================================
+*/
+
+#define DELTACACHE_WAYS			4		// different deltas kept per entity and frame
+#define DELTACACHE_MAX_BYTES	192		// longer deltas are encoded every time
+
+typedef struct entityDeltaCacheEntry_s {
+	entityState_t	from;
+	entityState_t	to;
+	qboolean		force;
+	int				numBits;
+	byte			bits[DELTACACHE_MAX_BYTES];
+} entityDeltaCacheEntry_t;
+
+typedef struct entityDeltaCacheSlot_s {
+	std::mutex				lock;			// snapshots may be encoded on the job threads
+	int						frameNum;
+	int						numEntries;
+	int						nextEntry;		// replaced next when all ways are used
+	entityDeltaCacheEntry_t	entries[DELTACACHE_WAYS];
+
+	// statistics, summed up by SV_DeltaCacheInfo_f
+	unsigned int			hits;
+	unsigned int			misses;
+	unsigned int			uncached;		// too long to be cached
+} entityDeltaCacheSlot_t;
+
+static entityDeltaCacheSlot_t	deltaCache[MAX_GENTITIES];
+static int						deltaCacheFrame;
+
+/*
+=============
+SV_DeltaCacheNewFrame
+
+Drops all cached deltas, called before the snapshots of a frame are sent.
+=============
+*/
+static void SV_DeltaCacheNewFrame( void ) {
+	deltaCacheFrame++;
+}
+
+/*
+=============
+SV_DeltaCacheFind
+=============
+*/
+static entityDeltaCacheEntry_t *SV_DeltaCacheFind( entityDeltaCacheSlot_t *slot, const entityState_t *from,
+	const entityState_t *to, qboolean force ) {
+	entityDeltaCacheEntry_t	*entry;
+	int						i;
+
+	if ( slot->frameNum != deltaCacheFrame ) {
+		slot->frameNum = deltaCacheFrame;
+		slot->numEntries = 0;
+		slot->nextEntry = 0;
+		return NULL;
+	}
+
+	for ( i = 0, entry = slot->entries ; i < slot->numEntries ; i++, entry++ ) {
+		if ( entry->force == force && !memcmp( &entry->to, to, sizeof( *to ) )
+			&& !memcmp( &entry->from, from, sizeof( *from ) ) ) {
+			return entry;
+		}
+	}
+	return NULL;
+}
+
+/*
+=============
+SV_WriteDeltaEntity
+
+MSG_WriteDeltaEntity through the entity delta cache
+=============
+*/
+static void SV_WriteDeltaEntity( msg_t *msg, entityState_t *from, entityState_t *to, qboolean force ) {
+	entityDeltaCacheSlot_t	*slot;
+	entityDeltaCacheEntry_t	*entry;
+	int						startBit, numBits, bit;
+	int						i;
+
+	if ( !sv_deltaCache->integer || !to || msg->oob || msg->overflowed ) {
+		MSG_WriteDeltaEntity( msg, from, to, force );
+		return;
+	}
+
+	// unchanged entities don't write anything
+	if ( !force && !memcmp( from, to, sizeof( *to ) ) ) {
+		return;
+	}
+
+	slot = &deltaCache[to->number & (MAX_GENTITIES-1)];
+
+	{
+		std::lock_guard<std::mutex> l( slot->lock );
+		entry = SV_DeltaCacheFind( slot, from, to, force );
+		if ( entry ) {
+			slot->hits++;
+			MSG_WriteEncodedBits( msg, entry->bits, entry->numBits );
+			return;
+		}
+	}
+
+	startBit = msg->bit;
+	MSG_WriteDeltaEntity( msg, from, to, force );
+	if ( msg->overflowed ) {
+		return;
+	}
+	numBits = msg->bit - startBit;
+
+	std::lock_guard<std::mutex> l( slot->lock );
+	if ( numBits > DELTACACHE_MAX_BYTES * 8 ) {
+		slot->uncached++;
+		return;
+	}
+	slot->misses++;
+
+	// another thread may have started a new frame or added it meanwhile
+	if ( SV_DeltaCacheFind( slot, from, to, force ) ) {
+		return;
+	}
+
+	if ( slot->numEntries < DELTACACHE_WAYS ) {
+		entry = &slot->entries[slot->numEntries++];
+	} else {
+		entry = &slot->entries[slot->nextEntry];
+		slot->nextEntry = ( slot->nextEntry + 1 ) % DELTACACHE_WAYS;
+	}
+
+	entry->from = *from;
+	entry->to = *to;
+	entry->force = force;
+	entry->numBits = numBits;
+	memset( entry->bits, 0, ( numBits + 7 ) >> 3 );
+	bit = startBit;
+	for ( i = 0 ; i < numBits ; i++ ) {
+		entry->bits[i >> 3] |= Huff_getBit( msg->data, &bit ) << ( i & 7 );
+	}
+}
+
+/*
+=============
+SV_DeltaCacheInfo_f
+
+Prints how often entity deltas were copied from the cache
+=============
+*/
+void SV_DeltaCacheInfo_f( void ) {
+	unsigned int	hits, misses, uncached, total;
+	int				i;
+
+	hits = misses = uncached = 0;
+	for ( i = 0 ; i < MAX_GENTITIES ; i++ ) {
+		std::lock_guard<std::mutex> l( deltaCache[i].lock );
+		hits += deltaCache[i].hits;
+		misses += deltaCache[i].misses;
+		uncached += deltaCache[i].uncached;
+		if ( Cmd_Argc() > 1 && !Q_stricmp( Cmd_Argv( 1 ), "reset" ) ) {
+			deltaCache[i].hits = deltaCache[i].misses = deltaCache[i].uncached = 0;
+		}
+	}
+
+	total = hits + misses + uncached;
+	Com_Printf( "entity delta cache (sv_deltaCache %i):\n", sv_deltaCache->integer );
+	Com_Printf( "%10u hits\n", hits );
+	Com_Printf( "%10u misses\n", misses );
+	Com_Printf( "%10u too long to cache\n", uncached );
+	if ( total ) {
+		Com_Printf( "%9.1f%% hit rate\n", 100.0f * hits / total );
+	}
+}
+
 /*
 =============
 SV_EmitPacketEntities
@@ -94,7 +278,7 @@ static void SV_EmitPacketEntities( clientSnapshot_t *from, clientSnapshot_t *to,
 			// delta update from old position
 			// because the force parm is qfalse, this will not result
 			// in any bytes being emited if the entity has not changed at all
-			MSG_WriteDeltaEntity (msg, oldent, newent, qfalse );
+			SV_WriteDeltaEntity (msg, oldent, newent, qfalse );
 			oldindex++;
 			newindex++;
 			continue;
@@ -102,7 +286,7 @@ static void SV_EmitPacketEntities( clientSnapshot_t *from, clientSnapshot_t *to,
 
 		if ( newnum < oldnum ) {
 			// this is a new entity, send it from the baseline
-			MSG_WriteDeltaEntity (msg, &sv.svEntities[newnum].baseline, newent, qtrue );
+			SV_WriteDeltaEntity (msg, &sv.svEntities[newnum].baseline, newent, qtrue );
 			newindex++;
 			continue;
 		}
@@ -122,19 +306,20 @@ static void SV_EmitPacketEntities( clientSnapshot_t *from, clientSnapshot_t *to,
 
 /*
 ==================
-SV_WriteSnapshotToClient
+SV_SnapshotDeltaFrame
+
+Picks the frame the current snapshot is delta compressed against, or NULL
+for a full snapshot. Must be called after the client's snapshot entities,
+and any others stored before the snapshot is written, are in
+svs.snapshotEntities, as it checks whether the old frame's entities are
+still there.
 ==================
 */
-static void SV_WriteSnapshotToClient( client_t *client, msg_t *msg ) {
-	clientSnapshot_t	*frame, *oldframe;
+static clientSnapshot_t *SV_SnapshotDeltaFrame( client_t *client, int *deltaFrame ) {
+	clientSnapshot_t	*oldframe;
 	int					lastframe;
-	int					i;
-	int					snapFlags;
 	int					deltaMessage;
 
-	// this is the snapshot we are creating
-	frame = &client->frames[ client->netchan.outgoingSequence & PACKET_MASK ];
-
 	// bots never acknowledge, but it doesn't matter since the only use case is for serverside demos
 	// in which case we can delta against the very last message every time
 	deltaMessage = client->deltaMessage;
@@ -193,6 +378,7 @@ static void SV_WriteSnapshotToClient( client_t *client, msg_t *msg ) {
 	}
 
 #ifdef DEDICATED
+	client->demo.nonDeltaFrame = oldframe ? qfalse : qtrue;
 	if ( oldframe == NULL ) {
 		if ( client->demo.demowaiting ) {
 			// this is a non-delta frame, so we can delta against it in the demo
@@ -219,6 +405,26 @@ static void SV_WriteSnapshotToClient( client_t *client, msg_t *msg ) {
 	}
 #endif
 
+	*deltaFrame = lastframe;
+	return oldframe;
+}
+
+/*
+==================
+SV_WriteSnapshotFrame
+
+Encodes the current snapshot against oldframe. Only touches the client's
+own state, so this can run for several clients at once.
+==================
+*/
+static void SV_WriteSnapshotFrame( client_t *client, clientSnapshot_t *oldframe, int lastframe, msg_t *msg ) {
+	clientSnapshot_t	*frame;
+	int					i;
+	int					snapFlags;
+
+	// this is the snapshot we are creating
+	frame = &client->frames[ client->netchan.outgoingSequence & PACKET_MASK ];
+
 	MSG_WriteByte (msg, svc_snapshot);
 
 	// NOTE, MRE: now sent at the start of every message from server to client
@@ -314,6 +520,19 @@ static void SV_WriteSnapshotToClient( client_t *client, msg_t *msg ) {
 	}
 }
 
+/*
+==================
+SV_WriteSnapshotToClient
+==================
+*/
+static void SV_WriteSnapshotToClient( client_t *client, msg_t *msg ) {
+	clientSnapshot_t	*oldframe;
+	int					lastframe;
+
+	oldframe = SV_SnapshotDeltaFrame( client, &lastframe );
+	SV_WriteSnapshotFrame( client, oldframe, lastframe, msg );
+}
+
 
 /*
 ==================
@@ -355,8 +574,21 @@ Build a client snapshot structure
 typedef struct snapshotEntityNumbers_s {
 	int		numSnapshotEntities;
 	int		snapshotEntities[MAX_SNAPSHOT_ENTITIES];
+	byte	added[MAX_GENTITIES/8];		// prevents double adding from portal views
 } snapshotEntityNumbers_t;
 
+/*
+=======================
+SV_ClearSnapshotEntityNumbers
+=======================
+*/
+static void SV_ClearSnapshotEntityNumbers( snapshotEntityNumbers_t *eNums ) {
+	eNums->numSnapshotEntities = 0;
+	Com_Memset( eNums->added, 0, sizeof( eNums->added ) );
+}
+
+#define SV_SnapshotEntityAdded( eNums, e )	( (eNums)->added[(e) >> 3] & (1 << ((e)&7)) )
+
 /*
 =======================
 SV_QsortEntityNumbers
@@ -385,12 +617,14 @@ static int QDECL SV_QsortEntityNumbers( const void *a, const void *b ) {
 SV_AddEntToSnapshot
 ===============
 */
-static void SV_AddEntToSnapshot( svEntity_t *svEnt, sharedEntity_t *gEnt, snapshotEntityNumbers_t *eNums ) {
+static void SV_AddEntToSnapshot( sharedEntity_t *gEnt, snapshotEntityNumbers_t *eNums ) {
+	int		e = gEnt->s.number;
+
 	// if we have already added this entity to this snapshot, don't add again
-	if ( svEnt->snapshotCounter == sv.snapshotCounter ) {
+	if ( SV_SnapshotEntityAdded( eNums, e ) ) {
 		return;
 	}
-	svEnt->snapshotCounter = sv.snapshotCounter;
+	eNums->added[e >> 3] |= 1 << (e&7);
 
 	// if we are full, silently discard entities
 	if ( eNums->numSnapshotEntities == MAX_SNAPSHOT_ENTITIES ) {
@@ -401,13 +635,273 @@ static void SV_AddEntToSnapshot( svEntity_t *svEnt, sharedEntity_t *gEnt, snapsh
 	eNums->numSnapshotEntities++;
 }
 
+/*
+=============================================================================
+
+Per-frame snapshot candidates
+
+Walking all of sv.num_entities for every client repeats the same client
+independent tests over and over.  Instead, the entities that could be sent to
+anyone are collected once per SV_SendClientMessages in increasing entity
+number order, and bucketed by the PVS clusters they touch.  A viewpoint then
+only has to test the occupied clusters against its PVS.  The per-client tests
+are still applied in entity number order, so the selected entities are
+exactly the same as with the full scan (sv_snapshotVisCache 0).
+
+=============================================================================
+*/
+
+#define	SNAPCAND_LANDING_EFFECT		1	// counts against MAX_LANDING_EFFECTS_PER_SNAPSHOT
+#define	SNAPCAND_OVERFLOW_CLUSTERS	2	// clusters didn't fit in clusternums, check the pvs directly
+
+typedef struct snapshotCandidate_s {
+	sharedEntity_t	*ent;
+	svEntity_t		*svEnt;
+	int				flags;
+} snapshotCandidate_t;
+
+typedef struct snapshotClusterRef_s {
+	int		cluster;
+	int		candidate;
+} snapshotClusterRef_t;
+
+typedef struct snapshotClusterRun_s {
+	int		cluster;
+	int		firstRef;
+	int		numRefs;
+} snapshotClusterRun_t;
+
+typedef struct snapshotCandidates_s {
+	qboolean				valid;			// only while the current frame's snapshots are built
+	int						numCandidates;
+	snapshotCandidate_t		candidates[MAX_GENTITIES];
+
+	int						numClusterRefs;	// sorted by cluster
+	snapshotClusterRef_t	clusterRefs[MAX_GENTITIES*MAX_ENT_CLUSTERS];
+	int						numClusterRuns;	// one per occupied cluster
+	snapshotClusterRun_t	clusterRuns[MAX_GENTITIES*MAX_ENT_CLUSTERS];
+} snapshotCandidates_t;
+
+static snapshotCandidates_t	snapCandidates;
+
+/*
+===============
+SV_SnapshotEntityFlags
+
+Client independent part of the snapshot entity checks.
+Returns -1 if the entity can't be sent to anybody.
+===============
+*/
+#define MAX_LANDING_EFFECTS_PER_SNAPSHOT 16
+static int SV_SnapshotEntityFlags( sharedEntity_t *ent, int e ) {
+	int		flags = 0;
+
+	// never send entities that aren't linked in
+	if ( !ent->r.linked ) {
+		return -1;
+	}
+
+	if (ent->s.eFlags & EF_PERMANENT)
+	{	// he's permanent, so don't send him down!
+		return -1;
+	}
+
+	if (ent->s.number != e) {
+		Com_DPrintf ("FIXING ENT->S.NUMBER!!!\n");
+		ent->s.number = e;
+	}
+
+	// entities can be flagged to explicitly not be sent to the client
+	if ( ent->r.svFlags & SVF_NOCLIENT ) {
+		return -1;
+	}
+
+	if (ent->s.eType >= ET_EVENTS && sv_legacyFixes->integer && !(sv_legacyFixes->integer & SVFIXES_DISABLE_MOVEMENT_EVENT_CHECKS) &&
+		svs.servermod < SVMOD_JAPRO && svs.servermod != SVMOD_UNKNOWN && svs.servermod != SVMOD_MBII)//only check event types on known mods, to avoid modified eTypes/event enum conflicts
+	{
+		int eventNum = (ent->s.eType - ET_EVENTS) & ~EV_EVENT_BITS;
+
+		if (eventNum == EV_JUMP || eventNum == EV_FALL || eventNum == EV_FOOTSTEP)
+		{ //block these movement-triggered event entities, these should always be on a player
+			return -1;
+		}
+
+		if ((eventNum == EV_PLAY_EFFECT || eventNum == EV_PLAY_EFFECT_ID) &&
+			(ent->s.eventParm >= EFFECT_WATER_SPLASH && ent->s.eventParm <= EFFECT_LANDING_GRAVEL)) //all landing effects
+		{
+			flags |= SNAPCAND_LANDING_EFFECT; //block these so they cant be abused on ffa3
+		}
+	}
+
+	return flags;
+}
+
+/*
+=======================
+SV_QsortClusterRefs
+=======================
+*/
+static int QDECL SV_QsortClusterRefs( const void *a, const void *b ) {
+	const snapshotClusterRef_t *ra = (const snapshotClusterRef_t *)a;
+	const snapshotClusterRef_t *rb = (const snapshotClusterRef_t *)b;
+
+	if ( ra->cluster != rb->cluster ) {
+		return ra->cluster < rb->cluster ? -1 : 1;
+	}
+	return ra->candidate - rb->candidate;
+}
+
+/*
+===============
+SV_BuildSnapshotCandidates
+
+Collects the entities every snapshot of this frame will choose from.
+The list is only valid until SV_InvalidateSnapshotCandidates, as any
+entity relinking would leave it stale.
+===============
+*/
+static void SV_BuildSnapshotCandidates( void ) {
+	int					e, i;
+	sharedEntity_t		*ent;
+	svEntity_t			*svEnt;
+	snapshotCandidate_t	*cand;
+	snapshotClusterRun_t	*run;
+	int					flags;
+
+	snapCandidates.valid = qfalse;
+	snapCandidates.numCandidates = 0;
+	snapCandidates.numClusterRefs = 0;
+	snapCandidates.numClusterRuns = 0;
+
+	if ( !sv.state ) {
+		return;
+	}
+
+	for ( e = 0 ; e < sv.num_entities ; e++ ) {
+		ent = SV_GentityNum(e);
+
+		flags = SV_SnapshotEntityFlags( ent, e );
+		if ( flags < 0 ) {
+			continue;
+		}
+
+		svEnt = SV_SvEntityForGentity( ent );
+		if ( svEnt->lastCluster ) {
+			flags |= SNAPCAND_OVERFLOW_CLUSTERS;
+		}
+
+		for ( i = 0 ; i < svEnt->numClusters ; i++ ) {
+			snapCandidates.clusterRefs[snapCandidates.numClusterRefs].cluster = svEnt->clusternums[i];
+			snapCandidates.clusterRefs[snapCandidates.numClusterRefs].candidate = snapCandidates.numCandidates;
+			snapCandidates.numClusterRefs++;
+		}
+
+		cand = &snapCandidates.candidates[snapCandidates.numCandidates++];
+		cand->ent = ent;
+		cand->svEnt = svEnt;
+		cand->flags = flags;
+	}
+
+	// group the references by cluster
+	qsort( snapCandidates.clusterRefs, snapCandidates.numClusterRefs,
+		sizeof( snapCandidates.clusterRefs[0] ), SV_QsortClusterRefs );
+
+	run = NULL;
+	for ( i = 0 ; i < snapCandidates.numClusterRefs ; i++ ) {
+		if ( !run || run->cluster != snapCandidates.clusterRefs[i].cluster ) {
+			run = &snapCandidates.clusterRuns[snapCandidates.numClusterRuns++];
+			run->cluster = snapCandidates.clusterRefs[i].cluster;
+			run->firstRef = i;
+			run->numRefs = 0;
+		}
+		run->numRefs++;
+	}
+
+	snapCandidates.valid = qtrue;
+}
+
+/*
+===============
+SV_InvalidateSnapshotCandidates
+===============
+*/
+static void SV_InvalidateSnapshotCandidates( void ) {
+	snapCandidates.valid = qfalse;
+}
+
+/*
+===============
+SV_MarkVisibleCandidates
+
+Sets the bit of every candidate touching a cluster in the pvs
+===============
+*/
+static void SV_MarkVisibleCandidates( const byte *bitvector, byte *visible ) {
+	const snapshotClusterRun_t	*run;
+	const snapshotClusterRef_t	*ref;
+	int							i, j, l, c;
+
+	Com_Memset( visible, 0, (snapCandidates.numCandidates + 7) >> 3 );
+
+	for ( i = 0, run = snapCandidates.clusterRuns ; i < snapCandidates.numClusterRuns ; i++, run++ ) {
+		l = run->cluster;
+		if ( !(bitvector[l >> 3] & (1 << (l&7))) ) {
+			continue;
+		}
+		ref = &snapCandidates.clusterRefs[run->firstRef];
+		for ( j = 0 ; j < run->numRefs ; j++, ref++ ) {
+			c = ref->candidate;
+			visible[c >> 3] |= 1 << (c&7);
+		}
+	}
+}
+
+/*
+===============
+SV_EntityInPVS
+===============
+*/
+static qboolean SV_EntityInPVS( const svEntity_t *svEnt, const byte *bitvector ) {
+	int		i, l;
+
+	// check individual leafs
+	if ( !svEnt->numClusters ) {
+		return qfalse;
+	}
+	l = 0;
+	for ( i=0 ; i < svEnt->numClusters ; i++ ) {
+		l = svEnt->clusternums[i];
+		if ( bitvector[l >> 3] & (1 << (l&7) ) ) {
+			break;
+		}
+	}
+
+	// if we haven't found it to be visible,
+	// check overflow clusters that coudln't be stored
+	if ( i == svEnt->numClusters ) {
+		if ( svEnt->lastCluster ) {
+			for ( ; l <= svEnt->lastCluster ; l++ ) {
+				if ( bitvector[l >> 3] & (1 << (l&7) ) ) {
+					break;
+				}
+			}
+			if ( l == svEnt->lastCluster ) {
+				return qfalse;	// not visible
+			}
+		} else {
+			return qfalse;
+		}
+	}
+
+	return qtrue;
+}
+
 /*
 ===============
 SV_AddEntitiesVisibleFromPoint
 ===============
 */
 float g_svCullDist = -1.0f;
-#define MAX_LANDING_EFFECTS_PER_SNAPSHOT 16
 static void SV_AddEntitiesVisibleFromPoint( vec3_t origin, clientSnapshot_t *frame,
 #ifndef DEDICATED
 									snapshotEntityNumbers_t *eNums, qboolean portal )
@@ -415,17 +909,19 @@ static void SV_AddEntitiesVisibleFromPoint( vec3_t origin, clientSnapshot_t *fra
 									snapshotEntityNumbers_t *eNums, qboolean portal, qboolean skipDuelCull )
 #endif
 {
-	int		e, i;
+	int		e, c;
 	sharedEntity_t *ent;
 	svEntity_t	*svEnt;
-	int		l;
 	int		clientarea, clientcluster;
 	int		leafnum;
 	byte	*clientpvs;
-	byte	*bitvector;
 	vec3_t	difference;
 	float	length, radius;
 	int		effectCount = 0;
+	int		flags;
+	int		numEnts;
+	qboolean	useCandidates;
+	byte	visible[MAX_GENTITIES/8];
 
 	// during an error shutdown message we may need to transmit
 	// the shutdown message after the server has shutdown, so
@@ -443,27 +939,28 @@ static void SV_AddEntitiesVisibleFromPoint( vec3_t origin, clientSnapshot_t *fra
 
 	clientpvs = CM_ClusterPVS (clientcluster);
 
-	for ( e = 0 ; e < sv.num_entities ; e++ ) {
-		ent = SV_GentityNum(e);
-
-		// never send entities that aren't linked in
-		if ( !ent->r.linked ) {
-			continue;
-		}
-
-		if (ent->s.eFlags & EF_PERMANENT)
-		{	// he's permanent, so don't send him down!
-			continue;
-		}
-
-		if (ent->s.number != e) {
-			Com_DPrintf ("FIXING ENT->S.NUMBER!!!\n");
-			ent->s.number = e;
-		}
+	useCandidates = snapCandidates.valid;
+	if ( useCandidates ) {
+		SV_MarkVisibleCandidates( clientpvs, visible );
+		numEnts = snapCandidates.numCandidates;
+	} else {
+		numEnts = sv.num_entities;
+	}
 
-		// entities can be flagged to explicitly not be sent to the client
-		if ( ent->r.svFlags & SVF_NOCLIENT ) {
-			continue;
+	for ( c = 0 ; c < numEnts ; c++ ) {
+		if ( useCandidates ) {
+			ent = snapCandidates.candidates[c].ent;
+			svEnt = snapCandidates.candidates[c].svEnt;
+			flags = snapCandidates.candidates[c].flags;
+			e = ent->s.number;
+		} else {
+			e = c;
+			ent = SV_GentityNum(e);
+			flags = SV_SnapshotEntityFlags( ent, e );
+			if ( flags < 0 ) {
+				continue;
+			}
+			svEnt = SV_SvEntityForGentity( ent );
 		}
 
 		// entities can be flagged to be sent to only one client
@@ -485,29 +982,14 @@ static void SV_AddEntitiesVisibleFromPoint( vec3_t origin, clientSnapshot_t *fra
 		}
 #endif
 
-		if (ent->s.eType >= ET_EVENTS && sv_legacyFixes->integer && !(sv_legacyFixes->integer & SVFIXES_DISABLE_MOVEMENT_EVENT_CHECKS) &&
-			svs.servermod < SVMOD_JAPRO && svs.servermod != SVMOD_UNKNOWN && svs.servermod != SVMOD_MBII)//only check event types on known mods, to avoid modified eTypes/event enum conflicts
-		{
-			int eventNum = (ent->s.eType - ET_EVENTS) & ~EV_EVENT_BITS;
-
-			if (eventNum == EV_JUMP || eventNum == EV_FALL || eventNum == EV_FOOTSTEP)
-			{ //block these movement-triggered event entities, these should always be on a player
-				continue;
-			}
-			
-			if ((eventNum == EV_PLAY_EFFECT || eventNum == EV_PLAY_EFFECT_ID) &&
-				(ent->s.eventParm >= EFFECT_WATER_SPLASH && ent->s.eventParm <= EFFECT_LANDING_GRAVEL)) //all landing effects
-			{
-				effectCount++;
-				if (effectCount > MAX_LANDING_EFFECTS_PER_SNAPSHOT)
-					continue; //block these so they cant be abused on ffa3
-			}
+		if ( flags & SNAPCAND_LANDING_EFFECT ) {
+			effectCount++;
+			if (effectCount > MAX_LANDING_EFFECTS_PER_SNAPSHOT)
+				continue; //block these so they cant be abused on ffa3
 		}
 
-		svEnt = SV_SvEntityForGentity( ent );
-
 		// don't double add an entity through portals
-		if ( svEnt->snapshotCounter == sv.snapshotCounter ) {
+		if ( SV_SnapshotEntityAdded( eNums, e ) ) {
 			continue;
 		}
 
@@ -521,13 +1003,13 @@ static void SV_AddEntitiesVisibleFromPoint( vec3_t origin, clientSnapshot_t *fra
 		if ( (ent->r.svFlags & SVF_BROADCAST) || e == frame->ps.clientNum
 			|| (ent->r.broadcastClients[frame->ps.clientNum/32] & (1 << (frame->ps.clientNum % 32))) )
 		{
-			SV_AddEntToSnapshot( svEnt, ent, eNums );
+			SV_AddEntToSnapshot( ent, eNums );
 			continue;
 		}
 
 		if (ent->s.isPortalEnt)
 		{ //rww - portal entities are always sent as well
-			SV_AddEntToSnapshot( svEnt, ent, eNums );
+			SV_AddEntToSnapshot( ent, eNums );
 			continue;
 		}
 
@@ -537,7 +1019,7 @@ static void SV_AddEntitiesVisibleFromPoint( vec3_t origin, clientSnapshot_t *fra
 			sharedEntity_t *ent2;
 			ent2 = SV_GentityNum(frame->ps.clientNum);
 			if (ent2->r.svFlags & SVF_BOT && ent2->playerState->pm_type == PM_SPECTATOR) {
-				SV_AddEntToSnapshot( svEnt, ent, eNums );
+				SV_AddEntToSnapshot( ent, eNums );
 				continue;
 			}
 		}
@@ -553,35 +1035,12 @@ static void SV_AddEntitiesVisibleFromPoint( vec3_t origin, clientSnapshot_t *fra
 			}
 		}
 
-		bitvector = clientpvs;
-
-		// check individual leafs
-		if ( !svEnt->numClusters ) {
-			continue;
-		}
-		l = 0;
-		for ( i=0 ; i < svEnt->numClusters ; i++ ) {
-			l = svEnt->clusternums[i];
-			if ( bitvector[l >> 3] & (1 << (l&7) ) ) {
-				break;
-			}
-		}
-
-		// if we haven't found it to be visible,
-		// check overflow clusters that coudln't be stored
-		if ( i == svEnt->numClusters ) {
-			if ( svEnt->lastCluster ) {
-				for ( ; l <= svEnt->lastCluster ; l++ ) {
-					if ( bitvector[l >> 3] & (1 << (l&7) ) ) {
-						break;
-					}
-				}
-				if ( l == svEnt->lastCluster ) {
-					continue;	// not visible
-				}
-			} else {
+		if ( useCandidates && !(flags & SNAPCAND_OVERFLOW_CLUSTERS) ) {
+			if ( !(visible[c >> 3] & (1 << (c&7))) ) {
 				continue;
 			}
+		} else if ( !SV_EntityInPVS( svEnt, clientpvs ) ) {
+			continue;
 		}
 
 		if (g_svCullDist != -1.0f)
@@ -601,7 +1060,7 @@ static void SV_AddEntitiesVisibleFromPoint( vec3_t origin, clientSnapshot_t *fra
 		}
 
 		// add it
-		SV_AddEntToSnapshot( svEnt, ent, eNums );
+		SV_AddEntToSnapshot( ent, eNums );
 
 		// if its a portal entity, add everything visible from its camera position
 		if ( ent->r.svFlags & SVF_PORTAL ) {
@@ -623,43 +1082,28 @@ static void SV_AddEntitiesVisibleFromPoint( vec3_t origin, clientSnapshot_t *fra
 
 /*
 =============
-SV_BuildClientSnapshot
-
-Decides which entities are going to be visible to the client, and
-copies off the playerstate and areabits.
+SV_BeginClientSnapshot
 
-This properly handles multiple recursive portals, but the render
-currently doesn't.
-
-For viewing through other player's eyes, client can be something other than client->gentity
+Clears the frame the next snapshot is built in and copies off the
+playerstate. Returns NULL if no entities should be added to it.
 =============
 */
-static void SV_BuildClientSnapshot( client_t *client ) {
-	vec3_t						org;
+static clientSnapshot_t *SV_BeginClientSnapshot( client_t *client ) {
 	clientSnapshot_t			*frame;
-	snapshotEntityNumbers_t		entityNumbers;
-	int							i;
-	sharedEntity_t				*ent;
-	entityState_t				*state;
-	svEntity_t					*svEnt;
 	sharedEntity_t				*clent;
 	playerState_t				*ps;
 
-	// bump the counter used to prevent double adding
-	sv.snapshotCounter++;
-
 	// this is the frame we are creating
 	frame = &client->frames[ client->netchan.outgoingSequence & PACKET_MASK ];
 
 	// clear everything in this snapshot
-	entityNumbers.numSnapshotEntities = 0;
 	Com_Memset( frame->areabits, 0, sizeof( frame->areabits ) );
 
 	frame->num_entities = 0;
 
 	clent = client->gentity;
 	if ( !clent || client->state == CS_ZOMBIE ) {
-		return;
+		return NULL;
 	}
 
 	// grab the current playerState_t
@@ -686,35 +1130,64 @@ static void SV_BuildClientSnapshot( client_t *client ) {
 		}
 	}
 
-	int							clientNum;
+	if ( frame->ps.clientNum < 0 || frame->ps.clientNum >= MAX_GENTITIES ) {
+		Com_Error( ERR_DROP, "SV_SvEntityForGentity: bad gEnt" );
+	}
+
+	return frame;
+}
+
+/*
+=============
+SV_AddClientViewEntities
+
+Fills eNums with the sorted numbers of the entities visible from the
+viewpoint of frame->ps. Only reads shared state, so this can run for
+several clients at once.
+=============
+*/
+static void SV_AddClientViewEntities( client_t *client, clientSnapshot_t *frame, snapshotEntityNumbers_t *eNums ) {
+	vec3_t			org;
+	int				clientNum;
+
 	// never send client's own entity, because it can
 	// be regenerated from the playerstate
 	clientNum = frame->ps.clientNum;
-	if ( clientNum < 0 || clientNum >= MAX_GENTITIES ) {
-		Com_Error( ERR_DROP, "SV_SvEntityForGentity: bad gEnt" );
-	}
-	svEnt = &sv.svEntities[ clientNum ];
-	svEnt->snapshotCounter = sv.snapshotCounter;
+	eNums->added[clientNum >> 3] |= 1 << (clientNum&7);
 
 
 	// find the client's viewpoint
-	VectorCopy( ps->origin, org );
-	org[2] += ps->viewheight;
+	VectorCopy( frame->ps.origin, org );
+	org[2] += frame->ps.viewheight;
 
 	// add all the entities directly visible to the eye, which
 	// may include portal entities that merge other viewpoints
 #ifndef DEDICATED
-	SV_AddEntitiesVisibleFromPoint( org, frame, &entityNumbers, qfalse );
+	SV_AddEntitiesVisibleFromPoint( org, frame, eNums, qfalse );
 #else
-	SV_AddEntitiesVisibleFromPoint( org, frame, &entityNumbers, qfalse, client->disableDuelCull );
+	SV_AddEntitiesVisibleFromPoint( org, frame, eNums, qfalse, client->disableDuelCull );
 #endif
 
 	// if there were portals visible, there may be out of order entities
 	// in the list which will need to be resorted for the delta compression
-	// to work correctly.  This also catches the error condition
-	// of an entity being included twice.
-	qsort( entityNumbers.snapshotEntities, entityNumbers.numSnapshotEntities,
-		sizeof( entityNumbers.snapshotEntities[0] ), SV_QsortEntityNumbers );
+	// to work correctly.  Entities can't be included twice, eNums->added
+	// takes care of that.
+	qsort( eNums->snapshotEntities, eNums->numSnapshotEntities,
+		sizeof( eNums->snapshotEntities[0] ), SV_QsortEntityNumbers );
+}
+
+/*
+=============
+SV_StoreClientSnapshot
+
+Finishes the areabits and copies the entity states out to
+svs.snapshotEntities
+=============
+*/
+static void SV_StoreClientSnapshot( client_t *client, clientSnapshot_t *frame, snapshotEntityNumbers_t *eNums ) {
+	int							i;
+	sharedEntity_t				*ent;
+	entityState_t				*state;
 
 	// now that all viewpoint's areabits have been OR'd together, invert
 	// all of them to make it a mask vector, which is what the renderer wants
@@ -725,8 +1198,8 @@ static void SV_BuildClientSnapshot( client_t *client ) {
 	// copy the entity states out
 	frame->num_entities = 0;
 	frame->first_entity = svs.nextSnapshotEntities;
-	for ( i = 0 ; i < entityNumbers.numSnapshotEntities ; i++ ) {
-		ent = SV_GentityNum(entityNumbers.snapshotEntities[i]);
+	for ( i = 0 ; i < eNums->numSnapshotEntities ; i++ ) {
+		ent = SV_GentityNum(eNums->snapshotEntities[i]);
 		state = &svs.snapshotEntities[svs.nextSnapshotEntities % svs.numSnapshotEntities];
 		*state = ent->s;
 #ifdef DEDICATED
@@ -743,6 +1216,33 @@ static void SV_BuildClientSnapshot( client_t *client ) {
 	}
 }
 
+/*
+=============
+SV_BuildClientSnapshot
+
+Decides which entities are going to be visible to the client, and
+copies off the playerstate and areabits.
+
+This properly handles multiple recursive portals, but the render
+currently doesn't.
+
+For viewing through other player's eyes, client can be something other than client->gentity
+=============
+*/
+static void SV_BuildClientSnapshot( client_t *client ) {
+	clientSnapshot_t			*frame;
+	snapshotEntityNumbers_t		entityNumbers;
+
+	frame = SV_BeginClientSnapshot( client );
+	if ( !frame ) {
+		return;
+	}
+
+	SV_ClearSnapshotEntityNumbers( &entityNumbers );
+	SV_AddClientViewEntities( client, frame, &entityNumbers );
+	SV_StoreClientSnapshot( client, frame, &entityNumbers );
+}
+
 
 /*
 ====================
@@ -816,39 +1316,16 @@ void SV_SendMessageToClient( msg_t *msg, client_t *client ) {
 #ifdef DEDICATED
 	if (sv_demoPreRecord->integer) { // If pre record demo message buffering is enabled, we write this message to the buffer.
 
-		// But first, Do a quick cleanup of possible old packages in the buffer that have msgNum > client->netchan.outgoingSequence
+		// But first, make sure nothing in the buffer is newer than this message.
 		// This shouldn't really happen as we clear the buffer on disconnects/connects and map_restarts but let's be safe.
-		demoPreRecordBufferIt lastEvilPackage;
-		qboolean evilPackagesFound = qfalse;
-		for (demoPreRecordBufferIt it = demoPreRecordBuffer[client - svs.clients].begin(); it != demoPreRecordBuffer[client - svs.clients].end(); it++) {
-			if (it->get()->msgNum > client->netchan.outgoingSequence || it->get()->time > sv.time) {
-				lastEvilPackage = it;
-				evilPackagesFound = qtrue;
-			}
-			else {
-				break;
-			}
-		}
-		if (evilPackagesFound) {
-			// The lastTooOldKeyframe itself won't be erased because .erase()'s second parameter is not inclusive, 
-			// aka it deletes up to that element, but not that element itself.
-			Com_Printf("Found evil old messages in demoPreRecordBuffer. This shouldn't happen.\n");
-			lastEvilPackage++; // .erase() function excludes the last element, but we want to delete the last evil package too.
-			demoPreRecordBuffer[client - svs.clients].erase(demoPreRecordBuffer[client - svs.clients].begin(), lastEvilPackage);
-		}
+		SV_PreRecordCheckNewest(client);
 
 		// Now put the current messsage in the buffer.
+		// In theory it might be a gamestate message, but we only call it a keyframe if we ourselves explicitly save a keyframe.
 		if(client->netchan.remoteAddress.type != NA_BOT || sv_demoPreRecordBots->integer){
-			std::unique_ptr<bufferedMessageContainer_t> bmtPtr(new bufferedMessageContainer_t(msg));
-			bufferedMessageContainer_t* bmt = bmtPtr.get();
-			//static bufferedMessageContainer_t bmt; // I make these static so they don't sit on the stack.
-			//Com_Memset(bmt, 0, sizeof(bufferedMessageContainer_t));
-			//MSG_ToBuffered(msg,&bmt->msg);
-			bmt->msgNum = client->netchan.outgoingSequence;
-			bmt->lastClientCommand = client->lastClientCommand;
-			bmt->time = sv.time;
-			bmt->isKeyframe = qfalse; // In theory it might be a gamestate message, but we only call it a keyframe if we ourselves explicitly save a keyframe.
-			demoPreRecordBuffer[client - svs.clients].push_back(std::move(bmtPtr));
+			if (!SV_PreRecordStore(client, msg, client->netchan.outgoingSequence, qfalse)) {
+				client->demo.preRecord.lastKeyframeTime = -(1000*sv_demoPreRecordKeyframeDistance->integer) * 2; // Ran out of room and lost the only keyframe, make a new one right away.
+			}
 		}
 	}
 
@@ -858,6 +1335,7 @@ void SV_SendMessageToClient( msg_t *msg, client_t *client ) {
 		MSG_WriteByte( &msgcopy, svc_EOF );
 		SV_WriteDemoMessage( client, &msgcopy, 0 );
 	}
+	client->demo.nonDeltaFrame = qfalse; // gamestate messages don't go through SV_SnapshotDeltaFrame
 
 	// Check for whether a new keyframe must be written in pre recording, and if so, do it.
 	if (sv_demoPreRecord->integer && (client->netchan.remoteAddress.type != NA_BOT || sv_demoPreRecordBots->integer)) {
@@ -867,7 +1345,6 @@ void SV_SendMessageToClient( msg_t *msg, client_t *client ) {
 			static byte keyframeBufData[MAX_MSGLEN]; // I make these static so they don't sit on the stack.
 			static msg_t		keyframeMsg;
 			Com_Memset(&keyframeMsg, 0, sizeof(msg_t));
-			//Com_Memset(bmt, 0, sizeof(bufferedMessageContainer_t));
 
 			MSG_Init(&keyframeMsg, keyframeBufData, sizeof(keyframeBufData));
 
@@ -875,14 +1352,8 @@ void SV_SendMessageToClient( msg_t *msg, client_t *client ) {
 			SV_CreateClientGameStateMessage(client, &keyframeMsg);
 			client->reliableSent = tmp;
 
-			//MSG_ToBuffered(&keyframeMsg, &bmt->msg);
-			std::unique_ptr<bufferedMessageContainer_t> bmtPtr(new bufferedMessageContainer_t(&keyframeMsg));
-			bufferedMessageContainer_t* bmt = bmtPtr.get();
-			bmt->msgNum = client->netchan.outgoingSequence; // Yes the keyframe duplicates the messagenum of a message. This is (part of) why we dump only one keyframe at the start of the demo and discard future keyframes
-			bmt->lastClientCommand = client->lastClientCommand;
-			bmt->time = sv.time;
-			bmt->isKeyframe = qtrue; // This is a keyframe (gamestate that will be followed by non-delta frames)
-			demoPreRecordBuffer[client - svs.clients].push_back(std::move(bmtPtr));
+			// Yes the keyframe duplicates the messagenum of a message. This is (part of) why we dump only one keyframe at the start of the demo and discard future keyframes
+			SV_PreRecordStore(client, &keyframeMsg, client->netchan.outgoingSequence, qtrue);
 			client->demo.preRecord.minDeltaFrame = 0;
 			client->demo.preRecord.keyframeWaiting = qtrue;
 			client->demo.preRecord.lastKeyframeTime = sv.time;
@@ -892,22 +1363,11 @@ void SV_SendMessageToClient( msg_t *msg, client_t *client ) {
 		// 
 		// The goal is to always maintain *at least* sv_demoPreRecordTime seconds of buffer. Rather more than less. 
 		// So we find the last keyframe that is older than sv_demoPreRecordTime seconds (or just that old) and then delete everything *before* it.
-		demoPreRecordBufferIt lastTooOldKeyframe;
-		qboolean lastTooOldKeyframeFound = qfalse;
-		for (demoPreRecordBufferIt it = demoPreRecordBuffer[client - svs.clients].begin(); it != demoPreRecordBuffer[client - svs.clients].end(); it++) {
-			if (it->get()->isKeyframe && (it->get()->time + (1000*sv_demoPreRecordTime->integer)) < sv.time) {
-				lastTooOldKeyframe = it;
-				lastTooOldKeyframeFound = qtrue;
-			}
-		}
-		if (lastTooOldKeyframeFound) {
-			// The lastTooOldKeyframe itself won't be erased because .erase()'s second parameter is not inclusive, 
-			// aka it deletes up to that element, but not that element itself.
-			demoPreRecordBuffer[client - svs.clients].erase(demoPreRecordBuffer[client - svs.clients].begin(), lastTooOldKeyframe);
-		}
+		SV_PreRecordTrim(client, 1000*sv_demoPreRecordTime->integer);
 	}
 	else { // Pre-recording disabled. Clear buffer to prevent unexpected behavior if it is turned back on.
 		SV_ClearClientDemoPreRecord(client);
+		SV_PreRecordFree(client);
 	}
 
 	// bots need to have their snapshots built, but
@@ -957,6 +1417,32 @@ void SV_SendMessageToClient( msg_t *msg, client_t *client ) {
 }
 
 
+#ifdef DEDICATED
+/*
+=======================
+SV_ShouldBeginAutoRecord
+
+Whether sending this client a snapshot starts the automatic demos
+=======================
+*/
+static qboolean SV_ShouldBeginAutoRecord( client_t *client ) {
+	if ( client->demo.demorecording ) { //dont think this needs to be done with singledemo option
+		return qfalse;
+	}
+	if (sv_autoDemo->integer == 2) {
+		if (client->netchan.remoteAddress.type == NA_BOT && !Q_stricmp(client->name, "RECORDER")) {
+			return qtrue;
+		}
+	}
+	else if (sv_autoDemo->integer == 1) {
+		if ( client->netchan.remoteAddress.type != NA_BOT || sv_autoDemoBots->integer ) {
+			return qtrue;
+		}
+	}
+	return qfalse;
+}
+#endif
+
 /*
 =======================
 SV_SendClientSnapshot
@@ -1016,17 +1502,8 @@ void SV_SendClientSnapshot( client_t *client ) {
 	SV_BuildClientSnapshot( client );
 
 #ifdef DEDICATED
-	if ( !client->demo.demorecording ) { //dont think this needs to be done with singledemo option
-		if (sv_autoDemo->integer == 2) {
-			if (client->netchan.remoteAddress.type == NA_BOT && !Q_stricmp(client->name, "RECORDER")) {
-				SV_BeginAutoRecordDemos();
-			}
-		}
-		else if (sv_autoDemo->integer == 1) {
-			if ( client->netchan.remoteAddress.type != NA_BOT || sv_autoDemoBots->integer ) {
-				SV_BeginAutoRecordDemos();
-			}
-		}
+	if ( SV_ShouldBeginAutoRecord( client ) ) {
+		SV_BeginAutoRecordDemos();
 	}
 #endif
 
@@ -1067,6 +1544,212 @@ void SV_SendClientSnapshot( client_t *client ) {
 }
 
 
+/*
+=============================================================================
+
+Parallel snapshots
+
+With sv_threads set, the entity selection and the encoding of every
+client's snapshot run on the job pool, each into its own message buffer.
+Everything that depends on the order clients are processed in (storing
+the entity states, picking the delta frame, demos and the actual sends)
+still happens on the main thread in client order, so the packets are the
+same as when building them one client at a time.
+
+=============================================================================
+*/
+
+typedef enum {
+	SNAPACTION_NONE,
+	SNAPACTION_FRAGMENT,		// send the next fragment of the last message
+	SNAPACTION_SNAPSHOT			// build and send a new snapshot
+} snapshotAction_t;
+
+typedef struct snapshotJob_s {
+	client_t				*client;
+	clientSnapshot_t		*frame;			// NULL if no entities are added
+	snapshotEntityNumbers_t	entityNumbers;
+	qboolean				transmit;		// bots only need their snapshots built
+	clientSnapshot_t		*oldframe;
+	int						lastframe;
+	int						msgWarnings;	// printed on the main thread afterwards
+	msg_t					msg;
+	byte					msgBuf[MAX_MSGLEN];
+} snapshotJob_t;
+
+static snapshotJob_t	snapshotJobs[MAX_CLIENTS];
+
+/*
+=======================
+SV_SnapshotEntitiesJob
+=======================
+*/
+static void SV_SnapshotEntitiesJob( int jobNum, void *data ) {
+	snapshotJob_t *job = &((snapshotJob_t *)data)[jobNum];
+
+	if ( job->frame ) {
+		SV_AddClientViewEntities( job->client, job->frame, &job->entityNumbers );
+	}
+}
+
+/*
+=======================
+SV_SnapshotEncodeJob
+=======================
+*/
+static void SV_SnapshotEncodeJob( int jobNum, void *data ) {
+	snapshotJob_t *job = &((snapshotJob_t *)data)[jobNum];
+
+	if ( !job->transmit ) {
+		return;
+	}
+
+	MSG_BeginJob();
+
+	// NOTE, MRE: all server->client messages now acknowledge
+	// let the client know which reliable clientCommands we have received
+	MSG_WriteLong( &job->msg, job->client->lastClientCommand );
+
+	// (re)send any reliable server commands
+	SV_UpdateServerCommandsToClient( job->client, &job->msg );
+
+	// send over all the relevant entityState_t
+	// and the playerState_t
+	SV_WriteSnapshotFrame( job->client, job->oldframe, job->lastframe, &job->msg );
+
+	job->msgWarnings = MSG_EndJob();
+}
+
+/*
+=======================
+SV_SendClientSnapshotsParallel
+
+Returns qfalse without doing anything if this frame has to be handled
+one client at a time.
+=======================
+*/
+static qboolean SV_SendClientSnapshotsParallel( void ) {
+	snapshotAction_t	actions[MAX_CLIENTS];
+	snapshotJob_t		*job;
+	int					i, numJobs;
+	client_t			*c;
+
+	if ( !SV_NumJobThreads() || !sv_snapshotVisCache->integer || sv.state != SS_GAME ) {
+		return qfalse;
+	}
+
+	numJobs = 0;
+	for ( i = 0, c = svs.clients ; i < sv_maxclients->integer ; i++, c++ ) {
+		actions[i] = SNAPACTION_NONE;
+
+		if ( !c->state || svs.time < c->nextSnapshotTime ) {
+			continue;
+		}
+		if ( c->netchan.unsentFragments ) {
+			actions[i] = SNAPACTION_FRAGMENT;
+			continue;
+		}
+
+		// the gamedir message and starting demos affect the other
+		// clients' packets, keep the usual order for those frames
+		if ( !c->sentGamedir ) {
+			return qfalse;
+		}
+#ifdef DEDICATED
+		if ( SV_ShouldBeginAutoRecord( c ) ) {
+			return qfalse;
+		}
+#endif
+
+		actions[i] = SNAPACTION_SNAPSHOT;
+		numJobs++;
+	}
+
+	if ( numJobs < 2 ) {
+		return qfalse;
+	}
+
+	SV_BuildSnapshotCandidates();
+
+	numJobs = 0;
+	for ( i = 0, c = svs.clients ; i < sv_maxclients->integer ; i++, c++ ) {
+		if ( actions[i] != SNAPACTION_SNAPSHOT ) {
+			continue;
+		}
+		job = &snapshotJobs[numJobs++];
+		job->client = c;
+		job->frame = SV_BeginClientSnapshot( c );
+		SV_ClearSnapshotEntityNumbers( &job->entityNumbers );
+	}
+
+	SV_RunJobs( numJobs, SV_SnapshotEntitiesJob, snapshotJobs );
+
+	for ( i = 0, job = snapshotJobs ; i < numJobs ; i++, job++ ) {
+		if ( job->frame ) {
+			SV_StoreClientSnapshot( job->client, job->frame, &job->entityNumbers );
+		}
+	}
+
+	// only once every frame is stored, the later stores can push an old
+	// frame's entities off svs.snapshotEntities
+	for ( i = 0, job = snapshotJobs ; i < numJobs ; i++, job++ ) {
+		c = job->client;
+
+		// bots need to have their snapshots built, but
+		// they query them directly without needing to be sent
+		job->transmit = (qboolean)( c->netchan.remoteAddress.type != NA_BOT
+#ifdef DEDICATED
+			|| c->demo.demorecording
+#endif
+			);
+		if ( !job->transmit ) {
+			continue;
+		}
+
+		job->oldframe = SV_SnapshotDeltaFrame( c, &job->lastframe );
+		MSG_Init( &job->msg, job->msgBuf, sizeof( job->msgBuf ) );
+		job->msg.allowoverflow = qtrue;
+	}
+
+	SV_RunJobs( numJobs, SV_SnapshotEncodeJob, snapshotJobs );
+
+	job = snapshotJobs;
+	for ( i = 0, c = svs.clients ; i < sv_maxclients->integer ; i++, c++ ) {
+		if ( actions[i] == SNAPACTION_FRAGMENT ) {
+			// send additional message fragments if the last message
+			// was too large to send at once
+			c->nextSnapshotTime = svs.time +
+				SV_RateMsec( c, c->netchan.unsentLength - c->netchan.unsentFragmentStart );
+			SV_Netchan_TransmitNextFragment( &c->netchan );
+			continue;
+		}
+		if ( actions[i] != SNAPACTION_SNAPSHOT ) {
+			continue;
+		}
+
+		if ( job->transmit ) {
+			if ( job->msgWarnings ) {
+				Com_Printf( "WARNING: %i oversized strings left out of the snapshot for %s\n", job->msgWarnings, c->name );
+			}
+
+			// Add any download data if the client is downloading
+			SV_WriteDownloadToClient( c, &job->msg );
+
+			// check for overflow
+			if ( job->msg.overflowed ) {
+				Com_Printf ("WARNING: msg overflowed for %s\n", c->name);
+				MSG_Clear (&job->msg);
+			}
+
+			SV_SendMessageToClient( &job->msg, c );
+		}
+		job++;
+	}
+
+	SV_InvalidateSnapshotCandidates();
+	return qtrue;
+}
+
 /*
 =======================
 SV_SendClientMessages
@@ -1075,6 +1758,17 @@ SV_SendClientMessages
 void SV_SendClientMessages( void ) {
 	int			i;
 	client_t	*c;
+	qboolean	candidatesBuilt = qfalse;
+
+	SV_DeltaCacheNewFrame();
+
+	// the snapshots of all clients leave in as few syscalls as possible
+	NET_BeginPacketBatch();
+
+	if ( SV_SendClientSnapshotsParallel() ) {
+		NET_FlushPacketBatch();
+		return;
+	}
 
 	// send a message to each connected client
 	for (i=0, c = svs.clients ; i < sv_maxclients->integer ; i++, c++) {
@@ -1095,8 +1789,97 @@ void SV_SendClientMessages( void ) {
 			continue;
 		}
 
+		// the entities every snapshot picks from are the same for all clients
+		if ( !candidatesBuilt && sv_snapshotVisCache->integer ) {
+			SV_BuildSnapshotCandidates();
+			candidatesBuilt = qtrue;
+		}
+
 		// generate and send a new message
 		SV_SendClientSnapshot( c );
 	}
+
+	SV_InvalidateSnapshotCandidates();
+	NET_FlushPacketBatch();
+}
+
+/*
+=======================
+SV_SnapshotBench_f
+
+Times the snapshot entity selection of all active clients with the full
+entity scan and with the per-frame candidate list, and checks that both
+pick exactly the same entities.
+=======================
+*/
+void SV_SnapshotBench_f( void ) {
+	static clientSnapshot_t			frame;
+	static snapshotEntityNumbers_t	reference[MAX_CLIENTS];
+	static snapshotEntityNumbers_t	entityNumbers;
+	int			iterations, mode, iter, i;
+	int			msec[2];
+	int			numClients = 0, mismatches = 0;
+	client_t	*cl;
+
+	if ( !com_sv_running->integer || sv.state != SS_GAME ) {
+		Com_Printf( "Server is not running.\n" );
+		return;
+	}
+
+	iterations = Cmd_Argc() > 1 ? atoi( Cmd_Argv( 1 ) ) : 100;
+	if ( iterations < 1 ) {
+		iterations = 1;
+	}
+
+	for ( mode = 0 ; mode < 2 ; mode++ ) {
+		int start = Sys_Milliseconds();
+
+		for ( iter = 0 ; iter < iterations ; iter++ ) {
+			if ( mode ) {
+				// count the per-frame cost as well
+				SV_BuildSnapshotCandidates();
+			} else {
+				SV_InvalidateSnapshotCandidates();
+			}
+
+			numClients = 0;
+			for ( i = 0, cl = svs.clients ; i < sv_maxclients->integer ; i++, cl++ ) {
+				if ( cl->state != CS_ACTIVE || !cl->gentity ) {
+					continue;
+				}
+				frame.ps = *SV_GameClientNum( i );
+				if ( frame.ps.clientNum < 0 || frame.ps.clientNum >= MAX_GENTITIES ) {
+					continue;
+				}
+				numClients++;
+
+				SV_ClearSnapshotEntityNumbers( &entityNumbers );
+				SV_AddClientViewEntities( cl, &frame, &entityNumbers );
+
+				if ( iter ) {
+					continue;
+				}
+				if ( !mode ) {
+					reference[i] = entityNumbers;
+				} else if ( reference[i].numSnapshotEntities != entityNumbers.numSnapshotEntities
+					|| memcmp( reference[i].snapshotEntities, entityNumbers.snapshotEntities,
+						entityNumbers.numSnapshotEntities * sizeof( entityNumbers.snapshotEntities[0] ) ) ) {
+					mismatches++;
+				}
+			}
+		}
+
+		msec[mode] = Sys_Milliseconds() - start;
+	}
+
+	Com_Printf( "%i clients, %i iterations, %i candidates in %i clusters\n",
+		numClients, iterations, snapCandidates.numCandidates, snapCandidates.numClusterRuns );
+	Com_Printf( "full scan: %i msec (%.3f msec/frame)\n", msec[0], (float)msec[0] / iterations );
+	Com_Printf( "candidates: %i msec (%.3f msec/frame)\n", msec[1], (float)msec[1] / iterations );
+	if ( mismatches ) {
+		Com_Printf( S_COLOR_RED "%i clients got a different entity selection!\n", mismatches );
+	}
+
+	SV_InvalidateSnapshotCandidates();
 }
 
@@ -100,6 +100,205 @@ void SV_SectorList_f( void ) {
 	}
 }
 
+/*
+===============================================================================
+
+LOOSE GRID
+
+Alternative to the sector tree, selected with sv_broadphase 1. The world
+is split into square cells on x and y and every entity is kept in the
+cell its center is in. As an entity may not be wider than a cell, it never
+reaches further than half a cell outside of it, so a query only has to
+look at the cells around its box. Entities that are too large for that go
+into a separate list that is always checked.
+
+Unlike the tree, entities that straddle a split don't collect in a few
+nodes, which keeps the lists short on big maps full of NPCs and missiles.
+Both structures are always kept up to date so sv_broadphase can be
+changed at any time.
+
+===============================================================================
+*/
+
+#define	AREAGRID_MAX_CELLS		64		// per axis
+#define	AREAGRID_MIN_CELL_SIZE	128
+#define	AREAGRID_OVERSIZED		(AREAGRID_MAX_CELLS*AREAGRID_MAX_CELLS)
+
+typedef struct areaGrid_s {
+	vec2_t	origin;
+	float	cellSize;
+	int		size[2];
+
+	int		cells[AREAGRID_OVERSIZED+1];	// first item in each cell, -1 if empty
+	int		cellOf[MAX_GENTITIES];			// -1 if not linked
+	int		next[MAX_GENTITIES];
+	int		prev[MAX_GENTITIES];
+
+	// copied at link time so queries don't have to touch the entities
+	vec3_t	absmin[MAX_GENTITIES];
+	vec3_t	absmax[MAX_GENTITIES];
+} areaGrid_t;
+
+static areaGrid_t	sv_areaGrid;
+
+/*
+===============
+SV_GridClear
+
+Sets up an empty grid covering the given bounds
+===============
+*/
+static void SV_GridClear( areaGrid_t *grid, const vec3_t mins, const vec3_t maxs ) {
+	float	size;
+	int		i;
+
+	size = Q_max( maxs[0] - mins[0], maxs[1] - mins[1] );
+	grid->cellSize = Q_max( (float)AREAGRID_MIN_CELL_SIZE, ceilf( size / AREAGRID_MAX_CELLS ) );
+
+	for ( i = 0 ; i < 2 ; i++ ) {
+		grid->origin[i] = mins[i];
+		grid->size[i] = (int)ceilf( ( maxs[i] - mins[i] ) / grid->cellSize );
+		grid->size[i] = Com_Clampi( 1, AREAGRID_MAX_CELLS, grid->size[i] );
+	}
+
+	for ( i = 0 ; i <= AREAGRID_OVERSIZED ; i++ ) {
+		grid->cells[i] = -1;
+	}
+	for ( i = 0 ; i < MAX_GENTITIES ; i++ ) {
+		grid->cellOf[i] = -1;
+	}
+}
+
+/*
+===============
+SV_GridCellCoord
+
+Cell column or row of a coordinate, positions outside of the grid go to
+the border cells.
+===============
+*/
+static int SV_GridCellCoord( const areaGrid_t *grid, int axis, float v ) {
+	v = ( v - grid->origin[axis] ) / grid->cellSize;
+	if ( v <= 0 ) {
+		return 0;
+	}
+	if ( v >= grid->size[axis] - 1 ) {
+		return grid->size[axis] - 1;
+	}
+	return (int)v;
+}
+
+/*
+===============
+SV_GridUnlink
+===============
+*/
+static void SV_GridUnlink( areaGrid_t *grid, int num ) {
+	int		cell;
+
+	cell = grid->cellOf[num];
+	if ( cell == -1 ) {
+		return;
+	}
+	grid->cellOf[num] = -1;
+
+	if ( grid->prev[num] == -1 ) {
+		grid->cells[cell] = grid->next[num];
+	} else {
+		grid->next[grid->prev[num]] = grid->next[num];
+	}
+	if ( grid->next[num] != -1 ) {
+		grid->prev[grid->next[num]] = grid->prev[num];
+	}
+}
+
+/*
+===============
+SV_GridLink
+===============
+*/
+static void SV_GridLink( areaGrid_t *grid, int num, const vec3_t absmin, const vec3_t absmax ) {
+	int		cell;
+
+	SV_GridUnlink( grid, num );
+
+	VectorCopy( absmin, grid->absmin[num] );
+	VectorCopy( absmax, grid->absmax[num] );
+
+	if ( absmax[0] - absmin[0] > grid->cellSize || absmax[1] - absmin[1] > grid->cellSize ) {
+		cell = AREAGRID_OVERSIZED;
+	} else {
+		cell = SV_GridCellCoord( grid, 1, 0.5f * ( absmin[1] + absmax[1] ) ) * AREAGRID_MAX_CELLS
+			+ SV_GridCellCoord( grid, 0, 0.5f * ( absmin[0] + absmax[0] ) );
+	}
+
+	grid->cellOf[num] = cell;
+	grid->prev[num] = -1;
+	grid->next[num] = grid->cells[cell];
+	if ( grid->next[num] != -1 ) {
+		grid->prev[grid->next[num]] = num;
+	}
+	grid->cells[cell] = num;
+}
+
+/*
+===============
+SV_GridCellEntities
+===============
+*/
+static int SV_GridCellEntities( const areaGrid_t *grid, int cell, const float *mins, const float *maxs,
+	int *list, int count, int maxcount ) {
+	int		num;
+
+	for ( num = grid->cells[cell] ; num != -1 ; num = grid->next[num] ) {
+		if ( grid->absmin[num][0] > maxs[0]
+		|| grid->absmin[num][1] > maxs[1]
+		|| grid->absmin[num][2] > maxs[2]
+		|| grid->absmax[num][0] < mins[0]
+		|| grid->absmax[num][1] < mins[1]
+		|| grid->absmax[num][2] < mins[2]) {
+			continue;
+		}
+
+		if ( count == maxcount ) {
+			Com_DPrintf ("SV_AreaEntities: MAXCOUNT\n");
+			return -1;
+		}
+
+		list[count++] = num;
+	}
+
+	return count;
+}
+
+/*
+===============
+SV_GridAreaEntities
+===============
+*/
+static int SV_GridAreaEntities( const areaGrid_t *grid, const float *mins, const float *maxs,
+	int *list, int maxcount ) {
+	float	loose;
+	int		x, y, x0, y0, x1, y1;
+	int		count;
+
+	// entities stick out of their cell by up to half a cell
+	loose = 0.5f * grid->cellSize;
+	x0 = SV_GridCellCoord( grid, 0, mins[0] - loose );
+	x1 = SV_GridCellCoord( grid, 0, maxs[0] + loose );
+	y0 = SV_GridCellCoord( grid, 1, mins[1] - loose );
+	y1 = SV_GridCellCoord( grid, 1, maxs[1] + loose );
+
+	count = SV_GridCellEntities( grid, AREAGRID_OVERSIZED, mins, maxs, list, 0, maxcount );
+	for ( y = y0 ; y <= y1 && count != -1 ; y++ ) {
+		for ( x = x0 ; x <= x1 && count != -1 ; x++ ) {
+			count = SV_GridCellEntities( grid, y * AREAGRID_MAX_CELLS + x, mins, maxs, list, count, maxcount );
+		}
+	}
+
+	return count == -1 ? maxcount : count;
+}
+
 /*
 ===============
 SV_CreateworldSector
@@ -159,6 +358,8 @@ void SV_ClearWorld( void ) {
 	h = CM_InlineModel( 0 );
 	CM_ModelBounds( h, mins, maxs );
 	SV_CreateworldSector( 0, mins, maxs );
+
+	SV_GridClear( &sv_areaGrid, mins, maxs );
 }
 
 
@@ -177,6 +378,8 @@ void SV_UnlinkEntity( sharedEntity_t *gEnt ) {
 
 	gEnt->r.linked = qfalse;
 
+	SV_GridUnlink( &sv_areaGrid, ent - sv.svEntities );
+
 	ws = ent->worldSector;
 	if ( !ws ) {
 		return;		// not linked in anywhere
@@ -362,6 +565,8 @@ void SV_LinkEntity( sharedEntity_t *gEnt ) {
 	ent->nextEntityInWorldSector = node->entities;
 	node->entities = ent;
 
+	SV_GridLink( &sv_areaGrid, ent - sv.svEntities, gEnt->r.absmin, gEnt->r.absmax );
+
 	gEnt->r.linked = qtrue;
 }
 
@@ -429,6 +634,264 @@ void SV_AreaEntities_r( worldSector_t *node, areaParms_t *ap ) {
 	}
 }
 
+/*
+================
+SV_BroadphaseInfo_f
+
+Summary of how the linked entities are spread over the sector tree and
+the loose grid
+================
+*/
+void SV_BroadphaseInfo_f( void ) {
+	const areaGrid_t	*grid = &sv_areaGrid;
+	worldSector_t		*sec;
+	svEntity_t			*ent;
+	int					i, c, num;
+	int					linked, inNodes, maxChain;
+	int					occupied, oversized;
+
+	Com_Printf( "sv_broadphase %i (%s)\n", sv_broadphase->integer, sv_broadphase->integer ? "loose grid" : "sector tree" );
+
+	linked = inNodes = maxChain = 0;
+	for ( i = 0 ; i < sv_numworldSectors ; i++ ) {
+		sec = &sv_worldSectors[i];
+
+		c = 0;
+		for ( ent = sec->entities ; ent ; ent = ent->nextEntityInWorldSector ) {
+			c++;
+		}
+		linked += c;
+		if ( sec->axis != -1 ) {
+			inNodes += c;
+		}
+		maxChain = Q_max( maxChain, c );
+	}
+	Com_Printf( "sector tree: %i sectors, %i entities, %i above the leafs, longest list %i\n",
+		sv_numworldSectors, linked, inNodes, maxChain );
+
+	occupied = maxChain = 0;
+	linked = 0;
+	for ( i = 0 ; i < AREAGRID_OVERSIZED ; i++ ) {
+		c = 0;
+		for ( num = grid->cells[i] ; num != -1 ; num = grid->next[num] ) {
+			c++;
+		}
+		if ( c ) {
+			occupied++;
+		}
+		linked += c;
+		maxChain = Q_max( maxChain, c );
+	}
+	oversized = 0;
+	for ( num = grid->cells[AREAGRID_OVERSIZED] ; num != -1 ; num = grid->next[num] ) {
+		oversized++;
+	}
+	Com_Printf( "loose grid: %ix%i cells of %.0f units, %i entities in %i cells, longest list %i, %i oversized\n",
+		grid->size[0], grid->size[1], grid->cellSize, linked, occupied, maxChain, oversized );
+}
+
+/*
+================
+SV_BroadphaseBench_f
+
+broadphasebench [iterations]
+broadphasebench save <name>
+broadphasebench load <name> [iterations]
+
+Times an SV_AreaEntities query around every linked entity. With "save"
+the current entity bounds are written to a file, so the same layout can
+be replayed with "load" later on, even without a map running. A replayed
+layout is put into a grid of its own and compared to checking every box,
+as the sector tree only works on the real entities.
+================
+*/
+#define BROADPHASE_LAYOUT_IDENT		(('L'<<24)+('P'<<16)+('B'<<8)+'S')
+#define BROADPHASE_LAYOUT_VERSION	1
+#define BROADPHASE_QUERY_RANGE		64		// roughly what a player move covers
+
+typedef struct broadphaseLayout_s {
+	int		ident;
+	int		version;
+	vec3_t	worldMins, worldMaxs;
+	int		numEntities;
+	struct {
+		int		number;
+		vec3_t	absmin, absmax;
+	} entities[MAX_GENTITIES];
+} broadphaseLayout_t;
+
+static int QDECL SV_QsortEntityNums( const void *a, const void *b ) {
+	return *(const int *)a - *(const int *)b;
+}
+
+typedef enum {
+	BENCH_EVERY_BOX,
+	BENCH_SECTOR_TREE,
+	BENCH_LOOSE_GRID
+} broadphaseBench_t;
+
+/*
+================
+SV_BenchQueries
+
+Returns the msec taken, the sorted results of the first iteration are
+summed up in checksum so the different methods can be compared.
+================
+*/
+static int SV_BenchQueries( const broadphaseLayout_t *layout, const areaGrid_t *grid, broadphaseBench_t mode,
+	int iterations, unsigned int *checksum ) {
+	int			list[MAX_GENTITIES];
+	int			i, j, iter, count, start;
+	vec3_t		mins, maxs, range;
+	areaParms_t	ap;
+
+	VectorSet( range, BROADPHASE_QUERY_RANGE, BROADPHASE_QUERY_RANGE, BROADPHASE_QUERY_RANGE );
+
+	*checksum = 0;
+	start = Sys_Milliseconds();
+	for ( iter = 0 ; iter < iterations ; iter++ ) {
+		for ( i = 0 ; i < layout->numEntities ; i++ ) {
+			VectorSubtract( layout->entities[i].absmin, range, mins );
+			VectorAdd( layout->entities[i].absmax, range, maxs );
+
+			switch ( mode ) {
+			case BENCH_EVERY_BOX:
+				count = 0;
+				for ( j = 0 ; j < layout->numEntities ; j++ ) {
+					if ( layout->entities[j].absmin[0] > maxs[0]
+					|| layout->entities[j].absmin[1] > maxs[1]
+					|| layout->entities[j].absmin[2] > maxs[2]
+					|| layout->entities[j].absmax[0] < mins[0]
+					|| layout->entities[j].absmax[1] < mins[1]
+					|| layout->entities[j].absmax[2] < mins[2] ) {
+						continue;
+					}
+					list[count++] = layout->entities[j].number;
+				}
+				break;
+			case BENCH_SECTOR_TREE:
+				ap.mins = mins;
+				ap.maxs = maxs;
+				ap.list = list;
+				ap.count = 0;
+				ap.maxcount = MAX_GENTITIES;
+				SV_AreaEntities_r( sv_worldSectors, &ap );
+				count = ap.count;
+				break;
+			default:
+				count = SV_GridAreaEntities( grid, mins, maxs, list, MAX_GENTITIES );
+				break;
+			}
+
+			if ( !iter ) {
+				// the order differs between the methods
+				qsort( list, count, sizeof( list[0] ), SV_QsortEntityNums );
+				for ( j = 0 ; j < count ; j++ ) {
+					*checksum = *checksum * 31 + list[j];
+				}
+				*checksum = *checksum * 31 + count;
+			}
+		}
+	}
+	return Sys_Milliseconds() - start;
+}
+
+void SV_BroadphaseBench_f( void ) {
+	static broadphaseLayout_t	layout;
+	static areaGrid_t			replayGrid;
+	static const char			*names[] = { "every box", "sector tree", "loose grid" };
+	broadphaseLayout_t	*loaded;
+	const areaGrid_t	*grid;
+	char				filename[MAX_QPATH];
+	int					iterations, i, len, msec;
+	unsigned int		checksum, reference = 0;
+	sharedEntity_t		*gEnt;
+	clipHandle_t		h;
+	int					argBase = 1;
+	qboolean			replay = qfalse;
+
+	if ( Cmd_Argc() > 2 && ( !Q_stricmp( Cmd_Argv( 1 ), "save" ) || !Q_stricmp( Cmd_Argv( 1 ), "load" ) ) ) {
+		Q_strncpyz( filename, Cmd_Argv( 2 ), sizeof( filename ) );
+		COM_DefaultExtension( filename, sizeof( filename ), ".bpl" );
+		replay = (qboolean)!Q_stricmp( Cmd_Argv( 1 ), "load" );
+		argBase = 3;
+	}
+
+	if ( replay ) {
+		len = FS_ReadFile( filename, (void **)&loaded );
+		if ( len < 0 ) {
+			Com_Printf( "Couldn't load %s\n", filename );
+			return;
+		}
+		if ( len != sizeof( layout ) || loaded->ident != BROADPHASE_LAYOUT_IDENT
+			|| loaded->version != BROADPHASE_LAYOUT_VERSION
+			|| loaded->numEntities < 0 || loaded->numEntities > MAX_GENTITIES ) {
+			Com_Printf( "%s is not a valid entity layout\n", filename );
+			FS_FreeFile( loaded );
+			return;
+		}
+		layout = *loaded;
+		FS_FreeFile( loaded );
+
+		SV_GridClear( &replayGrid, layout.worldMins, layout.worldMaxs );
+		for ( i = 0 ; i < layout.numEntities ; i++ ) {
+			if ( layout.entities[i].number < 0 || layout.entities[i].number >= MAX_GENTITIES ) {
+				Com_Printf( "%s is not a valid entity layout\n", filename );
+				return;
+			}
+			SV_GridLink( &replayGrid, layout.entities[i].number, layout.entities[i].absmin, layout.entities[i].absmax );
+		}
+		grid = &replayGrid;
+	} else {
+		if ( !com_sv_running->integer || sv.state != SS_GAME ) {
+			Com_Printf( "Server is not running.\n" );
+			return;
+		}
+
+		layout.ident = BROADPHASE_LAYOUT_IDENT;
+		layout.version = BROADPHASE_LAYOUT_VERSION;
+		h = CM_InlineModel( 0 );
+		CM_ModelBounds( h, layout.worldMins, layout.worldMaxs );
+		layout.numEntities = 0;
+		for ( i = 0 ; i < sv.num_entities ; i++ ) {
+			gEnt = SV_GentityNum( i );
+			if ( !gEnt->r.linked ) {
+				continue;
+			}
+			layout.entities[layout.numEntities].number = i;
+			VectorCopy( gEnt->r.absmin, layout.entities[layout.numEntities].absmin );
+			VectorCopy( gEnt->r.absmax, layout.entities[layout.numEntities].absmax );
+			layout.numEntities++;
+		}
+
+		if ( argBase == 3 ) {
+			FS_WriteFile( filename, &layout, sizeof( layout ) );
+			Com_Printf( "Wrote %i entities to %s\n", layout.numEntities, filename );
+			return;
+		}
+		grid = &sv_areaGrid;
+	}
+
+	iterations = Cmd_Argc() > argBase ? atoi( Cmd_Argv( argBase ) ) : 100;
+	if ( iterations < 1 ) {
+		iterations = 1;
+	}
+
+	Com_Printf( "%i entities, %i iterations\n", layout.numEntities, iterations );
+	for ( i = BENCH_EVERY_BOX ; i <= BENCH_LOOSE_GRID ; i++ ) {
+		if ( i == BENCH_SECTOR_TREE && replay ) {
+			continue;		// only has the real entities
+		}
+		msec = SV_BenchQueries( &layout, grid, (broadphaseBench_t)i, iterations, &checksum );
+		Com_Printf( "%s: %i msec (%.3f msec/iteration)\n", names[i], msec, (float)msec / iterations );
+		if ( i == BENCH_EVERY_BOX ) {
+			reference = checksum;
+		} else if ( checksum != reference ) {
+			Com_Printf( S_COLOR_RED "%s returned different entities!\n", names[i] );
+		}
+	}
+}
+
 /*
 ================
 SV_AreaEntities
@@ -443,6 +906,10 @@ int SV_AreaEntities( const vec3_t mins, const vec3_t maxs, int *entityList, int
 	ap.count = 0;
 	ap.maxcount = maxcount;
 
+	if ( sv_broadphase->integer ) {
+		return SV_GridAreaEntities( &sv_areaGrid, mins, maxs, entityList, maxcount );
+	}
+
 	SV_AreaEntities_r( sv_worldSectors, &ap );
 
 	return ap.count;
@@ -810,33 +1277,18 @@ Ghoul2 Insert End
 
 /*
 ==================
-SV_Trace
+SV_ClipTraceToEntities
 
-Moves the given mins/maxs volume through the world from start to end.
-passEntityNum and entities owned by passEntityNum are explicitly not checked.
+Finishes a trace that has already been clipped to the world
 ==================
 */
-/*
-Ghoul2 Insert Start
-*/
-void SV_Trace( trace_t *results, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end, int passEntityNum, int contentmask, int capsule, int traceFlags, int useLod ) {
-/*
-Ghoul2 Insert End
-*/
+static void SV_ClipTraceToEntities( trace_t *results, const trace_t *world, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end, int passEntityNum, int contentmask, int capsule, int traceFlags, int useLod ) {
 	moveclip_t	clip;
 	int			i;
 
-	if ( !mins ) {
-		mins = vec3_origin;
-	}
-	if ( !maxs ) {
-		maxs = vec3_origin;
-	}
-
 	Com_Memset ( &clip, 0, sizeof ( moveclip_t ) );
 
-	// clip to world
-	CM_BoxTrace( &clip.trace, start, end, mins, maxs, 0, contentmask, capsule );
+	clip.trace = *world;
 	clip.trace.entityNum = clip.trace.fraction != 1.0 ? ENTITYNUM_WORLD : ENTITYNUM_NONE;
 	if ( clip.trace.fraction == 0 ) {
 		*results = clip.trace;
@@ -880,6 +1332,231 @@ Ghoul2 Insert End
 	*results = clip.trace;
 }
 
+/*
+==================
+SV_Trace
+
+Moves the given mins/maxs volume through the world from start to end.
+passEntityNum and entities owned by passEntityNum are explicitly not checked.
+==================
+*/
+/*
+Ghoul2 Insert Start
+*/
+void SV_Trace( trace_t *results, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end, int passEntityNum, int contentmask, int capsule, int traceFlags, int useLod ) {
+/*
+Ghoul2 Insert End
+*/
+	trace_t		world;
+
+	if ( !mins ) {
+		mins = vec3_origin;
+	}
+	if ( !maxs ) {
+		maxs = vec3_origin;
+	}
+
+	// clip to world
+	CM_BoxTrace( &world, start, end, mins, maxs, 0, contentmask, capsule );
+	SV_ClipTraceToEntities( results, &world, start, mins, maxs, end, passEntityNum, contentmask, capsule, traceFlags, useLod );
+}
+
+/*
+==================
+SV_TraceBatchJob
+
+The world part of one slice of a large trace batch, with a trace context
+of its own so slices can run at the same time
+==================
+*/
+#define TRACE_JOB_RAYS		64
+#define MAX_TRACE_JOBS		64
+
+typedef struct traceBatchJobs_s {
+	trace_t					*results;
+	const traceRequest_t	*requests;
+	int						numRequests;
+	int						numJobs;
+	int						capsule;
+} traceBatchJobs_t;
+
+static traceContext_t	*sv_traceJobContexts[MAX_TRACE_JOBS];
+
+static void SV_TraceBatchJob( int jobNum, void *data ) {
+	traceBatchJobs_t	*jobs = (traceBatchJobs_t *)data;
+	int					first = jobs->numRequests * jobNum / jobs->numJobs;
+	int					last = jobs->numRequests * ( jobNum + 1 ) / jobs->numJobs;
+
+	CM_BoxTraceBatchCtx( sv_traceJobContexts[jobNum], jobs->results + first, jobs->requests + first, last - first, jobs->capsule );
+}
+
+/*
+==================
+SV_TraceBatch
+
+The same as an SV_Trace for each request, but the world part of all of
+them is done in one walk of the BSP tree.  Meant for the many short
+visibility traces of waypoint and path building.
+
+Large batches have their world part split over the sv_threads workers.
+Every ray gets the same result whichever slice it is traced in.
+==================
+*/
+void SV_TraceBatch( trace_t *results, const traceRequest_t *requests, int numRequests, int capsule, int traceFlags, int useLod ) {
+	const traceRequest_t	*req;
+	traceBatchJobs_t		jobs;
+	int			i;
+
+	if ( numRequests <= 0 ) {
+		return;
+	}
+
+	// clip to world
+	jobs.numJobs = 0;
+	if ( numRequests >= 2 * TRACE_JOB_RAYS && SV_NumJobThreads() ) {
+		jobs.numJobs = Q_min( numRequests / TRACE_JOB_RAYS, 2 * ( SV_NumJobThreads() + 1 ) );
+		jobs.numJobs = Q_min( jobs.numJobs, MAX_TRACE_JOBS );
+	}
+
+	if ( jobs.numJobs > 1 ) {
+		for ( i = 0 ; i < jobs.numJobs ; i++ ) {
+			if ( !sv_traceJobContexts[i] ) {
+				sv_traceJobContexts[i] = CM_AllocTraceContext();
+			}
+		}
+		jobs.results = results;
+		jobs.requests = requests;
+		jobs.numRequests = numRequests;
+		jobs.capsule = capsule;
+		SV_RunJobs( jobs.numJobs, SV_TraceBatchJob, &jobs );
+	} else {
+		CM_BoxTraceBatch( results, requests, numRequests, capsule );
+	}
+
+	for ( i = 0 ; i < numRequests ; i++ ) {
+		req = &requests[i];
+		SV_ClipTraceToEntities( &results[i], &results[i], req->start, req->mins, req->maxs, req->end, req->passEntityNum, req->contentmask, capsule, traceFlags, useLod );
+	}
+}
+
+/*
+================
+SV_TraceBench_f
+
+tracebench [rays] [fan]
+
+Times the same rays traced one at a time and as batches. The rays come in
+fans of nearby directions from one origin, like the shots of a spread
+weapon or the visibility checks of a waypoint, half of them as points and
+half with a player sized box.
+================
+*/
+#define TRACEBENCH_LENGTH	2048
+
+static int SV_BenchTraces( trace_t *results, const traceRequest_t *requests, int numRays, int fan, qboolean world, qboolean batched ) {
+	const traceRequest_t	*req;
+	int		i, j, n, start;
+
+	start = Sys_Milliseconds();
+	for ( i = 0 ; i < numRays ; i += fan ) {
+		n = Q_min( fan, numRays - i );
+		if ( batched ) {
+			if ( world ) {
+				CM_BoxTraceBatch( results + i, requests + i, n, qfalse );
+			} else {
+				SV_TraceBatch( results + i, requests + i, n, qfalse, 0, 0 );
+			}
+			continue;
+		}
+		for ( j = i ; j < i + n ; j++ ) {
+			req = &requests[j];
+			if ( world ) {
+				CM_BoxTrace( &results[j], req->start, req->end, req->mins, req->maxs, 0, req->contentmask, qfalse );
+			} else {
+				SV_Trace( &results[j], req->start, req->mins, req->maxs, req->end, req->passEntityNum, req->contentmask, qfalse, 0, 0 );
+			}
+		}
+	}
+	return Sys_Milliseconds() - start;
+}
+
+void SV_TraceBench_f( void ) {
+	static const char	*names[] = { "world", "world + entities" };
+	traceRequest_t	*requests, *req;
+	trace_t			*single, *batched;
+	vec3_t			worldMins, worldMaxs, origin, dir, spread;
+	int				numRays, fan, i, j, pass, mismatches;
+	int				singleMsec, batchMsec;
+
+	if ( !com_sv_running->integer || sv.state != SS_GAME ) {
+		Com_Printf( "Server is not running.\n" );
+		return;
+	}
+
+	numRays = Cmd_Argc() > 1 ? atoi( Cmd_Argv( 1 ) ) : 100000;
+	fan = Cmd_Argc() > 2 ? atoi( Cmd_Argv( 2 ) ) : 32;
+	numRays = Q_max( numRays, 1 );
+	fan = Q_max( fan, 1 );
+
+	requests = (traceRequest_t *)Z_Malloc( numRays * sizeof( *requests ), TAG_TEMP_WORKSPACE, qtrue );
+	single = (trace_t *)Z_Malloc( numRays * sizeof( *single ), TAG_TEMP_WORKSPACE, qtrue );
+	batched = (trace_t *)Z_Malloc( numRays * sizeof( *batched ), TAG_TEMP_WORKSPACE, qtrue );
+
+	CM_ModelBounds( CM_InlineModel( 0 ), worldMins, worldMaxs );
+	for ( i = 0 ; i < numRays ; i += fan ) {
+		// an origin out in the open
+		for ( j = 0 ; j < 64 ; j++ ) {
+			origin[0] = Q_flrand( worldMins[0], worldMaxs[0] );
+			origin[1] = Q_flrand( worldMins[1], worldMaxs[1] );
+			origin[2] = Q_flrand( worldMins[2], worldMaxs[2] );
+			if ( !( CM_PointContents( origin, 0 ) & MASK_SOLID ) ) {
+				break;
+			}
+		}
+		dir[0] = Q_flrand( -1, 1 );
+		dir[1] = Q_flrand( -1, 1 );
+		dir[2] = Q_flrand( -0.25f, 0.25f );
+		VectorNormalize( dir );
+
+		for ( j = i ; j < i + fan && j < numRays ; j++ ) {
+			req = &requests[j];
+			VectorSet( spread, Q_flrand( -0.1f, 0.1f ), Q_flrand( -0.1f, 0.1f ), Q_flrand( -0.1f, 0.1f ) );
+			VectorAdd( spread, dir, spread );
+			VectorCopy( origin, req->start );
+			VectorMA( origin, TRACEBENCH_LENGTH, spread, req->end );
+			if ( ( i / fan ) & 1 ) {
+				VectorSet( req->mins, -15, -15, -24 );
+				VectorSet( req->maxs, 15, 15, 40 );
+			}
+			req->passEntityNum = ENTITYNUM_NONE;
+			req->contentmask = MASK_SHOT;
+		}
+	}
+
+	Com_Printf( "%i rays in fans of %i\n", numRays, fan );
+	for ( pass = 0 ; pass < 2 ; pass++ ) {
+		singleMsec = SV_BenchTraces( single, requests, numRays, fan, (qboolean)!pass, qfalse );
+		batchMsec = SV_BenchTraces( batched, requests, numRays, fan, (qboolean)!pass, qtrue );
+
+		mismatches = 0;
+		for ( i = 0 ; i < numRays ; i++ ) {
+			if ( memcmp( &single[i], &batched[i], sizeof( trace_t ) ) ) {
+				mismatches++;
+			}
+		}
+
+		Com_Printf( "%s: single %i msec (%.0f rays/sec), batched %i msec (%.0f rays/sec)\n", names[pass],
+			singleMsec, numRays * 1000.0f / Q_max( singleMsec, 1 ), batchMsec, numRays * 1000.0f / Q_max( batchMsec, 1 ) );
+		if ( mismatches ) {
+			Com_Printf( S_COLOR_RED "%i batched traces differ from single ones!\n", mismatches );
+		}
+	}
+
+	Z_Free( batched );
+	Z_Free( single );
+	Z_Free( requests );
+}
+
 
 
 /*
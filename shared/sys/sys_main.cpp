@@ -281,6 +281,25 @@ time_t Sys_FileTime( const char *path )
 	return buf.st_mtime;
 }
 
+/*
+============
+Sys_FileStat
+
+returns qfalse if not present
+============
+*/
+qboolean Sys_FileStat( const char *path, int64_t *size, time_t *mtime )
+{
+	struct stat buf;
+
+	if ( stat( path, &buf ) == -1 )
+		return qfalse;
+
+	*size = buf.st_size;
+	*mtime = buf.st_mtime;
+	return qtrue;
+}
+
 /*
 =================
 Sys_UnloadDll
@@ -153,6 +153,7 @@ void	Sys_FreeFileList( char **fileList );
 //rwwRMG - changed to fileList to not conflict with list type
 
 time_t Sys_FileTime( const char *path );
+qboolean Sys_FileStat( const char *path, int64_t *size, time_t *mtime );
 
 qboolean Sys_LowPhysicalMemory();
 
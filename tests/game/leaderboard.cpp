@@ -0,0 +1,139 @@
+#include "qcommon/q_shared.h"
+extern "C" {
+#include "game/g_leaderboard.h"
+}
+
+#include <boost/test/unit_test.hpp>
+
+#include "testrandom.h"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+static raceEntry_t RandomRun( int numUsers )
+{
+	raceEntry_t run;
+
+	memset( &run, 0, sizeof( run ) );
+	snprintf( run.username, sizeof( run.username ), "racer%d", RandomInt( numUsers ) );
+	run.duration_ms = 20000 + RandomInt( 4000 ); // plenty of ties
+	run.topspeed = 400 + RandomInt( 800 );
+	run.average = run.topspeed - RandomInt( 300 );
+	run.end_time = 1500000000 + RandomInt( 100000 );
+	return run;
+}
+
+static bool RunsBefore( const raceEntry_t &a, const raceEntry_t &b )
+{
+	return std::make_tuple( a.duration_ms, a.end_time, -a.average, std::string( a.username ) )
+		< std::make_tuple( b.duration_ms, b.end_time, -b.average, std::string( b.username ) );
+}
+
+// what the rTop query does: everyone's fastest run, fastest first
+static std::vector<raceEntry_t> ReferenceBoard( const std::vector<raceEntry_t> &runs )
+{
+	std::map<std::string, raceEntry_t> best;
+
+	for ( const raceEntry_t &run : runs ) {
+		auto it = best.find( run.username );
+		if ( it == best.end() || run.duration_ms < it->second.duration_ms
+			|| ( run.duration_ms == it->second.duration_ms && RunsBefore( run, it->second ) ) ) {
+			best[run.username] = run;
+		}
+	}
+
+	std::vector<raceEntry_t> board;
+	for ( const auto &user : best ) {
+		board.push_back( user.second );
+	}
+	std::sort( board.begin(), board.end(), RunsBefore );
+	return board;
+}
+
+static void CheckBoard( const raceBoard_t &board, const std::vector<raceEntry_t> &reference )
+{
+	BOOST_REQUIRE_EQUAL( board.numEntries, (int)reference.size() );
+	for ( int i = 0; i < board.numEntries; i++ ) {
+		BOOST_REQUIRE_EQUAL( std::string( board.entries[i].username ), std::string( reference[i].username ) );
+		BOOST_REQUIRE_EQUAL( board.entries[i].duration_ms, reference[i].duration_ms );
+		BOOST_REQUIRE_EQUAL( G_BoardFind( &board, reference[i].username ), i );
+	}
+}
+
+BOOST_AUTO_TEST_SUITE( game )
+
+BOOST_AUTO_TEST_SUITE( leaderboard )
+
+BOOST_AUTO_TEST_CASE( load_keeps_best_run )
+{
+	std::vector<raceEntry_t> runs;
+	raceBoard_t board;
+
+	SeedRandom( 1 );
+	for ( int i = 0; i < 5000; i++ ) {
+		runs.push_back( RandomRun( 700 ) );
+	}
+
+	std::vector<raceEntry_t> rows = runs;
+	G_BoardInit( &board, "racearena (long)", 1, -1 );
+	G_BoardLoad( &board, rows.data(), (int)rows.size() );
+	CheckBoard( board, ReferenceBoard( runs ) );
+
+	BOOST_CHECK_EQUAL( G_BoardFind( &board, "nobody" ), -1 );
+	G_BoardFree( &board );
+}
+
+BOOST_AUTO_TEST_CASE( submit_matches_reload )
+{
+	std::vector<raceEntry_t> runs;
+	raceBoard_t board;
+
+	SeedRandom( 2 );
+	G_BoardInit( &board, "racearena (long)", 1, 6 );
+	for ( int i = 0; i < 3000; i++ ) {
+		raceEntry_t run = RandomRun( 400 );
+		int before = G_BoardFind( &board, run.username );
+		bool faster = before == -1 || run.duration_ms < board.entries[before].duration_ms;
+
+		BOOST_CHECK_EQUAL( G_BoardSubmit( &board, &run, NULL ) ? true : false, faster );
+		runs.push_back( run );
+
+		if ( i % 100 == 0 ) {
+			CheckBoard( board, ReferenceBoard( runs ) );
+		}
+	}
+	CheckBoard( board, ReferenceBoard( runs ) );
+	G_BoardFree( &board );
+}
+
+BOOST_AUTO_TEST_CASE( coop_ties_share_rank )
+{
+	static const int durations[] = { 100, 100, 150, 200, 200, 200, 250 };
+	static const int denseRanks[] = { 1, 1, 2, 3, 3, 3, 4 };
+	raceBoard_t board;
+
+	G_BoardInit( &board, "coop", 7, -1 );
+	for ( int i = 0; i < 7; i++ ) {
+		raceEntry_t run;
+
+		memset( &run, 0, sizeof( run ) );
+		snprintf( run.username, sizeof( run.username ), "pair%d", i );
+		run.duration_ms = durations[i];
+		run.end_time = i;
+		G_BoardSubmit( &board, &run, NULL );
+	}
+
+	for ( int i = 0; i < 7; i++ ) {
+		BOOST_CHECK_EQUAL( G_BoardRank( &board, i, qfalse ), i + 1 );
+		BOOST_CHECK_EQUAL( G_BoardRank( &board, i, qtrue ), denseRanks[i] );
+	}
+	G_BoardFree( &board );
+}
+
+BOOST_AUTO_TEST_SUITE_END() // leaderboard
+
+BOOST_AUTO_TEST_SUITE_END() // game
@@ -0,0 +1,224 @@
+#include "qcommon/q_shared.h"
+extern "C" {
+#include "game/g_unlagged.h"
+}
+
+#include <boost/test/unit_test.hpp>
+
+#include "testrandom.h"
+
+// trails of three clients as stored by G_StoreTrail, 25 msec apart: one running
+// along x, one bobbing up and down diagonally and one that ducks halfway
+static const struct {
+	int				head;
+	clientTrail_t	trail[NUM_CLIENT_TRAILS];
+} recordedTrails[] = {
+	{ 9, {
+		{ { -15, -15, -24 }, { 15, 15, 40 }, { -72.000f, 0.000f, 24.000f }, 39775 },
+		{ { -15, -15, -24 }, { 15, 15, 40 }, { -64.000f, 0.000f, 24.000f }, 39800 },
+		{ { -15, -15, -24 }, { 15, 15, 40 }, { -56.000f, 0.000f, 24.000f }, 39825 },
+		{ { -15, -15, -24 }, { 15, 15, 40 }, { -48.000f, 0.000f, 24.000f }, 39850 },
+		{ { -15, -15, -24 }, { 15, 15, 40 }, { -40.000f, 0.000f, 24.000f }, 39875 },
+		{ { -15, -15, -24 }, { 15, 15, 40 }, { -32.000f, 0.000f, 24.000f }, 39900 },
+		{ { -15, -15, -24 }, { 15, 15, 40 }, { -24.000f, 0.000f, 24.000f }, 39925 },
+		{ { -15, -15, -24 }, { 15, 15, 40 }, { -16.000f, 0.000f, 24.000f }, 39950 },
+		{ { -15, -15, -24 }, { 15, 15, 40 }, { -8.000f, 0.000f, 24.000f }, 39975 },
+		{ { -15, -15, -24 }, { 15, 15, 40 }, { 0.000f, 0.000f, 24.000f }, 40000 },
+	} },
+	{ 3, {
+		{ { -15, -15, -24 }, { 15, 15, 40 }, { 615.000f, -218.750f, 21.765f }, 39925 },
+		{ { -15, -15, -24 }, { 15, 15, 40 }, { 610.000f, -212.500f, 29.256f }, 39950 },
+		{ { -15, -15, -24 }, { 15, 15, 40 }, { 605.000f, -206.250f, 31.915f }, 39975 },
+		{ { -15, -15, -24 }, { 15, 15, 40 }, { 600.000f, -200.000f, 27.297f }, 40000 },
+		{ { -15, -15, -24 }, { 15, 15, 40 }, { 645.000f, -256.250f, 24.000f }, 39775 },
+		{ { -15, -15, -24 }, { 15, 15, 40 }, { 640.000f, -250.000f, 30.732f }, 39800 },
+		{ { -15, -15, -24 }, { 15, 15, 40 }, { 635.000f, -243.750f, 31.274f }, 39825 },
+		{ { -15, -15, -24 }, { 15, 15, 40 }, { 630.000f, -237.500f, 25.129f }, 39850 },
+		{ { -15, -15, -24 }, { 15, 15, 40 }, { 625.000f, -231.250f, 17.946f }, 39875 },
+		{ { -15, -15, -24 }, { 15, 15, 40 }, { 620.000f, -225.000f, 16.329f }, 39900 },
+	} },
+	{ 6, {
+		{ { -15, -15, -24 }, { 15, 15, 40 }, { -300.000f, 860.000f, 88.000f }, 39850 },
+		{ { -15, -15, -24 }, { 15, 15, 40 }, { -300.000f, 850.000f, 88.000f }, 39875 },
+		{ { -15, -15, -24 }, { 15, 15, 40 }, { -300.000f, 840.000f, 88.000f }, 39900 },
+		{ { -15, -15, -24 }, { 15, 15, 16 }, { -300.000f, 830.000f, 88.000f }, 39925 },
+		{ { -15, -15, -24 }, { 15, 15, 16 }, { -300.000f, 820.000f, 88.000f }, 39950 },
+		{ { -15, -15, -24 }, { 15, 15, 16 }, { -300.000f, 810.000f, 88.000f }, 39975 },
+		{ { -15, -15, -24 }, { 15, 15, 16 }, { -300.000f, 800.000f, 88.000f }, 40000 },
+		{ { -15, -15, -24 }, { 15, 15, 40 }, { -300.000f, 890.000f, 88.000f }, 39775 },
+		{ { -15, -15, -24 }, { 15, 15, 40 }, { -300.000f, 880.000f, 88.000f }, 39800 },
+		{ { -15, -15, -24 }, { 15, 15, 40 }, { -300.000f, 870.000f, 88.000f }, 39825 },
+	} },
+};
+
+static const int numRecordedTrails = sizeof( recordedTrails ) / sizeof( recordedTrails[0] );
+
+// how G_TimeShiftClient used to place the client, kept as the reference
+static bool ReferenceBoxForTime( const clientTrail_t *trail, int head, int time, vec3_t origin, vec3_t mins, vec3_t maxs )
+{
+	int j, k;
+
+	j = k = head;
+	do {
+		if ( trail[j].time <= time )
+			break;
+
+		k = j;
+		j--;
+		if ( j < 0 ) {
+			j = NUM_CLIENT_TRAILS - 1;
+		}
+	}
+	while ( j != head );
+
+	if ( j == k ) {
+		return false;
+	}
+
+	if ( j != head ) {
+		float frac = (float)(trail[k].time - time) / (float)(trail[k].time - trail[j].time);
+		float comp = 1.0f - frac;
+
+		for ( int i = 0; i < 3; i++ ) {
+			origin[i] = frac * trail[k].currentOrigin[i] + comp * trail[j].currentOrigin[i];
+			mins[i] = frac * trail[k].mins[i] + comp * trail[j].mins[i];
+			maxs[i] = frac * trail[k].maxs[i] + comp * trail[j].maxs[i];
+		}
+	} else {
+		for ( int i = 0; i < 3; i++ ) {
+			origin[i] = trail[k].currentOrigin[i];
+			mins[i] = trail[k].mins[i];
+			maxs[i] = trail[k].maxs[i];
+		}
+	}
+	return true;
+}
+
+// steps along the trace to see whether it really touches the box
+static bool TraceTouchesBox( const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end,
+	const vec3_t absmin, const vec3_t absmax )
+{
+	const int steps = 4096;
+
+	for ( int s = 0; s <= steps; s++ ) {
+		bool inside = true;
+
+		for ( int i = 0; i < 3 && inside; i++ ) {
+			float p = start[i] + ( end[i] - start[i] ) * s / steps;
+			inside = p + ( maxs ? maxs[i] : 0.0f ) >= absmin[i] && p + ( mins ? mins[i] : 0.0f ) <= absmax[i];
+		}
+		if ( inside ) {
+			return true;
+		}
+	}
+	return false;
+}
+
+BOOST_AUTO_TEST_SUITE( game )
+
+BOOST_AUTO_TEST_SUITE( unlagged )
+
+BOOST_AUTO_TEST_CASE( trail_entries )
+{
+	const clientTrail_t *trail = recordedTrails[1].trail;
+	int older, newer;
+
+	// between two entries
+	BOOST_CHECK( G_TrailEntriesForTime( trail, 3, 39940, &older, &newer ) );
+	BOOST_CHECK_EQUAL( older, 0 );
+	BOOST_CHECK_EQUAL( newer, 1 );
+
+	// across the end of the ring
+	BOOST_CHECK( G_TrailEntriesForTime( trail, 3, 39910, &older, &newer ) );
+	BOOST_CHECK_EQUAL( older, 9 );
+	BOOST_CHECK_EQUAL( newer, 0 );
+
+	// at or after the newest entry nothing moves
+	BOOST_CHECK( !G_TrailEntriesForTime( trail, 3, 40000, &older, &newer ) );
+	BOOST_CHECK( !G_TrailEntriesForTime( trail, 3, 40020, &older, &newer ) );
+
+	// before the oldest entry the trail wraps
+	BOOST_CHECK( G_TrailEntriesForTime( trail, 3, 39000, &older, &newer ) );
+	BOOST_CHECK_EQUAL( older, 3 );
+	BOOST_CHECK_EQUAL( newer, 4 );
+}
+
+BOOST_AUTO_TEST_CASE( box_matches_timeshift )
+{
+	for ( int c = 0; c < numRecordedTrails; c++ ) {
+		for ( int time = 39700; time <= 40050; time++ ) {
+			vec3_t origin, mins, maxs;
+			vec3_t refOrigin, refMins, refMaxs;
+			bool moved = G_TrailBoxForTime( recordedTrails[c].trail, recordedTrails[c].head, time, origin, mins, maxs ) != qfalse;
+
+			BOOST_REQUIRE_EQUAL( moved, ReferenceBoxForTime( recordedTrails[c].trail, recordedTrails[c].head, time, refOrigin, refMins, refMaxs ) );
+			if ( !moved ) {
+				continue;
+			}
+			for ( int i = 0; i < 3; i++ ) {
+				BOOST_REQUIRE_EQUAL( origin[i], refOrigin[i] );
+				BOOST_REQUIRE_EQUAL( mins[i], refMins[i] );
+				BOOST_REQUIRE_EQUAL( maxs[i], refMaxs[i] );
+			}
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE( filter_keeps_every_hit )
+{
+	const vec3_t shotMins = { -1, -1, -1 };
+	const vec3_t shotMaxs = { 1, 1, 1 };
+	int hits = 0, skipped = 0;
+
+	SeedRandom( 1 );
+	for ( int shot = 0; shot < 3000; shot++ ) {
+		const int c = shot % numRecordedTrails;
+		const int time = 39760 + (int)RandomRange( 0, 240 );
+		const bool box = ( shot & 4 ) != 0;
+		vec3_t origin, mins, maxs, absmin, absmax, start, end;
+
+		if ( !G_TrailBoxForTime( recordedTrails[c].trail, recordedTrails[c].head, time, origin, mins, maxs ) ) {
+			continue;
+		}
+		// aim somewhere close to where the client was, from far away
+		for ( int i = 0; i < 3; i++ ) {
+			absmin[i] = origin[i] + mins[i];
+			absmax[i] = origin[i] + maxs[i];
+			start[i] = origin[i] + RandomRange( -1000, 1000 );
+			end[i] = origin[i] + RandomRange( -48, 48 );
+			end[i] += ( end[i] - start[i] ) * RandomRange( 0, 2 );
+		}
+
+		const bool touches = TraceTouchesBox( start, box ? shotMins : NULL, box ? shotMaxs : NULL, end, absmin, absmax );
+		const bool kept = G_TraceMayTouchBox( start, box ? shotMins : NULL, box ? shotMaxs : NULL, end, absmin, absmax ) != qfalse;
+
+		if ( touches ) {
+			hits++;
+			BOOST_REQUIRE( kept );
+		} else if ( !kept ) {
+			skipped++;
+		}
+	}
+
+	// make sure both cases were actually covered
+	BOOST_CHECK_GT( hits, 100 );
+	BOOST_CHECK_GT( skipped, 100 );
+}
+
+BOOST_AUTO_TEST_CASE( filter_skips_far_shots )
+{
+	const vec3_t absmin = { -16, -16, -25 };
+	const vec3_t absmax = { 16, 16, 41 };
+	const vec3_t start = { -1000, 100, 0 };
+	const vec3_t end = { 1000, 100, 0 };
+	const vec3_t endShort = { -100, 0, 0 };
+	const vec3_t startInside = { 0, 0, 0 };
+
+	BOOST_CHECK( !G_TraceMayTouchBox( start, NULL, NULL, end, absmin, absmax ) );
+	BOOST_CHECK( !G_TraceMayTouchBox( start, NULL, NULL, endShort, absmin, absmax ) );
+	BOOST_CHECK( G_TraceMayTouchBox( startInside, NULL, NULL, end, absmin, absmax ) );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,136 @@
+#include "icarus/ringqueue.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include "testrandom.h"
+
+#include <deque>
+#include <vector>
+
+static void CheckSame( const CRingQueue<int> &queue, const std::deque<int> &expected )
+{
+	BOOST_REQUIRE_EQUAL( queue.size(), (int)expected.size() );
+	BOOST_CHECK_EQUAL( queue.empty(), expected.empty() );
+
+	std::vector<int> items;
+	for ( CRingQueue<int>::iterator it = queue.begin(); it != queue.end(); ++it ) {
+		items.push_back( *it );
+	}
+	BOOST_CHECK_EQUAL_COLLECTIONS( items.begin(), items.end(), expected.begin(), expected.end() );
+
+	if ( !expected.empty() ) {
+		BOOST_CHECK_EQUAL( queue.front(), expected.front() );
+		BOOST_CHECK_EQUAL( queue.back(), expected.back() );
+	}
+}
+
+BOOST_AUTO_TEST_SUITE( icarus )
+
+BOOST_AUTO_TEST_SUITE( ringqueue )
+
+BOOST_AUTO_TEST_CASE( wraps_at_both_ends )
+{
+	CRingQueue<int> queue;
+	std::deque<int> expected;
+
+	// the first push_front lands in the last slot of the array
+	queue.push_front( 1 );
+	expected.push_front( 1 );
+	queue.push_back( 2 );
+	expected.push_back( 2 );
+	CheckSame( queue, expected );
+
+	// walk the head all the way around the array a few times without growing
+	for ( int i = 0; i < 40; i++ ) {
+		queue.push_back( 3 + i );
+		expected.push_back( 3 + i );
+		queue.pop_front();
+		expected.pop_front();
+		CheckSame( queue, expected );
+	}
+	for ( int i = 0; i < 40; i++ ) {
+		queue.push_front( -i );
+		expected.push_front( -i );
+		queue.pop_back();
+		expected.pop_back();
+		CheckSame( queue, expected );
+	}
+}
+
+BOOST_AUTO_TEST_CASE( grows_while_wrapped )
+{
+	CRingQueue<int> queue;
+	std::deque<int> expected;
+
+	// fill the first array with the head in the middle, so the items wrap
+	for ( int i = 0; i < 4; i++ ) {
+		queue.push_back( i );
+		expected.push_back( i );
+	}
+	for ( int i = 0; i < 4; i++ ) {
+		queue.push_front( 100 + i );
+		expected.push_front( 100 + i );
+	}
+	CheckSame( queue, expected );
+
+	// and grow it twice from either end
+	for ( int i = 0; i < 20; i++ ) {
+		if ( i & 1 ) {
+			queue.push_front( 200 + i );
+			expected.push_front( 200 + i );
+		} else {
+			queue.push_back( 200 + i );
+			expected.push_back( 200 + i );
+		}
+		CheckSame( queue, expected );
+	}
+
+	// clear keeps the storage, and it still works from a reset head
+	queue.clear();
+	expected.clear();
+	CheckSame( queue, expected );
+	queue.push_front( 7 );
+	expected.push_front( 7 );
+	queue.push_back( 8 );
+	expected.push_back( 8 );
+	CheckSame( queue, expected );
+}
+
+BOOST_AUTO_TEST_CASE( matches_deque )
+{
+	CRingQueue<int> queue;
+	std::deque<int> expected;
+
+	SeedRandom( 0 );
+	for ( int i = 0; i < 20000; i++ ) {
+		// lean towards pushing early on so the queue grows through a few sizes
+		const int op = RandomInt( i < 10000 ? 5 : 4 );
+
+		if ( op == 0 && !expected.empty() ) {
+			queue.pop_front();
+			expected.pop_front();
+		} else if ( op == 1 && !expected.empty() ) {
+			queue.pop_back();
+			expected.pop_back();
+		} else if ( op == 2 ) {
+			queue.push_front( i );
+			expected.push_front( i );
+		} else {
+			queue.push_back( i );
+			expected.push_back( i );
+		}
+
+		BOOST_REQUIRE_EQUAL( queue.size(), (int)expected.size() );
+		if ( !expected.empty() ) {
+			BOOST_REQUIRE_EQUAL( queue.front(), expected.front() );
+			BOOST_REQUIRE_EQUAL( queue.back(), expected.back() );
+			const int index = RandomInt( (int)expected.size() );
+			BOOST_REQUIRE_EQUAL( queue[index], expected[index] );
+		}
+	}
+	CheckSame( queue, expected );
+}
+
+BOOST_AUTO_TEST_SUITE_END() // ringqueue
+
+BOOST_AUTO_TEST_SUITE_END() // icarus
@@ -0,0 +1,224 @@
+#include "qcommon/cm_local.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include "testrandom.h"
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+// some coordinates are whole numbers, so points land exactly on axial planes
+static float RandomCoord( float min, float max )
+{
+	float f = RandomRange( min, max );
+	return RandomInt( 4 ) ? f : (float)(int)f;
+}
+
+static void SetPlane( cplane_t *plane, const vec3_t normal, float dist )
+{
+	VectorCopy( normal, plane->normal );
+	plane->dist = dist;
+	plane->type = PLANE_NON_AXIAL;
+	plane->signbits = 0;
+	for ( int k = 0; k < 3; k++ ) {
+		if ( normal[k] < 0 ) {
+			plane->signbits |= 1 << k;
+		}
+	}
+}
+
+// a box with the six axial sides first, like q3map writes them, and a few
+// bevels cutting its corners
+struct testBrush_t {
+	std::vector<cplane_t>		planes;
+	std::vector<cbrushside_t>	sides;
+	std::vector<cbrushPlanes_t>	blocks;
+	cbrush_t					brush;
+
+	explicit testBrush_t( int numBevels )
+		: planes( 6 + numBevels ), sides( 6 + numBevels )
+	{
+		vec3_t mins, maxs;
+
+		for ( int k = 0; k < 3; k++ ) {
+			mins[k] = RandomCoord( -64, -8 );
+			maxs[k] = RandomCoord( 8, 64 );
+		}
+		for ( int k = 0; k < 3; k++ ) {
+			vec3_t normal = { 0, 0, 0 };
+
+			normal[k] = -1;
+			SetPlane( &planes[k * 2], normal, -mins[k] );
+			planes[k * 2].type = k;
+			normal[k] = 1;
+			SetPlane( &planes[k * 2 + 1], normal, maxs[k] );
+			planes[k * 2 + 1].type = k;
+		}
+		for ( int i = 6; i < 6 + numBevels; i++ ) {
+			vec3_t normal, corner;
+
+			for ( int k = 0; k < 3; k++ ) {
+				normal[k] = RandomRange( -1, 1 );
+				corner[k] = normal[k] < 0 ? mins[k] : maxs[k];
+			}
+			float length = sqrtf( DotProduct( normal, normal ) );
+			if ( length < 0.01f ) {
+				VectorSet( normal, 1, 1, 1 );
+				length = sqrtf( 3.0f );
+			}
+			VectorScale( normal, 1.0f / length, normal );
+			SetPlane( &planes[i], normal, DotProduct( normal, corner ) - RandomRange( 0, 16 ) );
+		}
+
+		for ( size_t i = 0; i < sides.size(); i++ ) {
+			sides[i].plane = &planes[i];
+			sides[i].shaderNum = 0;
+		}
+		memset( &brush, 0, sizeof( brush ) );
+		brush.sides = sides.data();
+		brush.numsides = (unsigned short)sides.size();
+		blocks.resize( CM_NumBrushPlaneBlocks( brush.numsides ) );
+	}
+};
+
+// a trace near the brush, set up the way CM_Trace does
+static void RandomTrace( traceWork_t *tw, bool sphere )
+{
+	memset( tw, 0, sizeof( *tw ) );
+	for ( int k = 0; k < 3; k++ ) {
+		tw->start[k] = RandomCoord( -96, 96 );
+		tw->end[k] = RandomInt( 8 ) ? RandomCoord( -96, 96 ) : tw->start[k];
+		if ( RandomInt( 4 ) ) {
+			tw->size[0][k] = -RandomCoord( 0, 24 );
+			tw->size[1][k] = RandomCoord( 0, 32 );
+		}
+	}
+	for ( int i = 0; i < 8; i++ ) {
+		for ( int k = 0; k < 3; k++ ) {
+			tw->offsets[i][k] = tw->size[( i >> k ) & 1][k];
+		}
+	}
+	if ( sphere ) {
+		tw->sphere.use = qtrue;
+		tw->sphere.radius = RandomRange( 0, 24 );
+		tw->sphere.halfheight = tw->sphere.radius + RandomRange( 0, 24 );
+		VectorSet( tw->sphere.offset, 0, 0, tw->sphere.halfheight - tw->sphere.radius );
+	}
+}
+
+static void ResetClip( traceWork_t *tw )
+{
+	tw->enterFrac = -1.0f;
+	tw->leaveFrac = 1.0f;
+	tw->clipplane = NULL;
+	tw->leadside = NULL;
+	tw->getout = false;
+	tw->startout = false;
+}
+
+static bool SameFloat( float a, float b )
+{
+	return memcmp( &a, &b, sizeof( a ) ) == 0;
+}
+
+BOOST_AUTO_TEST_SUITE( qcommon )
+
+BOOST_AUTO_TEST_SUITE( brushsides )
+
+BOOST_AUTO_TEST_CASE( planes_match_sides )
+{
+	SeedRandom( 1 );
+	for ( int numBevels = 0; numBevels < 12; numBevels++ ) {
+		testBrush_t b( numBevels );
+
+		CM_SetBrushPlanes( &b.brush, b.blocks.data() );
+		BOOST_REQUIRE( b.brush.planes == b.blocks.data() );
+		for ( int i = 0; i < (int)b.blocks.size() * 4; i++ ) {
+			const cbrushPlanes_t &block = b.blocks[i / 4];
+
+			if ( i >= b.brush.numsides ) {
+				// padding that everything is behind
+				BOOST_CHECK_EQUAL( block.dist[i % 4], 1.0f );
+				continue;
+			}
+			for ( int k = 0; k < 3; k++ ) {
+				BOOST_CHECK_EQUAL( block.normal[k][i % 4], b.planes[i].normal[k] );
+				BOOST_CHECK_EQUAL( block.sign[k][i % 4] != 0, ( b.planes[i].signbits & ( 1 << k ) ) != 0 );
+			}
+			BOOST_CHECK_EQUAL( block.dist[i % 4], b.planes[i].dist );
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE( clip_matches_scalar )
+{
+	int clipped = 0, outside = 0;
+
+	SeedRandom( 2 );
+	for ( int n = 0; n < 2000; n++ ) {
+		testBrush_t b( RandomInt( 14 ) );
+
+		CM_SetBrushPlanes( &b.brush, b.blocks.data() );
+		for ( int t = 0; t < 100; t++ ) {
+			traceWork_t scalar, blocked;
+
+			RandomTrace( &scalar, false );
+			ResetClip( &scalar );
+			blocked = scalar;
+
+			b.brush.planes = NULL;
+			const bool scalarIn = CM_ClipToBrushSides( &scalar, &b.brush );
+			b.brush.planes = b.blocks.data();
+			const bool blockedIn = CM_ClipToBrushSides( &blocked, &b.brush );
+
+			BOOST_REQUIRE_EQUAL( scalarIn, blockedIn );
+			BOOST_REQUIRE( SameFloat( scalar.enterFrac, blocked.enterFrac ) );
+			BOOST_REQUIRE( SameFloat( scalar.leaveFrac, blocked.leaveFrac ) );
+			BOOST_REQUIRE( scalar.leadside == blocked.leadside );
+			BOOST_REQUIRE( scalar.clipplane == blocked.clipplane );
+			BOOST_REQUIRE_EQUAL( scalar.getout, blocked.getout );
+			BOOST_REQUIRE_EQUAL( scalar.startout, blocked.startout );
+
+			if ( !scalarIn ) {
+				outside++;
+			} else if ( scalar.clipplane ) {
+				clipped++;
+			}
+		}
+	}
+	// make sure the traces cover both outcomes
+	BOOST_CHECK_GT( clipped, 10000 );
+	BOOST_CHECK_GT( outside, 10000 );
+}
+
+BOOST_AUTO_TEST_CASE( box_in_brush_matches_scalar )
+{
+	int inside = 0, outside = 0;
+
+	SeedRandom( 3 );
+	for ( int n = 0; n < 2000; n++ ) {
+		testBrush_t b( RandomInt( 14 ) );
+
+		CM_SetBrushPlanes( &b.brush, b.blocks.data() );
+		for ( int t = 0; t < 100; t++ ) {
+			traceWork_t tw;
+
+			RandomTrace( &tw, ( t & 3 ) == 0 );
+
+			b.brush.planes = NULL;
+			const bool scalarIn = CM_BoxInBrushSides( &tw, &b.brush );
+			b.brush.planes = b.blocks.data();
+			const bool blockedIn = CM_BoxInBrushSides( &tw, &b.brush );
+
+			BOOST_REQUIRE_EQUAL( scalarIn, blockedIn );
+			( scalarIn ? inside : outside )++;
+		}
+	}
+	BOOST_CHECK_GT( inside, 10000 );
+	BOOST_CHECK_GT( outside, 10000 );
+}
+
+BOOST_AUTO_TEST_SUITE_END() // brushsides
+
+BOOST_AUTO_TEST_SUITE_END() // qcommon
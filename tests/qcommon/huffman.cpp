@@ -0,0 +1,248 @@
+#include "qcommon/qcommon.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include "testrandom.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+// how often each byte turns up, shaped like snapshot deltas: mostly zeros
+// and small numbers, a few common field values and a long tail
+static void NetworkWeights( int *weights )
+{
+	for ( int i = 0; i < 256; i++ ) {
+		weights[i] = 1 + 4000 / ( 1 + i * i / 4 ) + RandomInt( 40 );
+	}
+	weights[0] = 250000;
+	weights[255] = 13000;
+	weights[254] = 11000;
+	weights[128] = 9000;
+}
+
+// weights that give a few codes longer than the decode table
+static void SkewedWeights( int *weights )
+{
+	int a = 1, b = 1;
+
+	for ( int i = 0; i < 256; i++ ) {
+		weights[i] = 1;
+	}
+	for ( int i = 0; i < 22; i++ ) {
+		weights[i * 11] = b;
+		b += a;
+		a = b - a;
+	}
+}
+
+struct testHuff_t {
+	huffman_t		huff;
+	huffTable_t		table;
+	int				weights[256];
+	int				total;
+
+	explicit testHuff_t( void (*makeWeights)( int *weights ) )
+	{
+		makeWeights( weights );
+		total = 0;
+		Huff_Init( &huff );
+		for ( int i = 0; i < 256; i++ ) {
+			for ( int j = 0; j < weights[i]; j++ ) {
+				Huff_addRef( &huff.compressor, (byte)i );
+				Huff_addRef( &huff.decompressor, (byte)i );
+			}
+			total += weights[i];
+		}
+		Huff_BuildTable( &table, &huff.compressor, &huff.decompressor );
+	}
+
+	// a byte drawn with the same odds the tree was built with
+	int RandomSymbol() const
+	{
+		int r = RandomInt( total );
+
+		for ( int i = 0; i < 256; i++ ) {
+			if ( r < weights[i] ) {
+				return i;
+			}
+			r -= weights[i];
+		}
+		return 255;
+	}
+};
+
+// a message the way MSG_WriteBits writes it: the odd bits of each field sent
+// raw, then the whole bytes through the codec
+static int WriteMessage( testHuff_t &h, bool table, const std::vector<int> &fields, byte *out, int maxoffset )
+{
+	int bit = 0;
+
+	for ( size_t i = 0; i + 1 < fields.size() && bit <= maxoffset; i += 2 ) {
+		int bits = fields[i], value = fields[i + 1];
+
+		for ( int j = 0; j < ( bits & 7 ) && bit < maxoffset; j++ ) {
+			Huff_putBit( ( value >> j ) & 1, out, &bit );
+		}
+		for ( int j = bits & 7; j < bits && bit <= maxoffset; j += 8 ) {
+			if ( table ) {
+				Huff_tableTransmit( &h.table, ( value >> j ) & 0xff, out, &bit, maxoffset );
+			} else {
+				Huff_offsetTransmit( &h.huff.compressor, ( value >> j ) & 0xff, out, &bit, maxoffset );
+			}
+		}
+	}
+	return bit;
+}
+
+static std::vector<int> RandomFields( testHuff_t &h, int count )
+{
+	std::vector<int> fields;
+	static const int sizes[] = { 1, 4, 7, 8, 10, 16, 19, 24, 32 };
+
+	for ( int i = 0; i < count; i++ ) {
+		int bits = sizes[RandomInt( sizeof( sizes ) / sizeof( sizes[0] ) )];
+		int value = 0;
+
+		for ( int j = 0; j < bits; j += 8 ) {
+			value |= h.RandomSymbol() << j;
+		}
+		fields.push_back( bits );
+		fields.push_back( bits < 32 ? value & ( ( 1 << bits ) - 1 ) : value );
+	}
+	return fields;
+}
+
+static void CheckCodec( void (*makeWeights)( int *weights ), unsigned int startSeed )
+{
+	int mismatches = 0;
+
+	SeedRandom( startSeed );
+	testHuff_t h( makeWeights );
+
+	for ( int n = 0; n < 500; n++ ) {
+		std::vector<int> fields = RandomFields( h, 1 + RandomInt( 200 ) );
+		std::vector<byte> tree( 4096, 0xcd ), table( 4096, 0xcd );
+		// every so often the message doesn't fit
+		int maxoffset = RandomInt( 4 ) ? 4000 * 8 : RandomInt( 400 * 8 );
+
+		int treeBits = WriteMessage( h, false, fields, tree.data(), maxoffset );
+		int tableBits = WriteMessage( h, true, fields, table.data(), maxoffset );
+		BOOST_REQUIRE_EQUAL( treeBits, tableBits );
+		BOOST_REQUIRE( tree == table );
+
+		// read it back symbol by symbol from every starting bit, including
+		// from the middle of codes and past the end
+		int cursize = ( std::min( treeBits, maxoffset ) >> 3 ) + 1;
+		for ( int start = 0; start < ( cursize << 3 ) + 2; start += 1 + RandomInt( 16 ) ) {
+			int treeOffset = start, tableOffset = start;
+
+			while ( treeOffset <= cursize << 3 ) {
+				int treeCh = -1, tableCh = -1;
+
+				Huff_offsetReceive( h.huff.decompressor.tree, &treeCh, tree.data(), &treeOffset, cursize << 3 );
+				Huff_tableReceive( &h.table, &tableCh, tree.data(), &tableOffset, cursize << 3 );
+				if ( treeCh != tableCh || treeOffset != tableOffset ) {
+					mismatches++;
+					break;
+				}
+			}
+		}
+	}
+	BOOST_CHECK_EQUAL( mismatches, 0 );
+}
+
+BOOST_AUTO_TEST_SUITE( qcommon )
+
+BOOST_AUTO_TEST_SUITE( huffman )
+
+BOOST_AUTO_TEST_CASE( table_matches_tree_codes )
+{
+	SeedRandom( 1 );
+	testHuff_t h( NetworkWeights );
+
+	for ( int ch = 0; ch <= HMAX; ch++ ) {
+		int length = 0;
+
+		for ( node_t *node = h.huff.compressor.loc[ch]; node->parent; node = node->parent ) {
+			length++;
+		}
+		BOOST_CHECK_EQUAL( h.table.codeLength[ch], length );
+
+		// the code decodes to its symbol
+		byte buffer[8] = { 0 };
+		int offset = 0, get = -1;
+		Huff_tableTransmit( &h.table, ch, buffer, &offset, sizeof( buffer ) * 8 );
+		BOOST_CHECK_EQUAL( offset, length );
+		offset = 0;
+		Huff_tableReceive( &h.table, &get, buffer, &offset, sizeof( buffer ) * 8 );
+		BOOST_CHECK_EQUAL( get, ch );
+		BOOST_CHECK_EQUAL( offset, length );
+	}
+}
+
+BOOST_AUTO_TEST_CASE( network_stream_matches_tree )
+{
+	CheckCodec( NetworkWeights, 2 );
+}
+
+BOOST_AUTO_TEST_CASE( long_codes_match_tree )
+{
+	SeedRandom( 3 );
+	testHuff_t h( SkewedWeights );
+	int longCodes = 0;
+
+	for ( int ch = 0; ch <= HMAX; ch++ ) {
+		longCodes += h.table.codeLength[ch] > HUFF_TABLE_BITS;
+	}
+	BOOST_REQUIRE_GT( longCodes, 100 );
+
+	CheckCodec( SkewedWeights, 4 );
+}
+
+// fields of 1 to 32 bits, written at once and a bit at a time from every
+// alignment, read back both ways
+BOOST_AUTO_TEST_CASE( raw_bits_match_single_bits )
+{
+	SeedRandom( 6 );
+	for ( int n = 0; n < 2000; n++ ) {
+		std::vector<byte> single( 256, 0xcd ), multi( 256, 0xcd );
+		std::vector<int> widths;
+		std::vector<unsigned> values;
+		const int start = RandomInt( 8 );
+		int singleBit = start, multiBit = start;
+
+		// a started byte has nothing above the bits written so far
+		single[0] = multi[0] = 0xcd & ( ( 1 << start ) - 1 );
+
+		while ( singleBit < 32 * 8 * 7 ) {
+			int bits = 1 + RandomInt( 32 );
+			unsigned value = (unsigned)RandomInt( 1 << 24 ) * 251 + RandomInt( 1 << 16 );
+
+			widths.push_back( bits );
+			values.push_back( bits < 32 ? value & ( ( 1u << bits ) - 1 ) : value );
+			for ( int i = 0; i < bits; i++ ) {
+				Huff_putBit( ( value >> i ) & 1, single.data(), &singleBit );
+			}
+			Huff_putBits( value, bits, multi.data(), &multiBit );
+			BOOST_REQUIRE_EQUAL( singleBit, multiBit );
+		}
+		BOOST_REQUIRE( single == multi );
+
+		int singleOffset = start, multiOffset = start;
+		for ( size_t f = 0; f < widths.size(); f++ ) {
+			unsigned singleValue = 0;
+
+			for ( int i = 0; i < widths[f]; i++ ) {
+				singleValue |= (unsigned)Huff_getBit( multi.data(), &singleOffset ) << i;
+			}
+			BOOST_REQUIRE_EQUAL( singleValue, values[f] );
+			BOOST_REQUIRE_EQUAL( Huff_getBits( multi.data(), widths[f], &multiOffset ), values[f] );
+			BOOST_REQUIRE_EQUAL( singleOffset, multiOffset );
+		}
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END() // huffman
+
+BOOST_AUTO_TEST_SUITE_END() // qcommon
@@ -0,0 +1,28 @@
+#pragma once
+
+// Seeded pseudo random numbers, so a test sees the same values on every run.
+// Each test case seeds its own sequence with SeedRandom.
+
+static unsigned int randomSeed;
+
+static inline void SeedRandom( unsigned int seed )
+{
+	randomSeed = seed;
+}
+
+// 24 random bits
+static inline unsigned int RandomBits()
+{
+	randomSeed = randomSeed * 1664525 + 1013904223;
+	return randomSeed >> 8;
+}
+
+static inline int RandomInt( int max )
+{
+	return (int)( RandomBits() % (unsigned int)max );
+}
+
+static inline float RandomRange( float min, float max )
+{
+	return min + ( max - min ) * ( RandomBits() / 16777216.0f );
+}